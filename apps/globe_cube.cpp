@@ -174,7 +174,6 @@ class CubeApp : public GlobeApp {
     GlobeTexture *_texture;
     VkDescriptorSetLayout _vk_desc_set_layout;
     VkPipelineLayout _vk_pipeline_layout;
-    VkPipelineCache _vk_pipeline_cache;
     VkPipeline _vk_pipeline;
     VkDescriptorPool _vk_desc_pool;
 
@@ -185,7 +184,6 @@ class CubeApp : public GlobeApp {
 CubeApp::CubeApp() {
     _vk_desc_set_layout = VK_NULL_HANDLE;
     _vk_pipeline_layout = VK_NULL_HANDLE;
-    _vk_pipeline_cache = VK_NULL_HANDLE;
     _vk_pipeline = VK_NULL_HANDLE;
     _vk_desc_pool = VK_NULL_HANDLE;
 
@@ -336,25 +334,24 @@ bool CubeApp::Setup() {
             if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                     _swapchain_resources[i].uniform_buffer,
                     (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                    _swapchain_resources[i].uniform_memory, _swapchain_resources[i].vk_allocated_size)) {
+                    _swapchain_resources[i].uniform_memory)) {
                 std::string error_message = "Failed to allocate buffer for swapchain image ";
                 error_message += std::to_string(i);
                 logger.LogFatalError(error_message);
                 return false;
             }
 
-            if (VK_SUCCESS !=
-                vkMapMemory(_vk_device, _swapchain_resources[i].uniform_memory, 0, VK_WHOLE_SIZE, 0, (void **)&pData)) {
+            pData = _swapchain_resources[i].uniform_memory.mapped_data;
+            if (nullptr == pData) {
                 logger.LogFatalError("Failed to map memory for buffer");
                 return false;
             }
 
             memcpy(pData, &data, sizeof data);
 
-            vkUnmapMemory(_vk_device, _swapchain_resources[i].uniform_memory);
-
             if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _swapchain_resources[i].uniform_buffer,
-                                                 _swapchain_resources[i].uniform_memory, 0)) {
+                                                 _swapchain_resources[i].uniform_memory.vk_memory,
+                                                 _swapchain_resources[i].uniform_memory.vk_offset)) {
                 logger.LogFatalError("Failed to find memory type supporting necessary buffer requirements");
                 return false;
             }
@@ -455,7 +452,6 @@ bool CubeApp::Setup() {
         }
 
         VkGraphicsPipelineCreateInfo gfx_pipeline_create_info = {};
-        VkPipelineCacheCreateInfo pipeline_cache_create_info = {};
         VkPipelineVertexInputStateCreateInfo pipline_vert_input_state_create_info = {};
         VkPipelineInputAssemblyStateCreateInfo pipline_input_assembly_state_create_info = {};
         VkPipelineRasterizationStateCreateInfo pipeline_raster_state_create_info = {};
@@ -525,13 +521,6 @@ bool CubeApp::Setup() {
         std::vector<VkPipelineShaderStageCreateInfo> pipeline_shader_stage_create_info;
         cube_shader->GetPipelineShaderStages(pipeline_shader_stage_create_info);
 
-        pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-        if (VK_SUCCESS !=
-            vkCreatePipelineCache(_vk_device, &pipeline_cache_create_info, nullptr, &_vk_pipeline_cache)) {
-            logger.LogFatalError("Failed to create pipeline cache");
-            return false;
-        }
-
         gfx_pipeline_create_info.pVertexInputState = &pipline_vert_input_state_create_info;
         gfx_pipeline_create_info.pInputAssemblyState = &pipline_input_assembly_state_create_info;
         gfx_pipeline_create_info.pRasterizationState = &pipeline_raster_state_create_info;
@@ -631,7 +620,6 @@ void CubeApp::CleanupCommandObjects(bool is_resize) {
         vkDestroyDescriptorPool(_vk_device, _vk_desc_pool, NULL);
 
         vkDestroyPipeline(_vk_device, _vk_pipeline, NULL);
-        vkDestroyPipelineCache(_vk_device, _vk_pipeline_cache, NULL);
         vkDestroyRenderPass(_vk_device, _vk_render_pass, NULL);
         vkDestroyPipelineLayout(_vk_device, _vk_pipeline_layout, NULL);
         vkDestroyDescriptorSetLayout(_vk_device, _vk_desc_set_layout, NULL);
@@ -658,13 +646,12 @@ bool CubeApp::Update(float diff_ms) {
     mat4x4_rotate(_model_matrix, Model, 0.0f, 1.0f, 0.0f, (float)degreesToRadians(_spin_angle));
     mat4x4_mul(MVP, VP, _model_matrix);
 
-    if (VK_SUCCESS != vkMapMemory(_vk_device, _swapchain_resources[_current_buffer].uniform_memory, 0, VK_WHOLE_SIZE, 0,
-                                  (void **)&pData)) {
+    pData = _swapchain_resources[_current_buffer].uniform_memory.mapped_data;
+    if (nullptr == pData) {
         logger.LogFatalError("Failed to map uniform buffer memory");
         return false;
     }
     memcpy(pData, (const void *)&MVP[0][0], matrixSize);
-    vkUnmapMemory(_vk_device, _swapchain_resources[_current_buffer].uniform_memory);
     return true;
 }
 
@@ -7,6 +7,8 @@
 // Author(s):               Mark Young <marky@lunarg.com>
 //
 
+#include <cctype>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
 
@@ -17,11 +19,32 @@
 #include "globe_clock.hpp"
 #include "globe_app.hpp"
 #include "globe_logger.hpp"
+#include "globe_file_view.hpp"
 
 #define GLOBE_APP_ENGINE_MAJOR 0
 #define GLOBE_APP_ENGINE_MINOR 0
 #define GLOBE_APP_ENGINE_PATCH 1
 
+#if defined(VK_USE_PLATFORM_WIN32_KHR)
+const char directory_symbol = '\\';
+#else
+const char directory_symbol = '/';
+#endif
+
+// Written in front of the data returned by vkGetPipelineCacheData.  The data itself already starts with
+// the device's pipeline cache UUID, but not the driver version, and a driver update is exactly when a
+// stale cache is most likely to be around.
+#define GLOBE_PIPELINE_CACHE_FILE_MAGIC 0x43504C47  // "GLPC"
+
+struct GlobePipelineCacheFileHeader {
+    uint32_t magic;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+    uint64_t data_size;
+};
+
 GlobeApp::GlobeApp() {
     _app_version.major = 0;
     _app_version.minor = 0;
@@ -44,6 +67,7 @@ GlobeApp::GlobeApp() {
     _display_overlay = false;
     _overlay = nullptr;
     _uses_staging_buffer = true;
+    _staging_buffer_size = GLOBE_STAGING_BUFFER_DEFAULT_SIZE;
     _google_display_timing_enabled = false;
     _left_mouse_pressed = false;
     _current_frame = 0;
@@ -55,6 +79,7 @@ GlobeApp::GlobeApp() {
     _vk_device = VK_NULL_HANDLE;
     _vk_setup_command_pool = VK_NULL_HANDLE;
     _vk_setup_command_buffer = VK_NULL_HANDLE;
+    _vk_pipeline_cache = VK_NULL_HANDLE;
     _ring_buffer_index = 0;
     _overlay_font_name = "RobotoMono-Regular";
 }
@@ -95,6 +120,9 @@ bool GlobeApp::Init(GlobeInitStruct &init_struct) {
     _app_version.minor = init_struct.version.minor;
     _app_version.patch = init_struct.version.patch;
     _resource_directory = "resources";
+    if (init_struct.staging_buffer_size > 0) {
+        _staging_buffer_size = init_struct.staging_buffer_size;
+    }
 
     // Handle command-line arguments
     size_t max_arg = init_struct.command_line_args.size();
@@ -117,6 +145,15 @@ bool GlobeApp::Init(GlobeInitStruct &init_struct) {
         } else if (init_struct.command_line_args[cur_arg] == "--resource_dir" && not_last_argument) {
             _resource_directory = init_struct.command_line_args[cur_arg + 1];
             ++cur_arg;
+        } else if (init_struct.command_line_args[cur_arg] == "--cache_dir" && not_last_argument) {
+            _cache_directory = init_struct.command_line_args[cur_arg + 1];
+            ++cur_arg;
+        } else if (init_struct.command_line_args[cur_arg] == "--staging_size" && not_last_argument) {
+            uint32_t staging_megabytes = std::stoi(init_struct.command_line_args[cur_arg + 1], &argument_size);
+            if (staging_megabytes > 0) {
+                _staging_buffer_size = static_cast<VkDeviceSize>(staging_megabytes) * 1024 * 1024;
+            }
+            ++cur_arg;
         } else if (init_struct.command_line_args[cur_arg] == "--suppress_popups") {
             logger.EnablePopups(false);
         } else if (init_struct.command_line_args[cur_arg] == "--display_timing") {
@@ -135,7 +172,8 @@ bool GlobeApp::Init(GlobeInitStruct &init_struct) {
         usage_message += _name;
         usage_message +=
             "\t[--resource_dir <directory] [--validate] [--break] [--fullscreen]\n"
-            "\t[--c <framecount>] [--suppress_popups] [--display_timing]\n\n";
+            "\t[--c <framecount>] [--suppress_popups] [--display_timing]\n"
+            "\t[--staging_size <megabytes>] [--cache_dir <directory>]\n\n";
         GlobeLogger::getInstance().LogFatalError(usage_message);
         fflush(stderr);
         return false;
@@ -268,7 +306,10 @@ bool GlobeApp::Init(GlobeInitStruct &init_struct) {
     }
     device_create_info.enabledLayerCount = 0;
     device_create_info.ppEnabledLayerNames = nullptr;
-    device_create_info.pEnabledFeatures = nullptr;  // If specific features are required, pass them in here
+    // Block compressed textures (see GlobeTextureCompression) can only be sampled with the feature enabled.
+    VkPhysicalDeviceFeatures enabled_features = {};
+    enabled_features.textureCompressionBC = _vk_phys_device_features.textureCompressionBC;
+    device_create_info.pEnabledFeatures = &enabled_features;
     device_create_info.enabledExtensionCount = static_cast<uint32_t>(enabled_extensions.size());
     device_create_info.ppEnabledExtensionNames = enabled_extensions.data();
     device_create_info.pNext = next_ptr;
@@ -282,8 +323,14 @@ bool GlobeApp::Init(GlobeInitStruct &init_struct) {
         return false;
     }
 
+    if (!LoadPipelineCache()) {
+        logger.LogFatalError("Failed to create pipeline cache!");
+        return false;
+    }
+
     _globe_resource_mgr =
-        new GlobeResourceManager(this, _resource_directory, _globe_submit_mgr->GetGraphicsQueueIndex());
+        new GlobeResourceManager(this, _resource_directory, _globe_submit_mgr->GetGraphicsQueueIndex(),
+                                 _globe_submit_mgr->GetTransferQueueIndex());
     if (nullptr == _globe_resource_mgr) {
         logger.LogFatalError("Failed to create resource manager!");
         return false;
@@ -415,13 +462,13 @@ bool GlobeApp::PreSetup(VkCommandPool &vk_setup_command_pool, VkCommandBuffer &v
         }
 
         if (!_globe_resource_mgr->AllocateDeviceImageMemory(_depth_buffer.vk_image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                                            _depth_buffer.vk_device_memory,
-                                                            _depth_buffer.vk_allocated_size)) {
+                                                            _depth_buffer.device_memory)) {
             logger.LogFatalError("Failed allocating depth buffer image to memory");
             return false;
         }
 
-        if (VK_SUCCESS != vkBindImageMemory(_vk_device, _depth_buffer.vk_image, _depth_buffer.vk_device_memory, 0)) {
+        if (VK_SUCCESS != vkBindImageMemory(_vk_device, _depth_buffer.vk_image, _depth_buffer.device_memory.vk_memory,
+                                            _depth_buffer.device_memory.vk_offset)) {
             logger.LogFatalError("Failed binding depth buffer image to memory");
             return false;
         }
@@ -488,6 +535,8 @@ void GlobeApp::Resize() {
         // In order to properly resize the window, we must re-create the swapchain
         // AND redo the command buffers, etc.
         CleanupCommandObjects(true);
+        // The device is idle, so anything freed so far, including what was just cleaned up, can go now.
+        _globe_resource_mgr->ReleaseAllDeferredResources();
         _width = _globe_submit_mgr->CurrentWidth();
         _height = _globe_submit_mgr->CurrentHeight();
     }
@@ -497,6 +546,9 @@ void GlobeApp::Resize() {
 void GlobeApp::PreCleanup() { CleanupCommandObjects(false); }
 
 void GlobeApp::PostCleanup() {
+    // The overlay's fonts and pipelines belong to the resource manager.
+    delete _overlay;
+    _overlay = nullptr;
     if (nullptr != _globe_resource_mgr) {
         delete _globe_resource_mgr;
         _globe_resource_mgr = nullptr;
@@ -513,7 +565,7 @@ void GlobeApp::CleanupCommandObjects(bool is_resize) {
     if (!_is_minimized) {
         vkDestroyImageView(_vk_device, _depth_buffer.vk_image_view, nullptr);
         vkDestroyImage(_vk_device, _depth_buffer.vk_image, nullptr);
-        _globe_resource_mgr->FreeDeviceMemory(_depth_buffer.vk_device_memory);
+        _globe_resource_mgr->FreeDeviceMemory(_depth_buffer.device_memory);
 
         if (is_resize) {
             _globe_submit_mgr->Resize();
@@ -629,6 +681,7 @@ bool GlobeApp::UpdateOverlay(uint32_t copy) {
 
 bool GlobeApp::Draw() {
     _current_frame++;
+    _globe_resource_mgr->ReleaseRetiredResources();
     if (_exit_on_frame && _current_frame == _exit_frame) {
         GlobeEvent quit_event(GLOBE_EVENT_QUIT);
         GlobeEventList::getInstance().InsertEvent(quit_event);
@@ -649,6 +702,7 @@ void GlobeApp::Exit() {
     }
     Cleanup();
     vkDeviceWaitIdle(_vk_device);
+    SavePipelineCache();
     if (_globe_submit_mgr) {
         delete _globe_submit_mgr;
         _globe_submit_mgr = nullptr;
@@ -661,6 +715,114 @@ void GlobeApp::Exit() {
     vkDestroyInstance(_vk_instance, nullptr);
 }
 
+// The pipeline cache is stored per application in the cache directory.
+std::string GlobeApp::PipelineCacheFileName() const {
+    std::string file_name = CacheDirectory();
+    file_name += directory_symbol;
+    for (auto cur_char : _name) {
+        file_name += isalnum(static_cast<unsigned char>(cur_char)) ? static_cast<char>(tolower(cur_char)) : '_';
+    }
+    file_name += ".pipeline_cache";
+    return file_name;
+}
+
+bool GlobeApp::LoadPipelineCache() {
+    GlobeLogger &logger = GlobeLogger::getInstance();
+    std::string file_name = PipelineCacheFileName();
+    // The cache contents are handed to the driver straight out of the mapped file.
+    GlobeFileView cache_file;
+    const uint8_t *cache_data = nullptr;
+    size_t cache_data_size = 0;
+    if (cache_file.Open(file_name)) {
+        GlobePipelineCacheFileHeader header = {};
+        if (cache_file.Size() >= sizeof(GlobePipelineCacheFileHeader)) {
+            memcpy(&header, cache_file.Data(), sizeof(GlobePipelineCacheFileHeader));
+        }
+        if (header.magic != GLOBE_PIPELINE_CACHE_FILE_MAGIC) {
+            logger.LogWarning("Ignoring invalid pipeline cache file " + file_name);
+        } else if (header.vendor_id != _vk_phys_device_properties.vendorID ||
+                   header.device_id != _vk_phys_device_properties.deviceID ||
+                   header.driver_version != _vk_phys_device_properties.driverVersion ||
+                   0 != memcmp(header.pipeline_cache_uuid, _vk_phys_device_properties.pipelineCacheUUID,
+                               VK_UUID_SIZE)) {
+            logger.LogInfo("Pipeline cache file " + file_name + " was created by a different device or driver");
+        } else if (0 == header.data_size ||
+                   header.data_size > cache_file.Size() - sizeof(GlobePipelineCacheFileHeader)) {
+            logger.LogWarning("Ignoring truncated pipeline cache file " + file_name);
+        } else {
+            cache_data = cache_file.Data() + sizeof(GlobePipelineCacheFileHeader);
+            cache_data_size = static_cast<size_t>(header.data_size);
+        }
+    }
+
+    VkPipelineCacheCreateInfo pipeline_cache_create_info = {};
+    pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    pipeline_cache_create_info.pNext = nullptr;
+    pipeline_cache_create_info.flags = 0;
+    pipeline_cache_create_info.initialDataSize = cache_data_size;
+    pipeline_cache_create_info.pInitialData = cache_data;
+    if (VK_SUCCESS == vkCreatePipelineCache(_vk_device, &pipeline_cache_create_info, nullptr, &_vk_pipeline_cache)) {
+        if (nullptr != cache_data) {
+            logger.LogInfo("Loaded pipeline cache from " + file_name);
+        }
+        return true;
+    }
+
+    // The driver may still reject the contents, so fall back to an empty cache.
+    if (nullptr != cache_data) {
+        logger.LogWarning("Driver rejected pipeline cache file " + file_name);
+        pipeline_cache_create_info.initialDataSize = 0;
+        pipeline_cache_create_info.pInitialData = nullptr;
+        if (VK_SUCCESS ==
+            vkCreatePipelineCache(_vk_device, &pipeline_cache_create_info, nullptr, &_vk_pipeline_cache)) {
+            return true;
+        }
+    }
+    _vk_pipeline_cache = VK_NULL_HANDLE;
+    return false;
+}
+
+bool GlobeApp::SavePipelineCache() {
+    GlobeLogger &logger = GlobeLogger::getInstance();
+    if (VK_NULL_HANDLE == _vk_pipeline_cache) {
+        return false;
+    }
+
+    bool success = false;
+    size_t data_size = 0;
+    std::vector<uint8_t> cache_data;
+    if (VK_SUCCESS == vkGetPipelineCacheData(_vk_device, _vk_pipeline_cache, &data_size, nullptr) && data_size > 0) {
+        cache_data.resize(data_size);
+        if (VK_SUCCESS != vkGetPipelineCacheData(_vk_device, _vk_pipeline_cache, &data_size, cache_data.data())) {
+            cache_data.clear();
+        }
+    }
+    vkDestroyPipelineCache(_vk_device, _vk_pipeline_cache, nullptr);
+    _vk_pipeline_cache = VK_NULL_HANDLE;
+
+    if (!cache_data.empty()) {
+        GlobePipelineCacheFileHeader header = {};
+        header.magic = GLOBE_PIPELINE_CACHE_FILE_MAGIC;
+        header.vendor_id = _vk_phys_device_properties.vendorID;
+        header.device_id = _vk_phys_device_properties.deviceID;
+        header.driver_version = _vk_phys_device_properties.driverVersion;
+        memcpy(header.pipeline_cache_uuid, _vk_phys_device_properties.pipelineCacheUUID, VK_UUID_SIZE);
+        header.data_size = data_size;
+
+        std::string file_name = PipelineCacheFileName();
+        FILE *file_ptr = fopen(file_name.c_str(), "wb");
+        if (nullptr != file_ptr) {
+            success = 1 == fwrite(&header, sizeof(GlobePipelineCacheFileHeader), 1, file_ptr) &&
+                      1 == fwrite(cache_data.data(), data_size, 1, file_ptr);
+            fclose(file_ptr);
+        }
+        if (!success) {
+            logger.LogWarning("Failed to write pipeline cache file " + file_name);
+        }
+    }
+    return success;
+}
+
 bool GlobeApp::ProcessEvents() {
     std::vector<GlobeEvent> current_events;
     if (GlobeEventList::getInstance().GetEvents(current_events)) {
@@ -23,6 +23,7 @@
 #else
 #include "globe_window.hpp"
 #endif
+#include "globe_basic_types.hpp"
 
 struct GlobeVersion {
     uint8_t major;
@@ -45,13 +46,13 @@ struct GlobeInitStruct {
     uint32_t num_swapchain_buffers;
     VkFormat ideal_swapchain_format;
     VkFormat secondary_swapchain_format;
+    VkDeviceSize staging_buffer_size;  // 0 uses GLOBE_STAGING_BUFFER_DEFAULT_SIZE
 };
 
 struct GlobeDepthBuffer {
     VkFormat vk_format;
     VkImage vk_image;
-    VkDeviceMemory vk_device_memory;
-    VkDeviceSize vk_allocated_size;
+    GlobeDeviceMemory device_memory;
     VkImageView vk_image_view;
 };
 
@@ -82,8 +83,15 @@ class GlobeApp {
         instance = _vk_instance, phys_device = _vk_phys_device, device = _vk_device;
     }
     bool UsesStagingBuffer() const { return _uses_staging_buffer; }
+    VkDeviceSize StagingBufferSize() const { return _staging_buffer_size; }
     GlobeResourceManager *ResourceManager() const { return _globe_resource_mgr; }
     GlobeSubmitManager *SubmitManager() const { return _globe_submit_mgr; }
+    VkPipelineCache GetVkPipelineCache() const { return _vk_pipeline_cache; }
+    // Where generated caches (pipeline cache, model and texture caches) are stored: the cache directory if one was
+    // given on the command line and the resource directory otherwise.
+    const std::string &CacheDirectory() const {
+        return _cache_directory.empty() ? _resource_directory : _cache_directory;
+    }
 
 #if defined(VK_USE_PLATFORM_ANDROID_KHR)
     void SetAndroidNativeWindow(ANativeWindow *android_native_window) {
@@ -98,6 +106,9 @@ class GlobeApp {
     bool PostSetup(VkCommandPool &vk_setup_command_pool, VkCommandBuffer &vk_setup_command_buffer);
     bool ProcessEvents();
     virtual void HandleEvent(GlobeEvent &event);
+    std::string PipelineCacheFileName() const;
+    bool LoadPipelineCache();
+    bool SavePipelineCache();
 
     std::string _name;
     GlobeVersion _app_version;
@@ -120,6 +131,7 @@ class GlobeApp {
     uint32_t _height;
     bool _prepared;
     bool _uses_staging_buffer;
+    VkDeviceSize _staging_buffer_size;
     bool _was_minimized;
     bool _is_minimized;
     bool _focused;
@@ -142,6 +154,7 @@ class GlobeApp {
     uint32_t _swapchain_count;
     VkFormat _vk_swapchain_format;
     VkRenderPass _vk_render_pass;
+    VkPipelineCache _vk_pipeline_cache;
     VkCommandPool _vk_setup_command_pool;
     VkCommandBuffer _vk_setup_command_buffer;
     GlobeDepthBuffer _depth_buffer;
@@ -156,4 +169,5 @@ class GlobeApp {
     ANativeWindow *_android_native_window;
 #endif
     std::string _resource_directory;
+    std::string _cache_directory;
 };
@@ -0,0 +1,120 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_asset_archive.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include <algorithm>
+
+#include "globe_logger.hpp"
+#include "globe_asset_archive.hpp"
+
+std::mutex GlobeAssetArchive::_mount_mutex;
+std::vector<GlobeAssetArchive*> GlobeAssetArchive::_mounted_archives;
+
+GlobeAssetArchive::~GlobeAssetArchive() { Unmount(this); }
+
+bool GlobeAssetArchive::Open(const std::string& archive_file, const std::string& mount_directory) {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    Unmount(this);
+    _entries = nullptr;
+    _names = nullptr;
+    _entry_count = 0;
+    if (!_archive_view.Open(archive_file, GLOBE_FILE_ACCESS_RANDOM)) {
+        return false;
+    }
+
+    const uint8_t* data = _archive_view.Data();
+    size_t size = _archive_view.Size();
+    const GlobeAssetArchiveHeader* header = reinterpret_cast<const GlobeAssetArchiveHeader*>(data);
+    if (size < sizeof(GlobeAssetArchiveHeader) || GLOBE_ASSET_ARCHIVE_MAGIC != header->magic ||
+        GLOBE_ASSET_ARCHIVE_VERSION != header->version) {
+        logger.LogError("GlobeAssetArchive::Open - " + archive_file + " is not a valid asset archive");
+        _archive_view.Close();
+        return false;
+    }
+    uint64_t toc_size = static_cast<uint64_t>(header->entry_count) * sizeof(GlobeAssetArchiveEntry);
+    if (header->toc_offset > size || toc_size > size - header->toc_offset || header->names_offset > size ||
+        header->names_size > size - header->names_offset) {
+        logger.LogError("GlobeAssetArchive::Open - " + archive_file + " is truncated");
+        _archive_view.Close();
+        return false;
+    }
+    _entries = reinterpret_cast<const GlobeAssetArchiveEntry*>(data + header->toc_offset);
+    _names = reinterpret_cast<const char*>(data + header->names_offset);
+    for (uint32_t entry = 0; entry < header->entry_count; ++entry) {
+        const GlobeAssetArchiveEntry& cur_entry = _entries[entry];
+        if (cur_entry.offset > size || cur_entry.size > size - cur_entry.offset ||
+            static_cast<uint64_t>(cur_entry.name_offset) + cur_entry.name_size > header->names_size) {
+            logger.LogError("GlobeAssetArchive::Open - " + archive_file + " has an invalid table of contents");
+            _archive_view.Close();
+            _entries = nullptr;
+            _names = nullptr;
+            return false;
+        }
+    }
+    _entry_count = header->entry_count;
+    _mount_directory = GlobeAssetArchiveNormalizePath(mount_directory);
+    return true;
+}
+
+bool GlobeAssetArchive::Find(const std::string& relative_path, GlobeFileView& view) const {
+    uint64_t path_hash = GlobeAssetArchivePathHash(relative_path);
+    const GlobeAssetArchiveEntry* entries_end = _entries + _entry_count;
+    const GlobeAssetArchiveEntry* entry = std::lower_bound(
+        _entries, entries_end, path_hash,
+        [](const GlobeAssetArchiveEntry& cur_entry, uint64_t hash) { return cur_entry.path_hash < hash; });
+
+    // Different paths may share a hash, so compare the names of every entry with this hash.
+    for (; entry != entries_end && entry->path_hash == path_hash; ++entry) {
+        if (entry->name_size == relative_path.size() &&
+            0 == relative_path.compare(0, relative_path.size(), _names + entry->name_offset, entry->name_size)) {
+            view = _archive_view.SubView(static_cast<size_t>(entry->offset), static_cast<size_t>(entry->size));
+            return true;
+        }
+    }
+    return false;
+}
+
+void GlobeAssetArchive::Mount(GlobeAssetArchive* archive) {
+    std::lock_guard<std::mutex> lock(_mount_mutex);
+    if (nullptr != archive && 0 < archive->_entry_count &&
+        _mounted_archives.end() == std::find(_mounted_archives.begin(), _mounted_archives.end(), archive)) {
+        _mounted_archives.push_back(archive);
+    }
+}
+
+void GlobeAssetArchive::Unmount(GlobeAssetArchive* archive) {
+    std::lock_guard<std::mutex> lock(_mount_mutex);
+    _mounted_archives.erase(std::remove(_mounted_archives.begin(), _mounted_archives.end(), archive),
+                            _mounted_archives.end());
+}
+
+bool GlobeAssetArchive::FindMounted(const std::string& file_name, GlobeFileView& view) {
+    std::lock_guard<std::mutex> lock(_mount_mutex);
+    if (_mounted_archives.empty()) {
+        return false;
+    }
+    std::string normalized_name = GlobeAssetArchiveNormalizePath(file_name);
+    // The most recently mounted archive wins.
+    for (auto archive = _mounted_archives.rbegin(); archive != _mounted_archives.rend(); ++archive) {
+        const std::string& mount_directory = (*archive)->_mount_directory;
+        std::string relative_path;
+        if (mount_directory.empty()) {
+            relative_path = normalized_name;
+        } else if (normalized_name.size() > mount_directory.size() &&
+                   0 == normalized_name.compare(0, mount_directory.size(), mount_directory) &&
+                   '/' == normalized_name[mount_directory.size()]) {
+            relative_path = normalized_name.substr(mount_directory.size() + 1);
+        } else {
+            continue;
+        }
+        if ((*archive)->Find(relative_path, view)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,111 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_asset_archive.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "globe_file_view.hpp"
+
+// Packed asset archive ("globepak") layout, all values little-endian:
+//
+//     GlobeAssetArchiveHeader
+//     GlobeAssetArchiveEntry[entry_count]     sorted by path_hash
+//     char names[names_size]                  entry paths, not null terminated
+//     payloads                                each starting on a GLOBE_ASSET_ARCHIVE_ALIGNMENT boundary
+//
+// Entry paths are relative to the root directory that was packed (for example "textures/lunarg.png") and
+// always use '/' as the separator.  The index sits at the front of the file so a lookup only touches the
+// first few pages, and the payloads are aligned so they can be handed to Vulkan or parsed in place.
+#define GLOBE_ASSET_ARCHIVE_MAGIC 0x4B415045424F4C47ULL  // "GLOBEPAK"
+#define GLOBE_ASSET_ARCHIVE_VERSION 1
+#define GLOBE_ASSET_ARCHIVE_ALIGNMENT 64
+#define GLOBE_ASSET_ARCHIVE_EXTENSION ".globepak"
+
+struct GlobeAssetArchiveHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint64_t toc_offset;
+    uint64_t names_offset;
+    uint64_t names_size;
+};
+
+struct GlobeAssetArchiveEntry {
+    uint64_t path_hash;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t name_offset;
+    uint32_t name_size;
+};
+
+// 64-bit FNV-1a of the normalized entry path.
+inline uint64_t GlobeAssetArchivePathHash(const std::string& path) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char cur_char : path) {
+        hash ^= static_cast<uint8_t>(cur_char);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Converts separators to '/', drops "./" components and duplicate separators.
+inline std::string GlobeAssetArchiveNormalizePath(const std::string& path) {
+    std::string normalized;
+    size_t start = 0;
+    while (start < path.size()) {
+        size_t end = path.find_first_of("/\\", start);
+        if (std::string::npos == end) {
+            end = path.size();
+        }
+        if (end > start && 0 != path.compare(start, end - start, ".")) {
+            if (!normalized.empty()) {
+                normalized += '/';
+            }
+            normalized.append(path, start, end - start);
+        }
+        start = end + 1;
+    }
+    // Keep absolute paths absolute
+    if (!path.empty() && ('/' == path[0] || '\\' == path[0])) {
+        normalized.insert(0, 1, '/');
+    }
+    return normalized;
+}
+
+// A read-only, memory-mapped archive.  Mounting makes GlobeFileView::Open resolve any file below the
+// mount directory out of the archive first, so the loaders pick it up without knowing about it.  Files
+// which aren't in any mounted archive are still opened from disk.
+class GlobeAssetArchive {
+   public:
+    GlobeAssetArchive() : _entries(nullptr), _names(nullptr), _entry_count(0) {}
+    ~GlobeAssetArchive();
+
+    bool Open(const std::string& archive_file, const std::string& mount_directory);
+    bool Find(const std::string& relative_path, GlobeFileView& view) const;
+    uint32_t NumEntries() const { return _entry_count; }
+    const std::string& MountDirectory() const { return _mount_directory; }
+
+    static void Mount(GlobeAssetArchive* archive);
+    static void Unmount(GlobeAssetArchive* archive);
+    static bool FindMounted(const std::string& file_name, GlobeFileView& view);
+
+   private:
+    GlobeFileView _archive_view;
+    const GlobeAssetArchiveEntry* _entries;
+    const char* _names;
+    uint32_t _entry_count;
+    std::string _mount_directory;
+
+    static std::mutex _mount_mutex;
+    static std::vector<GlobeAssetArchive*> _mounted_archives;
+};
@@ -9,6 +9,20 @@
 
 #pragma once
 
+// How a vertex attribute is stored in a model's vertex buffer.  Vertex fetch converts every encoding back to
+// float, so shaders don't change, except that normalized positions are relative to the model's bounding box
+// (see GlobeModel::GetPositionDequantization).  8-bit encodings always take 4 components and 16-bit ones 2 or
+// 4, which keeps attributes 4-byte aligned and in formats every device supports for vertex input.  Normalized
+// encodings clamp, so SNORM suits unit vectors and UNORM suits colors and texture coordinates in [0,1].
+enum GlobeVertexEncoding {
+    GLOBE_VERTEX_ENCODING_FLOAT = 0,
+    GLOBE_VERTEX_ENCODING_HALF,
+    GLOBE_VERTEX_ENCODING_SNORM8,
+    GLOBE_VERTEX_ENCODING_SNORM16,
+    GLOBE_VERTEX_ENCODING_UNORM8,
+    GLOBE_VERTEX_ENCODING_UNORM16,
+};
+
 struct GlobeComponentSizes {
     uint8_t position;
     uint8_t normal;
@@ -20,10 +34,44 @@ struct GlobeComponentSizes {
     uint8_t texcoord[3];
     uint8_t tangent;
     uint8_t bitangent;
+    // GlobeVertexEncoding of each kind of attribute.  Zero initializing the sizes leaves everything float.
+    // Tangents and bitangents use the normal encoding, and shininess is always float.
+    uint8_t position_encoding;
+    uint8_t normal_encoding;
+    uint8_t color_encoding;
+    uint8_t texcoord_encoding;
 };
 
-struct GlobeVulkanBuffer {
-    VkBuffer vk_buffer;
+// A range of device memory sub-allocated by the GlobeResourceManager.  Resources must be bound
+// at vk_offset inside vk_memory.  If the memory is host visible, mapped_data already points at
+// vk_offset inside the persistently mapped block, so no vkMapMemory/vkUnmapMemory is needed.
+struct GlobeDeviceMemory {
     VkDeviceMemory vk_memory;
+    VkDeviceSize vk_offset;
     VkDeviceSize vk_size;
+    uint8_t* mapped_data;
+    uint32_t memory_type_index;
+};
+
+// Whether a loaded resource keeps a host copy of the data it uploaded to the GPU.  A released copy is
+// read back from the asset (or its cache) if the CPU ever needs it again.  GLOBE_HOST_COPY_DEFAULT follows
+// GlobeResourceManager::SetHostCopyPolicy.
+enum GlobeHostCopyPolicy {
+    GLOBE_HOST_COPY_DEFAULT = 0,
+    GLOBE_HOST_COPY_KEEP,
+    GLOBE_HOST_COPY_RELEASE,
+};
+
+// Where model vertex and index buffers live.  Device local buffers are filled through the staging ring,
+// host visible ones are mapped and written directly, which is just as fast on unified memory devices.
+// GLOBE_GEOMETRY_MEMORY_DEFAULT follows GlobeResourceManager::SetGeometryMemoryPolicy.
+enum GlobeGeometryMemoryPolicy {
+    GLOBE_GEOMETRY_MEMORY_DEFAULT = 0,
+    GLOBE_GEOMETRY_MEMORY_HOST_VISIBLE,
+    GLOBE_GEOMETRY_MEMORY_DEVICE_LOCAL,
+};
+
+struct GlobeVulkanBuffer {
+    VkBuffer vk_buffer;
+    GlobeDeviceMemory memory;
 };
@@ -0,0 +1,363 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_block_compressor.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLOBE_BLOCK_COMPRESSOR_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define GLOBE_BLOCK_COMPRESSOR_NEON 1
+#include <arm_neon.h>
+#endif
+
+#include "globe_thread_pool.hpp"
+#include "globe_block_compressor.hpp"
+
+// Roughly how many blocks each band of block rows covers when an image is split across threads.
+#define GLOBE_BLOCK_COMPRESSOR_BLOCKS_PER_BAND 1024
+
+// Per channel minimum and maximum of the 16 RGBA texels of a block.
+static void BlockBounds(const uint8_t* texels, uint8_t* min_color, uint8_t* max_color) {
+#if defined(GLOBE_BLOCK_COMPRESSOR_SSE2)
+    const __m128i* rows = reinterpret_cast<const __m128i*>(texels);
+    __m128i min_texels = _mm_min_epu8(_mm_min_epu8(_mm_loadu_si128(rows), _mm_loadu_si128(rows + 1)),
+                                      _mm_min_epu8(_mm_loadu_si128(rows + 2), _mm_loadu_si128(rows + 3)));
+    __m128i max_texels = _mm_max_epu8(_mm_max_epu8(_mm_loadu_si128(rows), _mm_loadu_si128(rows + 1)),
+                                      _mm_max_epu8(_mm_loadu_si128(rows + 2), _mm_loadu_si128(rows + 3)));
+    min_texels = _mm_min_epu8(min_texels, _mm_shuffle_epi32(min_texels, 0x4E));
+    min_texels = _mm_min_epu8(min_texels, _mm_shuffle_epi32(min_texels, 0xB1));
+    max_texels = _mm_max_epu8(max_texels, _mm_shuffle_epi32(max_texels, 0x4E));
+    max_texels = _mm_max_epu8(max_texels, _mm_shuffle_epi32(max_texels, 0xB1));
+    uint32_t min_value = static_cast<uint32_t>(_mm_cvtsi128_si32(min_texels));
+    uint32_t max_value = static_cast<uint32_t>(_mm_cvtsi128_si32(max_texels));
+    memcpy(min_color, &min_value, 4);
+    memcpy(max_color, &max_value, 4);
+#elif defined(GLOBE_BLOCK_COMPRESSOR_NEON)
+    uint8x16_t min_texels = vminq_u8(vminq_u8(vld1q_u8(texels), vld1q_u8(texels + 16)),
+                                     vminq_u8(vld1q_u8(texels + 32), vld1q_u8(texels + 48)));
+    uint8x16_t max_texels = vmaxq_u8(vmaxq_u8(vld1q_u8(texels), vld1q_u8(texels + 16)),
+                                     vmaxq_u8(vld1q_u8(texels + 32), vld1q_u8(texels + 48)));
+    uint8x8_t min_half = vmin_u8(vget_low_u8(min_texels), vget_high_u8(min_texels));
+    uint8x8_t max_half = vmax_u8(vget_low_u8(max_texels), vget_high_u8(max_texels));
+    min_half = vmin_u8(min_half, vext_u8(min_half, min_half, 4));
+    max_half = vmax_u8(max_half, vext_u8(max_half, max_half, 4));
+    vst1_lane_u32(reinterpret_cast<uint32_t*>(min_color), vreinterpret_u32_u8(min_half), 0);
+    vst1_lane_u32(reinterpret_cast<uint32_t*>(max_color), vreinterpret_u32_u8(max_half), 0);
+#else
+    memcpy(min_color, texels, 4);
+    memcpy(max_color, texels, 4);
+    for (uint32_t texel = 1; texel < 16; ++texel) {
+        for (uint32_t comp = 0; comp < 4; ++comp) {
+            min_color[comp] = std::min(min_color[comp], texels[texel * 4 + comp]);
+            max_color[comp] = std::max(max_color[comp], texels[texel * 4 + comp]);
+        }
+    }
+#endif
+}
+
+// dot(texel - base, direction) for each of the 16 texels of a block.
+static void BlockProjections(const uint8_t* texels, const int16_t* base, const int16_t* direction,
+                             int32_t* projections) {
+#if defined(GLOBE_BLOCK_COMPRESSOR_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i base_pair = _mm_setr_epi16(base[0], base[1], base[2], base[3], base[0], base[1], base[2], base[3]);
+    const __m128i direction_pair = _mm_setr_epi16(direction[0], direction[1], direction[2], direction[3],
+                                                  direction[0], direction[1], direction[2], direction[3]);
+    for (uint32_t texel = 0; texel < 16; texel += 4) {
+        // madd leaves (r + g, b + a) partial sums per texel, which the shuffles pair up for the final add.
+        __m128i four_texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + texel * 4));
+        __m128i low = _mm_madd_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(four_texels, zero), base_pair), direction_pair);
+        __m128i high =
+            _mm_madd_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(four_texels, zero), base_pair), direction_pair);
+        __m128 low_ps = _mm_castsi128_ps(low);
+        __m128 high_ps = _mm_castsi128_ps(high);
+        __m128i even = _mm_castps_si128(_mm_shuffle_ps(low_ps, high_ps, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i odd = _mm_castps_si128(_mm_shuffle_ps(low_ps, high_ps, _MM_SHUFFLE(3, 1, 3, 1)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(projections + texel), _mm_add_epi32(even, odd));
+    }
+#elif defined(GLOBE_BLOCK_COMPRESSOR_NEON)
+    const int16x4_t base_vector = vld1_s16(base);
+    const int16x4_t direction_vector = vld1_s16(direction);
+    for (uint32_t texel = 0; texel < 16; texel += 2) {
+        int16x8_t two_texels = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(texels + texel * 4)));
+        int32x4_t first = vmull_s16(vsub_s16(vget_low_s16(two_texels), base_vector), direction_vector);
+        int32x4_t second = vmull_s16(vsub_s16(vget_high_s16(two_texels), base_vector), direction_vector);
+        int32x2_t first_sum = vpadd_s32(vget_low_s32(first), vget_high_s32(first));
+        int32x2_t second_sum = vpadd_s32(vget_low_s32(second), vget_high_s32(second));
+        vst1_s32(projections + texel, vpadd_s32(first_sum, second_sum));
+    }
+#else
+    for (uint32_t texel = 0; texel < 16; ++texel) {
+        int32_t projection = 0;
+        for (uint32_t comp = 0; comp < 4; ++comp) {
+            projection += (static_cast<int32_t>(texels[texel * 4 + comp]) - base[comp]) * direction[comp];
+        }
+        projections[texel] = projection;
+    }
+#endif
+}
+
+// Maps a projection onto [0, num_steps] of the line between the two endpoints, rounding to the nearest step.
+static inline uint32_t ProjectionStep(int32_t projection, int32_t line_length_squared, int32_t num_steps) {
+    int32_t step = (2 * num_steps * projection + line_length_squared) / (2 * line_length_squared);
+    return static_cast<uint32_t>(std::min(std::max(step, 0), num_steps));
+}
+
+static inline uint16_t PackRgb565(const uint8_t* color) {
+    return static_cast<uint16_t>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+static inline void UnpackRgb565(uint16_t packed, int16_t* color) {
+    int16_t red = (packed >> 11) & 0x1F;
+    int16_t green = (packed >> 5) & 0x3F;
+    int16_t blue = packed & 0x1F;
+    color[0] = static_cast<int16_t>((red << 3) | (red >> 2));
+    color[1] = static_cast<int16_t>((green << 2) | (green >> 4));
+    color[2] = static_cast<int16_t>((blue << 3) | (blue >> 2));
+    color[3] = 0;
+}
+
+// The 8 byte BC1 color block, always in 4 color mode so it is also valid as the color half of BC3.
+static void EncodeBc1Color(const uint8_t* texels, const uint8_t* min_color, const uint8_t* max_color, uint8_t* block) {
+    // Pull the endpoints in a little, the extremes are usually outliers.
+    uint8_t inset_min[4];
+    uint8_t inset_max[4];
+    for (uint32_t comp = 0; comp < 3; ++comp) {
+        uint8_t inset = static_cast<uint8_t>((max_color[comp] - min_color[comp]) >> 4);
+        inset_min[comp] = static_cast<uint8_t>(min_color[comp] + inset);
+        inset_max[comp] = static_cast<uint8_t>(max_color[comp] - inset);
+    }
+    uint16_t color0 = PackRgb565(inset_max);
+    uint16_t color1 = PackRgb565(inset_min);
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        int16_t endpoint0[4];
+        int16_t endpoint1[4];
+        int16_t direction[4];
+        UnpackRgb565(color0, endpoint0);
+        UnpackRgb565(color1, endpoint1);
+        int32_t line_length_squared = 0;
+        for (uint32_t comp = 0; comp < 4; ++comp) {
+            direction[comp] = static_cast<int16_t>(endpoint0[comp] - endpoint1[comp]);
+            line_length_squared += direction[comp] * direction[comp];
+        }
+        int32_t projections[16];
+        BlockProjections(texels, endpoint1, direction, projections);
+        // Steps from color1 (0) to color0 (3) to BC1 palette indices.
+        static const uint32_t step_to_index[4] = {1, 3, 2, 0};
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            indices |= step_to_index[ProjectionStep(projections[texel], line_length_squared, 3)] << (texel * 2);
+        }
+    }
+    block[0] = static_cast<uint8_t>(color0);
+    block[1] = static_cast<uint8_t>(color0 >> 8);
+    block[2] = static_cast<uint8_t>(color1);
+    block[3] = static_cast<uint8_t>(color1 >> 8);
+    memcpy(block + 4, &indices, 4);
+}
+
+// The 8 byte BC3 alpha block, in the 8 alpha mode with the exact alpha range as endpoints.
+static void EncodeBc3Alpha(const uint8_t* texels, uint8_t min_alpha, uint8_t max_alpha, uint8_t* block) {
+    uint64_t indices = 0;
+    if (max_alpha != min_alpha) {
+        int32_t range = max_alpha - min_alpha;
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            uint32_t step = static_cast<uint32_t>(((texels[texel * 4 + 3] - min_alpha) * 14 + range) / (2 * range));
+            // Steps from alpha1 (0) to alpha0 (7) to palette indices, where 2 through 7 run from alpha0 down.
+            uint64_t index = 7 == step ? 0 : (0 == step ? 1 : 8 - step);
+            indices |= index << (texel * 3);
+        }
+    }
+    block[0] = max_alpha;
+    block[1] = min_alpha;
+    for (uint32_t byte = 0; byte < 6; ++byte) {
+        block[2 + byte] = static_cast<uint8_t>(indices >> (byte * 8));
+    }
+}
+
+// Writes values into a 128-bit block from the least significant bit up.
+class GlobeBlockBitWriter {
+   public:
+    GlobeBlockBitWriter() : _position(0) { _bits[0] = _bits[1] = 0; }
+
+    void Write(uint32_t value, uint32_t num_bits) {
+        uint32_t word = _position / 64;
+        uint32_t shift = _position % 64;
+        _bits[word] |= static_cast<uint64_t>(value) << shift;
+        if (shift + num_bits > 64) {
+            _bits[1] |= static_cast<uint64_t>(value) >> (64 - shift);
+        }
+        _position += num_bits;
+    }
+    void Store(uint8_t* block) const {
+        for (uint32_t byte = 0; byte < 16; ++byte) {
+            block[byte] = static_cast<uint8_t>(_bits[byte / 8] >> ((byte % 8) * 8));
+        }
+    }
+
+   private:
+    uint64_t _bits[2];
+    uint32_t _position;
+};
+
+// Closest 7-bit value plus shared low bit for one endpoint, trying both values of the bit.
+static void QuantizeBc7Endpoint(const uint8_t* color, uint8_t* quantized, uint32_t& p_bit) {
+    int32_t best_error = INT32_MAX;
+    for (uint32_t cur_p_bit = 0; cur_p_bit < 2; ++cur_p_bit) {
+        uint8_t cur_quantized[4];
+        int32_t error = 0;
+        for (uint32_t comp = 0; comp < 4; ++comp) {
+            cur_quantized[comp] = static_cast<uint8_t>(std::min((color[comp] - cur_p_bit + 1) >> 1, 127u));
+            error += std::abs(static_cast<int32_t>((cur_quantized[comp] << 1) | cur_p_bit) - color[comp]);
+        }
+        if (error < best_error) {
+            best_error = error;
+            memcpy(quantized, cur_quantized, 4);
+            p_bit = cur_p_bit;
+        }
+    }
+}
+
+// The 16 byte BC7 mode 6 block: one subset, RGBA 7.7.7.7 endpoints each with a p-bit, 4-bit indices.
+static void EncodeBc7Mode6(const uint8_t* texels, const uint8_t* min_color, const uint8_t* max_color,
+                           uint8_t* block) {
+    uint8_t endpoints[2][4];
+    for (uint32_t comp = 0; comp < 4; ++comp) {
+        uint8_t inset = static_cast<uint8_t>((max_color[comp] - min_color[comp]) >> 4);
+        endpoints[0][comp] = static_cast<uint8_t>(min_color[comp] + inset);
+        endpoints[1][comp] = static_cast<uint8_t>(max_color[comp] - inset);
+    }
+    uint8_t quantized[2][4];
+    uint32_t p_bits[2];
+    int16_t expanded[2][4];
+    for (uint32_t endpoint = 0; endpoint < 2; ++endpoint) {
+        QuantizeBc7Endpoint(endpoints[endpoint], quantized[endpoint], p_bits[endpoint]);
+        for (uint32_t comp = 0; comp < 4; ++comp) {
+            expanded[endpoint][comp] = static_cast<int16_t>((quantized[endpoint][comp] << 1) | p_bits[endpoint]);
+        }
+    }
+
+    int16_t direction[4];
+    int32_t line_length_squared = 0;
+    for (uint32_t comp = 0; comp < 4; ++comp) {
+        direction[comp] = static_cast<int16_t>(expanded[1][comp] - expanded[0][comp]);
+        line_length_squared += direction[comp] * direction[comp];
+    }
+    uint32_t indices[16] = {};
+    if (0 != line_length_squared) {
+        int32_t projections[16];
+        BlockProjections(texels, expanded[0], direction, projections);
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            indices[texel] = ProjectionStep(projections[texel], line_length_squared, 15);
+        }
+    }
+    // The first texel's index is stored without its top bit, so it has to be in the lower half.
+    if (indices[0] >= 8) {
+        std::swap(quantized[0], quantized[1]);
+        std::swap(p_bits[0], p_bits[1]);
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            indices[texel] = 15 - indices[texel];
+        }
+    }
+
+    GlobeBlockBitWriter writer;
+    writer.Write(1 << 6, 7);
+    for (uint32_t comp = 0; comp < 4; ++comp) {
+        writer.Write(quantized[0][comp], 7);
+        writer.Write(quantized[1][comp], 7);
+    }
+    writer.Write(p_bits[0], 1);
+    writer.Write(p_bits[1], 1);
+    writer.Write(indices[0], 3);
+    for (uint32_t texel = 1; texel < 16; ++texel) {
+        writer.Write(indices[texel], 4);
+    }
+    writer.Store(block);
+}
+
+GlobeBlockCompressor::GlobeBlockCompressor(GlobeThreadPool* thread_pool, GlobeBlockFormat format)
+    : _thread_pool(thread_pool), _format(format) {}
+
+uint32_t GlobeBlockCompressor::BlockSize(GlobeBlockFormat format) { return GLOBE_BLOCK_FORMAT_BC1 == format ? 8 : 16; }
+
+size_t GlobeBlockCompressor::CompressedSize(GlobeBlockFormat format, uint32_t width, uint32_t height) {
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * BlockSize(format);
+}
+
+const char* GlobeBlockCompressor::SimdPathName() {
+#if defined(GLOBE_BLOCK_COMPRESSOR_SSE2)
+    return "SSE2";
+#elif defined(GLOBE_BLOCK_COMPRESSOR_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+void GlobeBlockCompressor::Compress(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* blocks) const {
+    uint32_t blocks_wide = (width + 3) / 4;
+    uint32_t blocks_high = (height + 3) / 4;
+    uint32_t block_size = BlockSize(_format);
+    uint32_t rows_per_band = std::max(GLOBE_BLOCK_COMPRESSOR_BLOCKS_PER_BAND / blocks_wide, 1u);
+    uint32_t num_bands = (blocks_high + rows_per_band - 1) / rows_per_band;
+    GlobeBlockFormat format = _format;
+
+    std::function<void(uint32_t)> compress_band = [=](uint32_t band) {
+        uint8_t texels[64];
+        uint32_t end_block_row = std::min((band + 1) * rows_per_band, blocks_high);
+        for (uint32_t block_row = band * rows_per_band; block_row < end_block_row; ++block_row) {
+            for (uint32_t block_col = 0; block_col < blocks_wide; ++block_col) {
+                // Gather the block, repeating the last row and column of the image where it runs past them.
+                uint32_t x = block_col * 4;
+                for (uint32_t row = 0; row < 4; ++row) {
+                    uint32_t y = std::min(block_row * 4 + row, height - 1);
+                    const uint8_t* src_row = rgba + (static_cast<size_t>(y) * width) * 4;
+                    if (x + 4 <= width) {
+                        memcpy(texels + row * 16, src_row + x * 4, 16);
+                    } else {
+                        for (uint32_t col = 0; col < 4; ++col) {
+                            memcpy(texels + row * 16 + col * 4, src_row + std::min(x + col, width - 1) * 4, 4);
+                        }
+                    }
+                }
+
+                uint8_t* block = blocks + (static_cast<size_t>(block_row) * blocks_wide + block_col) * block_size;
+                uint8_t min_color[4];
+                uint8_t max_color[4];
+                BlockBounds(texels, min_color, max_color);
+                switch (format) {
+                    case GLOBE_BLOCK_FORMAT_BC1:
+                        EncodeBc1Color(texels, min_color, max_color, block);
+                        break;
+                    case GLOBE_BLOCK_FORMAT_BC3:
+                        EncodeBc3Alpha(texels, min_color[3], max_color[3], block);
+                        EncodeBc1Color(texels, min_color, max_color, block + 8);
+                        break;
+                    case GLOBE_BLOCK_FORMAT_BC7:
+                        EncodeBc7Mode6(texels, min_color, max_color, block);
+                        break;
+                }
+            }
+        }
+    };
+
+    if (nullptr != _thread_pool && num_bands > 1) {
+        _thread_pool->ParallelFor(num_bands, compress_band);
+    } else {
+        for (uint32_t band = 0; band < num_bands; ++band) {
+            compress_band(band);
+        }
+    }
+}
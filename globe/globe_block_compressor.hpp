@@ -0,0 +1,61 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_block_compressor.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class GlobeThreadPool;
+
+enum GlobeBlockFormat {
+    // 4 bits per texel, RGB only (VK_FORMAT_BC1_RGB_UNORM_BLOCK).
+    GLOBE_BLOCK_FORMAT_BC1 = 0,
+    // 8 bits per texel, BC1 color with interpolated alpha (VK_FORMAT_BC3_UNORM_BLOCK).
+    GLOBE_BLOCK_FORMAT_BC3,
+    // 8 bits per texel, only mode 6 (a single RGBA line with 4-bit indices) (VK_FORMAT_BC7_UNORM_BLOCK).
+    GLOBE_BLOCK_FORMAT_BC7,
+};
+
+// Optional block compression of textures loaded from standard image files.  Compressed textures are only
+// used when the device can sample the format and the texture goes through the staging buffer, otherwise the
+// texture stays RGBA8.
+enum GlobeTextureCompression {
+    GLOBE_TEXTURE_COMPRESSION_NONE = 0,
+    // BC1 for opaque images, BC7 (or BC3 when BC7 isn't supported) for images with alpha.
+    GLOBE_TEXTURE_COMPRESSION_AUTO,
+    GLOBE_TEXTURE_COMPRESSION_BC1,
+    GLOBE_TEXTURE_COMPRESSION_BC3,
+    GLOBE_TEXTURE_COMPRESSION_BC7,
+};
+
+// Real-time RGBA8 to BC1/BC3/BC7 encoder.  Every block is range fit: the endpoints come from the (inset)
+// bounding box of the block's colors and each texel gets the palette entry nearest to its projection onto
+// the line between them.  This is a lot faster than an exhaustive search, at some loss of quality on
+// blocks whose colors don't lie along the box diagonal.
+//
+// Images of any size work, partial blocks along the right and bottom edges repeat the last column and
+// row.  Rows of blocks are run across the thread pool like GlobeMipmapGenerator does, and the block
+// bounds and projections use SSE2 or NEON when available.
+class GlobeBlockCompressor {
+   public:
+    GlobeBlockCompressor(GlobeThreadPool* thread_pool, GlobeBlockFormat format);
+
+    // Bytes per 4x4 block.
+    static uint32_t BlockSize(GlobeBlockFormat format);
+    static size_t CompressedSize(GlobeBlockFormat format, uint32_t width, uint32_t height);
+    static const char* SimdPathName();
+
+    // blocks has room for CompressedSize(format, width, height) bytes.
+    void Compress(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* blocks) const;
+
+   private:
+    GlobeThreadPool* _thread_pool;
+    GlobeBlockFormat _format;
+};
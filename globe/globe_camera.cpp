@@ -9,6 +9,7 @@
 
 #include <stdio.h>
 #include <cmath>
+#include <limits>
 
 #include "globe_camera.hpp"
 
@@ -41,3 +42,18 @@ glm::mat4 GlobeCamera::ViewMatrix() {
     glm::mat4 view_mat = glm::eulerAngleYXZ(_camera_orientation.y, _camera_orientation.x, _camera_orientation.z);
     return glm::translate(view_mat, _camera_position);
 }
+
+float GlobeCamera::ProjectedSize(const glm::vec3& center, float size, float viewport_height) {
+    float pixels_per_unit = std::fabs(_projection_matrix[1][1]) * 0.5f * viewport_height;
+    if (0.f == _projection_matrix[2][3]) {
+        return size * pixels_per_unit;
+    }
+
+    // Perspective divides by the view space depth, measured to the nearest point of the bounding sphere.
+    glm::vec4 view_center = ViewMatrix() * glm::vec4(center, 1.f);
+    float depth = -view_center.z - size * 0.5f;
+    if (depth <= 0.f) {
+        return std::numeric_limits<float>::max();
+    }
+    return size * pixels_per_unit / depth;
+}
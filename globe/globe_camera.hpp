@@ -25,6 +25,8 @@ class GlobeCamera {
 
     glm::mat4 ViewMatrix();
     const glm::mat4* ProjectionMatrix() { return &_projection_matrix; }
+    // Height in pixels an object of the given world space size centered at the given point covers on screen.
+    float ProjectedSize(const glm::vec3& center, float size, float viewport_height);
 
    protected:
     glm::mat4 _projection_matrix;
@@ -0,0 +1,259 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_descriptor_allocator.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#include "globe_logger.hpp"
+#include "globe_descriptor_allocator.hpp"
+
+// Pools start out holding this many sets and double with every pool added to a chain, up to the max.
+static const uint32_t globe_descriptor_pool_base_sets = 64;
+static const uint32_t globe_descriptor_pool_max_growth_shift = 6;
+
+// Descriptors of each type per set, enough for the sets this framework tends to build.
+struct GlobeDescriptorPoolRatio {
+    VkDescriptorType vk_descriptor_type;
+    float per_set;
+};
+static const GlobeDescriptorPoolRatio globe_descriptor_pool_ratios[] = {
+    {VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f},
+    {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f},
+    {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1.f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1.f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.f},
+    {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f},
+};
+
+// Frame set pools of a single thread.  Only ever touched by that thread, apart from creation and
+// destruction which happen under the allocator's thread context lock.
+struct GlobeDescriptorThreadContext {
+    struct FrameChain {
+        uint64_t frame_number;
+        GlobeDescriptorAllocator::PoolChain chain;
+    };
+    std::thread::id thread_id;
+    bool has_frame;
+    FrameChain current;
+    std::vector<FrameChain> retired;
+};
+
+// Caches the calling thread's context for the allocator used last, so the lookup normally stays
+// lock-free.  Allocator ids are never reused, so a stale entry can't match a newer allocator.
+static std::atomic<uint64_t> globe_next_descriptor_allocator_id(1);
+static thread_local uint64_t globe_tls_descriptor_allocator_id = 0;
+static thread_local GlobeDescriptorThreadContext* globe_tls_descriptor_thread_context = nullptr;
+
+GlobeDescriptorAllocator::GlobeDescriptorAllocator(VkDevice vk_device)
+    : _allocator_id(globe_next_descriptor_allocator_id++),
+      _vk_device(vk_device),
+      _frame_number(1),
+      _completed_frame(0),
+      _num_pools(0),
+      _num_frame_resets(0) {
+    _persistent_chain.current_pool = 0;
+}
+
+GlobeDescriptorAllocator::~GlobeDescriptorAllocator() {
+    DestroyChain(_persistent_chain);
+    for (auto thread_context : _thread_contexts) {
+        DestroyChain(thread_context->current.chain);
+        for (auto& frame_chain : thread_context->retired) {
+            DestroyChain(frame_chain.chain);
+        }
+        delete thread_context;
+    }
+    _thread_contexts.clear();
+}
+
+bool GlobeDescriptorAllocator::AllocatePersistentSet(VkDescriptorSetLayout vk_descriptor_set_layout,
+                                                     GlobeDescriptorAllocation& allocation) {
+    std::unique_lock<std::mutex> lock(_persistent_mutex);
+    // Sets freed earlier leave holes in older pools, so look through the whole chain before growing it.
+    _persistent_chain.current_pool = 0;
+    return AllocateFromChain(_persistent_chain, true, vk_descriptor_set_layout, allocation);
+}
+
+void GlobeDescriptorAllocator::FreePersistentSet(GlobeDescriptorAllocation& allocation) {
+    if (VK_NULL_HANDLE == allocation.vk_descriptor_set) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(_persistent_mutex);
+    vkFreeDescriptorSets(_vk_device, allocation.vk_descriptor_pool, 1, &allocation.vk_descriptor_set);
+    allocation.vk_descriptor_set = VK_NULL_HANDLE;
+    allocation.vk_descriptor_pool = VK_NULL_HANDLE;
+}
+
+bool GlobeDescriptorAllocator::AllocateFrameSet(VkDescriptorSetLayout vk_descriptor_set_layout,
+                                                VkDescriptorSet& vk_descriptor_set) {
+    GlobeDescriptorThreadContext* thread_context = GetThreadContext();
+    uint64_t frame_number = _frame_number.load(std::memory_order_acquire);
+    if (!thread_context->has_frame || thread_context->current.frame_number != frame_number) {
+        if (thread_context->has_frame) {
+            thread_context->retired.push_back(thread_context->current);
+        }
+
+        // Recycle the oldest chain the GPU is done with, otherwise start a new one.
+        uint64_t completed_frame = _completed_frame.load(std::memory_order_acquire);
+        auto retired_iter = std::find_if(thread_context->retired.begin(), thread_context->retired.end(),
+                                         [completed_frame](const GlobeDescriptorThreadContext::FrameChain& chain) {
+                                             return chain.frame_number <= completed_frame;
+                                         });
+        if (retired_iter != thread_context->retired.end()) {
+            thread_context->current.chain = retired_iter->chain;
+            thread_context->retired.erase(retired_iter);
+            ResetChain(thread_context->current.chain);
+            _num_frame_resets++;
+        } else {
+            thread_context->current.chain = PoolChain();
+            thread_context->current.chain.current_pool = 0;
+        }
+        thread_context->current.frame_number = frame_number;
+        thread_context->has_frame = true;
+    }
+
+    GlobeDescriptorAllocation allocation = {};
+    if (!AllocateFromChain(thread_context->current.chain, false, vk_descriptor_set_layout, allocation)) {
+        return false;
+    }
+    vk_descriptor_set = allocation.vk_descriptor_set;
+    return true;
+}
+
+void GlobeDescriptorAllocator::BeginFrame(uint64_t frame_number, uint64_t completed_frame) {
+    _completed_frame.store(completed_frame, std::memory_order_release);
+    _frame_number.store(frame_number, std::memory_order_release);
+}
+
+GlobeDescriptorThreadContext* GlobeDescriptorAllocator::GetThreadContext() {
+    if (globe_tls_descriptor_allocator_id == _allocator_id) {
+        return globe_tls_descriptor_thread_context;
+    }
+
+    std::unique_lock<std::mutex> lock(_thread_context_mutex);
+    std::thread::id thread_id = std::this_thread::get_id();
+    GlobeDescriptorThreadContext* thread_context = nullptr;
+    for (auto cur_context : _thread_contexts) {
+        if (cur_context->thread_id == thread_id) {
+            thread_context = cur_context;
+            break;
+        }
+    }
+    if (nullptr == thread_context) {
+        thread_context = new GlobeDescriptorThreadContext();
+        thread_context->thread_id = thread_id;
+        thread_context->has_frame = false;
+        thread_context->current.frame_number = 0;
+        thread_context->current.chain.current_pool = 0;
+        _thread_contexts.push_back(thread_context);
+    }
+    globe_tls_descriptor_allocator_id = _allocator_id;
+    globe_tls_descriptor_thread_context = thread_context;
+    return thread_context;
+}
+
+bool GlobeDescriptorAllocator::AllocateFromChain(PoolChain& chain, bool free_individual_sets,
+                                                 VkDescriptorSetLayout vk_descriptor_set_layout,
+                                                 GlobeDescriptorAllocation& allocation) {
+    VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
+    descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptor_set_allocate_info.pNext = nullptr;
+    descriptor_set_allocate_info.descriptorSetCount = 1;
+    descriptor_set_allocate_info.pSetLayouts = &vk_descriptor_set_layout;
+    bool new_pool = false;
+    while (true) {
+        if (chain.current_pool >= chain.vk_descriptor_pools.size()) {
+            uint32_t growth_shift = static_cast<uint32_t>(chain.vk_descriptor_pools.size());
+            growth_shift = std::min(growth_shift, globe_descriptor_pool_max_growth_shift);
+            VkDescriptorPool vk_descriptor_pool =
+                CreatePool(globe_descriptor_pool_base_sets << growth_shift, free_individual_sets);
+            if (VK_NULL_HANDLE == vk_descriptor_pool) {
+                return false;
+            }
+            chain.vk_descriptor_pools.push_back(vk_descriptor_pool);
+            chain.current_pool = static_cast<uint32_t>(chain.vk_descriptor_pools.size() - 1);
+            new_pool = true;
+        }
+
+        descriptor_set_allocate_info.descriptorPool = chain.vk_descriptor_pools[chain.current_pool];
+        VkResult vk_result =
+            vkAllocateDescriptorSets(_vk_device, &descriptor_set_allocate_info, &allocation.vk_descriptor_set);
+        if (VK_SUCCESS == vk_result) {
+            allocation.vk_descriptor_pool = descriptor_set_allocate_info.descriptorPool;
+            return true;
+        }
+        // Vulkan 1.0 drivers without VK_KHR_maintenance1 may report a full pool with other errors.
+        if (VK_ERROR_OUT_OF_POOL_MEMORY != vk_result && VK_ERROR_FRAGMENTED_POOL != vk_result &&
+            VK_ERROR_OUT_OF_DEVICE_MEMORY != vk_result && VK_ERROR_OUT_OF_HOST_MEMORY != vk_result) {
+            GlobeLogger::getInstance().LogError("GlobeDescriptorAllocator failed to allocate descriptor set");
+            return false;
+        }
+        // A set that doesn't fit into a brand new pool never will.
+        if (new_pool) {
+            GlobeLogger::getInstance().LogError("GlobeDescriptorAllocator set layout too large for descriptor pools");
+            return false;
+        }
+        chain.current_pool++;
+    }
+}
+
+VkDescriptorPool GlobeDescriptorAllocator::CreatePool(uint32_t max_sets, bool free_individual_sets) {
+    std::vector<VkDescriptorPoolSize> pool_sizes;
+    for (const auto& ratio : globe_descriptor_pool_ratios) {
+        VkDescriptorPoolSize pool_size = {};
+        pool_size.type = ratio.vk_descriptor_type;
+        pool_size.descriptorCount = std::max(1u, static_cast<uint32_t>(ratio.per_set * max_sets));
+        pool_sizes.push_back(pool_size);
+    }
+    VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.pNext = nullptr;
+    descriptor_pool_create_info.flags = free_individual_sets ? VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT : 0;
+    descriptor_pool_create_info.maxSets = max_sets;
+    descriptor_pool_create_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    descriptor_pool_create_info.pPoolSizes = pool_sizes.data();
+    VkDescriptorPool vk_descriptor_pool = VK_NULL_HANDLE;
+    if (VK_SUCCESS != vkCreateDescriptorPool(_vk_device, &descriptor_pool_create_info, nullptr, &vk_descriptor_pool)) {
+        GlobeLogger::getInstance().LogError("GlobeDescriptorAllocator failed to create descriptor pool");
+        return VK_NULL_HANDLE;
+    }
+    _num_pools++;
+    return vk_descriptor_pool;
+}
+
+void GlobeDescriptorAllocator::ResetChain(PoolChain& chain) {
+    for (auto vk_descriptor_pool : chain.vk_descriptor_pools) {
+        vkResetDescriptorPool(_vk_device, vk_descriptor_pool, 0);
+    }
+    chain.current_pool = 0;
+}
+
+void GlobeDescriptorAllocator::DestroyChain(PoolChain& chain) {
+    for (auto vk_descriptor_pool : chain.vk_descriptor_pools) {
+        vkDestroyDescriptorPool(_vk_device, vk_descriptor_pool, nullptr);
+    }
+    _num_pools -= static_cast<uint32_t>(chain.vk_descriptor_pools.size());
+    chain.vk_descriptor_pools.clear();
+    chain.current_pool = 0;
+}
+
+void GlobeDescriptorAllocator::LogStats() const {
+    std::string perf_msg = "Descriptor allocator: ";
+    perf_msg += std::to_string(_num_pools.load());
+    perf_msg += " pools, ";
+    perf_msg += std::to_string(_num_frame_resets.load());
+    perf_msg += " frame pool resets";
+    GlobeLogger::getInstance().LogPerf(perf_msg);
+}
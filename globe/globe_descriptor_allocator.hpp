@@ -0,0 +1,76 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_descriptor_allocator.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "vulkan/vulkan_core.h"
+
+struct GlobeDescriptorThreadContext;
+
+struct GlobeDescriptorAllocation {
+    VkDescriptorSet vk_descriptor_set;
+    VkDescriptorPool vk_descriptor_pool;
+};
+
+// Hands out descriptor sets from chains of general purpose descriptor pools.  When the current pool of
+// a chain runs dry, the next one is used and, past the end of the chain, a new (larger) pool is added,
+// so nobody has to size pools up front.
+//
+// Persistent sets live until they are freed with FreePersistentSet.  They come from one shared chain
+// guarded by a mutex, since they're normally only allocated while loading.
+//
+// Frame sets are only good for the frame being recorded and are never freed individually.  Every
+// thread gets its own chains for them, so threads recording in parallel allocate without taking a
+// lock.  Once the frame a chain was used for has completed on the GPU, the whole chain is recycled with
+// vkResetDescriptorPool the next time that thread allocates.  BeginFrame must be called by the thread
+// driving the frames, while no other thread is allocating frame sets.
+class GlobeDescriptorAllocator {
+   public:
+    GlobeDescriptorAllocator(VkDevice vk_device);
+    ~GlobeDescriptorAllocator();
+
+    bool AllocatePersistentSet(VkDescriptorSetLayout vk_descriptor_set_layout, GlobeDescriptorAllocation& allocation);
+    void FreePersistentSet(GlobeDescriptorAllocation& allocation);
+
+    bool AllocateFrameSet(VkDescriptorSetLayout vk_descriptor_set_layout, VkDescriptorSet& vk_descriptor_set);
+    void BeginFrame(uint64_t frame_number, uint64_t completed_frame);
+
+    uint32_t NumPools() const { return _num_pools; }
+    void LogStats() const;
+
+   private:
+    struct PoolChain {
+        std::vector<VkDescriptorPool> vk_descriptor_pools;
+        uint32_t current_pool;
+    };
+
+    GlobeDescriptorThreadContext* GetThreadContext();
+    bool AllocateFromChain(PoolChain& chain, bool free_individual_sets, VkDescriptorSetLayout vk_descriptor_set_layout,
+                           GlobeDescriptorAllocation& allocation);
+    VkDescriptorPool CreatePool(uint32_t max_sets, bool free_individual_sets);
+    void ResetChain(PoolChain& chain);
+    void DestroyChain(PoolChain& chain);
+
+    friend struct GlobeDescriptorThreadContext;
+
+    uint64_t _allocator_id;
+    VkDevice _vk_device;
+    std::mutex _persistent_mutex;
+    PoolChain _persistent_chain;
+    std::mutex _thread_context_mutex;
+    std::vector<GlobeDescriptorThreadContext*> _thread_contexts;
+    std::atomic<uint64_t> _frame_number;
+    std::atomic<uint64_t> _completed_frame;
+    std::atomic<uint32_t> _num_pools;
+    std::atomic<uint64_t> _num_frame_resets;
+};
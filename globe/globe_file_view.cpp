@@ -0,0 +1,135 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_file_view.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+
+#include "globe_logger.hpp"
+#include "globe_file_view.hpp"
+#include "globe_asset_archive.hpp"
+
+struct GlobeFileMapping {
+    GlobeFileMapping() : data(nullptr), size(0) {}
+    ~GlobeFileMapping() {
+        if (nullptr != data) {
+#if defined(_WIN32)
+            UnmapViewOfFile(data);
+#else
+            munmap(data, size);
+#endif
+        }
+    }
+    void* data;
+    size_t size;
+};
+
+bool GlobeFileView::Open(const std::string& file_name, GlobeFileAccessPattern access) {
+    Close();
+    // Files packed into a mounted archive are served from the archive's mapping.
+    if (GlobeAssetArchive::FindMounted(file_name, *this)) {
+        return true;
+    }
+    std::shared_ptr<GlobeFileMapping> mapping = std::make_shared<GlobeFileMapping>();
+#if defined(_WIN32)
+    DWORD flags = (GLOBE_FILE_ACCESS_SEQUENTIAL == access) ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+    HANDLE file_handle =
+        CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (INVALID_HANDLE_VALUE == file_handle) {
+        return false;
+    }
+    LARGE_INTEGER file_size = {};
+    if (!GetFileSizeEx(file_handle, &file_size)) {
+        CloseHandle(file_handle);
+        return false;
+    }
+    mapping->size = static_cast<size_t>(file_size.QuadPart);
+    if (mapping->size > 0) {
+        HANDLE mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (nullptr != mapping_handle) {
+            mapping->data = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+            // The view keeps the mapping object alive on its own.
+            CloseHandle(mapping_handle);
+        }
+    }
+    CloseHandle(file_handle);
+#else
+    int file_descriptor = open(file_name.c_str(), O_RDONLY);
+    if (file_descriptor < 0) {
+        return false;
+    }
+    struct stat file_stat = {};
+    if (0 != fstat(file_descriptor, &file_stat)) {
+        close(file_descriptor);
+        return false;
+    }
+    mapping->size = static_cast<size_t>(file_stat.st_size);
+    if (mapping->size > 0) {
+        void* data = mmap(nullptr, mapping->size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+        if (MAP_FAILED != data) {
+            mapping->data = data;
+            madvise(data, mapping->size, (GLOBE_FILE_ACCESS_SEQUENTIAL == access) ? MADV_SEQUENTIAL : MADV_RANDOM);
+            madvise(data, mapping->size, MADV_WILLNEED);
+        }
+    }
+    // The mapping holds its own reference to the file.
+    close(file_descriptor);
+#endif
+    if (mapping->size > 0 && nullptr == mapping->data) {
+        std::string error_msg = "GlobeFileView::Open failed to map file ";
+        error_msg += file_name;
+        GlobeLogger::getInstance().LogError(error_msg);
+        return false;
+    }
+    _mapping = mapping;
+    _data = static_cast<const uint8_t*>(mapping->data);
+    _size = mapping->size;
+    return true;
+}
+
+void GlobeFileView::Close() {
+    _mapping.reset();
+    _data = nullptr;
+    _size = 0;
+}
+
+GlobeFileView GlobeFileView::SubView(size_t offset, size_t size) const {
+    GlobeFileView sub_view;
+    if (nullptr == _mapping || offset > _size || size > _size - offset) {
+        return sub_view;
+    }
+    sub_view._mapping = _mapping;
+    sub_view._data = _data + offset;
+    sub_view._size = size;
+    return sub_view;
+}
+
+uint64_t GlobeHashData(const uint8_t* data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    size_t word_count = size / sizeof(uint64_t);
+    for (size_t word = 0; word < word_count; ++word) {
+        uint64_t value;
+        memcpy(&value, data + word * sizeof(uint64_t), sizeof(uint64_t));
+        hash ^= value;
+        hash *= 1099511628211ULL;
+    }
+    for (size_t byte = word_count * sizeof(uint64_t); byte < size; ++byte) {
+        hash ^= data[byte];
+        hash *= 1099511628211ULL;
+    }
+    hash ^= size;
+    hash *= 1099511628211ULL;
+    return hash;
+}
@@ -0,0 +1,50 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_file_view.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+enum GlobeFileAccessPattern {
+    GLOBE_FILE_ACCESS_SEQUENTIAL = 0,
+    GLOBE_FILE_ACCESS_RANDOM,
+};
+
+struct GlobeFileMapping;
+
+// Read-only view of a file mapped into memory, so loaders can parse (or hand to Vulkan) the file contents
+// in place instead of reading them into heap buffers first.  The access pattern is passed on to the OS
+// as a paging hint and the whole file is requested up front, so the reads overlap with whatever the
+// loader does first.
+//
+// If the file is part of a mounted GlobeAssetArchive, the view points into the archive instead.
+//
+// Views are cheap to copy.  Copies and sub-views keep the mapping alive, it goes away with the last one.
+// A mapping starts on a page boundary, so the data of a view is as aligned as its offset into the file.
+class GlobeFileView {
+   public:
+    GlobeFileView() : _data(nullptr), _size(0) {}
+
+    bool Open(const std::string& file_name, GlobeFileAccessPattern access = GLOBE_FILE_ACCESS_SEQUENTIAL);
+    void Close();
+    bool IsOpen() const { return nullptr != _mapping; }
+    const uint8_t* Data() const { return _data; }
+    size_t Size() const { return _size; }
+    GlobeFileView SubView(size_t offset, size_t size) const;
+
+   private:
+    std::shared_ptr<GlobeFileMapping> _mapping;
+    const uint8_t* _data;
+    size_t _size;
+};
+
+// Word-wise FNV-1a of a block of data, used to check that generated caches still match their source files.
+uint64_t GlobeHashData(const uint8_t* data, size_t size);
@@ -8,6 +8,7 @@
 //
 
 #include <cstring>
+#include <utility>
 
 #include "globe_logger.hpp"
 #include "globe_event.hpp"
@@ -15,22 +16,27 @@
 #include "globe_shader.hpp"
 #include "globe_font.hpp"
 #include "globe_resource_manager.hpp"
+#include "globe_pipeline_cache.hpp"
+#include "globe_layout_cache.hpp"
+#include "globe_sampler_cache.hpp"
+#include "globe_file_view.hpp"
 #include "globe_app.hpp"
 
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "stb_truetype.h"
 
-GlobeFont* GlobeFont::GenerateFont(GlobeResourceManager* resource_manager, GlobeSubmitManager* submit_manager,
+GlobeFont* GlobeFont::GenerateFont(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
                                    VkDevice vk_device, const std::string& font_name, GlobeFontData& font_data) {
     GlobeLogger& logger = GlobeLogger::getInstance();
-    if (!InitFromContent(resource_manager, submit_manager, vk_device, font_name, font_data.texture_data)) {
+    if (!InitFromContent(resource_manager, upload_batch, vk_device, font_name, font_data.texture_data)) {
         std::string error_message = "GenerateFont - Failed to setting up font for Vulkan \"";
         error_message += font_name;
         error_message += "\"";
         logger.LogError(error_message);
+        FreeContent(font_data.texture_data);
         return nullptr;
     }
-    delete font_data.texture_data.standard_data;
+    FreeContent(font_data.texture_data);
 
     GlobeFont* font = new GlobeFont(resource_manager, vk_device, font_name, &font_data);
     if (nullptr == font) {
@@ -40,9 +46,19 @@ GlobeFont* GlobeFont::GenerateFont(GlobeResourceManager* resource_manager, Globe
     return font;
 }
 
-GlobeFont* GlobeFont::LoadFontMap(GlobeResourceManager* resource_manager, GlobeSubmitManager* submit_manager,
+GlobeFont* GlobeFont::LoadFontMap(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
                                   VkDevice vk_device, float character_pixel_size, const std::string& font_name,
                                   const std::string& directory) {
+    GlobeFontData font_data = {};
+    if (!LoadFontMapContent(resource_manager, character_pixel_size, font_name, directory, font_data)) {
+        return nullptr;
+    }
+    return GenerateFont(resource_manager, upload_batch, vk_device, font_name, font_data);
+}
+
+bool GlobeFont::LoadFontMapContent(GlobeResourceManager* resource_manager, float character_pixel_size,
+                                   const std::string& font_name, const std::string& directory,
+                                   GlobeFontData& font_data) {
 #if (defined(VK_USE_PLATFORM_IOS_MVK) || defined(VK_USE_PLATFORM_MACOS_MVK) || defined(__ANDROID__))
 // filename = [[[NSBundle mainBundle] resourcePath] stringByAppendingPathComponent:@(filename.c_str())].UTF8String;
 #error("Unsupported platform")
@@ -51,35 +67,26 @@ GlobeFont* GlobeFont::LoadFontMap(GlobeResourceManager* resource_manager, GlobeS
     // https://stackoverflow.com/questions/51276586/how-to-render-text-in-directx9-with-stb-truetype
     // http://www.cs.unh.edu/~cs770/lwjgl-javadoc/lwjgl-stb/org/lwjgl/stb/STBTruetype.html#stbtt_GetCodepointBitmapBox-org.lwjgl.stb.STBTTFontinfo-int-float-float-java.nio.IntBuffer-java.nio.IntBuffer-java.nio.IntBuffer-java.nio.IntBuffer-
     GlobeLogger& logger = GlobeLogger::getInstance();
-    GlobeFontData font_data = {};
     std::string font_file_name = directory;
     font_file_name += font_name;
     font_file_name += ".ttf";
 
-    FILE* file_ptr = fopen(font_file_name.c_str(), "rb");
-    if (nullptr == file_ptr) {
+    // stb_truetype reads the glyph data straight out of the mapped file.
+    GlobeFileView font_file;
+    if (!font_file.Open(font_file_name, GLOBE_FILE_ACCESS_RANDOM)) {
         std::string error_string = "LoadFontMap - Failed to open file ";
         error_string += font_file_name;
         logger.LogError(error_string);
-        return nullptr;
+        return false;
     }
 
-    // Determine how big the file is and then read it.
-    fseek(file_ptr, 0, SEEK_END);
-    size_t file_size = ftell(file_ptr);
-    fseek(file_ptr, 0, SEEK_SET);
-    std::vector<uint8_t> file_contents;
-    file_contents.resize(file_size);
-    fread(file_contents.data(), file_size, 1, file_ptr);
-    fclose(file_ptr);
-
     // Initialize the font based on the file contents
     stbtt_fontinfo font_info = {};
-    if (!stbtt_InitFont(&font_info, file_contents.data(), 0)) {
+    if (!stbtt_InitFont(&font_info, font_file.Data(), 0)) {
         std::string error_string = "LoadFontMap - loading font contents for file ";
         error_string += font_file_name;
         logger.LogError(error_string);
-        return nullptr;
+        return false;
     }
 
     // Reserve enough space for the font bitmap for 100 characters of
@@ -206,12 +213,14 @@ GlobeFont* GlobeFont::LoadFontMap(GlobeResourceManager* resource_manager, GlobeS
         std::string error_string = "LoadFontMap - loading font contents for file ";
         error_string += font_file_name;
         logger.LogError(error_string);
-        return nullptr;
+        return false;
     }
 
     font_data.texture_data.width = bitmap_width;
     font_data.texture_data.height = bitmap_height;
     font_data.texture_data.num_mip_levels = 1;
+    font_data.texture_data.blit_mipmaps = false;
+    font_data.texture_data.array_layers = 0;
     font_data.texture_data.vk_format = VK_FORMAT_R8G8B8A8_UNORM;
     font_data.texture_data.vk_format_props = resource_manager->GetVkFormatProperties(font_data.texture_data.vk_format);
     GlobeTextureLevel level_data = {};
@@ -219,19 +228,12 @@ GlobeFont* GlobeFont::LoadFontMap(GlobeResourceManager* resource_manager, GlobeS
     level_data.height = bitmap_height;
     level_data.data_size = bitmap_width * bitmap_height * 4;
     font_data.texture_data.standard_data->levels.push_back(level_data);
-    font_data.texture_data.standard_data->raw_data.resize(level_data.data_size);
-    uint8_t* dst_ptr = reinterpret_cast<uint8_t*>(font_data.texture_data.standard_data->raw_data.data());
-    uint8_t* src_ptr = font_bitmap.data();
-    for (int32_t row = 0; row < static_cast<int32_t>(font_data.texture_data.height); ++row) {
-        for (int32_t col = 0; col < static_cast<int32_t>(font_data.texture_data.width); ++col) {
-            *dst_ptr++ = *src_ptr;
-            *dst_ptr++ = *src_ptr;
-            *dst_ptr++ = *src_ptr++;
-            *dst_ptr++ = 255;
-        }
-    }
+    // The glyphs stay single channel, they are expanded to RGBA while being copied to the GPU.
+    font_bitmap.resize(static_cast<size_t>(bitmap_width) * bitmap_height);
+    font_data.texture_data.standard_data->raw_data = std::move(font_bitmap);
+    font_data.texture_data.standard_data->conversion = GLOBE_PIXEL_CONVERSION_GRAY_TO_RGBA;
 
-    return GenerateFont(resource_manager, submit_manager, vk_device, font_name, font_data);
+    return true;
 #endif
 }
 
@@ -242,7 +244,7 @@ GlobeFont::GlobeFont(GlobeResourceManager* resource_manager, VkDevice vk_device,
     _char_data = std::move(font_data->char_data);
     _vk_descriptor_set_layout = VK_NULL_HANDLE;
     _vk_pipeline_layout = VK_NULL_HANDLE;
-    _vk_descriptor_pool = VK_NULL_HANDLE;
+    _descriptor_allocation = {};
     _vk_descriptor_set = VK_NULL_HANDLE;
     _vk_pipeline = VK_NULL_HANDLE;
 }
@@ -255,66 +257,32 @@ GlobeFont::~GlobeFont() {
 bool GlobeFont::LoadIntoRenderPass(VkRenderPass render_pass, float viewport_width, float viewport_height) {
     GlobeLogger& logger = GlobeLogger::getInstance();
 
-    VkDescriptorSetLayoutBinding descriptor_set_layout_binding = {};
-    descriptor_set_layout_binding.binding = 1;
-    descriptor_set_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptor_set_layout_binding.descriptorCount = 1;
-    descriptor_set_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-    descriptor_set_layout_binding.pImmutableSamplers = nullptr;
-
-    VkDescriptorSetLayoutCreateInfo descriptor_set_layout = {};
-    descriptor_set_layout.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    descriptor_set_layout.pNext = nullptr;
-    descriptor_set_layout.bindingCount = 1;
-    descriptor_set_layout.pBindings = &descriptor_set_layout_binding;
-    if (VK_SUCCESS !=
-        vkCreateDescriptorSetLayout(_vk_device, &descriptor_set_layout, nullptr, &_vk_descriptor_set_layout)) {
-        logger.LogError("GlobeFont failed to create descriptor set layout");
-        return false;
-    }
-
-    VkPushConstantRange push_constant_range = {};
-    push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    push_constant_range.offset = 0;
-    push_constant_range.size = sizeof(glm::mat4);
-
-    VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
-    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipeline_layout_create_info.pNext = nullptr;
-    pipeline_layout_create_info.setLayoutCount = 1;
-    pipeline_layout_create_info.pSetLayouts = &_vk_descriptor_set_layout;
-    pipeline_layout_create_info.pushConstantRangeCount = 1;
-    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
-    if (VK_SUCCESS != vkCreatePipelineLayout(_vk_device, &pipeline_layout_create_info, nullptr, &_vk_pipeline_layout)) {
-        logger.LogError("GlobeFont failed to create pipeline layout layout");
+    GlobeShader* font_shader = _globe_resource_mgr->LoadShader("poscolortex_pushmat");
+    if (nullptr == font_shader) {
+        logger.LogError("GlobeFont failed to load poscolortex_pushmat shaders");
         return false;
     }
 
-    VkDescriptorPoolSize pool_size = {};
-    pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    pool_size.descriptorCount = 1;
-    VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
-    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    descriptor_pool_create_info.pNext = nullptr;
-    descriptor_pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-    descriptor_pool_create_info.maxSets = 1;
-    descriptor_pool_create_info.poolSizeCount = 1;
-    descriptor_pool_create_info.pPoolSizes = &pool_size;
-    if (VK_SUCCESS != vkCreateDescriptorPool(_vk_device, &descriptor_pool_create_info, nullptr, &_vk_descriptor_pool)) {
-        logger.LogError("GlobeFont failed to create descriptor pool");
+    // The layouts come from the shader's reflected interface and are shared with anything else using it.  The
+    // glyph texture is always sampled the same way, so its sampler is baked into the layout as well.
+    std::vector<VkDescriptorSetLayout> set_layouts;
+    VkSamplerCreateInfo sampler_create_info = GlobeSamplerCache::DefaultCreateInfo(1.0f);
+    if (!_globe_resource_mgr->GetLayoutCache()->GetShaderLayouts(font_shader, set_layouts, _vk_pipeline_layout, false,
+                                                                 &sampler_create_info) ||
+        set_layouts.size() != 1) {
+        logger.LogError("GlobeFont failed to create pipeline layout");
+        _globe_resource_mgr->FreeShader(font_shader);
         return false;
     }
+    _vk_descriptor_set_layout = set_layouts[0];
 
-    VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
-    descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    descriptor_set_allocate_info.pNext = NULL;
-    descriptor_set_allocate_info.descriptorPool = _vk_descriptor_pool;
-    descriptor_set_allocate_info.descriptorSetCount = 1;
-    descriptor_set_allocate_info.pSetLayouts = &_vk_descriptor_set_layout;
-    if (VK_SUCCESS != vkAllocateDescriptorSets(_vk_device, &descriptor_set_allocate_info, &_vk_descriptor_set)) {
+    if (!_globe_resource_mgr->GetDescriptorAllocator()->AllocatePersistentSet(_vk_descriptor_set_layout,
+                                                                               _descriptor_allocation)) {
         logger.LogError("GlobeFont failed to allocate descriptor set");
+        _globe_resource_mgr->FreeShader(font_shader);
         return false;
     }
+    _vk_descriptor_set = _descriptor_allocation.vk_descriptor_set;
 
     VkDescriptorImageInfo image_info = {};
     image_info.sampler = GetVkSampler();
@@ -436,11 +404,6 @@ bool GlobeFont::LoadIntoRenderPass(VkRenderPass render_pass, float viewport_widt
     pipeline_multisample_state_create_info.pSampleMask = nullptr;
     pipeline_multisample_state_create_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
-    GlobeShader* font_shader = _globe_resource_mgr->LoadShader("poscolortex_pushmat");
-    if (nullptr == font_shader) {
-        logger.LogError("GlobeFont failed to load poscolortex_pushmat shaders");
-        return false;
-    }
     std::vector<VkPipelineShaderStageCreateInfo> pipeline_shader_stage_create_info;
     font_shader->GetPipelineShaderStages(pipeline_shader_stage_create_info);
 
@@ -458,9 +421,10 @@ bool GlobeFont::LoadIntoRenderPass(VkRenderPass render_pass, float viewport_widt
     gfx_pipeline_create_info.pStages = pipeline_shader_stage_create_info.data();
     gfx_pipeline_create_info.renderPass = render_pass;
     gfx_pipeline_create_info.pDynamicState = nullptr;
-    if (VK_SUCCESS !=
-        vkCreateGraphicsPipelines(_vk_device, VK_NULL_HANDLE, 1, &gfx_pipeline_create_info, nullptr, &_vk_pipeline)) {
+    _vk_pipeline = _globe_resource_mgr->GetPipelineCache()->GetGraphicsPipeline(gfx_pipeline_create_info);
+    if (VK_NULL_HANDLE == _vk_pipeline) {
         logger.LogError("GlobeFont failed to create graphics pipeline");
+        _globe_resource_mgr->FreeShader(font_shader);
         return false;
     }
 
@@ -468,27 +432,24 @@ bool GlobeFont::LoadIntoRenderPass(VkRenderPass render_pass, float viewport_widt
     return true;
 }
 
+// The pipeline and layouts belong to the resource manager's caches and may be shared with other fonts,
+// so only the references are dropped here.
 void GlobeFont::UnloadFromRenderPass() {
     if (VK_NULL_HANDLE != _vk_pipeline) {
-        vkDestroyPipeline(_vk_device, _vk_pipeline, nullptr);
+        _globe_resource_mgr->GetPipelineCache()->ReleaseGraphicsPipeline(_vk_pipeline);
         _vk_pipeline = VK_NULL_HANDLE;
     }
     if (VK_NULL_HANDLE != _vk_descriptor_set) {
-        vkFreeDescriptorSets(_vk_device, _vk_descriptor_pool, 1, &_vk_descriptor_set);
+        GlobeDescriptorAllocator* descriptor_allocator = _globe_resource_mgr->GetDescriptorAllocator();
+        GlobeDescriptorAllocation descriptor_allocation = _descriptor_allocation;
+        _globe_resource_mgr->DeferredFree([descriptor_allocator, descriptor_allocation]() mutable {
+            descriptor_allocator->FreePersistentSet(descriptor_allocation);
+        });
+        _descriptor_allocation = {};
         _vk_descriptor_set = VK_NULL_HANDLE;
     }
-    if (VK_NULL_HANDLE != _vk_descriptor_pool) {
-        vkDestroyDescriptorPool(_vk_device, _vk_descriptor_pool, nullptr);
-        _vk_descriptor_pool = VK_NULL_HANDLE;
-    }
-    if (VK_NULL_HANDLE != _vk_pipeline_layout) {
-        vkDestroyPipelineLayout(_vk_device, _vk_pipeline_layout, nullptr);
-        _vk_pipeline_layout = VK_NULL_HANDLE;
-    }
-    if (_vk_descriptor_set_layout != VK_NULL_HANDLE) {
-        vkDestroyDescriptorSetLayout(_vk_device, _vk_descriptor_set_layout, nullptr);
-        _vk_descriptor_set_layout = VK_NULL_HANDLE;
-    }
+    _vk_pipeline_layout = VK_NULL_HANDLE;
+    _vk_descriptor_set_layout = VK_NULL_HANDLE;
 }
 
 int32_t GlobeFont::AddStaticString(const std::string& text_string, const glm::vec3& fg_color, const glm::vec4& bg_color,
@@ -627,20 +588,19 @@ int32_t GlobeFont::AddStaticString(const std::string& text_string, const glm::ve
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 string_data.vertex_buffer.vk_buffer,
                 (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                string_data.vertex_buffer.vk_memory, string_data.vertex_buffer.vk_size)) {
+                string_data.vertex_buffer.memory)) {
             logger.LogError("AddStaticString: Failed to allocate vertex buffer memory");
             return false;
         }
-        uint8_t* mapped_data;
-        if (VK_SUCCESS != vkMapMemory(_vk_device, string_data.vertex_buffer.vk_memory, 0,
-                                      string_data.vertex_buffer.vk_size, 0, (void**)&mapped_data)) {
+        uint8_t* mapped_data = string_data.vertex_buffer.memory.mapped_data;
+        if (nullptr == mapped_data) {
             logger.LogError("AddStaticString: Failed to map vertex buffer memory");
             return false;
         }
         memcpy(mapped_data, string_data.vertex_data.data(), string_data.vertex_data.size() * sizeof(float));
-        vkUnmapMemory(_vk_device, string_data.vertex_buffer.vk_memory);
         if (VK_SUCCESS != vkBindBufferMemory(_vk_device, string_data.vertex_buffer.vk_buffer,
-                                             string_data.vertex_buffer.vk_memory, 0)) {
+                                             string_data.vertex_buffer.memory.vk_memory,
+                                             string_data.vertex_buffer.memory.vk_offset)) {
             logger.LogError("AddStaticString: Failed to bind vertex buffer memory");
             return false;
         }
@@ -655,23 +615,24 @@ int32_t GlobeFont::AddStaticString(const std::string& text_string, const glm::ve
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 string_data.index_buffer.vk_buffer,
                 (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                string_data.index_buffer.vk_memory, string_data.index_buffer.vk_size)) {
+                string_data.index_buffer.memory)) {
             logger.LogError("AddStaticString: Failed to allocate index buffer memory");
             return false;
         }
-        if (VK_SUCCESS != vkMapMemory(_vk_device, string_data.index_buffer.vk_memory, 0,
-                                      string_data.index_buffer.vk_size, 0, (void**)&mapped_data)) {
+        mapped_data = string_data.index_buffer.memory.mapped_data;
+        if (nullptr == mapped_data) {
             logger.LogError("AddStaticString: Failed to map index buffer memory");
             return false;
         }
         memcpy(mapped_data, string_data.index_data.data(), string_data.index_data.size() * sizeof(uint32_t));
-        vkUnmapMemory(_vk_device, string_data.index_buffer.vk_memory);
         if (VK_SUCCESS !=
-            vkBindBufferMemory(_vk_device, string_data.index_buffer.vk_buffer, string_data.index_buffer.vk_memory, 0)) {
+            vkBindBufferMemory(_vk_device, string_data.index_buffer.vk_buffer,
+                               string_data.index_buffer.memory.vk_memory, string_data.index_buffer.memory.vk_offset)) {
             logger.LogError("AddStaticString: Failed to bind index buffer memory");
             return false;
         }
 
+        TrackStringHostCopy(string_data);
         string_index = static_cast<int32_t>(_string_data.size());
         _string_data.push_back(string_data);
     }
@@ -819,20 +780,19 @@ int32_t GlobeFont::AddDynamicString(const std::string& text_string, const glm::v
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 string_data.vertex_buffer.vk_buffer,
                 (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                string_data.vertex_buffer.vk_memory, string_data.vertex_buffer.vk_size)) {
+                string_data.vertex_buffer.memory)) {
             logger.LogError("AddDynamicString: Failed to allocate vertex buffer memory");
             return false;
         }
-        uint8_t* mapped_data;
-        if (VK_SUCCESS != vkMapMemory(_vk_device, string_data.vertex_buffer.vk_memory, 0,
-                                      string_data.vertex_buffer.vk_size, 0, (void**)&mapped_data)) {
+        uint8_t* mapped_data = string_data.vertex_buffer.memory.mapped_data;
+        if (nullptr == mapped_data) {
             logger.LogError("AddDynamicString: Failed to map vertex buffer memory");
             return false;
         }
         memcpy(mapped_data, string_data.vertex_data.data(), string_data.vertex_data.size() * sizeof(float));
-        vkUnmapMemory(_vk_device, string_data.vertex_buffer.vk_memory);
         if (VK_SUCCESS != vkBindBufferMemory(_vk_device, string_data.vertex_buffer.vk_buffer,
-                                             string_data.vertex_buffer.vk_memory, 0)) {
+                                             string_data.vertex_buffer.memory.vk_memory,
+                                             string_data.vertex_buffer.memory.vk_offset)) {
             logger.LogError("AddDynamicString: Failed to bind vertex buffer memory");
             return false;
         }
@@ -847,23 +807,24 @@ int32_t GlobeFont::AddDynamicString(const std::string& text_string, const glm::v
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 string_data.index_buffer.vk_buffer,
                 (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                string_data.index_buffer.vk_memory, string_data.index_buffer.vk_size)) {
+                string_data.index_buffer.memory)) {
             logger.LogError("AddDynamicString: Failed to allocate index buffer memory");
             return false;
         }
-        if (VK_SUCCESS != vkMapMemory(_vk_device, string_data.index_buffer.vk_memory, 0,
-                                      string_data.index_buffer.vk_size, 0, (void**)&mapped_data)) {
+        mapped_data = string_data.index_buffer.memory.mapped_data;
+        if (nullptr == mapped_data) {
             logger.LogError("AddDynamicString: Failed to map index buffer memory");
             return false;
         }
         memcpy(mapped_data, string_data.index_data.data(), string_data.index_data.size() * sizeof(uint32_t));
-        vkUnmapMemory(_vk_device, string_data.index_buffer.vk_memory);
         if (VK_SUCCESS !=
-            vkBindBufferMemory(_vk_device, string_data.index_buffer.vk_buffer, string_data.index_buffer.vk_memory, 0)) {
+            vkBindBufferMemory(_vk_device, string_data.index_buffer.vk_buffer,
+                               string_data.index_buffer.memory.vk_memory, string_data.index_buffer.memory.vk_offset)) {
             logger.LogError("AddDynamicString: Failed to bind index buffer memory");
             return false;
         }
 
+        TrackStringHostCopy(string_data);
         string_index = static_cast<int32_t>(_string_data.size());
         _string_data.push_back(string_data);
     }
@@ -889,9 +850,8 @@ bool GlobeFont::UpdateStringText(int32_t string_index, const std::string& text_s
             logger.LogError("UpdateStringText - Attempting to update past valid copy");
             return false;
         }
-        float* mapped_data;
-        if (VK_SUCCESS != vkMapMemory(_vk_device, string_data.vertex_buffer.vk_memory, 0,
-                                      string_data.vertex_buffer.vk_size, 0, (void**)&mapped_data)) {
+        float* mapped_data = reinterpret_cast<float*>(string_data.vertex_buffer.memory.mapped_data);
+        if (nullptr == mapped_data) {
             logger.LogError("UpdateStringText - Failed to map vertex buffer memory");
             return false;
         }
@@ -909,15 +869,10 @@ bool GlobeFont::UpdateStringText(int32_t string_index, const std::string& text_s
             mapped_data[mapped_index + 61] = char_data->top_v;
             mapped_index += 64;
         }
-        vkUnmapMemory(_vk_device, string_data.vertex_buffer.vk_memory);
-
-        // TODO: This is only needed if memory is not host coherent.
-        VkMappedMemoryRange memoryRange = {};
-        memoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        memoryRange.memory = string_data.vertex_buffer.vk_memory;
-        memoryRange.size = VK_WHOLE_SIZE;
-        memoryRange.offset = 0;
-        vkFlushMappedMemoryRanges(_vk_device, 1, &memoryRange);
+
+        // Only does any work if the memory is not host coherent.
+        VkDeviceSize copy_size = string_data.vertex_size_per_copy * sizeof(float);
+        _globe_resource_mgr->FlushDeviceMemory(string_data.vertex_buffer.memory, copy_size * copy, copy_size);
         return true;
     }
 
@@ -933,16 +888,34 @@ void GlobeFont::RemoveString(int32_t string_index) {
             vkDestroyBuffer(_vk_device, _string_data[string_index].index_buffer.vk_buffer, nullptr);
             _string_data[string_index].index_buffer.vk_buffer = VK_NULL_HANDLE;
         }
-        _globe_resource_mgr->FreeDeviceMemory(_string_data[string_index].index_buffer.vk_memory);
+        _globe_resource_mgr->FreeDeviceMemory(_string_data[string_index].index_buffer.memory);
         if (VK_NULL_HANDLE != _string_data[string_index].vertex_buffer.vk_buffer) {
             vkDestroyBuffer(_vk_device, _string_data[string_index].vertex_buffer.vk_buffer, nullptr);
             _string_data[string_index].vertex_buffer.vk_buffer = VK_NULL_HANDLE;
         }
-        _globe_resource_mgr->FreeDeviceMemory(_string_data[string_index].vertex_buffer.vk_memory);
+        _globe_resource_mgr->FreeDeviceMemory(_string_data[string_index].vertex_buffer.memory);
+        _globe_resource_mgr->UntrackHostCopy(StringHostCopySize(_string_data[string_index]));
         _string_data.erase(_string_data.begin() + string_index);
     }
 }
 
+uint64_t GlobeFont::StringHostCopySize(const GlobeFontStringData& string_data) {
+    return string_data.vertex_data.size() * sizeof(float) + string_data.index_data.size() * sizeof(uint32_t);
+}
+
+// Strings are drawn and updated straight out of their mapped buffers, so the host copy is only kept when
+// the resource manager's host copy policy asks for it.
+void GlobeFont::TrackStringHostCopy(GlobeFontStringData& string_data) {
+    uint64_t host_copy_size = StringHostCopySize(string_data);
+    if (GLOBE_HOST_COPY_RELEASE == _globe_resource_mgr->HostCopyPolicy()) {
+        std::vector<float>().swap(string_data.vertex_data);
+        std::vector<uint32_t>().swap(string_data.index_data);
+        _globe_resource_mgr->TrackHostCopy(0, host_copy_size);
+    } else {
+        _globe_resource_mgr->TrackHostCopy(host_copy_size, 0);
+    }
+}
+
 void GlobeFont::RemoveAllStrings() {
     while (_string_data.size()) {
         RemoveString(0);
@@ -16,6 +16,7 @@
 #include "globe_texture.hpp"
 #include "globe_basic_types.hpp"
 #include "globe_glm_include.hpp"
+#include "globe_descriptor_allocator.hpp"
 
 #define GLOBE_FONT_STARTING_ASCII_CHAR 32
 #define GLOBE_FONT_ENDING_ASCII_CHAR 126
@@ -50,9 +51,15 @@ struct GlobeFontStringData {
 
 class GlobeFont : public GlobeTexture {
    public:
-    static GlobeFont* LoadFontMap(GlobeResourceManager* resource_manager, GlobeSubmitManager* submit_manager,
+    static GlobeFont* LoadFontMap(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
                                   VkDevice vk_device, float character_pixel_size, const std::string& font_name,
                                   const std::string& directory);
+    // CPU stage of LoadFontMap (file read and glyph rasterization), safe to run on a worker thread.
+    static bool LoadFontMapContent(GlobeResourceManager* resource_manager, float character_pixel_size,
+                                   const std::string& font_name, const std::string& directory,
+                                   GlobeFontData& font_data);
+    static GlobeFont* GenerateFont(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
+                                   VkDevice vk_device, const std::string& font_name, GlobeFontData& font_data);
 
     GlobeFont(GlobeResourceManager* resource_manager, VkDevice vk_device, const std::string& font_name,
               GlobeFontData* font_data);
@@ -74,8 +81,8 @@ class GlobeFont : public GlobeTexture {
     float Size() { return _generated_size; }
 
    private:
-    static GlobeFont* GenerateFont(GlobeResourceManager* resource_manager, GlobeSubmitManager* submit_manager,
-                                   VkDevice vk_device, const std::string& font_name, GlobeFontData& font_data);
+    static uint64_t StringHostCopySize(const GlobeFontStringData& string_data);
+    void TrackStringHostCopy(GlobeFontStringData& string_data);
 
     std::string _font_name;
     float _generated_size;
@@ -83,7 +90,7 @@ class GlobeFont : public GlobeTexture {
     std::vector<GlobeFontStringData> _string_data;
     VkDescriptorSetLayout _vk_descriptor_set_layout;
     VkPipelineLayout _vk_pipeline_layout;
-    VkDescriptorPool _vk_descriptor_pool;
+    GlobeDescriptorAllocation _descriptor_allocation;
     VkDescriptorSet _vk_descriptor_set;
     VkPipeline _vk_pipeline;
 };
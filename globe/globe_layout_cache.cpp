@@ -0,0 +1,206 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_layout_cache.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include <algorithm>
+
+#include "globe_logger.hpp"
+#include "globe_file_view.hpp"
+#include "globe_shader.hpp"
+#include "globe_sampler_cache.hpp"
+#include "globe_layout_cache.hpp"
+
+template <typename T>
+static void AppendToKey(std::string& key, const T& value) {
+    key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+GlobeLayoutCache::GlobeLayoutCache(VkDevice vk_device, GlobeSamplerCache* sampler_cache)
+    : _vk_device(vk_device), _sampler_cache(sampler_cache), _num_hits(0), _num_misses(0) {}
+
+GlobeLayoutCache::~GlobeLayoutCache() {
+    for (auto& pipeline_layout : _pipeline_layouts) {
+        vkDestroyPipelineLayout(_vk_device, pipeline_layout.second, nullptr);
+    }
+    _pipeline_layouts.clear();
+    _pipeline_layout_hashes.clear();
+    for (auto& descriptor_set_layout : _descriptor_set_layouts) {
+        vkDestroyDescriptorSetLayout(_vk_device, descriptor_set_layout.second, nullptr);
+    }
+    _descriptor_set_layouts.clear();
+    for (auto immutable_sampler : _immutable_samplers) {
+        _sampler_cache->ReleaseSampler(immutable_sampler);
+    }
+    _immutable_samplers.clear();
+}
+
+VkDescriptorSetLayout GlobeLayoutCache::GetDescriptorSetLayout(
+    const std::vector<VkDescriptorSetLayoutBinding>& bindings) {
+    // Binding order doesn't matter to Vulkan, so don't let it matter to the key either.
+    std::vector<VkDescriptorSetLayoutBinding> sorted_bindings = bindings;
+    std::sort(sorted_bindings.begin(), sorted_bindings.end(),
+              [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+                  return a.binding < b.binding;
+              });
+    std::string key;
+    for (const auto& binding : sorted_bindings) {
+        AppendToKey(key, binding.binding);
+        AppendToKey(key, binding.descriptorType);
+        AppendToKey(key, binding.descriptorCount);
+        AppendToKey(key, binding.stageFlags);
+        // Samplers come from the sampler cache, so their handles identify their state.
+        uint32_t num_immutable_samplers = nullptr != binding.pImmutableSamplers ? binding.descriptorCount : 0;
+        AppendToKey(key, num_immutable_samplers);
+        for (uint32_t sampler = 0; sampler < num_immutable_samplers; ++sampler) {
+            AppendToKey(key, binding.pImmutableSamplers[sampler]);
+        }
+    }
+    auto layout_iter = _descriptor_set_layouts.find(key);
+    if (layout_iter != _descriptor_set_layouts.end()) {
+        _num_hits++;
+        return layout_iter->second;
+    }
+
+    _num_misses++;
+    VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = {};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.pNext = nullptr;
+    descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(sorted_bindings.size());
+    descriptor_set_layout_create_info.pBindings = sorted_bindings.data();
+    VkDescriptorSetLayout vk_descriptor_set_layout = VK_NULL_HANDLE;
+    if (VK_SUCCESS != vkCreateDescriptorSetLayout(_vk_device, &descriptor_set_layout_create_info, nullptr,
+                                                  &vk_descriptor_set_layout)) {
+        GlobeLogger::getInstance().LogError("GlobeLayoutCache failed to create descriptor set layout");
+        return VK_NULL_HANDLE;
+    }
+    _descriptor_set_layouts[key] = vk_descriptor_set_layout;
+    return vk_descriptor_set_layout;
+}
+
+VkPipelineLayout GlobeLayoutCache::GetPipelineLayout(const std::vector<VkDescriptorSetLayout>& set_layouts,
+                                                     const std::vector<VkPushConstantRange>& push_constant_ranges) {
+    // Set layouts all come from this cache, so their handles already identify their contents.
+    std::string key;
+    AppendToKey(key, static_cast<uint32_t>(set_layouts.size()));
+    for (const auto& set_layout : set_layouts) {
+        AppendToKey(key, set_layout);
+    }
+    for (const auto& push_constant_range : push_constant_ranges) {
+        AppendToKey(key, push_constant_range.stageFlags);
+        AppendToKey(key, push_constant_range.offset);
+        AppendToKey(key, push_constant_range.size);
+    }
+    auto layout_iter = _pipeline_layouts.find(key);
+    if (layout_iter != _pipeline_layouts.end()) {
+        _num_hits++;
+        return layout_iter->second;
+    }
+
+    _num_misses++;
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.pNext = nullptr;
+    pipeline_layout_create_info.setLayoutCount = static_cast<uint32_t>(set_layouts.size());
+    pipeline_layout_create_info.pSetLayouts = set_layouts.data();
+    pipeline_layout_create_info.pushConstantRangeCount = static_cast<uint32_t>(push_constant_ranges.size());
+    pipeline_layout_create_info.pPushConstantRanges = push_constant_ranges.data();
+    VkPipelineLayout vk_pipeline_layout = VK_NULL_HANDLE;
+    if (VK_SUCCESS != vkCreatePipelineLayout(_vk_device, &pipeline_layout_create_info, nullptr, &vk_pipeline_layout)) {
+        GlobeLogger::getInstance().LogError("GlobeLayoutCache failed to create pipeline layout");
+        return VK_NULL_HANDLE;
+    }
+    _pipeline_layouts[key] = vk_pipeline_layout;
+    _pipeline_layout_hashes[vk_pipeline_layout] =
+        GlobeHashData(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+    return vk_pipeline_layout;
+}
+
+bool GlobeLayoutCache::GetPipelineLayoutHash(VkPipelineLayout vk_pipeline_layout, uint64_t& hash) const {
+    auto hash_iter = _pipeline_layout_hashes.find(vk_pipeline_layout);
+    if (hash_iter == _pipeline_layout_hashes.end()) {
+        return false;
+    }
+    hash = hash_iter->second;
+    return true;
+}
+
+bool GlobeLayoutCache::GetShaderLayouts(const GlobeShader* shader, std::vector<VkDescriptorSetLayout>& set_layouts,
+                                        VkPipelineLayout& pipeline_layout, bool dynamic_uniform_buffers,
+                                        const VkSamplerCreateInfo* immutable_sampler_info) {
+    set_layouts.clear();
+    pipeline_layout = VK_NULL_HANDLE;
+
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>> set_bindings;
+    if (nullptr == shader || !shader->GetDescriptorSetLayoutBindings(set_bindings)) {
+        return false;
+    }
+
+    // One array of the sampler is enough for every binding, since they all point at the same handle.
+    std::vector<VkSampler> immutable_samplers;
+    if (nullptr != immutable_sampler_info) {
+        VkSampler immutable_sampler = _sampler_cache->AcquireSampler(*immutable_sampler_info);
+        if (VK_NULL_HANDLE == immutable_sampler) {
+            return false;
+        }
+        if (!_immutable_samplers.insert(immutable_sampler).second) {
+            _sampler_cache->ReleaseSampler(immutable_sampler);
+        }
+        uint32_t max_descriptor_count = 0;
+        for (const auto& bindings : set_bindings) {
+            for (const auto& binding : bindings) {
+                max_descriptor_count = std::max(max_descriptor_count, binding.descriptorCount);
+            }
+        }
+        immutable_samplers.assign(max_descriptor_count, immutable_sampler);
+    }
+
+    for (auto& bindings : set_bindings) {
+        if (!immutable_samplers.empty()) {
+            for (auto& binding : bindings) {
+                if (VK_DESCRIPTOR_TYPE_SAMPLER == binding.descriptorType ||
+                    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER == binding.descriptorType) {
+                    binding.pImmutableSamplers = immutable_samplers.data();
+                }
+            }
+        }
+        if (dynamic_uniform_buffers) {
+            for (auto& binding : bindings) {
+                if (VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER == binding.descriptorType) {
+                    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+                }
+            }
+        }
+        VkDescriptorSetLayout vk_descriptor_set_layout = GetDescriptorSetLayout(bindings);
+        if (VK_NULL_HANDLE == vk_descriptor_set_layout) {
+            set_layouts.clear();
+            return false;
+        }
+        set_layouts.push_back(vk_descriptor_set_layout);
+    }
+
+    std::vector<VkPushConstantRange> push_constant_ranges;
+    VkPushConstantRange push_constant_range;
+    if (shader->GetPushConstantRange(push_constant_range)) {
+        push_constant_ranges.push_back(push_constant_range);
+    }
+    pipeline_layout = GetPipelineLayout(set_layouts, push_constant_ranges);
+    return VK_NULL_HANDLE != pipeline_layout;
+}
+
+void GlobeLayoutCache::LogStats() const {
+    std::string perf_msg = "Layout cache: ";
+    perf_msg += std::to_string(_descriptor_set_layouts.size());
+    perf_msg += " descriptor set layouts, ";
+    perf_msg += std::to_string(_pipeline_layouts.size());
+    perf_msg += " pipeline layouts, ";
+    perf_msg += std::to_string(_num_hits);
+    perf_msg += " hits, ";
+    perf_msg += std::to_string(_num_misses);
+    perf_msg += " misses";
+    GlobeLogger::getInstance().LogPerf(perf_msg);
+}
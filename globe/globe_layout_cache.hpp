@@ -0,0 +1,63 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_layout_cache.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "vulkan/vulkan_core.h"
+
+class GlobeShader;
+class GlobeSamplerCache;
+
+// Hands out descriptor set layouts and pipeline layouts keyed on their contents, so every shader with
+// the same interface ends up with the very same VkDescriptorSetLayout and VkPipelineLayout handles.
+// Pipelines built from those shaders are then layout compatible, descriptor sets can be bound once and
+// reused across them, and the pipeline cache sees identical layout handles.
+//
+// The cache owns every layout it returns; they stay alive until the cache is destroyed.  Immutable
+// samplers are keyed on their handles, so they should come out of the GlobeSamplerCache.
+class GlobeLayoutCache {
+   public:
+    GlobeLayoutCache(VkDevice vk_device, GlobeSamplerCache* sampler_cache);
+    ~GlobeLayoutCache();
+
+    VkDescriptorSetLayout GetDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+    VkPipelineLayout GetPipelineLayout(const std::vector<VkDescriptorSetLayout>& set_layouts,
+                                       const std::vector<VkPushConstantRange>& push_constant_ranges);
+
+    // Builds the layouts out of the shader's reflected SPIR-V interface.  Sets the shader skips over
+    // get an empty layout.  SPIR-V can't express dynamic offsets, so dynamic_uniform_buffers turns
+    // every uniform buffer binding into VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC.  A non-null
+    // immutable_sampler_info bakes that sampler into every sampler and combined image sampler binding;
+    // the cache keeps a reference on it for as long as it keeps the layouts.
+    bool GetShaderLayouts(const GlobeShader* shader, std::vector<VkDescriptorSetLayout>& set_layouts,
+                          VkPipelineLayout& pipeline_layout, bool dynamic_uniform_buffers = false,
+                          const VkSamplerCreateInfo* immutable_sampler_info = nullptr);
+
+    // Content hash of a pipeline layout this cache handed out, which the pipeline cache keys pipelines on.
+    bool GetPipelineLayoutHash(VkPipelineLayout vk_pipeline_layout, uint64_t& hash) const;
+
+    uint32_t NumDescriptorSetLayouts() const { return static_cast<uint32_t>(_descriptor_set_layouts.size()); }
+    uint32_t NumPipelineLayouts() const { return static_cast<uint32_t>(_pipeline_layouts.size()); }
+    void LogStats() const;
+
+   private:
+    VkDevice _vk_device;
+    GlobeSamplerCache* _sampler_cache;
+    std::unordered_set<VkSampler> _immutable_samplers;
+    std::unordered_map<std::string, VkDescriptorSetLayout> _descriptor_set_layouts;
+    std::unordered_map<std::string, VkPipelineLayout> _pipeline_layouts;
+    std::unordered_map<VkPipelineLayout, uint64_t> _pipeline_layout_hashes;
+    uint64_t _num_hits;
+    uint64_t _num_misses;
+};
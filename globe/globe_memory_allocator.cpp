@@ -0,0 +1,311 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_memory_allocator.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include <chrono>
+
+#include "globe_logger.hpp"
+#include "globe_memory_allocator.hpp"
+
+static inline VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static inline VkDeviceSize AlignDown(VkDeviceSize value, VkDeviceSize alignment) {
+    return value / alignment * alignment;
+}
+
+GlobeMemoryAllocator::GlobeMemoryAllocator(VkPhysicalDevice vk_physical_device, VkDevice vk_device,
+                                           VkDeviceSize block_size) {
+    _vk_device = vk_device;
+    _block_size = block_size;
+    _allocation_count = 0;
+    _used_bytes = 0;
+    _total_allocations = 0;
+    _total_allocation_ns = 0;
+    _max_allocation_ns = 0;
+
+    VkPhysicalDeviceProperties vk_physical_device_properties = {};
+    vkGetPhysicalDeviceProperties(vk_physical_device, &vk_physical_device_properties);
+    _buffer_image_granularity = vk_physical_device_properties.limits.bufferImageGranularity;
+    _non_coherent_atom_size = vk_physical_device_properties.limits.nonCoherentAtomSize;
+    if (_buffer_image_granularity == 0) {
+        _buffer_image_granularity = 1;
+    }
+    if (_non_coherent_atom_size == 0) {
+        _non_coherent_atom_size = 1;
+    }
+    vkGetPhysicalDeviceMemoryProperties(vk_physical_device, &_vk_memory_properties);
+}
+
+GlobeMemoryAllocator::~GlobeMemoryAllocator() {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    if (_allocation_count > 0) {
+        std::string warning_msg = "GlobeMemoryAllocator destroyed with ";
+        warning_msg += std::to_string(_allocation_count);
+        warning_msg += " allocations still outstanding";
+        logger.LogWarning(warning_msg);
+    }
+    for (uint32_t type = 0; type < VK_MAX_MEMORY_TYPES; ++type) {
+        for (auto block : _blocks[type]) {
+            if (nullptr != block->mapped_data) {
+                vkUnmapMemory(_vk_device, block->vk_memory);
+            }
+            vkFreeMemory(_vk_device, block->vk_memory, nullptr);
+            delete block;
+        }
+        _blocks[type].clear();
+    }
+}
+
+VkDeviceSize GlobeMemoryAllocator::BlockSizeForType(uint32_t memory_type_index) const {
+    // Don't let a single block eat too much of a small heap
+    uint32_t heap_index = _vk_memory_properties.memoryTypes[memory_type_index].heapIndex;
+    VkDeviceSize block_size = _block_size;
+    if (_vk_memory_properties.memoryHeaps[heap_index].size / 8 < block_size) {
+        block_size = _vk_memory_properties.memoryHeaps[heap_index].size / 8;
+    }
+    return block_size;
+}
+
+GlobeMemoryAllocator::MemoryBlock* GlobeMemoryAllocator::CreateBlock(uint32_t memory_type_index, VkDeviceSize size) {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    VkMemoryAllocateInfo vk_memory_alloc_info = {};
+    vk_memory_alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    vk_memory_alloc_info.pNext = nullptr;
+    vk_memory_alloc_info.allocationSize = size;
+    vk_memory_alloc_info.memoryTypeIndex = memory_type_index;
+    VkDeviceMemory vk_memory = VK_NULL_HANDLE;
+    if (VK_SUCCESS != vkAllocateMemory(_vk_device, &vk_memory_alloc_info, nullptr, &vk_memory)) {
+        std::string error_msg = "GlobeMemoryAllocator::CreateBlock failed allocating ";
+        error_msg += std::to_string(size);
+        error_msg += " bytes from memory type ";
+        error_msg += std::to_string(memory_type_index);
+        logger.LogError(error_msg);
+        return nullptr;
+    }
+
+    // Host visible blocks stay mapped for their whole lifetime so that every sub-allocation
+    // can be written without its own vkMapMemory call (which is only allowed once per memory object).
+    uint8_t* mapped_data = nullptr;
+    if (_vk_memory_properties.memoryTypes[memory_type_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (VK_SUCCESS != vkMapMemory(_vk_device, vk_memory, 0, VK_WHOLE_SIZE, 0, (void**)&mapped_data)) {
+            logger.LogError("GlobeMemoryAllocator::CreateBlock failed mapping host visible block");
+            vkFreeMemory(_vk_device, vk_memory, nullptr);
+            return nullptr;
+        }
+    }
+
+    MemoryBlock* block = new MemoryBlock();
+    block->vk_memory = vk_memory;
+    block->size = size;
+    block->mapped_data = mapped_data;
+    block->allocation_count = 0;
+    FreeRange whole_block = {0, size};
+    block->free_ranges.push_back(whole_block);
+    _blocks[memory_type_index].push_back(block);
+    return block;
+}
+
+bool GlobeMemoryAllocator::SubAllocate(MemoryBlock* block, VkDeviceSize size, VkDeviceSize alignment,
+                                       VkDeviceSize& offset) {
+    // First fit through the sorted free list
+    for (uint32_t range_index = 0; range_index < block->free_ranges.size(); ++range_index) {
+        FreeRange& range = block->free_ranges[range_index];
+        VkDeviceSize aligned_offset = AlignUp(range.offset, alignment);
+        VkDeviceSize padding = aligned_offset - range.offset;
+        if (range.size < padding || range.size - padding < size) {
+            continue;
+        }
+        VkDeviceSize remaining = range.size - padding - size;
+        if (padding > 0 && remaining > 0) {
+            // Keep the leading padding in this range and insert the trailing remainder after it
+            FreeRange trailing = {aligned_offset + size, remaining};
+            range.size = padding;
+            block->free_ranges.insert(block->free_ranges.begin() + range_index + 1, trailing);
+        } else if (padding > 0) {
+            range.size = padding;
+        } else if (remaining > 0) {
+            range.offset = aligned_offset + size;
+            range.size = remaining;
+        } else {
+            block->free_ranges.erase(block->free_ranges.begin() + range_index);
+        }
+        offset = aligned_offset;
+        block->allocation_count++;
+        return true;
+    }
+    return false;
+}
+
+void GlobeMemoryAllocator::ReleaseRange(MemoryBlock* block, VkDeviceSize offset, VkDeviceSize size) {
+    std::vector<FreeRange>& ranges = block->free_ranges;
+    uint32_t insert_index = 0;
+    while (insert_index < ranges.size() && ranges[insert_index].offset < offset) {
+        insert_index++;
+    }
+    FreeRange released = {offset, size};
+    ranges.insert(ranges.begin() + insert_index, released);
+
+    // Merge with the following range, then with the preceding one
+    if (insert_index + 1 < ranges.size() &&
+        ranges[insert_index].offset + ranges[insert_index].size == ranges[insert_index + 1].offset) {
+        ranges[insert_index].size += ranges[insert_index + 1].size;
+        ranges.erase(ranges.begin() + insert_index + 1);
+    }
+    if (insert_index > 0 && ranges[insert_index - 1].offset + ranges[insert_index - 1].size == offset) {
+        ranges[insert_index - 1].size += ranges[insert_index].size;
+        ranges.erase(ranges.begin() + insert_index);
+    }
+    block->allocation_count--;
+}
+
+bool GlobeMemoryAllocator::Allocate(const VkMemoryRequirements& vk_memory_requirements, uint32_t memory_type_index,
+                                    bool is_image, GlobeDeviceMemory& memory) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto start_time = std::chrono::steady_clock::now();
+
+    VkDeviceSize alignment = vk_memory_requirements.alignment > 0 ? vk_memory_requirements.alignment : 1;
+    VkDeviceSize size = vk_memory_requirements.size;
+
+    // Buffers and images share blocks, so keep images on their own bufferImageGranularity "pages".
+    // Aligning both the start and the size of every image means a neighboring buffer can never
+    // land on the same page.
+    if (is_image && _buffer_image_granularity > 1) {
+        alignment = AlignUp(alignment, _buffer_image_granularity);
+        size = AlignUp(size, _buffer_image_granularity);
+    }
+
+    // Non-coherent memory has to be flushed in nonCoherentAtomSize units, so pad out allocations
+    // to keep flushes from touching a neighbor.
+    VkMemoryPropertyFlags flags = _vk_memory_properties.memoryTypes[memory_type_index].propertyFlags;
+    if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+        alignment = AlignUp(alignment, _non_coherent_atom_size);
+        size = AlignUp(size, _non_coherent_atom_size);
+    }
+
+    VkDeviceSize block_size = BlockSizeForType(memory_type_index);
+    MemoryBlock* found_block = nullptr;
+    VkDeviceSize offset = 0;
+    if (size <= block_size / 2) {
+        for (auto block : _blocks[memory_type_index]) {
+            if (SubAllocate(block, size, alignment, offset)) {
+                found_block = block;
+                break;
+            }
+        }
+    }
+    if (nullptr == found_block) {
+        // Large resources get a block of their own which is released as soon as they are freed.
+        VkDeviceSize new_block_size = size <= block_size / 2 ? block_size : AlignUp(size, alignment);
+        found_block = CreateBlock(memory_type_index, new_block_size);
+        if (nullptr == found_block || !SubAllocate(found_block, size, alignment, offset)) {
+            return false;
+        }
+    }
+
+    memory.vk_memory = found_block->vk_memory;
+    memory.vk_offset = offset;
+    memory.vk_size = size;
+    memory.memory_type_index = memory_type_index;
+    memory.mapped_data = nullptr;
+    if (nullptr != found_block->mapped_data) {
+        memory.mapped_data = found_block->mapped_data + offset;
+    }
+
+    _allocation_count++;
+    _used_bytes += size;
+    uint64_t elapsed_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count());
+    _total_allocations++;
+    _total_allocation_ns += elapsed_ns;
+    if (elapsed_ns > _max_allocation_ns) {
+        _max_allocation_ns = elapsed_ns;
+    }
+    return true;
+}
+
+void GlobeMemoryAllocator::Free(GlobeDeviceMemory& memory) {
+    if (VK_NULL_HANDLE == memory.vk_memory) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<MemoryBlock*>& blocks = _blocks[memory.memory_type_index];
+    for (uint32_t block_index = 0; block_index < blocks.size(); ++block_index) {
+        MemoryBlock* block = blocks[block_index];
+        if (block->vk_memory != memory.vk_memory) {
+            continue;
+        }
+        ReleaseRange(block, memory.vk_offset, memory.vk_size);
+        _allocation_count--;
+        _used_bytes -= memory.vk_size;
+
+        // Keep one empty standard block around per memory type so that load/unload cycles don't
+        // bounce off vkAllocateMemory, but return anything else to the driver.
+        if (block->allocation_count == 0 &&
+            (block->size != BlockSizeForType(memory.memory_type_index) || blocks.size() > 1)) {
+            if (nullptr != block->mapped_data) {
+                vkUnmapMemory(_vk_device, block->vk_memory);
+            }
+            vkFreeMemory(_vk_device, block->vk_memory, nullptr);
+            delete block;
+            blocks.erase(blocks.begin() + block_index);
+        }
+        break;
+    }
+    memory.vk_memory = VK_NULL_HANDLE;
+    memory.vk_offset = 0;
+    memory.vk_size = 0;
+    memory.mapped_data = nullptr;
+}
+
+bool GlobeMemoryAllocator::Flush(const GlobeDeviceMemory& memory, VkDeviceSize offset, VkDeviceSize size) const {
+    VkMemoryPropertyFlags flags = _vk_memory_properties.memoryTypes[memory.memory_type_index].propertyFlags;
+    if (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+        return true;
+    }
+    if (offset > memory.vk_size) {
+        return false;
+    }
+    // Compared against what's left rather than summed, since offset + size can wrap.
+    if (VK_WHOLE_SIZE == size || size > memory.vk_size - offset) {
+        size = memory.vk_size - offset;
+    }
+    if (0 == size) {
+        return true;
+    }
+
+    // The allocation itself is atom aligned, so rounding within it never reaches a neighbor.
+    VkMappedMemoryRange vk_mapped_memory_range = {};
+    vk_mapped_memory_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    vk_mapped_memory_range.memory = memory.vk_memory;
+    vk_mapped_memory_range.offset = memory.vk_offset + AlignDown(offset, _non_coherent_atom_size);
+    VkDeviceSize end = memory.vk_offset + AlignUp(offset + size, _non_coherent_atom_size);
+    if (end > memory.vk_offset + memory.vk_size) {
+        end = memory.vk_offset + memory.vk_size;
+    }
+    vk_mapped_memory_range.size = end - vk_mapped_memory_range.offset;
+    return VK_SUCCESS == vkFlushMappedMemoryRanges(_vk_device, 1, &vk_mapped_memory_range);
+}
+
+GlobeMemoryStats GlobeMemoryAllocator::GetStats() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    GlobeMemoryStats stats = {};
+    for (uint32_t type = 0; type < VK_MAX_MEMORY_TYPES; ++type) {
+        for (auto block : _blocks[type]) {
+            stats.device_memory_count++;
+            stats.reserved_bytes += block->size;
+        }
+    }
+    stats.allocation_count = _allocation_count;
+    stats.used_bytes = _used_bytes;
+    stats.total_allocations = _total_allocations;
+    stats.total_allocation_ns = _total_allocation_ns;
+    stats.max_allocation_ns = _max_allocation_ns;
+    return stats;
+}
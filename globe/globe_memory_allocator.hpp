@@ -0,0 +1,73 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_memory_allocator.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "vulkan/vulkan_core.h"
+#include "globe_basic_types.hpp"
+
+struct GlobeMemoryStats {
+    uint32_t device_memory_count;    // Number of live VkDeviceMemory objects (blocks)
+    uint32_t allocation_count;       // Number of live sub-allocations handed out
+    VkDeviceSize reserved_bytes;     // Total size of all blocks
+    VkDeviceSize used_bytes;         // Total size of all live sub-allocations
+    uint64_t total_allocations;      // Number of allocation requests serviced since creation
+    uint64_t total_allocation_ns;    // Accumulated time spent servicing allocation requests
+    uint64_t max_allocation_ns;      // Slowest single allocation request
+};
+
+// Sub-allocates device memory out of large per-memory-type blocks so that we only call
+// vkAllocateMemory when a block fills up, instead of once per buffer or image.
+class GlobeMemoryAllocator {
+   public:
+    GlobeMemoryAllocator(VkPhysicalDevice vk_physical_device, VkDevice vk_device, VkDeviceSize block_size);
+    ~GlobeMemoryAllocator();
+
+    bool Allocate(const VkMemoryRequirements& vk_memory_requirements, uint32_t memory_type_index, bool is_image,
+                  GlobeDeviceMemory& memory);
+    void Free(GlobeDeviceMemory& memory);
+    bool Flush(const GlobeDeviceMemory& memory, VkDeviceSize offset, VkDeviceSize size) const;
+
+    const VkPhysicalDeviceMemoryProperties& GetVkMemoryProperties() const { return _vk_memory_properties; }
+    GlobeMemoryStats GetStats();
+
+   private:
+    struct FreeRange {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+    struct MemoryBlock {
+        VkDeviceMemory vk_memory;
+        VkDeviceSize size;
+        uint8_t* mapped_data;
+        uint32_t allocation_count;
+        std::vector<FreeRange> free_ranges;  // Sorted by offset, adjacent ranges always merged
+    };
+
+    VkDeviceSize BlockSizeForType(uint32_t memory_type_index) const;
+    MemoryBlock* CreateBlock(uint32_t memory_type_index, VkDeviceSize size);
+    bool SubAllocate(MemoryBlock* block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+    void ReleaseRange(MemoryBlock* block, VkDeviceSize offset, VkDeviceSize size);
+
+    std::mutex _mutex;
+    VkDevice _vk_device;
+    VkPhysicalDeviceMemoryProperties _vk_memory_properties;
+    VkDeviceSize _buffer_image_granularity;
+    VkDeviceSize _non_coherent_atom_size;
+    VkDeviceSize _block_size;
+    std::vector<MemoryBlock*> _blocks[VK_MAX_MEMORY_TYPES];
+    uint32_t _allocation_count;
+    VkDeviceSize _used_bytes;
+    uint64_t _total_allocations;
+    uint64_t _total_allocation_ns;
+    uint64_t _max_allocation_ns;
+};
@@ -0,0 +1,573 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_mesh_optimizer.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
+
+#include "globe_file_view.hpp"
+#include "globe_mesh_optimizer.hpp"
+
+#define GLOBE_MESH_OPTIMIZER_INVALID 0xFFFFFFFF
+// A collapse may turn the triangles around the vertex by at most acos(0.25), about 75 degrees.
+#define GLOBE_MESH_OPTIMIZER_MIN_FLIP_COS_SQUARED 0.0625
+
+// FIFO cache simulation.  A vertex is in the cache if fewer than cache_size misses happened since it was
+// loaded, and bumping the time by more than the cache size empties the cache.
+struct GlobeVertexCacheSim {
+    GlobeVertexCacheSim(uint32_t vertex_count, uint32_t cache_size)
+        : stamps(vertex_count, 0), time(cache_size + 1), size(cache_size) {}
+
+    bool Miss(uint32_t vertex) {
+        if (time - stamps[vertex] > size) {
+            stamps[vertex] = time++;
+            return true;
+        }
+        return false;
+    }
+    void Flush() { time += size + 1; }
+
+    std::vector<uint32_t> stamps;
+    uint32_t time;
+    uint32_t size;
+};
+
+GlobeMeshOptimizer::GlobeMeshOptimizer(uint32_t vertex_stride, uint32_t cache_size)
+    : _vertex_stride(vertex_stride), _cache_size(cache_size) {}
+
+void GlobeMeshOptimizer::Optimize(std::vector<float>& vertices, std::vector<uint32_t>& indices) const {
+    WeldVertices(vertices, indices);
+    OptimizeVertexCache(indices, VertexCount(vertices));
+    OptimizeOverdraw(vertices, indices);
+    OptimizeVertexFetch(vertices, indices);
+}
+
+// For every vertex, the first vertex whose leading compare_floats floats are bitwise identical to its own,
+// found with open addressing on those floats.
+static void FindFirstMatches(const std::vector<float>& vertices, uint32_t vertex_stride, uint32_t compare_floats,
+                             std::vector<uint32_t>& first_matches) {
+    uint32_t vertex_count = static_cast<uint32_t>(vertices.size() / vertex_stride);
+    size_t compare_size = compare_floats * sizeof(float);
+    uint32_t table_size = 1;
+    while (table_size < vertex_count * 2) {
+        table_size <<= 1;
+    }
+    std::vector<uint32_t> table(table_size, GLOBE_MESH_OPTIMIZER_INVALID);
+    first_matches.resize(vertex_count);
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        const float* vertex_data = vertices.data() + static_cast<size_t>(vertex) * vertex_stride;
+        uint64_t hash = GlobeHashData(reinterpret_cast<const uint8_t*>(vertex_data), compare_size);
+        uint32_t slot = static_cast<uint32_t>(hash ^ (hash >> 32)) & (table_size - 1);
+        while (GLOBE_MESH_OPTIMIZER_INVALID != table[slot] &&
+               0 != memcmp(vertices.data() + static_cast<size_t>(table[slot]) * vertex_stride, vertex_data,
+                           compare_size)) {
+            slot = (slot + 1) & (table_size - 1);
+        }
+        if (GLOBE_MESH_OPTIMIZER_INVALID == table[slot]) {
+            table[slot] = vertex;
+        }
+        first_matches[vertex] = table[slot];
+    }
+}
+
+// The triangles using each vertex, as ranges of adjacency given by adjacency_offsets[vertex] and
+// adjacency_offsets[vertex + 1].
+static void BuildTriangleAdjacency(const std::vector<uint32_t>& indices, uint32_t vertex_count,
+                                   std::vector<uint32_t>& adjacency_offsets, std::vector<uint32_t>& adjacency) {
+    adjacency_offsets.assign(vertex_count + 1, 0);
+    for (auto index : indices) {
+        adjacency_offsets[index + 1]++;
+    }
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        adjacency_offsets[vertex + 1] += adjacency_offsets[vertex];
+    }
+    adjacency.resize(indices.size());
+    std::vector<uint32_t> adjacency_fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+    for (uint32_t index = 0; index < indices.size(); ++index) {
+        adjacency[adjacency_fill[indices[index]]++] = index / 3;
+    }
+}
+
+void GlobeMeshOptimizer::WeldVertices(std::vector<float>& vertices, std::vector<uint32_t>& indices) const {
+    std::vector<uint32_t> remap;
+    FindFirstMatches(vertices, _vertex_stride, _vertex_stride, remap);
+
+    // Unique vertices are compacted to the front in order, which never overwrites one not yet moved.
+    uint32_t vertex_count = static_cast<uint32_t>(remap.size());
+    size_t vertex_size = _vertex_stride * sizeof(float);
+    uint32_t unique_count = 0;
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        if (remap[vertex] == vertex) {
+            if (unique_count != vertex) {
+                memmove(vertices.data() + static_cast<size_t>(unique_count) * _vertex_stride,
+                        vertices.data() + static_cast<size_t>(vertex) * _vertex_stride, vertex_size);
+            }
+            remap[vertex] = unique_count++;
+        } else {
+            remap[vertex] = remap[remap[vertex]];
+        }
+    }
+    vertices.resize(static_cast<size_t>(unique_count) * _vertex_stride);
+    for (auto& index : indices) {
+        index = remap[index];
+    }
+}
+
+void GlobeMeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertex_count) const {
+    uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+    if (0 == triangle_count) {
+        return;
+    }
+
+    // Triangles using each vertex, and how many of those are still to be emitted.
+    std::vector<uint32_t> adjacency_offsets;
+    std::vector<uint32_t> adjacency;
+    BuildTriangleAdjacency(indices, vertex_count, adjacency_offsets, adjacency);
+    std::vector<uint32_t> live_triangles(vertex_count);
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        live_triangles[vertex] = adjacency_offsets[vertex + 1] - adjacency_offsets[vertex];
+    }
+
+    // Fan out around one vertex at a time, emitting all its remaining triangles, then move on to the
+    // candidate that will still be in the cache after its own fan, or else back up the dead-end stack.
+    GlobeVertexCacheSim cache(vertex_count, _cache_size);
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<uint32_t> dead_end_stack;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    uint32_t scan_vertex = 0;
+    uint32_t fan_vertex = 0;
+    while (GLOBE_MESH_OPTIMIZER_INVALID != fan_vertex) {
+        candidates.clear();
+        for (uint32_t adjacent = adjacency_offsets[fan_vertex]; adjacent < adjacency_offsets[fan_vertex + 1];
+             ++adjacent) {
+            uint32_t triangle = adjacency[adjacent];
+            if (emitted[triangle]) {
+                continue;
+            }
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                uint32_t vertex = indices[triangle * 3 + corner];
+                output.push_back(vertex);
+                dead_end_stack.push_back(vertex);
+                candidates.push_back(vertex);
+                live_triangles[vertex]--;
+                cache.Miss(vertex);
+            }
+            emitted[triangle] = true;
+        }
+
+        fan_vertex = GLOBE_MESH_OPTIMIZER_INVALID;
+        int32_t best_priority = -1;
+        for (auto vertex : candidates) {
+            if (live_triangles[vertex] > 0) {
+                int32_t priority = 0;
+                uint32_t age = cache.time - cache.stamps[vertex];
+                if (age + 2 * live_triangles[vertex] <= _cache_size) {
+                    priority = static_cast<int32_t>(age);
+                }
+                if (priority > best_priority) {
+                    best_priority = priority;
+                    fan_vertex = vertex;
+                }
+            }
+        }
+        while (GLOBE_MESH_OPTIMIZER_INVALID == fan_vertex && !dead_end_stack.empty()) {
+            uint32_t vertex = dead_end_stack.back();
+            dead_end_stack.pop_back();
+            if (live_triangles[vertex] > 0) {
+                fan_vertex = vertex;
+            }
+        }
+        while (GLOBE_MESH_OPTIMIZER_INVALID == fan_vertex && scan_vertex < vertex_count) {
+            if (live_triangles[scan_vertex] > 0) {
+                fan_vertex = scan_vertex;
+            }
+            scan_vertex++;
+        }
+    }
+    indices.swap(output);
+}
+
+void GlobeMeshOptimizer::OptimizeOverdraw(const std::vector<float>& vertices, std::vector<uint32_t>& indices,
+                                          float threshold) const {
+    uint32_t vertex_count = VertexCount(vertices);
+    uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+    if (triangle_count < 2) {
+        return;
+    }
+
+    // Hard boundaries are where the cache order starts over, every vertex of the triangle being a miss.
+    std::vector<uint32_t> hard_starts;
+    GlobeVertexCacheSim cache(vertex_count, _cache_size);
+    for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+        uint32_t misses = 0;
+        for (uint32_t corner = 0; corner < 3; ++corner) {
+            misses += cache.Miss(indices[triangle * 3 + corner]) ? 1 : 0;
+        }
+        if (0 == triangle || 3 == misses) {
+            hard_starts.push_back(triangle);
+        }
+    }
+    hard_starts.push_back(triangle_count);
+
+    // Soft boundaries split those up wherever the cache efficiency so far is already close to that of the
+    // whole cluster, so the pieces can be reordered without costing much.
+    std::vector<uint32_t> cluster_starts;
+    for (uint32_t hard = 0; hard + 1 < hard_starts.size(); ++hard) {
+        uint32_t start = hard_starts[hard];
+        uint32_t end = hard_starts[hard + 1];
+        cache.Flush();
+        uint32_t cluster_misses = 0;
+        for (uint32_t index = start * 3; index < end * 3; ++index) {
+            cluster_misses += cache.Miss(indices[index]) ? 1 : 0;
+        }
+        float target_acmr = threshold * static_cast<float>(cluster_misses) / static_cast<float>(end - start);
+
+        cache.Flush();
+        cluster_starts.push_back(start);
+        uint32_t misses = 0;
+        uint32_t soft_start = start;
+        for (uint32_t triangle = start; triangle < end; ++triangle) {
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                misses += cache.Miss(indices[triangle * 3 + corner]) ? 1 : 0;
+            }
+            if (triangle + 1 < end &&
+                static_cast<float>(misses) <= target_acmr * static_cast<float>(triangle + 1 - soft_start)) {
+                cluster_starts.push_back(triangle + 1);
+                soft_start = triangle + 1;
+                misses = 0;
+                cache.Flush();
+            }
+        }
+    }
+    cluster_starts.push_back(triangle_count);
+
+    // Area weighted centroid and normal of every cluster, and the centroid of the whole mesh.
+    uint32_t cluster_count = static_cast<uint32_t>(cluster_starts.size() - 1);
+    std::vector<float> cluster_data(cluster_count * 6, 0.f);
+    std::vector<float> cluster_area(cluster_count, 0.f);
+    float mesh_centroid[3] = {0.f, 0.f, 0.f};
+    float mesh_area = 0.f;
+    for (uint32_t cluster = 0; cluster < cluster_count; ++cluster) {
+        float* centroid = &cluster_data[cluster * 6];
+        float* normal = centroid + 3;
+        for (uint32_t triangle = cluster_starts[cluster]; triangle < cluster_starts[cluster + 1]; ++triangle) {
+            const float* p0 = vertices.data() + static_cast<size_t>(indices[triangle * 3]) * _vertex_stride;
+            const float* p1 = vertices.data() + static_cast<size_t>(indices[triangle * 3 + 1]) * _vertex_stride;
+            const float* p2 = vertices.data() + static_cast<size_t>(indices[triangle * 3 + 2]) * _vertex_stride;
+            float edge0[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            float edge1[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            float cross[3] = {edge0[1] * edge1[2] - edge0[2] * edge1[1], edge0[2] * edge1[0] - edge0[0] * edge1[2],
+                              edge0[0] * edge1[1] - edge0[1] * edge1[0]};
+            float area = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+            for (uint32_t comp = 0; comp < 3; ++comp) {
+                centroid[comp] += (p0[comp] + p1[comp] + p2[comp]) * area / 3.f;
+                normal[comp] += cross[comp];
+            }
+            cluster_area[cluster] += area;
+        }
+        for (uint32_t comp = 0; comp < 3; ++comp) {
+            mesh_centroid[comp] += centroid[comp];
+        }
+        mesh_area += cluster_area[cluster];
+    }
+    if (mesh_area > 0.f) {
+        for (uint32_t comp = 0; comp < 3; ++comp) {
+            mesh_centroid[comp] /= mesh_area;
+        }
+    }
+    std::vector<float> sort_keys(cluster_count, 0.f);
+    for (uint32_t cluster = 0; cluster < cluster_count; ++cluster) {
+        const float* centroid = &cluster_data[cluster * 6];
+        const float* normal = centroid + 3;
+        float normal_length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (cluster_area[cluster] > 0.f && normal_length > 0.f) {
+            for (uint32_t comp = 0; comp < 3; ++comp) {
+                sort_keys[cluster] +=
+                    (centroid[comp] / cluster_area[cluster] - mesh_centroid[comp]) * normal[comp] / normal_length;
+            }
+        }
+    }
+
+    std::vector<uint32_t> cluster_order(cluster_count);
+    for (uint32_t cluster = 0; cluster < cluster_count; ++cluster) {
+        cluster_order[cluster] = cluster;
+    }
+    std::stable_sort(cluster_order.begin(), cluster_order.end(),
+                     [&sort_keys](uint32_t a, uint32_t b) { return sort_keys[a] > sort_keys[b]; });
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (auto cluster : cluster_order) {
+        output.insert(output.end(), indices.begin() + cluster_starts[cluster] * 3,
+                      indices.begin() + cluster_starts[cluster + 1] * 3);
+    }
+    indices.swap(output);
+}
+
+void GlobeMeshOptimizer::OptimizeVertexFetch(std::vector<float>& vertices, std::vector<uint32_t>& indices) const {
+    std::vector<uint32_t> remap(VertexCount(vertices), GLOBE_MESH_OPTIMIZER_INVALID);
+    std::vector<float> output;
+    output.reserve(vertices.size());
+    uint32_t next_vertex = 0;
+    for (auto& index : indices) {
+        if (GLOBE_MESH_OPTIMIZER_INVALID == remap[index]) {
+            remap[index] = next_vertex++;
+            output.insert(output.end(), vertices.begin() + static_cast<size_t>(index) * _vertex_stride,
+                          vertices.begin() + static_cast<size_t>(index + 1) * _vertex_stride);
+        }
+        index = remap[index];
+    }
+    vertices.swap(output);
+}
+
+// Sum of the squared distances to the planes of the triangles around a vertex, weighted by their area.
+struct GlobeQuadric {
+    double a2, b2, c2, d2, ab, ac, ad, bc, bd, cd;
+    double weight;
+};
+
+static void AddPlane(GlobeQuadric& quadric, const double plane[4], double weight) {
+    quadric.a2 += plane[0] * plane[0] * weight;
+    quadric.b2 += plane[1] * plane[1] * weight;
+    quadric.c2 += plane[2] * plane[2] * weight;
+    quadric.d2 += plane[3] * plane[3] * weight;
+    quadric.ab += plane[0] * plane[1] * weight;
+    quadric.ac += plane[0] * plane[2] * weight;
+    quadric.ad += plane[0] * plane[3] * weight;
+    quadric.bc += plane[1] * plane[2] * weight;
+    quadric.bd += plane[1] * plane[3] * weight;
+    quadric.cd += plane[2] * plane[3] * weight;
+    quadric.weight += weight;
+}
+
+static GlobeQuadric SumQuadrics(const GlobeQuadric& a, const GlobeQuadric& b) {
+    GlobeQuadric sum = a;
+    sum.a2 += b.a2;
+    sum.b2 += b.b2;
+    sum.c2 += b.c2;
+    sum.d2 += b.d2;
+    sum.ab += b.ab;
+    sum.ac += b.ac;
+    sum.ad += b.ad;
+    sum.bc += b.bc;
+    sum.bd += b.bd;
+    sum.cd += b.cd;
+    sum.weight += b.weight;
+    return sum;
+}
+
+// Mean squared distance of the point to the quadric's planes.
+static double QuadricError(const GlobeQuadric& quadric, const float* position) {
+    if (quadric.weight <= 0.0) {
+        return 0.0;
+    }
+    double x = position[0];
+    double y = position[1];
+    double z = position[2];
+    double error = quadric.a2 * x * x + quadric.b2 * y * y + quadric.c2 * z * z + quadric.d2 +
+                   2.0 * (quadric.ab * x * y + quadric.ac * x * z + quadric.bc * y * z + quadric.ad * x +
+                          quadric.bd * y + quadric.cd * z);
+    return std::fabs(error) / quadric.weight;
+}
+
+static void TriangleNormal(const float* p0, const float* p1, const float* p2, double normal[3]) {
+    double edge0[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    double edge1[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    normal[0] = edge0[1] * edge1[2] - edge0[2] * edge1[1];
+    normal[1] = edge0[2] * edge1[0] - edge0[0] * edge1[2];
+    normal[2] = edge0[0] * edge1[1] - edge0[1] * edge1[0];
+}
+
+float GlobeMeshOptimizer::Simplify(const std::vector<float>& vertices, std::vector<uint32_t>& indices,
+                                   uint32_t target_index_count, float max_error) const {
+    uint32_t vertex_count = VertexCount(vertices);
+    auto position = [&vertices, this](uint32_t vertex) {
+        return vertices.data() + static_cast<size_t>(vertex) * _vertex_stride;
+    };
+
+    // A vertex sharing its position with another one is on an attribute seam, and one on an edge used in a
+    // single direction is on an open border.  Moving either would tear the surface.
+    std::vector<uint32_t> position_ids;
+    FindFirstMatches(vertices, _vertex_stride, 3, position_ids);
+    std::vector<uint32_t> position_users(vertex_count, 0);
+    for (auto position_id : position_ids) {
+        position_users[position_id]++;
+    }
+    std::unordered_set<uint64_t> directed_edges;
+    for (uint32_t index = 0; index < indices.size(); ++index) {
+        uint32_t next = index - index % 3 + (index + 1) % 3;
+        directed_edges.insert((static_cast<uint64_t>(position_ids[indices[index]]) << 32) |
+                              position_ids[indices[next]]);
+    }
+    std::vector<bool> on_border(vertex_count, false);
+    for (uint32_t index = 0; index < indices.size(); ++index) {
+        uint32_t start = position_ids[indices[index]];
+        uint32_t end = position_ids[indices[index - index % 3 + (index + 1) % 3]];
+        if (0 == directed_edges.count((static_cast<uint64_t>(end) << 32) | start)) {
+            on_border[start] = true;
+            on_border[end] = true;
+        }
+    }
+    std::vector<bool> locked(vertex_count);
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        locked[vertex] = position_users[position_ids[vertex]] > 1 || on_border[position_ids[vertex]];
+    }
+
+    std::vector<GlobeQuadric> quadrics(vertex_count, GlobeQuadric());
+    for (uint32_t index = 0; index < indices.size(); index += 3) {
+        double normal[4];
+        TriangleNormal(position(indices[index]), position(indices[index + 1]), position(indices[index + 2]),
+                       normal);
+        double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length <= 0.0) {
+            continue;
+        }
+        const float* p0 = position(indices[index]);
+        for (uint32_t comp = 0; comp < 3; ++comp) {
+            normal[comp] /= length;
+        }
+        normal[3] = -(normal[0] * p0[0] + normal[1] * p0[1] + normal[2] * p0[2]);
+        for (uint32_t corner = 0; corner < 3; ++corner) {
+            AddPlane(quadrics[indices[index + corner]], normal, length * 0.5);
+        }
+    }
+
+    // Every pass collapses the cheapest edges first, each vertex taking part in at most one collapse, then
+    // drops the triangles that became degenerate.
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+    double max_cost = static_cast<double>(max_error) * max_error;
+    double result_cost = 0.0;
+    std::vector<uint32_t> adjacency_offsets;
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(vertex_count);
+    std::vector<bool> touched(vertex_count);
+    while (indices.size() > target_index_count) {
+        BuildTriangleAdjacency(indices, vertex_count, adjacency_offsets, adjacency);
+        collapses.clear();
+        for (uint32_t index = 0; index < indices.size(); ++index) {
+            uint32_t a = indices[index];
+            uint32_t b = indices[index - index % 3 + (index + 1) % 3];
+            Collapse collapse = {GLOBE_MESH_OPTIMIZER_INVALID, GLOBE_MESH_OPTIMIZER_INVALID, max_cost};
+            if (!locked[a]) {
+                double cost = QuadricError(SumQuadrics(quadrics[a], quadrics[b]), position(b));
+                if (cost <= collapse.cost) {
+                    collapse = {a, b, cost};
+                }
+            }
+            if (!locked[b]) {
+                double cost = QuadricError(SumQuadrics(quadrics[a], quadrics[b]), position(a));
+                if (cost <= collapse.cost) {
+                    collapse = {b, a, cost};
+                }
+            }
+            if (GLOBE_MESH_OPTIMIZER_INVALID != collapse.from) {
+                collapses.push_back(collapse);
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+            remap[vertex] = vertex;
+        }
+        touched.assign(vertex_count, false);
+        uint32_t triangles_to_remove = static_cast<uint32_t>(indices.size() - target_index_count + 2) / 3;
+        uint32_t triangles_removed = 0;
+        for (const auto& collapse : collapses) {
+            if (triangles_removed >= triangles_to_remove) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+
+            // Moving the vertex must not turn any of the remaining triangles around it over.
+            bool flips = false;
+            uint32_t shared_triangles = 0;
+            for (uint32_t adjacent = adjacency_offsets[collapse.from];
+                 !flips && adjacent < adjacency_offsets[collapse.from + 1]; ++adjacent) {
+                const uint32_t* triangle = &indices[adjacency[adjacent] * 3];
+                if (collapse.to == triangle[0] || collapse.to == triangle[1] || collapse.to == triangle[2]) {
+                    shared_triangles++;
+                    continue;
+                }
+                const float* before[3] = {position(triangle[0]), position(triangle[1]), position(triangle[2])};
+                const float* after[3] = {before[0], before[1], before[2]};
+                for (uint32_t corner = 0; corner < 3; ++corner) {
+                    if (collapse.from == triangle[corner]) {
+                        after[corner] = position(collapse.to);
+                    }
+                }
+                double normal_before[3];
+                double normal_after[3];
+                TriangleNormal(before[0], before[1], before[2], normal_before);
+                TriangleNormal(after[0], after[1], after[2], normal_after);
+                double dot = normal_before[0] * normal_after[0] + normal_before[1] * normal_after[1] +
+                             normal_before[2] * normal_after[2];
+                double length_squared =
+                    (normal_before[0] * normal_before[0] + normal_before[1] * normal_before[1] +
+                     normal_before[2] * normal_before[2]) *
+                    (normal_after[0] * normal_after[0] + normal_after[1] * normal_after[1] +
+                     normal_after[2] * normal_after[2]);
+                // Turning most of the way over counts too, it leaves slivers standing on edge.
+                flips = dot <= 0.0 || dot * dot < length_squared * GLOBE_MESH_OPTIMIZER_MIN_FLIP_COS_SQUARED;
+            }
+            if (flips) {
+                continue;
+            }
+            // The flip test only holds while the rest of the triangles around the vertex stay where they are.
+            remap[collapse.from] = collapse.to;
+            for (uint32_t adjacent = adjacency_offsets[collapse.from]; adjacent < adjacency_offsets[collapse.from + 1];
+                 ++adjacent) {
+                for (uint32_t corner = 0; corner < 3; ++corner) {
+                    touched[indices[adjacency[adjacent] * 3 + corner]] = true;
+                }
+            }
+            quadrics[collapse.to] = SumQuadrics(quadrics[collapse.to], quadrics[collapse.from]);
+            result_cost = std::max(result_cost, collapse.cost);
+            triangles_removed += shared_triangles;
+        }
+        if (0 == triangles_removed) {
+            break;
+        }
+
+        size_t kept = 0;
+        for (size_t index = 0; index < indices.size(); index += 3) {
+            uint32_t a = remap[indices[index]];
+            uint32_t b = remap[indices[index + 1]];
+            uint32_t c = remap[indices[index + 2]];
+            if (a != b && b != c && a != c) {
+                indices[kept++] = a;
+                indices[kept++] = b;
+                indices[kept++] = c;
+            }
+        }
+        indices.resize(kept);
+    }
+    return static_cast<float>(std::sqrt(result_cost));
+}
+
+float GlobeMeshOptimizer::Acmr(const std::vector<uint32_t>& indices, uint32_t vertex_count) const {
+    if (indices.size() < 3) {
+        return 0.f;
+    }
+    GlobeVertexCacheSim cache(vertex_count, _cache_size);
+    uint32_t misses = 0;
+    for (auto index : indices) {
+        misses += cache.Miss(index) ? 1 : 0;
+    }
+    return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
@@ -0,0 +1,57 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_mesh_optimizer.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// FIFO post-transform cache size the vertex cache order is tuned for, and used when measuring ACMR.
+#define GLOBE_MESH_OPTIMIZER_CACHE_SIZE 16
+// How much worse than the vertex cache order the ACMR of a cluster may get when splitting it up for
+// the overdraw order.
+#define GLOBE_MESH_OPTIMIZER_OVERDRAW_THRESHOLD 1.05f
+
+// Reorders an indexed triangle list for the GPU, without changing what it draws.  Vertices are interleaved
+// floats, vertex_stride of them per vertex, starting with the position.  The passes, in the order Optimize
+// runs them:
+//  - WeldVertices merges bitwise identical vertices.
+//  - OptimizeVertexCache orders triangles for the post-transform cache (Tipsify, Sander et al. 2007).
+//  - OptimizeOverdraw splits that order into clusters that barely hurt the cache and draws the clusters
+//    facing outward from the middle of the mesh first, so more of the mesh is rejected by the depth test.
+//  - OptimizeVertexFetch renumbers the vertices in the order the triangles first use them.
+// Simplify is separate, it builds lower detail index lists over the same vertices (Garland and Heckbert's
+// quadric error metric, collapsing edges onto existing vertices).
+// ACMR (average cache miss ratio) is the number of vertex shader invocations per triangle.
+class GlobeMeshOptimizer {
+   public:
+    GlobeMeshOptimizer(uint32_t vertex_stride, uint32_t cache_size = GLOBE_MESH_OPTIMIZER_CACHE_SIZE);
+
+    void Optimize(std::vector<float>& vertices, std::vector<uint32_t>& indices) const;
+
+    void WeldVertices(std::vector<float>& vertices, std::vector<uint32_t>& indices) const;
+    void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertex_count) const;
+    void OptimizeOverdraw(const std::vector<float>& vertices, std::vector<uint32_t>& indices,
+                          float threshold = GLOBE_MESH_OPTIMIZER_OVERDRAW_THRESHOLD) const;
+    void OptimizeVertexFetch(std::vector<float>& vertices, std::vector<uint32_t>& indices) const;
+    // Collapses edges until at most target_index_count indices are left, or until the next collapse would
+    // be further than max_error from the original surface.  Vertices on attribute seams and open borders
+    // never move.  Returns the largest error of any collapse made.
+    float Simplify(const std::vector<float>& vertices, std::vector<uint32_t>& indices, uint32_t target_index_count,
+                   float max_error) const;
+
+    float Acmr(const std::vector<uint32_t>& indices, uint32_t vertex_count) const;
+    uint32_t VertexCount(const std::vector<float>& vertices) const {
+        return static_cast<uint32_t>(vertices.size() / _vertex_stride);
+    }
+
+   private:
+    uint32_t _vertex_stride;
+    uint32_t _cache_size;
+};
@@ -0,0 +1,619 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_mipmap_generator.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLOBE_MIPMAP_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define GLOBE_MIPMAP_AVX2 1
+#define GLOBE_MIPMAP_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(_MSC_VER)
+#define GLOBE_MIPMAP_AVX2 1
+#define GLOBE_MIPMAP_AVX2_TARGET
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define GLOBE_MIPMAP_NEON 1
+#include <arm_neon.h>
+#endif
+
+#include "globe_thread_pool.hpp"
+#include "globe_mipmap_generator.hpp"
+
+// Roughly how many destination texels each band of rows covers when a level is split across threads.
+#define GLOBE_MIPMAP_TEXELS_PER_BAND 16384
+#define GLOBE_MIPMAP_MAX_TAPS 16
+#define GLOBE_MIPMAP_KAISER_ALPHA 4.0f
+// Half-width of the Kaiser filter, in destination texels.
+#define GLOBE_MIPMAP_KAISER_RADIUS 2.0f
+// The general filter path works in fixed point: the tap weights are Q14 and horizontally filtered rows keep
+// 6 fractional bits, so the vertical pass sums Q20 values.  Being integer only, the SIMD kernels produce the
+// exact same bytes as the scalar ones.
+#define GLOBE_MIPMAP_WEIGHT_BITS 14
+#define GLOBE_MIPMAP_HORIZONTAL_SHIFT 8
+#define GLOBE_MIPMAP_VERTICAL_SHIFT 20
+
+// Filter taps of one destination texel along one axis.  The count is always even, padded with a zero
+// weight tap if needed, so the SIMD kernels can apply the taps in pairs.
+struct GlobeMipmapTaps {
+    uint32_t count;
+    uint32_t index[GLOBE_MIPMAP_MAX_TAPS];
+    int16_t weight[GLOBE_MIPMAP_MAX_TAPS];
+};
+
+typedef void (*GlobeBoxRowFunc)(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, uint32_t dst_width);
+// Filters one source row horizontally into dst_width texels of 16-bit fixed point values.
+typedef void (*GlobeHorizontalRowFunc)(const uint8_t* src_row, const GlobeMipmapTaps* taps, int16_t* dst,
+                                       uint32_t dst_width);
+// Combines num_taps (an even number) horizontally filtered rows into one destination row of num_values bytes.
+typedef void (*GlobeVerticalRowFunc)(const int16_t* const* rows, const int16_t* weights, uint32_t num_taps,
+                                     uint8_t* dst, uint32_t num_values);
+
+struct GlobeMipmapKernels {
+    const char* name;
+    GlobeBoxRowFunc box_row;
+    GlobeHorizontalRowFunc horizontal_row;
+    GlobeVerticalRowFunc vertical_row;
+};
+
+// 2x2 box filter of two source rows into one destination row, starting at first_texel.
+static void BoxRowScalar(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, uint32_t first_texel,
+                         uint32_t dst_width) {
+    for (uint32_t texel = first_texel; texel < dst_width; ++texel) {
+        const uint8_t* top = row0 + texel * 8;
+        const uint8_t* bottom = row1 + texel * 8;
+        for (uint32_t comp = 0; comp < 4; ++comp) {
+            uint32_t sum = top[comp] + top[comp + 4] + bottom[comp] + bottom[comp + 4];
+            dst[texel * 4 + comp] = static_cast<uint8_t>((sum + 2) >> 2);
+        }
+    }
+}
+
+static void BoxRowScalarAll(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, uint32_t dst_width) {
+    BoxRowScalar(row0, row1, dst, 0, dst_width);
+}
+
+static void HorizontalRowScalar(const uint8_t* src_row, const GlobeMipmapTaps* taps, int16_t* dst,
+                                uint32_t dst_width) {
+    for (uint32_t texel = 0; texel < dst_width; ++texel) {
+        const GlobeMipmapTaps& cur_taps = taps[texel];
+        for (uint32_t comp = 0; comp < 4; ++comp) {
+            int32_t sum = 1 << (GLOBE_MIPMAP_HORIZONTAL_SHIFT - 1);
+            for (uint32_t tap = 0; tap < cur_taps.count; ++tap) {
+                sum += cur_taps.weight[tap] * static_cast<int32_t>(src_row[cur_taps.index[tap] * 4 + comp]);
+            }
+            sum >>= GLOBE_MIPMAP_HORIZONTAL_SHIFT;
+            dst[texel * 4 + comp] = static_cast<int16_t>(std::min(std::max(sum, -32768), 32767));
+        }
+    }
+}
+
+// Vertical pass over the values starting at first_value.
+static void VerticalRowScalar(const int16_t* const* rows, const int16_t* weights, uint32_t num_taps, uint8_t* dst,
+                              uint32_t first_value, uint32_t num_values) {
+    for (uint32_t value = first_value; value < num_values; ++value) {
+        int32_t sum = 1 << (GLOBE_MIPMAP_VERTICAL_SHIFT - 1);
+        for (uint32_t tap = 0; tap < num_taps; ++tap) {
+            sum += weights[tap] * static_cast<int32_t>(rows[tap][value]);
+        }
+        dst[value] = static_cast<uint8_t>(std::min(std::max(sum >> GLOBE_MIPMAP_VERTICAL_SHIFT, 0), 255));
+    }
+}
+
+static void VerticalRowScalarAll(const int16_t* const* rows, const int16_t* weights, uint32_t num_taps,
+                                 uint8_t* dst, uint32_t num_values) {
+    VerticalRowScalar(rows, weights, num_taps, dst, 0, num_values);
+}
+
+#if defined(GLOBE_MIPMAP_SSE2) || defined(GLOBE_MIPMAP_NEON)
+static int32_t LoadTexel(const uint8_t* texel) {
+    int32_t value;
+    memcpy(&value, texel, sizeof(value));
+    return value;
+}
+#endif
+
+#if defined(GLOBE_MIPMAP_SSE2)
+// Two weights laid out the way a 16-bit multiply-add pairs them with interleaved values.
+static int32_t PackWeightPair(int16_t first, int16_t second) {
+    return static_cast<int32_t>((static_cast<uint32_t>(static_cast<uint16_t>(second)) << 16) |
+                                static_cast<uint16_t>(first));
+}
+
+static void BoxRowSse2(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, uint32_t dst_width) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    uint32_t texel = 0;
+    for (; texel + 4 <= dst_width; texel += 4) {
+        // Eight source texels per row, split into the even ones and the odd ones.
+        __m128i top_a = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + texel * 8)), 0xD8);
+        __m128i top_b =
+            _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + texel * 8 + 16)), 0xD8);
+        __m128i bottom_a =
+            _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + texel * 8)), 0xD8);
+        __m128i bottom_b =
+            _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + texel * 8 + 16)), 0xD8);
+        __m128i top_even = _mm_unpacklo_epi64(top_a, top_b);
+        __m128i top_odd = _mm_unpackhi_epi64(top_a, top_b);
+        __m128i bottom_even = _mm_unpacklo_epi64(bottom_a, bottom_b);
+        __m128i bottom_odd = _mm_unpackhi_epi64(bottom_a, bottom_b);
+
+        __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(top_even, zero), _mm_unpacklo_epi8(top_odd, zero));
+        low = _mm_add_epi16(low, _mm_unpacklo_epi8(bottom_even, zero));
+        low = _mm_add_epi16(low, _mm_unpacklo_epi8(bottom_odd, zero));
+        low = _mm_srli_epi16(_mm_add_epi16(low, two), 2);
+        __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top_even, zero), _mm_unpackhi_epi8(top_odd, zero));
+        high = _mm_add_epi16(high, _mm_unpackhi_epi8(bottom_even, zero));
+        high = _mm_add_epi16(high, _mm_unpackhi_epi8(bottom_odd, zero));
+        high = _mm_srli_epi16(_mm_add_epi16(high, two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + texel * 4), _mm_packus_epi16(low, high));
+    }
+    BoxRowScalar(row0, row1, dst, texel, dst_width);
+}
+
+// The source texels of taps tap and tap + 1 with their components interleaved, in the low 8 bytes, so one
+// multiply-add applies both weights.
+static __m128i LoadTexelPair(const uint8_t* src_row, const GlobeMipmapTaps& taps, uint32_t tap) {
+    const uint8_t* first = src_row + taps.index[tap] * 4;
+    if (taps.index[tap + 1] == taps.index[tap] + 1) {
+        __m128i both = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(first));
+        return _mm_unpacklo_epi8(both, _mm_srli_si128(both, 4));
+    }
+    return _mm_unpacklo_epi8(_mm_cvtsi32_si128(LoadTexel(first)),
+                             _mm_cvtsi32_si128(LoadTexel(src_row + taps.index[tap + 1] * 4)));
+}
+
+static void HorizontalRowSse2(const uint8_t* src_row, const GlobeMipmapTaps* taps, int16_t* dst,
+                              uint32_t dst_width) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(1 << (GLOBE_MIPMAP_HORIZONTAL_SHIFT - 1));
+    for (uint32_t texel = 0; texel < dst_width; ++texel) {
+        const GlobeMipmapTaps& cur_taps = taps[texel];
+        __m128i sum = round;
+        for (uint32_t tap = 0; tap < cur_taps.count; tap += 2) {
+            __m128i pair = _mm_unpacklo_epi8(LoadTexelPair(src_row, cur_taps, tap), zero);
+            __m128i weights = _mm_set1_epi32(PackWeightPair(cur_taps.weight[tap], cur_taps.weight[tap + 1]));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(pair, weights));
+        }
+        sum = _mm_srai_epi32(sum, GLOBE_MIPMAP_HORIZONTAL_SHIFT);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + texel * 4), _mm_packs_epi32(sum, sum));
+    }
+}
+
+static void VerticalRowSse2(const int16_t* const* rows, const int16_t* weights, uint32_t num_taps, uint8_t* dst,
+                            uint32_t num_values) {
+    const __m128i round = _mm_set1_epi32(1 << (GLOBE_MIPMAP_VERTICAL_SHIFT - 1));
+    uint32_t value = 0;
+    for (; value + 8 <= num_values; value += 8) {
+        __m128i sum_low = round;
+        __m128i sum_high = round;
+        for (uint32_t tap = 0; tap < num_taps; tap += 2) {
+            __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[tap] + value));
+            __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[tap + 1] + value));
+            __m128i pair_weights = _mm_set1_epi32(PackWeightPair(weights[tap], weights[tap + 1]));
+            sum_low = _mm_add_epi32(sum_low, _mm_madd_epi16(_mm_unpacklo_epi16(first, second), pair_weights));
+            sum_high = _mm_add_epi32(sum_high, _mm_madd_epi16(_mm_unpackhi_epi16(first, second), pair_weights));
+        }
+        __m128i packed = _mm_packs_epi32(_mm_srai_epi32(sum_low, GLOBE_MIPMAP_VERTICAL_SHIFT),
+                                         _mm_srai_epi32(sum_high, GLOBE_MIPMAP_VERTICAL_SHIFT));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + value), _mm_packus_epi16(packed, packed));
+    }
+    VerticalRowScalar(rows, weights, num_taps, dst, value, num_values);
+}
+#endif
+
+#if defined(GLOBE_MIPMAP_AVX2)
+GLOBE_MIPMAP_AVX2_TARGET static void BoxRowAvx2(const uint8_t* row0, const uint8_t* row1, uint8_t* dst,
+                                                uint32_t dst_width) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i two = _mm256_set1_epi16(2);
+    uint32_t texel = 0;
+    for (; texel + 8 <= dst_width; texel += 8) {
+        // Same as the SSE2 version, but each 128-bit lane ends up with half of the texels out of order,
+        // which the final 64-bit permute puts back.
+        __m256i top_a =
+            _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + texel * 8)), 0xD8);
+        __m256i top_b =
+            _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + texel * 8 + 32)), 0xD8);
+        __m256i bottom_a =
+            _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + texel * 8)), 0xD8);
+        __m256i bottom_b =
+            _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + texel * 8 + 32)), 0xD8);
+        __m256i top_even = _mm256_unpacklo_epi64(top_a, top_b);
+        __m256i top_odd = _mm256_unpackhi_epi64(top_a, top_b);
+        __m256i bottom_even = _mm256_unpacklo_epi64(bottom_a, bottom_b);
+        __m256i bottom_odd = _mm256_unpackhi_epi64(bottom_a, bottom_b);
+
+        __m256i low = _mm256_add_epi16(_mm256_unpacklo_epi8(top_even, zero), _mm256_unpacklo_epi8(top_odd, zero));
+        low = _mm256_add_epi16(low, _mm256_unpacklo_epi8(bottom_even, zero));
+        low = _mm256_add_epi16(low, _mm256_unpacklo_epi8(bottom_odd, zero));
+        low = _mm256_srli_epi16(_mm256_add_epi16(low, two), 2);
+        __m256i high = _mm256_add_epi16(_mm256_unpackhi_epi8(top_even, zero), _mm256_unpackhi_epi8(top_odd, zero));
+        high = _mm256_add_epi16(high, _mm256_unpackhi_epi8(bottom_even, zero));
+        high = _mm256_add_epi16(high, _mm256_unpackhi_epi8(bottom_odd, zero));
+        high = _mm256_srli_epi16(_mm256_add_epi16(high, two), 2);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + texel * 4), packed);
+    }
+    BoxRowScalar(row0, row1, dst, texel, dst_width);
+}
+
+// Two destination texels at a time, one per 128-bit lane, as long as both have the same number of taps.
+GLOBE_MIPMAP_AVX2_TARGET static void HorizontalRowAvx2(const uint8_t* src_row, const GlobeMipmapTaps* taps,
+                                                       int16_t* dst, uint32_t dst_width) {
+    const __m256i round = _mm256_set1_epi32(1 << (GLOBE_MIPMAP_HORIZONTAL_SHIFT - 1));
+    uint32_t texel = 0;
+    for (; texel + 2 <= dst_width; texel += 2) {
+        const GlobeMipmapTaps& first_taps = taps[texel];
+        const GlobeMipmapTaps& second_taps = taps[texel + 1];
+        if (first_taps.count != second_taps.count) {
+            HorizontalRowSse2(src_row, taps + texel, dst + texel * 4, 2);
+            continue;
+        }
+        __m256i sum = round;
+        for (uint32_t tap = 0; tap < first_taps.count; tap += 2) {
+            __m128i pairs = _mm_unpacklo_epi64(LoadTexelPair(src_row, first_taps, tap),
+                                               LoadTexelPair(src_row, second_taps, tap));
+            int32_t first_weights = PackWeightPair(first_taps.weight[tap], first_taps.weight[tap + 1]);
+            int32_t second_weights = PackWeightPair(second_taps.weight[tap], second_taps.weight[tap + 1]);
+            __m256i weights = _mm256_setr_epi32(first_weights, first_weights, first_weights, first_weights,
+                                                second_weights, second_weights, second_weights, second_weights);
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_cvtepu8_epi16(pairs), weights));
+        }
+        sum = _mm256_srai_epi32(sum, GLOBE_MIPMAP_HORIZONTAL_SHIFT);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(sum, sum), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + texel * 4), _mm256_castsi256_si128(packed));
+    }
+    HorizontalRowSse2(src_row, taps + texel, dst + texel * 4, dst_width - texel);
+}
+
+GLOBE_MIPMAP_AVX2_TARGET static void VerticalRowAvx2(const int16_t* const* rows, const int16_t* weights,
+                                                     uint32_t num_taps, uint8_t* dst, uint32_t num_values) {
+    const __m256i round = _mm256_set1_epi32(1 << (GLOBE_MIPMAP_VERTICAL_SHIFT - 1));
+    uint32_t value = 0;
+    for (; value + 16 <= num_values; value += 16) {
+        __m256i sum_low = round;
+        __m256i sum_high = round;
+        for (uint32_t tap = 0; tap < num_taps; tap += 2) {
+            __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[tap] + value));
+            __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[tap + 1] + value));
+            __m256i pair_weights = _mm256_set1_epi32(PackWeightPair(weights[tap], weights[tap + 1]));
+            sum_low =
+                _mm256_add_epi32(sum_low, _mm256_madd_epi16(_mm256_unpacklo_epi16(first, second), pair_weights));
+            sum_high =
+                _mm256_add_epi32(sum_high, _mm256_madd_epi16(_mm256_unpackhi_epi16(first, second), pair_weights));
+        }
+        // Unpacking and packing both stay within 128-bit lanes, so the values come out in order, each lane
+        // twice.  The permute keeps one copy of each.
+        __m256i packed = _mm256_packs_epi32(_mm256_srai_epi32(sum_low, GLOBE_MIPMAP_VERTICAL_SHIFT),
+                                            _mm256_srai_epi32(sum_high, GLOBE_MIPMAP_VERTICAL_SHIFT));
+        packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(packed, packed), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + value), _mm256_castsi256_si128(packed));
+    }
+    VerticalRowScalar(rows, weights, num_taps, dst, value, num_values);
+}
+
+static bool CpuSupportsAvx2() {
+#if defined(_MSC_VER)
+    int cpu_info[4] = {};
+    __cpuid(cpu_info, 0);
+    if (cpu_info[0] < 7) {
+        return false;
+    }
+    // AVX2 also needs the OS to save the upper halves of the YMM registers.
+    __cpuid(cpu_info, 1);
+    if (0 == (cpu_info[2] & (1 << 27)) || 0 == (cpu_info[2] & (1 << 28)) || 6 != (_xgetbv(0) & 6)) {
+        return false;
+    }
+    __cpuidex(cpu_info, 7, 0);
+    return 0 != (cpu_info[1] & (1 << 5));
+#else
+    // This runs during static initialization, possibly before the CPU model has been probed.
+    __builtin_cpu_init();
+    return 0 != __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#if defined(GLOBE_MIPMAP_NEON)
+static void BoxRowNeon(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, uint32_t dst_width) {
+    uint32_t texel = 0;
+    for (; texel + 8 <= dst_width; texel += 8) {
+        // Sixteen source texels per row, de-interleaved by component so neighbors can be added pairwise.
+        uint8x16x4_t top = vld4q_u8(row0 + texel * 8);
+        uint8x16x4_t bottom = vld4q_u8(row1 + texel * 8);
+        uint8x8x4_t result;
+        for (uint32_t comp = 0; comp < 4; ++comp) {
+            uint16x8_t sum = vpadalq_u8(vpaddlq_u8(top.val[comp]), bottom.val[comp]);
+            result.val[comp] = vrshrn_n_u16(sum, 2);
+        }
+        vst4_u8(dst + texel * 4, result);
+    }
+    BoxRowScalar(row0, row1, dst, texel, dst_width);
+}
+
+static void HorizontalRowNeon(const uint8_t* src_row, const GlobeMipmapTaps* taps, int16_t* dst,
+                              uint32_t dst_width) {
+    for (uint32_t texel = 0; texel < dst_width; ++texel) {
+        const GlobeMipmapTaps& cur_taps = taps[texel];
+        int32x4_t sum = vdupq_n_s32(0);
+        for (uint32_t tap = 0; tap < cur_taps.count; ++tap) {
+            uint32_t src_texel = static_cast<uint32_t>(LoadTexel(src_row + cur_taps.index[tap] * 4));
+            uint8x8_t bytes = vreinterpret_u8_u32(vdup_n_u32(src_texel));
+            int16x4_t components = vget_low_s16(vreinterpretq_s16_u16(vmovl_u8(bytes)));
+            sum = vmlal_n_s16(sum, components, cur_taps.weight[tap]);
+        }
+        vst1_s16(dst + texel * 4, vqmovn_s32(vrshrq_n_s32(sum, GLOBE_MIPMAP_HORIZONTAL_SHIFT)));
+    }
+}
+
+static void VerticalRowNeon(const int16_t* const* rows, const int16_t* weights, uint32_t num_taps, uint8_t* dst,
+                            uint32_t num_values) {
+    uint32_t value = 0;
+    for (; value + 8 <= num_values; value += 8) {
+        int32x4_t sum_low = vdupq_n_s32(0);
+        int32x4_t sum_high = vdupq_n_s32(0);
+        for (uint32_t tap = 0; tap < num_taps; ++tap) {
+            int16x8_t row = vld1q_s16(rows[tap] + value);
+            sum_low = vmlal_n_s16(sum_low, vget_low_s16(row), weights[tap]);
+            sum_high = vmlal_n_s16(sum_high, vget_high_s16(row), weights[tap]);
+        }
+        // Rounding shifts add the same half as the scalar version before shifting.
+        int16x8_t packed = vcombine_s16(vqmovn_s32(vrshrq_n_s32(sum_low, GLOBE_MIPMAP_VERTICAL_SHIFT)),
+                                        vqmovn_s32(vrshrq_n_s32(sum_high, GLOBE_MIPMAP_VERTICAL_SHIFT)));
+        vst1_u8(dst + value, vqmovun_s16(packed));
+    }
+    VerticalRowScalar(rows, weights, num_taps, dst, value, num_values);
+}
+#endif
+
+static const GlobeMipmapKernels scalar_kernels = {"scalar", BoxRowScalarAll, HorizontalRowScalar,
+                                                  VerticalRowScalarAll};
+
+static GlobeMipmapKernels SelectSimdKernels() {
+#if defined(GLOBE_MIPMAP_AVX2)
+    if (CpuSupportsAvx2()) {
+        GlobeMipmapKernels avx2_kernels = {"AVX2", BoxRowAvx2, HorizontalRowAvx2, VerticalRowAvx2};
+        return avx2_kernels;
+    }
+#endif
+#if defined(GLOBE_MIPMAP_SSE2)
+    GlobeMipmapKernels sse2_kernels = {"SSE2", BoxRowSse2, HorizontalRowSse2, VerticalRowSse2};
+    return sse2_kernels;
+#elif defined(GLOBE_MIPMAP_NEON)
+    GlobeMipmapKernels neon_kernels = {"NEON", BoxRowNeon, HorizontalRowNeon, VerticalRowNeon};
+    return neon_kernels;
+#else
+    return scalar_kernels;
+#endif
+}
+
+static const GlobeMipmapKernels simd_kernels = SelectSimdKernels();
+
+static float BesselI0(float x) {
+    float sum = 1.f;
+    float term = 1.f;
+    float half_x = x * 0.5f;
+    for (uint32_t k = 1; k < 20; ++k) {
+        term *= half_x / static_cast<float>(k);
+        sum += term * term;
+    }
+    return sum;
+}
+
+static float KaiserSinc(float t) {
+    float sinc = 1.f;
+    if (std::fabs(t) > 1e-5f) {
+        const float pi = 3.14159265358979f;
+        sinc = std::sin(pi * t) / (pi * t);
+    }
+    float u = t / GLOBE_MIPMAP_KAISER_RADIUS;
+    float window = BesselI0(GLOBE_MIPMAP_KAISER_ALPHA * std::sqrt(std::max(0.f, 1.f - u * u))) /
+                   BesselI0(GLOBE_MIPMAP_KAISER_ALPHA);
+    return sinc * window;
+}
+
+static void BuildTaps(GlobeMipmapFilter filter, uint32_t src_size, uint32_t dst_size,
+                      std::vector<GlobeMipmapTaps>& taps) {
+    taps.resize(dst_size);
+    for (uint32_t dst = 0; dst < dst_size; ++dst) {
+        GlobeMipmapTaps& cur_taps = taps[dst];
+        float weight[GLOBE_MIPMAP_MAX_TAPS];
+        cur_taps.count = 0;
+        if (src_size == dst_size) {
+            // A dimension that is already 1 stays as it is.
+            cur_taps.count = 1;
+            cur_taps.index[0] = dst;
+            weight[0] = 1.f;
+        } else if (GLOBE_MIPMAP_FILTER_BOX == filter) {
+            if (src_size == dst_size * 2) {
+                cur_taps.count = 2;
+                cur_taps.index[0] = dst * 2;
+                cur_taps.index[1] = dst * 2 + 1;
+                weight[0] = 0.5f;
+                weight[1] = 0.5f;
+            } else {
+                // An odd source size: each destination texel covers 2 + 1/dst_size source texels.
+                float denominator = static_cast<float>(src_size);
+                cur_taps.count = 3;
+                cur_taps.index[0] = dst * 2;
+                cur_taps.index[1] = dst * 2 + 1;
+                cur_taps.index[2] = dst * 2 + 2;
+                weight[0] = static_cast<float>(dst_size - dst) / denominator;
+                weight[1] = static_cast<float>(dst_size) / denominator;
+                weight[2] = static_cast<float>(dst + 1) / denominator;
+            }
+        } else {
+            float scale = static_cast<float>(src_size) / static_cast<float>(dst_size);
+            float center = (static_cast<float>(dst) + 0.5f) * scale;
+            float radius = GLOBE_MIPMAP_KAISER_RADIUS * scale;
+            int32_t first = static_cast<int32_t>(std::floor(center - radius));
+            int32_t last = static_cast<int32_t>(std::ceil(center + radius));
+            float total = 0.f;
+            for (int32_t src = first; src <= last && cur_taps.count < GLOBE_MIPMAP_MAX_TAPS; ++src) {
+                float t = (static_cast<float>(src) + 0.5f - center) / scale;
+                if (std::fabs(t) >= GLOBE_MIPMAP_KAISER_RADIUS) {
+                    continue;
+                }
+                int32_t clamped = std::min(std::max(src, 0), static_cast<int32_t>(src_size) - 1);
+                cur_taps.index[cur_taps.count] = static_cast<uint32_t>(clamped);
+                weight[cur_taps.count] = KaiserSinc(t);
+                total += weight[cur_taps.count];
+                cur_taps.count++;
+            }
+            for (uint32_t tap = 0; tap < cur_taps.count; ++tap) {
+                weight[tap] /= total;
+            }
+        }
+
+        // Convert to fixed point, folding the rounding error into the largest tap so the weights still add
+        // up to exactly one.
+        int32_t fixed_total = 0;
+        uint32_t largest = 0;
+        for (uint32_t tap = 0; tap < cur_taps.count; ++tap) {
+            cur_taps.weight[tap] =
+                static_cast<int16_t>(std::lround(weight[tap] * static_cast<float>(1 << GLOBE_MIPMAP_WEIGHT_BITS)));
+            fixed_total += cur_taps.weight[tap];
+            if (std::fabs(weight[tap]) > std::fabs(weight[largest])) {
+                largest = tap;
+            }
+        }
+        cur_taps.weight[largest] =
+            static_cast<int16_t>(cur_taps.weight[largest] + (1 << GLOBE_MIPMAP_WEIGHT_BITS) - fixed_total);
+        if (0 != (cur_taps.count & 1)) {
+            // Padding with the next texel keeps the last pair contiguous for the horizontal kernels.
+            uint32_t last = cur_taps.index[cur_taps.count - 1];
+            cur_taps.index[cur_taps.count] = last + 1 < src_size ? last + 1 : cur_taps.index[0];
+            cur_taps.weight[cur_taps.count] = 0;
+            cur_taps.count++;
+        }
+    }
+}
+
+// Separable filter of the destination rows [first_row, end_row) for any source/destination sizes.
+static void FilterRows(const GlobeMipmapKernels& kernels, const uint8_t* src, uint32_t src_width, uint8_t* dst,
+                       uint32_t dst_width, const std::vector<GlobeMipmapTaps>& horizontal_taps,
+                       const std::vector<GlobeMipmapTaps>& vertical_taps, uint32_t first_row, uint32_t end_row) {
+    // Horizontally filter every source row the band needs once, then combine them vertically.
+    uint32_t first_src_row = UINT32_MAX;
+    uint32_t last_src_row = 0;
+    for (uint32_t row = first_row; row < end_row; ++row) {
+        for (uint32_t tap = 0; tap < vertical_taps[row].count; ++tap) {
+            if (0 == vertical_taps[row].weight[tap]) {
+                continue;
+            }
+            first_src_row = std::min(first_src_row, vertical_taps[row].index[tap]);
+            last_src_row = std::max(last_src_row, vertical_taps[row].index[tap]);
+        }
+    }
+    size_t row_values = static_cast<size_t>(dst_width) * 4;
+    std::vector<int16_t> filtered_rows((last_src_row - first_src_row + 1) * row_values);
+    for (uint32_t src_row = first_src_row; src_row <= last_src_row; ++src_row) {
+        kernels.horizontal_row(src + static_cast<size_t>(src_row) * src_width * 4, horizontal_taps.data(),
+                               filtered_rows.data() + (src_row - first_src_row) * row_values, dst_width);
+    }
+    const int16_t* tap_rows[GLOBE_MIPMAP_MAX_TAPS];
+    for (uint32_t row = first_row; row < end_row; ++row) {
+        const GlobeMipmapTaps& taps = vertical_taps[row];
+        for (uint32_t tap = 0; tap < taps.count; ++tap) {
+            // Zero weight taps, such as the padding, may lie outside of the filtered rows.
+            tap_rows[tap] = filtered_rows.data();
+            if (0 != taps.weight[tap]) {
+                tap_rows[tap] += (taps.index[tap] - first_src_row) * row_values;
+            }
+        }
+        kernels.vertical_row(tap_rows, taps.weight, taps.count, dst + row * row_values,
+                             static_cast<uint32_t>(row_values));
+    }
+}
+
+GlobeMipmapGenerator::GlobeMipmapGenerator(GlobeThreadPool* thread_pool, GlobeMipmapFilter filter, bool use_simd)
+    : _thread_pool(thread_pool), _filter(filter), _use_simd(use_simd) {}
+
+uint32_t GlobeMipmapGenerator::NumMipLevels(uint32_t width, uint32_t height) {
+    uint32_t num_levels = 1;
+    uint32_t largest = std::max(width, height);
+    while (largest > 1) {
+        largest >>= 1;
+        num_levels++;
+    }
+    return num_levels;
+}
+
+size_t GlobeMipmapGenerator::MipChainSize(uint32_t width, uint32_t height) {
+    size_t size = 0;
+    uint32_t num_levels = NumMipLevels(width, height);
+    for (uint32_t level = 0; level < num_levels; ++level) {
+        size += static_cast<size_t>(width) * height * 4;
+        width = std::max(width >> 1, 1u);
+        height = std::max(height >> 1, 1u);
+    }
+    return size;
+}
+
+const char* GlobeMipmapGenerator::SimdPathName() { return simd_kernels.name; }
+
+void GlobeMipmapGenerator::Generate(uint8_t* rgba_chain, uint32_t width, uint32_t height) const {
+    uint32_t num_levels = NumMipLevels(width, height);
+    uint8_t* src = rgba_chain;
+    for (uint32_t level = 1; level < num_levels; ++level) {
+        uint8_t* dst = src + static_cast<size_t>(width) * height * 4;
+        DownsampleLevel(src, width, height, dst);
+        src = dst;
+        width = std::max(width >> 1, 1u);
+        height = std::max(height >> 1, 1u);
+    }
+}
+
+void GlobeMipmapGenerator::DownsampleLevel(const uint8_t* src, uint32_t src_width, uint32_t src_height,
+                                           uint8_t* dst) const {
+    uint32_t dst_width = std::max(src_width >> 1, 1u);
+    uint32_t dst_height = std::max(src_height >> 1, 1u);
+    uint32_t rows_per_band = std::max(GLOBE_MIPMAP_TEXELS_PER_BAND / dst_width, 1u);
+    uint32_t num_bands = (dst_height + rows_per_band - 1) / rows_per_band;
+
+    const GlobeMipmapKernels& kernels = _use_simd ? simd_kernels : scalar_kernels;
+    std::function<void(uint32_t)> filter_band;
+    std::vector<GlobeMipmapTaps> horizontal_taps;
+    std::vector<GlobeMipmapTaps> vertical_taps;
+    if (GLOBE_MIPMAP_FILTER_BOX == _filter && src_width == dst_width * 2 && src_height == dst_height * 2) {
+        // The common case, an exact 2x2 reduction.
+        GlobeBoxRowFunc box_row_func = kernels.box_row;
+        filter_band = [=](uint32_t band) {
+            uint32_t end_row = std::min((band + 1) * rows_per_band, dst_height);
+            for (uint32_t row = band * rows_per_band; row < end_row; ++row) {
+                const uint8_t* row0 = src + static_cast<size_t>(row) * 2 * src_width * 4;
+                box_row_func(row0, row0 + src_width * 4, dst + static_cast<size_t>(row) * dst_width * 4, dst_width);
+            }
+        };
+    } else {
+        BuildTaps(_filter, src_width, dst_width, horizontal_taps);
+        BuildTaps(_filter, src_height, dst_height, vertical_taps);
+        filter_band = [&, src, dst, src_width, dst_width, rows_per_band, dst_height](uint32_t band) {
+            FilterRows(kernels, src, src_width, dst, dst_width, horizontal_taps, vertical_taps, band * rows_per_band,
+                       std::min((band + 1) * rows_per_band, dst_height));
+        };
+    }
+
+    if (nullptr != _thread_pool && num_bands > 1) {
+        _thread_pool->ParallelFor(num_bands, filter_band);
+    } else {
+        for (uint32_t band = 0; band < num_bands; ++band) {
+            filter_band(band);
+        }
+    }
+}
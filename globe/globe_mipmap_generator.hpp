@@ -0,0 +1,51 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_mipmap_generator.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class GlobeThreadPool;
+
+enum GlobeMipmapFilter {
+    // Averages the 2x2 (or, along an odd dimension, the weighted 3-texel) footprint of each texel.
+    GLOBE_MIPMAP_FILTER_BOX = 0,
+    // Kaiser-windowed sinc, sharper than the box filter at a higher cost.
+    GLOBE_MIPMAP_FILTER_KAISER,
+};
+
+// Builds RGBA8 mip chains on the CPU.  Level sizes follow the Vulkan rule (each level is half the
+// previous one, rounded down, but never less than 1) so any width and height work, and odd sizes are
+// filtered with the proper 3-texel weights instead of dropping a row or column.
+//
+// Each level is split into bands of rows which are run across the thread pool, with the calling thread
+// working on bands too, so it is safe to generate mipmaps from inside a pool job.  The exact 2x2 box
+// case, and the fixed point filter used for odd sizes and the Kaiser filter, use AVX2, SSE2 or NEON when
+// available.  Both produce the same bytes as the scalar code, which use_simd = false forces.
+class GlobeMipmapGenerator {
+   public:
+    GlobeMipmapGenerator(GlobeThreadPool* thread_pool, GlobeMipmapFilter filter = GLOBE_MIPMAP_FILTER_BOX,
+                         bool use_simd = true);
+
+    static uint32_t NumMipLevels(uint32_t width, uint32_t height);
+    // Size in bytes of the whole chain, with the levels tightly packed one after the other.
+    static size_t MipChainSize(uint32_t width, uint32_t height);
+    static const char* SimdPathName();
+
+    // rgba_chain holds the base level and has room for MipChainSize(width, height) bytes.
+    void Generate(uint8_t* rgba_chain, uint32_t width, uint32_t height) const;
+    // Writes the next level (max(1, src_width / 2) by max(1, src_height / 2)) of src into dst.
+    void DownsampleLevel(const uint8_t* src, uint32_t src_width, uint32_t src_height, uint8_t* dst) const;
+
+   private:
+    GlobeThreadPool* _thread_pool;
+    GlobeMipmapFilter _filter;
+    bool _use_simd;
+};
@@ -7,6 +7,8 @@
 // Author(s):               Mark Young <marky@lunarg.com>
 //
 
+#include <cmath>
+#include <cstdio>
 #include <cstring>
 #include <algorithm>
 
@@ -14,13 +16,46 @@
 #include "globe_event.hpp"
 #include "globe_app.hpp"
 #include "globe_resource_manager.hpp"
+#include "globe_camera.hpp"
 #include "globe_model.hpp"
+#include "globe_file_view.hpp"
+#include "globe_mesh_optimizer.hpp"
+#include "globe_upload_batch.hpp"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <assimp/cimport.h>
 
+#if defined(VK_USE_PLATFORM_WIN32_KHR)
+const char directory_symbol = '\\';
+#else
+const char directory_symbol = '/';
+#endif
+
+// Binary model cache file layout: the header, followed by the MeshInfo array, the interleaved vertex
+// floats and the indices, all in the native layout of the running build.  Bump the version whenever
+// the import post-processing or any of these structures change.
+#define GLOBE_MODEL_CACHE_MAGIC 0x4548434C444F4D47ULL  // "GMODLCHE"
+#define GLOBE_MODEL_CACHE_VERSION 4
+
+struct GlobeModelCacheHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t mesh_info_size;
+    uint64_t source_hash;
+    GlobeComponentSizes sizes;
+    uint32_t mesh_count;
+    uint32_t vertex_float_count;
+    uint32_t index_count;
+    uint32_t lod_count;
+    GlobeModel::LodInfo lods[GLOBE_MODEL_MAX_LODS];
+    float bounding_box[12];
+    uint64_t meshes_offset;
+    uint64_t vertices_offset;
+    uint64_t indices_offset;
+};
+
 void GlobeModel::CopyVertexComponentData(std::vector<float>& buffer, float* data, bool data_valid, uint8_t copy_comps,
                                          uint8_t max_comps, bool flip_y) {
     uint8_t comp;
@@ -45,33 +80,348 @@ void GlobeModel::CopyVertexComponentData(std::vector<float>& buffer, float* data
     }
 }
 
-GlobeModel* GlobeModel::LoadDaeModelFile(const GlobeResourceManager* resource_manager, VkDevice vk_device,
-                                         const GlobeComponentSizes& sizes, const std::string& model_name,
-                                         const std::string& directory) {
+// One attribute of the interleaved vertex, in the order the importer writes them.
+struct GlobeVertexAttribute {
+    uint8_t components;  // Floats per vertex in the imported content
+    uint8_t encoding;    // GlobeVertexEncoding in the vertex buffer
+};
+
+static std::vector<GlobeVertexAttribute> VertexAttributes(const GlobeComponentSizes& sizes) {
+    std::vector<GlobeVertexAttribute> attributes;
+    attributes.push_back({sizes.position, sizes.position_encoding});
+    uint8_t color_sizes[4] = {sizes.diffuse_color, sizes.ambient_color, sizes.specular_color, sizes.emissive_color};
+    if (sizes.normal > 0) {
+        attributes.push_back({sizes.normal, sizes.normal_encoding});
+    }
+    for (uint8_t color = 0; color < 4; ++color) {
+        if (color_sizes[color] > 0) {
+            attributes.push_back({color_sizes[color], sizes.color_encoding});
+        }
+    }
+    if (sizes.shininess > 0) {
+        attributes.push_back({sizes.shininess, GLOBE_VERTEX_ENCODING_FLOAT});
+    }
+    for (uint8_t tc = 0; tc < 3; ++tc) {
+        if (sizes.texcoord[tc] > 0) {
+            attributes.push_back({sizes.texcoord[tc], sizes.texcoord_encoding});
+        }
+    }
+    if (sizes.tangent > 0) {
+        attributes.push_back({sizes.tangent, sizes.normal_encoding});
+    }
+    if (sizes.bitangent > 0) {
+        attributes.push_back({sizes.bitangent, sizes.normal_encoding});
+    }
+    return attributes;
+}
+
+static uint32_t EncodedComponentSize(uint8_t encoding) {
+    switch (encoding) {
+        case GLOBE_VERTEX_ENCODING_HALF:
+        case GLOBE_VERTEX_ENCODING_SNORM16:
+        case GLOBE_VERTEX_ENCODING_UNORM16:
+            return 2;
+        case GLOBE_VERTEX_ENCODING_SNORM8:
+        case GLOBE_VERTEX_ENCODING_UNORM8:
+            return 1;
+        default:
+            return 4;
+    }
+}
+
+static uint32_t EncodedComponents(const GlobeVertexAttribute& attribute) {
+    switch (EncodedComponentSize(attribute.encoding)) {
+        case 2:
+            return attribute.components > 2 ? 4 : 2;
+        case 1:
+            return 4;
+        default:
+            return attribute.components;
+    }
+}
+
+static VkFormat EncodedFormat(const GlobeVertexAttribute& attribute) {
+    static const VkFormat float_formats[5] = {VK_FORMAT_UNDEFINED, VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT,
+                                              VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+    bool wide = EncodedComponents(attribute) > 2;
+    switch (attribute.encoding) {
+        case GLOBE_VERTEX_ENCODING_HALF:
+            return wide ? VK_FORMAT_R16G16B16A16_SFLOAT : VK_FORMAT_R16G16_SFLOAT;
+        case GLOBE_VERTEX_ENCODING_SNORM16:
+            return wide ? VK_FORMAT_R16G16B16A16_SNORM : VK_FORMAT_R16G16_SNORM;
+        case GLOBE_VERTEX_ENCODING_UNORM16:
+            return wide ? VK_FORMAT_R16G16B16A16_UNORM : VK_FORMAT_R16G16_UNORM;
+        case GLOBE_VERTEX_ENCODING_SNORM8:
+            return VK_FORMAT_R8G8B8A8_SNORM;
+        case GLOBE_VERTEX_ENCODING_UNORM8:
+            return VK_FORMAT_R8G8B8A8_UNORM;
+        default:
+            return float_formats[attribute.components];
+    }
+}
+
+static bool IsNormalizedEncoding(uint8_t encoding) {
+    return GLOBE_VERTEX_ENCODING_FLOAT != encoding && GLOBE_VERTEX_ENCODING_HALF != encoding;
+}
+
+// Round to nearest even, with overflow going to infinity and underflow to (signed) zero through the
+// half denormals.
+static uint16_t FloatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    uint32_t exponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+    if (0xFF == exponent) {
+        return static_cast<uint16_t>(sign | 0x7C00 | (0 != mantissa ? 0x200 : 0));
+    }
+    int32_t half_exponent = static_cast<int32_t>(exponent) - 127 + 15;
+    if (half_exponent >= 31) {
+        return static_cast<uint16_t>(sign | 0x7C00);
+    }
+    if (half_exponent <= 0) {
+        if (half_exponent < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        uint32_t shift = static_cast<uint32_t>(14 - half_exponent);
+        uint32_t half_mantissa = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && 0 != (half_mantissa & 1))) {
+            half_mantissa++;
+        }
+        return static_cast<uint16_t>(sign | half_mantissa);
+    }
+    uint32_t half = (static_cast<uint32_t>(half_exponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && 0 != (half & 1))) {
+        half++;  // May carry into the exponent, which still rounds correctly (up to infinity)
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+static void EncodeComponent(uint8_t encoding, float value, uint8_t* output) {
+    switch (encoding) {
+        case GLOBE_VERTEX_ENCODING_HALF: {
+            uint16_t half = FloatToHalf(value);
+            memcpy(output, &half, sizeof(half));
+            break;
+        }
+        case GLOBE_VERTEX_ENCODING_SNORM16: {
+            int16_t snorm = static_cast<int16_t>(std::round(std::min(std::max(value, -1.f), 1.f) * 32767.f));
+            memcpy(output, &snorm, sizeof(snorm));
+            break;
+        }
+        case GLOBE_VERTEX_ENCODING_UNORM16: {
+            uint16_t unorm = static_cast<uint16_t>(std::round(std::min(std::max(value, 0.f), 1.f) * 65535.f));
+            memcpy(output, &unorm, sizeof(unorm));
+            break;
+        }
+        case GLOBE_VERTEX_ENCODING_SNORM8:
+            *reinterpret_cast<int8_t*>(output) =
+                static_cast<int8_t>(std::round(std::min(std::max(value, -1.f), 1.f) * 127.f));
+            break;
+        case GLOBE_VERTEX_ENCODING_UNORM8:
+            *output = static_cast<uint8_t>(std::round(std::min(std::max(value, 0.f), 1.f) * 255.f));
+            break;
+        default:
+            memcpy(output, &value, sizeof(value));
+            break;
+    }
+}
+
+// Writes the imported float vertices into the vertex buffer layout.  Normalized positions are stored
+// relative to the bounding box, and components added to pad an attribute out get the usual defaults.
+static void EncodeVertices(const std::vector<GlobeVertexAttribute>& attributes, const GlobeModel::BoundingBox& bounds,
+                           const float* vertex_data, uint32_t vertex_count, uint8_t* output) {
+    const float default_values[4] = {0.f, 0.f, 0.f, 1.f};
+    float position_scale[3];
+    for (uint32_t comp = 0; comp < 3; ++comp) {
+        position_scale[comp] = bounds.size[comp] > 0.f ? 1.f / bounds.size[comp] : 0.f;
+    }
+    bool normalized_position = IsNormalizedEncoding(attributes[0].encoding);
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        for (uint32_t attribute = 0; attribute < attributes.size(); ++attribute) {
+            uint8_t encoding = attributes[attribute].encoding;
+            uint32_t component_size = EncodedComponentSize(encoding);
+            uint32_t num_components = EncodedComponents(attributes[attribute]);
+            for (uint32_t comp = 0; comp < num_components; ++comp) {
+                float value = default_values[comp];
+                if (comp < attributes[attribute].components) {
+                    value = vertex_data[comp];
+                    if (0 == attribute && normalized_position && comp < 3) {
+                        value = (value - bounds.min[comp]) * position_scale[comp];
+                    }
+                }
+                EncodeComponent(encoding, value, output);
+                output += component_size;
+            }
+            vertex_data += attributes[attribute].components;
+        }
+    }
+}
+
+// Draw binds a single index buffer for all meshes, so 16-bit indices only work when every vertex of the
+// model can be reached with one.
+static bool UseShortIndices(uint32_t vertex_count) { return vertex_count <= 0xFFFF; }
+
+// LODs stop at this error, as a fraction of the bounding box diagonal, or once simplification no longer
+// gets a LOD below this fraction of the triangles of the one before.
+#define GLOBE_MODEL_LOD_MAX_ERROR 0.05f
+#define GLOBE_MODEL_LOD_MIN_REDUCTION 0.75f
+
+void GlobeModel::OptimizeMeshes(const GlobeComponentSizes& sizes, const std::string& model_name,
+                                ModelContent& content) {
+    uint32_t float_stride = 0;
+    for (const auto& attribute : VertexAttributes(sizes)) {
+        float_stride += attribute.components;
+    }
+    if (0 == float_stride) {
+        return;
+    }
+
+    // Each mesh is optimized on its own so its vertices and indices stay one contiguous range.
+    GlobeMeshOptimizer optimizer(float_stride);
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    vertices.reserve(content.vertices.size());
+    indices.reserve(content.indices.size());
+    float misses_before = 0.f;
+    float misses_after = 0.f;
+    for (auto& mesh : content.meshes) {
+        std::vector<float> mesh_vertices(
+            content.vertices.begin() + static_cast<size_t>(mesh.vertex_start) * float_stride,
+            content.vertices.begin() + static_cast<size_t>(mesh.vertex_start + mesh.vertex_count) * float_stride);
+        std::vector<uint32_t> mesh_indices(content.indices.begin() + mesh.index_start,
+                                           content.indices.begin() + mesh.index_start + mesh.index_count);
+        for (auto& index : mesh_indices) {
+            index -= mesh.vertex_start;
+        }
+        float triangle_count = static_cast<float>(mesh.index_count / 3);
+        misses_before += optimizer.Acmr(mesh_indices, mesh.vertex_count) * triangle_count;
+        optimizer.Optimize(mesh_vertices, mesh_indices);
+        mesh.vertex_start = optimizer.VertexCount(vertices);
+        mesh.vertex_count = optimizer.VertexCount(mesh_vertices);
+        mesh.index_start = static_cast<uint32_t>(indices.size());
+        misses_after += optimizer.Acmr(mesh_indices, mesh.vertex_count) * triangle_count;
+        for (auto index : mesh_indices) {
+            indices.push_back(mesh.vertex_start + index);
+        }
+        vertices.insert(vertices.end(), mesh_vertices.begin(), mesh_vertices.end());
+    }
+
+    uint64_t index_size = UseShortIndices(optimizer.VertexCount(vertices)) ? sizeof(uint16_t) : sizeof(uint32_t);
+    uint64_t vertex_bytes_before = content.vertices.size() * sizeof(float);
+    uint64_t vertex_bytes_after = vertices.size() * sizeof(float);
+    uint64_t index_bytes_before = content.indices.size() * sizeof(uint32_t);
+    uint64_t index_bytes_after = indices.size() * index_size;
+    float triangle_count = static_cast<float>(std::max(static_cast<size_t>(1), indices.size() / 3));
+
+    // The lower detail LODs follow LOD 0 in the index list and use the same vertices.  Each one is simplified
+    // from LOD 0 to about half the triangles of the one before, across all meshes at once so the error is
+    // spread evenly and the seams between meshes stay closed.
+    content.lods.clear();
+    content.lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.f});
+    float extent = glm::length(glm::vec3(content.bounding_box.size));
+    while (content.lods.size() < GLOBE_MODEL_MAX_LODS && extent > 0.f) {
+        uint32_t previous_count = content.lods.back().index_count;
+        std::vector<uint32_t> lod_indices(indices.begin(), indices.begin() + content.lods[0].index_count);
+        float error = optimizer.Simplify(vertices, lod_indices, previous_count / 6 * 3,
+                                         GLOBE_MODEL_LOD_MAX_ERROR * extent);
+        if (lod_indices.empty() ||
+            static_cast<float>(lod_indices.size()) > GLOBE_MODEL_LOD_MIN_REDUCTION * previous_count) {
+            break;
+        }
+        optimizer.OptimizeVertexCache(lod_indices, optimizer.VertexCount(vertices));
+        LodInfo lod = {static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lod_indices.size()),
+                       std::max(content.lods.back().error, error / extent)};
+        content.lods.push_back(lod);
+        indices.insert(indices.end(), lod_indices.begin(), lod_indices.end());
+    }
+
+    std::string perf_msg = "Mesh optimizer ";
+    perf_msg += model_name;
+    perf_msg += ": ";
+    perf_msg += std::to_string(optimizer.VertexCount(content.vertices));
+    perf_msg += " -> ";
+    perf_msg += std::to_string(optimizer.VertexCount(vertices));
+    perf_msg += " vertices, ACMR ";
+    perf_msg += std::to_string(misses_before / triangle_count);
+    perf_msg += " -> ";
+    perf_msg += std::to_string(misses_after / triangle_count);
+    perf_msg += ", vertex bytes ";
+    perf_msg += std::to_string(vertex_bytes_before);
+    perf_msg += " -> ";
+    perf_msg += std::to_string(vertex_bytes_after);
+    perf_msg += ", index bytes ";
+    perf_msg += std::to_string(index_bytes_before);
+    perf_msg += " -> ";
+    perf_msg += std::to_string(index_bytes_after);
+    perf_msg += ", ";
+    perf_msg += std::to_string(content.lods.size());
+    perf_msg += " LODs (";
+    for (uint32_t lod = 0; lod < content.lods.size(); ++lod) {
+        perf_msg += 0 == lod ? "" : ", ";
+        perf_msg += std::to_string(content.lods[lod].index_count / 3);
+    }
+    perf_msg += " triangles, ";
+    perf_msg += std::to_string((indices.size() - content.lods[0].index_count) * index_size);
+    perf_msg += " more index bytes)";
+    GlobeLogger::getInstance().LogPerf(perf_msg);
+
+    content.vertices.swap(vertices);
+    content.indices.swap(indices);
+}
+
+GlobeModel* GlobeModel::LoadDaeModelFile(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
+                                         VkDevice vk_device, const GlobeComponentSizes& sizes,
+                                         const std::string& model_name, const std::string& directory) {
+    ModelContent content = {};
+    if (!LoadDaeModelFileContent(sizes, model_name, directory, content)) {
+        return nullptr;
+    }
+    return CreateFromContent(resource_manager, upload_batch, vk_device, model_name, sizes, content);
+}
+
+bool GlobeModel::LoadDaeModelFileContent(const GlobeComponentSizes& sizes, const std::string& model_name,
+                                         const std::string& directory, ModelContent& content) {
     GlobeLogger& logger = GlobeLogger::getInstance();
     std::string model_file_name = directory;
     model_file_name += model_name;
 
+    // Assimp parses the mapped file directly, the extension tells it which importer to use.
+    GlobeFileView model_file;
+    const aiScene* scene_data = nullptr;
     Assimp::Importer importer = {};
-    const aiScene* scene_data = importer.ReadFile(
-        model_file_name.c_str(), (aiProcess_FlipWindingOrder | aiProcess_Triangulate | aiProcess_PreTransformVertices |
-                                  aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals));
+    if (model_file.Open(model_file_name) && model_file.Size() > 0) {
+        std::string extension_hint;
+        size_t extension_start = model_name.find_last_of('.');
+        if (std::string::npos != extension_start) {
+            extension_hint = model_name.substr(extension_start + 1);
+        }
+        scene_data = importer.ReadFileFromMemory(model_file.Data(), model_file.Size(),
+                                                 (aiProcess_FlipWindingOrder | aiProcess_Triangulate |
+                                                  aiProcess_PreTransformVertices | aiProcess_CalcTangentSpace |
+                                                  aiProcess_GenSmoothNormals),
+                                                 extension_hint.c_str());
+    }
     if (nullptr == scene_data) {
         std::string error_message = "Failed to load model for file \"";
         error_message += model_file_name;
         error_message += "\"";
         logger.LogError(error_message);
-        return nullptr;
+        return false;
     }
 
-    BoundingBox bounding_box = {};
+    BoundingBox& bounding_box = content.bounding_box;
     bounding_box.min = glm::vec4(9999999.f, 9999999.f, 9999999.f, 9999999.f);
     bounding_box.max = glm::vec4(-9999999.f, -9999999.f, -9999999.f, -9999999.f);
     bounding_box.size = glm::vec4(0.f, 0.f, 0.f, 0.f);
-    std::vector<MeshInfo> meshes;
+    std::vector<MeshInfo>& meshes = content.meshes;
     meshes.resize(scene_data->mNumMeshes);
-    std::vector<float> vertex_data;
-    std::vector<uint32_t> index_data;
+    std::vector<float>& vertex_data = content.vertices;
+    std::vector<uint32_t>& index_data = content.indices;
     float default_values[4] = {0.f, 0.f, 0.f, 1.f};
     uint32_t vertex_count = 0;
     uint32_t index_count = 0;
@@ -174,8 +524,8 @@ GlobeModel* GlobeModel::LoadDaeModelFile(const GlobeResourceManager* resource_ma
         bounding_box.size.z = bounding_box.max.z - bounding_box.min.z;
         bounding_box.size.w = bounding_box.max.w - bounding_box.min.w;
 
-        uint32_t last_mesh_start = static_cast<uint32_t>(index_data.size());
-        meshes[cur_mesh].index_start += last_mesh_start;
+        // Indices are relative to the mesh, but the vertices of all meshes share one buffer.
+        uint32_t mesh_vertex_start = meshes[cur_mesh].vertex_start;
         for (uint32_t face_index = 0; face_index < ai_mesh->mNumFaces; ++face_index) {
             const aiFace& cur_face = ai_mesh->mFaces[face_index];
             if (cur_face.mNumIndices != 3) {
@@ -183,7 +533,7 @@ GlobeModel* GlobeModel::LoadDaeModelFile(const GlobeResourceManager* resource_ma
                 continue;
             }
             for (uint8_t vert_index = 0; vert_index < cur_face.mNumIndices; ++vert_index) {
-                index_data.push_back(last_mesh_start + cur_face.mIndices[vert_index]);
+                index_data.push_back(mesh_vertex_start + cur_face.mIndices[vert_index]);
                 meshes[cur_mesh].index_count++;
             }
         }
@@ -191,9 +541,135 @@ GlobeModel* GlobeModel::LoadDaeModelFile(const GlobeResourceManager* resource_ma
         vertex_count += meshes[cur_mesh].vertex_count;
         index_count += meshes[cur_mesh].index_count;
     }
+    OptimizeMeshes(sizes, model_name, content);
+
+    content.vertex_data = vertex_data.data();
+    content.vertex_float_count = static_cast<uint32_t>(vertex_data.size());
+    content.index_data = index_data.data();
+    content.index_count = static_cast<uint32_t>(index_data.size());
+    return true;
+}
+
+std::string GlobeModel::ModelCacheFileName(const GlobeComponentSizes& sizes, const std::string& model_name,
+                                           const std::string& directory, const std::string& cache_directory) {
+    // The file name is unique per source path and vertex layout, the source contents are checked against
+    // the hash stored in the header.
+    std::string key = directory + model_name;
+    uint64_t key_hash = GlobeHashData(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+    key_hash ^= GlobeHashData(reinterpret_cast<const uint8_t*>(&sizes), sizeof(GlobeComponentSizes));
+    char key_string[17];
+    snprintf(key_string, sizeof(key_string), "%016llx", static_cast<unsigned long long>(key_hash));
+
+    std::string file_name = cache_directory;
+    file_name += directory_symbol;
+    for (auto cur_char : model_name) {
+        file_name += isalnum(static_cast<unsigned char>(cur_char)) ? static_cast<char>(tolower(cur_char)) : '_';
+    }
+    file_name += '_';
+    file_name += key_string;
+    file_name += ".model_cache";
+    return file_name;
+}
+
+bool GlobeModel::LoadModelCache(const std::string& cache_file_name, uint64_t source_hash,
+                                const GlobeComponentSizes& sizes, ModelContent& content) {
+    GlobeFileView cache_view;
+    if (!cache_view.Open(cache_file_name) || cache_view.Size() < sizeof(GlobeModelCacheHeader)) {
+        return false;
+    }
+    GlobeModelCacheHeader header = {};
+    memcpy(&header, cache_view.Data(), sizeof(GlobeModelCacheHeader));
+    uint64_t meshes_size = static_cast<uint64_t>(header.mesh_count) * sizeof(MeshInfo);
+    uint64_t vertices_size = static_cast<uint64_t>(header.vertex_float_count) * sizeof(float);
+    uint64_t indices_size = static_cast<uint64_t>(header.index_count) * sizeof(uint32_t);
+    bool lods_valid = header.lod_count <= GLOBE_MODEL_MAX_LODS;
+    for (uint32_t lod = 0; lods_valid && lod < header.lod_count; ++lod) {
+        lods_valid = static_cast<uint64_t>(header.lods[lod].index_start) + header.lods[lod].index_count <=
+                     header.index_count;
+    }
+    if (GLOBE_MODEL_CACHE_MAGIC != header.magic || GLOBE_MODEL_CACHE_VERSION != header.version ||
+        sizeof(MeshInfo) != header.mesh_info_size || source_hash != header.source_hash ||
+        0 != memcmp(&sizes, &header.sizes, sizeof(GlobeComponentSizes)) ||
+        header.meshes_offset + meshes_size > cache_view.Size() ||
+        header.vertices_offset + vertices_size > cache_view.Size() ||
+        header.indices_offset + indices_size > cache_view.Size() || 0 != (header.vertices_offset % sizeof(float)) ||
+        0 != (header.indices_offset % sizeof(uint32_t)) || !lods_valid) {
+        GlobeLogger::getInstance().LogInfo("Model cache " + cache_file_name + " is out of date");
+        return false;
+    }
 
+    // Only the small mesh table is copied, the vertices and indices are uploaded straight out of the mapping.
+    content.meshes.resize(header.mesh_count);
+    if (header.mesh_count > 0) {
+        memcpy(content.meshes.data(), cache_view.Data() + header.meshes_offset, static_cast<size_t>(meshes_size));
+    }
+    content.lods.assign(header.lods, header.lods + header.lod_count);
+    memcpy(&content.bounding_box, header.bounding_box, sizeof(header.bounding_box));
+    content.vertices.clear();
+    content.indices.clear();
+    content.vertex_data = reinterpret_cast<const float*>(cache_view.Data() + header.vertices_offset);
+    content.vertex_float_count = header.vertex_float_count;
+    content.index_data = reinterpret_cast<const uint32_t*>(cache_view.Data() + header.indices_offset);
+    content.index_count = header.index_count;
+    content.cache_view = cache_view;
+    return true;
+}
+
+bool GlobeModel::SaveModelCache(const std::string& cache_file_name, uint64_t source_hash,
+                                const GlobeComponentSizes& sizes, const ModelContent& content) {
+    GlobeModelCacheHeader header = {};
+    header.magic = GLOBE_MODEL_CACHE_MAGIC;
+    header.version = GLOBE_MODEL_CACHE_VERSION;
+    header.mesh_info_size = sizeof(MeshInfo);
+    header.source_hash = source_hash;
+    header.sizes = sizes;
+    header.mesh_count = static_cast<uint32_t>(content.meshes.size());
+    header.vertex_float_count = content.vertex_float_count;
+    header.index_count = content.index_count;
+    header.lod_count = static_cast<uint32_t>(std::min(content.lods.size(), static_cast<size_t>(GLOBE_MODEL_MAX_LODS)));
+    std::copy(content.lods.begin(), content.lods.begin() + header.lod_count, header.lods);
+    memcpy(header.bounding_box, &content.bounding_box, sizeof(header.bounding_box));
+    header.meshes_offset = sizeof(GlobeModelCacheHeader);
+    header.vertices_offset = header.meshes_offset + content.meshes.size() * sizeof(MeshInfo);
+    header.indices_offset = header.vertices_offset + content.vertex_float_count * sizeof(float);
+
+    // Write to a temporary file first so a concurrent or interrupted load never sees a partial cache.
+    std::string temp_file_name = cache_file_name + ".tmp";
+    FILE* file_ptr = fopen(temp_file_name.c_str(), "wb");
+    if (nullptr == file_ptr) {
+        GlobeLogger::getInstance().LogWarning("Failed to create model cache " + cache_file_name);
+        return false;
+    }
+    bool success = 1 == fwrite(&header, sizeof(GlobeModelCacheHeader), 1, file_ptr);
+    if (success && !content.meshes.empty()) {
+        success = 1 == fwrite(content.meshes.data(), content.meshes.size() * sizeof(MeshInfo), 1, file_ptr);
+    }
+    if (success && content.vertex_float_count > 0) {
+        success = 1 == fwrite(content.vertex_data, content.vertex_float_count * sizeof(float), 1, file_ptr);
+    }
+    if (success && content.index_count > 0) {
+        success = 1 == fwrite(content.index_data, content.index_count * sizeof(uint32_t), 1, file_ptr);
+    }
+    success = (0 == fclose(file_ptr)) && success;
+    if (success) {
+        remove(cache_file_name.c_str());
+        success = 0 == rename(temp_file_name.c_str(), cache_file_name.c_str());
+    }
+    if (!success) {
+        remove(temp_file_name.c_str());
+        GlobeLogger::getInstance().LogWarning("Failed to write model cache " + cache_file_name);
+        return false;
+    }
+    GlobeLogger::getInstance().LogInfo("Wrote model cache " + cache_file_name);
+    return true;
+}
+
+GlobeModel* GlobeModel::CreateFromContent(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
+                                          VkDevice vk_device, const std::string& model_name,
+                                          const GlobeComponentSizes& sizes, ModelContent& content,
+                                          GlobeHostCopyPolicy host_copy_policy) {
     GlobeModel* model =
-        new GlobeModel(resource_manager, vk_device, model_name, sizes, meshes, bounding_box, vertex_data, index_data);
+        new GlobeModel(resource_manager, upload_batch, vk_device, model_name, sizes, content, host_copy_policy);
     if (model != nullptr && !model->IsValid()) {
         delete model;
         model = nullptr;
@@ -201,10 +677,24 @@ GlobeModel* GlobeModel::LoadDaeModelFile(const GlobeResourceManager* resource_ma
     return model;
 }
 
-GlobeModel* GlobeModel::LoadModelFile(const GlobeResourceManager* resource_manager, VkDevice vk_device,
-                                      const GlobeComponentSizes& sizes, const std::string& model_name,
-                                      const std::string& directory) {
+GlobeModel* GlobeModel::LoadModelFile(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
+                                      VkDevice vk_device, const GlobeComponentSizes& sizes,
+                                      const std::string& model_name, const std::string& directory,
+                                      const std::string& cache_directory, GlobeHostCopyPolicy host_copy_policy) {
+    ModelContent content = {};
+    if (!LoadModelFileContent(sizes, model_name, directory, content, cache_directory)) {
+        return nullptr;
+    }
+    return CreateFromContent(resource_manager, upload_batch, vk_device, model_name, sizes, content,
+                             host_copy_policy);
+}
+
+bool GlobeModel::LoadModelFileContent(const GlobeComponentSizes& sizes, const std::string& model_name,
+                                      const std::string& directory, ModelContent& content,
+                                      const std::string& cache_directory) {
     GlobeLogger& logger = GlobeLogger::getInstance();
+    content.directory = directory;
+    content.cache_directory = cache_directory;
     size_t period_pos = model_name.find_last_of(".");
     std::string model_suffix = model_name.substr(period_pos + 1);
 
@@ -212,7 +702,25 @@ GlobeModel* GlobeModel::LoadModelFile(const GlobeResourceManager* resource_manag
     std::transform(model_suffix.begin(), model_suffix.end(), model_suffix.begin(), ::tolower);
 
     if (model_suffix == "dae") {
-        return LoadDaeModelFile(resource_manager, vk_device, sizes, model_name, directory);
+        std::string cache_file_name;
+        uint64_t source_hash = 0;
+        if (!cache_directory.empty()) {
+            GlobeFileView source_file;
+            if (source_file.Open(directory + model_name)) {
+                source_hash = GlobeHashData(source_file.Data(), source_file.Size());
+                cache_file_name = ModelCacheFileName(sizes, model_name, directory, cache_directory);
+                if (LoadModelCache(cache_file_name, source_hash, sizes, content)) {
+                    return true;
+                }
+            }
+        }
+        if (!LoadDaeModelFileContent(sizes, model_name, directory, content)) {
+            return false;
+        }
+        if (!cache_file_name.empty()) {
+            SaveModelCache(cache_file_name, source_hash, sizes, content);
+        }
+        return true;
     } else {
         std::string error_message = "Failed to load unknown model type ";
         error_message += model_suffix;
@@ -220,207 +728,149 @@ GlobeModel* GlobeModel::LoadModelFile(const GlobeResourceManager* resource_manag
         error_message += directory + model_name;
         error_message += ")";
         logger.LogFatalError(error_message);
-        return nullptr;
+        return false;
     }
 }
 
-GlobeModel::GlobeModel(const GlobeResourceManager* resource_manager, VkDevice vk_device, const std::string& model_name,
-                       const GlobeComponentSizes& sizes, std::vector<MeshInfo>& meshes, const BoundingBox& bounding_box,
-                       std::vector<float>& vertices, std::vector<uint32_t>& indices)
-    : _globe_resource_mgr(resource_manager),
+GlobeModel::GlobeModel(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch, VkDevice vk_device,
+                       const std::string& model_name, const GlobeComponentSizes& sizes, ModelContent& content,
+                       GlobeHostCopyPolicy host_copy_policy)
+    : _is_valid(false),
+      _globe_resource_mgr(resource_manager),
       _vk_device(vk_device),
       _model_name(model_name),
-      _bounding_box(bounding_box) {
+      _directory(content.directory),
+      _cache_directory(content.cache_directory),
+      _sizes(sizes),
+      _has_host_copy(false),
+      _bounding_box(content.bounding_box) {
     GlobeLogger& logger = GlobeLogger::getInstance();
-    uint8_t tc = 0;
-    uint8_t* mapped_data = nullptr;
 
-    _meshes.swap(meshes);
-    _vertices.swap(vertices);
-    _indices.swap(indices);
-    _vertex_buffer.vk_size = 0;
+    // Upload from wherever the content lives (imported vectors or the mapped model cache).
+    const float* vertex_data = content.vertex_data;
+    const uint32_t* index_data = content.index_data;
+    VkDeviceSize vertex_data_size = content.vertex_float_count * sizeof(float);
+    VkDeviceSize index_data_size = content.index_count * sizeof(uint32_t);
+    std::vector<GlobeVertexAttribute> attributes = VertexAttributes(sizes);
+    uint32_t float_stride = 0;
+    uint32_t vertex_stride = 0;
+    for (const auto& attribute : attributes) {
+        float_stride += attribute.components;
+        vertex_stride += EncodedComponents(attribute) * EncodedComponentSize(attribute.encoding);
+    }
+    uint32_t vertex_count = float_stride > 0 ? content.vertex_float_count / float_stride : 0;
+    _index_count = content.index_count;
+    _vk_index_type = UseShortIndices(vertex_count) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    _meshes.swap(content.meshes);
+    _lods.swap(content.lods);
+    if (_lods.empty()) {
+        _lods.push_back({0, _index_count, 0.f});
+    }
     _vertex_buffer.vk_buffer = VK_NULL_HANDLE;
-    _vertex_buffer.vk_memory = VK_NULL_HANDLE;
-    _index_buffer.vk_size = 0;
+    _vertex_buffer.memory = {};
     _index_buffer.vk_buffer = VK_NULL_HANDLE;
-    _index_buffer.vk_memory = VK_NULL_HANDLE;
+    _index_buffer.memory = {};
 
-    // Create and fill in the vertex buffer
-    VkBufferCreateInfo buffer_create_info = {};
-    buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    buffer_create_info.pNext = nullptr;
-    buffer_create_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    buffer_create_info.size = _vertices.size() * sizeof(float);
-    buffer_create_info.queueFamilyIndexCount = 0;
-    buffer_create_info.pQueueFamilyIndices = nullptr;
-    buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    buffer_create_info.flags = 0;
-    if (VK_SUCCESS != vkCreateBuffer(_vk_device, &buffer_create_info, NULL, &_vertex_buffer.vk_buffer)) {
-        std::string error_message = "Failed to create model ";
-        error_message += model_name;
-        error_message += "\'s vertex buffer";
-        logger.LogFatalError(error_message);
-        return;
+    // Encoded vertices and 16-bit indices are converted up front, everything else goes in as it is.
+    VkDeviceSize vertex_buffer_size = static_cast<VkDeviceSize>(vertex_count) * vertex_stride;
+    const uint8_t* vertex_buffer_data = reinterpret_cast<const uint8_t*>(vertex_data);
+    std::vector<uint8_t> encoded_vertices;
+    if (vertex_stride != float_stride * sizeof(float)) {
+        encoded_vertices.resize(static_cast<size_t>(vertex_buffer_size));
+        EncodeVertices(attributes, _bounding_box, vertex_data, vertex_count, encoded_vertices.data());
+        vertex_buffer_data = encoded_vertices.data();
     }
-    if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
-            _vertex_buffer.vk_buffer, (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-            _vertex_buffer.vk_memory, _vertex_buffer.vk_size)) {
-        std::string error_message = "Failed to allocate model ";
-        error_message += model_name;
-        error_message += "\'s vertex buffer memory";
-        logger.LogFatalError(error_message);
-        return;
-    }
-    if (VK_SUCCESS !=
-        vkMapMemory(_vk_device, _vertex_buffer.vk_memory, 0, _vertex_buffer.vk_size, 0, (void**)&mapped_data)) {
-        std::string error_message = "Failed to map model ";
-        error_message += model_name;
-        error_message += "\'s vertex buffer memory";
-        logger.LogFatalError(error_message);
-        return;
-    }
-    memcpy(mapped_data, _vertices.data(), _vertices.size() * sizeof(float));
-    vkUnmapMemory(_vk_device, _vertex_buffer.vk_memory);
-    if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _vertex_buffer.vk_buffer, _vertex_buffer.vk_memory, 0)) {
-        std::string error_message = "Failed to bind model ";
-        error_message += model_name;
-        error_message += "\'s vertex buffer memory";
-        logger.LogFatalError(error_message);
-        return;
+    VkDeviceSize index_buffer_size = index_data_size;
+    const uint8_t* index_buffer_data = reinterpret_cast<const uint8_t*>(index_data);
+    std::vector<uint16_t> short_indices;
+    if (VK_INDEX_TYPE_UINT16 == _vk_index_type) {
+        short_indices.resize(_index_count);
+        for (uint32_t index = 0; index < _index_count; ++index) {
+            short_indices[index] = static_cast<uint16_t>(index_data[index]);
+        }
+        index_buffer_size = short_indices.size() * sizeof(uint16_t);
+        index_buffer_data = reinterpret_cast<const uint8_t*>(short_indices.data());
     }
 
-    // Create and fill in the index buffer
-    buffer_create_info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-    buffer_create_info.size = _indices.size() * sizeof(uint32_t);
-    if (VK_SUCCESS != vkCreateBuffer(_vk_device, &buffer_create_info, NULL, &_index_buffer.vk_buffer)) {
-        std::string error_message = "Failed to create model ";
-        error_message += model_name;
-        error_message += "\'s index buffer";
-        logger.LogFatalError(error_message);
-        return;
+    // Device local geometry is copied in through the staging ring, using a batch of our own that is submitted
+    // and waited on before we return if the caller didn't pass one.
+    GlobeUploadBatch* batch = nullptr;
+    if (GLOBE_GEOMETRY_MEMORY_DEVICE_LOCAL == _globe_resource_mgr->GeometryMemoryPolicy()) {
+        batch = nullptr != upload_batch ? upload_batch : _globe_resource_mgr->BeginUploadBatch();
+        if (nullptr == batch) {
+            std::string error_message = "Failed starting upload batch for model ";
+            error_message += model_name;
+            logger.LogFatalError(error_message);
+            return;
+        }
     }
-    if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
-            _index_buffer.vk_buffer, (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-            _index_buffer.vk_memory, _index_buffer.vk_size)) {
-        std::string error_message = "Failed to allocate model ";
-        error_message += model_name;
-        error_message += "\'s index buffer memory";
-        logger.LogFatalError(error_message);
-        return;
+    bool buffers_created =
+        CreateGeometryBuffer(batch, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+                             vertex_buffer_data, vertex_buffer_size, "vertex", _vertex_buffer) &&
+        CreateGeometryBuffer(batch, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_ACCESS_INDEX_READ_BIT, index_buffer_data,
+                             index_buffer_size, "index", _index_buffer);
+    if (nullptr != batch && nullptr == upload_batch) {
+        if (buffers_created && !batch->Submit(true)) {
+            std::string error_message = "Failed submitting upload batch for model ";
+            error_message += model_name;
+            logger.LogFatalError(error_message);
+            buffers_created = false;
+        }
+        _globe_resource_mgr->FreeUploadBatch(batch);
     }
-    if (VK_SUCCESS !=
-        vkMapMemory(_vk_device, _index_buffer.vk_memory, 0, _index_buffer.vk_size, 0, (void**)&mapped_data)) {
-        std::string error_message = "Failed to map model ";
-        error_message += model_name;
-        error_message += "\'s index buffer memory";
-        logger.LogFatalError(error_message);
+    if (!buffers_created) {
+        // The caller's batch may already hold a copy into the vertex buffer and gets submitted later, so the
+        // buffers have to outlive it.  Hand them to the deferred frees and leave nothing for the destructor.
+        if (nullptr != batch && nullptr != upload_batch) {
+            GlobeResourceManager* globe_resource_mgr = _globe_resource_mgr;
+            VkDevice device = _vk_device;
+            GlobeVulkanBuffer vertex_buffer = _vertex_buffer;
+            GlobeVulkanBuffer index_buffer = _index_buffer;
+            _globe_resource_mgr->DeferredFree([globe_resource_mgr, device, vertex_buffer, index_buffer]() mutable {
+                if (VK_NULL_HANDLE != index_buffer.vk_buffer) {
+                    vkDestroyBuffer(device, index_buffer.vk_buffer, nullptr);
+                }
+                if (VK_NULL_HANDLE != vertex_buffer.vk_buffer) {
+                    vkDestroyBuffer(device, vertex_buffer.vk_buffer, nullptr);
+                }
+                globe_resource_mgr->FreeDeviceMemory(index_buffer.memory);
+                globe_resource_mgr->FreeDeviceMemory(vertex_buffer.memory);
+            });
+            _vertex_buffer.vk_buffer = VK_NULL_HANDLE;
+            _vertex_buffer.memory = {};
+            _index_buffer.vk_buffer = VK_NULL_HANDLE;
+            _index_buffer.memory = {};
+        }
         return;
     }
-    memcpy(mapped_data, _indices.data(), _indices.size() * sizeof(uint32_t));
-    vkUnmapMemory(_vk_device, _index_buffer.vk_memory);
-    if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _index_buffer.vk_buffer, _index_buffer.vk_memory, 0)) {
-        std::string error_message = "Failed to bind model ";
-        error_message += model_name;
-        error_message += "\'s index buffer memory";
-        logger.LogFatalError(error_message);
-        return;
+
+    // The buffers were either written directly or the data copied into the staging ring, so the host copy is
+    // no longer needed by the time we get here.  Keep it only if asked to, taking it out of the mapped model
+    // cache if that's where it is.
+    VkDeviceSize host_copy_size = vertex_data_size + index_data_size;
+    if (GLOBE_HOST_COPY_RELEASE == host_copy_policy) {
+        _globe_resource_mgr->TrackHostCopy(0, host_copy_size);
+    } else {
+        if (content.vertices.empty()) {
+            _vertices.assign(vertex_data, vertex_data + content.vertex_float_count);
+            _indices.assign(index_data, index_data + content.index_count);
+        } else {
+            _vertices.swap(content.vertices);
+            _indices.swap(content.indices);
+        }
+        _has_host_copy = true;
+        _globe_resource_mgr->TrackHostCopy(host_copy_size, 0);
     }
 
     // No need to tell it anything about input state right now.
-    VkFormat data_formats[5] = {VK_FORMAT_UNDEFINED, VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT,
-                                VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
-    uint32_t cur_binding = 0;
-    uint32_t cur_location = 0;
     uint32_t cur_offset = 0;
-
-    VkVertexInputAttributeDescription vert_input_attrib_desc = {};
-    vert_input_attrib_desc.binding = cur_binding;
-    vert_input_attrib_desc.location = cur_location++;
-    vert_input_attrib_desc.format = data_formats[sizes.position];
-    vert_input_attrib_desc.offset = cur_offset;
-    cur_offset += (sizes.position * sizeof(float));
-    _vk_vert_attrib_desc.push_back(vert_input_attrib_desc);
-    if (sizes.normal > 0) {
-        vert_input_attrib_desc = {};
-        vert_input_attrib_desc.binding = cur_binding;
-        vert_input_attrib_desc.location = cur_location++;
-        vert_input_attrib_desc.format = data_formats[sizes.normal];
-        vert_input_attrib_desc.offset = cur_offset;
-        cur_offset += (sizes.normal * sizeof(float));
-        _vk_vert_attrib_desc.push_back(vert_input_attrib_desc);
-    }
-    if (sizes.diffuse_color > 0) {
-        vert_input_attrib_desc = {};
-        vert_input_attrib_desc.binding = cur_binding;
-        vert_input_attrib_desc.location = cur_location++;
-        vert_input_attrib_desc.format = data_formats[sizes.diffuse_color];
-        vert_input_attrib_desc.offset = cur_offset;
-        cur_offset += (sizes.diffuse_color * sizeof(float));
-        _vk_vert_attrib_desc.push_back(vert_input_attrib_desc);
-    }
-    if (sizes.ambient_color > 0) {
-        vert_input_attrib_desc = {};
-        vert_input_attrib_desc.binding = cur_binding;
-        vert_input_attrib_desc.location = cur_location++;
-        vert_input_attrib_desc.format = data_formats[sizes.ambient_color];
-        vert_input_attrib_desc.offset = cur_offset;
-        cur_offset += (sizes.ambient_color * sizeof(float));
-        _vk_vert_attrib_desc.push_back(vert_input_attrib_desc);
-    }
-    if (sizes.specular_color > 0) {
-        vert_input_attrib_desc = {};
-        vert_input_attrib_desc.binding = cur_binding;
-        vert_input_attrib_desc.location = cur_location++;
-        vert_input_attrib_desc.format = data_formats[sizes.specular_color];
-        vert_input_attrib_desc.offset = cur_offset;
-        cur_offset += (sizes.specular_color * sizeof(float));
-        _vk_vert_attrib_desc.push_back(vert_input_attrib_desc);
-    }
-    if (sizes.emissive_color > 0) {
-        vert_input_attrib_desc = {};
-        vert_input_attrib_desc.binding = cur_binding;
-        vert_input_attrib_desc.location = cur_location++;
-        vert_input_attrib_desc.format = data_formats[sizes.emissive_color];
-        vert_input_attrib_desc.offset = cur_offset;
-        cur_offset += (sizes.emissive_color * sizeof(float));
-        _vk_vert_attrib_desc.push_back(vert_input_attrib_desc);
-    }
-    if (sizes.shininess > 0) {
-        vert_input_attrib_desc = {};
-        vert_input_attrib_desc.binding = cur_binding;
-        vert_input_attrib_desc.location = cur_location++;
-        vert_input_attrib_desc.format = data_formats[sizes.shininess];
-        vert_input_attrib_desc.offset = cur_offset;
-        cur_offset += (sizes.shininess * sizeof(float));
-        _vk_vert_attrib_desc.push_back(vert_input_attrib_desc);
-    }
-    for (tc = 0; tc < 3; ++tc) {
-        if (sizes.texcoord[tc] > 0) {
-            vert_input_attrib_desc = {};
-            vert_input_attrib_desc.binding = cur_binding;
-            vert_input_attrib_desc.location = cur_location++;
-            vert_input_attrib_desc.format = data_formats[sizes.texcoord[tc]];
-            vert_input_attrib_desc.offset = cur_offset;
-            cur_offset += (sizes.texcoord[tc] * sizeof(float));
-            _vk_vert_attrib_desc.push_back(vert_input_attrib_desc);
-        }
-    }
-    if (sizes.tangent > 0) {
-        vert_input_attrib_desc = {};
-        vert_input_attrib_desc.binding = cur_binding;
-        vert_input_attrib_desc.location = cur_location++;
-        vert_input_attrib_desc.format = data_formats[sizes.tangent];
-        vert_input_attrib_desc.offset = cur_offset;
-        cur_offset += (sizes.tangent * sizeof(float));
-        _vk_vert_attrib_desc.push_back(vert_input_attrib_desc);
-    }
-    if (sizes.bitangent > 0) {
-        vert_input_attrib_desc = {};
-        vert_input_attrib_desc.binding = cur_binding;
-        vert_input_attrib_desc.location = cur_location++;
-        vert_input_attrib_desc.format = data_formats[sizes.bitangent];
+    for (uint32_t attribute = 0; attribute < attributes.size(); ++attribute) {
+        VkVertexInputAttributeDescription vert_input_attrib_desc = {};
+        vert_input_attrib_desc.binding = 0;
+        vert_input_attrib_desc.location = attribute;
+        vert_input_attrib_desc.format = EncodedFormat(attributes[attribute]);
         vert_input_attrib_desc.offset = cur_offset;
-        cur_offset += (sizes.bitangent * sizeof(float));
+        cur_offset += EncodedComponents(attributes[attribute]) * EncodedComponentSize(attributes[attribute].encoding);
         _vk_vert_attrib_desc.push_back(vert_input_attrib_desc);
     }
 
@@ -438,9 +888,95 @@ GlobeModel::GlobeModel(const GlobeResourceManager* resource_manager, VkDevice vk
     _vk_pipeline_vert_create_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(_vk_vert_attrib_desc.size());
     _vk_pipeline_vert_create_info.pVertexAttributeDescriptions = _vk_vert_attrib_desc.data();
 
+    // The instanced state is the same plus one model matrix per instance, a column per attribute.
+    VkVertexInputBindingDescription inst_binding_desc = {};
+    inst_binding_desc.binding = GLOBE_MODEL_INSTANCE_BINDING;
+    inst_binding_desc.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    inst_binding_desc.stride = sizeof(glm::mat4);
+    _vk_inst_binding_desc.push_back(_vk_vert_binding_desc);
+    _vk_inst_binding_desc.push_back(inst_binding_desc);
+    _vk_inst_attrib_desc = _vk_vert_attrib_desc;
+    for (uint32_t column = 0; column < 4; ++column) {
+        VkVertexInputAttributeDescription inst_attrib_desc = {};
+        inst_attrib_desc.binding = GLOBE_MODEL_INSTANCE_BINDING;
+        inst_attrib_desc.location = static_cast<uint32_t>(_vk_vert_attrib_desc.size()) + column;
+        inst_attrib_desc.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        inst_attrib_desc.offset = column * sizeof(glm::vec4);
+        _vk_inst_attrib_desc.push_back(inst_attrib_desc);
+    }
+    _vk_pipeline_inst_create_info = _vk_pipeline_vert_create_info;
+    _vk_pipeline_inst_create_info.vertexBindingDescriptionCount = static_cast<uint32_t>(_vk_inst_binding_desc.size());
+    _vk_pipeline_inst_create_info.pVertexBindingDescriptions = _vk_inst_binding_desc.data();
+    _vk_pipeline_inst_create_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(_vk_inst_attrib_desc.size());
+    _vk_pipeline_inst_create_info.pVertexAttributeDescriptions = _vk_inst_attrib_desc.data();
+
     _is_valid = true;
 }
 
+bool GlobeModel::CreateGeometryBuffer(GlobeUploadBatch* upload_batch, VkBufferUsageFlags vk_usage,
+                                      VkAccessFlags vk_target_access, const uint8_t* data, VkDeviceSize size,
+                                      const std::string& buffer_name, GlobeVulkanBuffer& buffer) {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    VkBufferCreateInfo buffer_create_info = {};
+    buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_create_info.pNext = nullptr;
+    buffer_create_info.usage = vk_usage;
+    if (nullptr != upload_batch) {
+        buffer_create_info.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    }
+    buffer_create_info.size = size;
+    buffer_create_info.queueFamilyIndexCount = 0;
+    buffer_create_info.pQueueFamilyIndices = nullptr;
+    buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    buffer_create_info.flags = 0;
+    if (VK_SUCCESS != vkCreateBuffer(_vk_device, &buffer_create_info, NULL, &buffer.vk_buffer)) {
+        std::string error_message = "Failed to create model ";
+        error_message += _model_name;
+        error_message += "\'s " + buffer_name + " buffer";
+        logger.LogFatalError(error_message);
+        return false;
+    }
+    VkMemoryPropertyFlags vk_memory_properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    if (nullptr == upload_batch) {
+        vk_memory_properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    }
+    if (!_globe_resource_mgr->AllocateDeviceBufferMemory(buffer.vk_buffer, vk_memory_properties, buffer.memory)) {
+        std::string error_message = "Failed to allocate model ";
+        error_message += _model_name;
+        error_message += "\'s " + buffer_name + " buffer memory";
+        logger.LogFatalError(error_message);
+        return false;
+    }
+    if (VK_SUCCESS !=
+        vkBindBufferMemory(_vk_device, buffer.vk_buffer, buffer.memory.vk_memory, buffer.memory.vk_offset)) {
+        std::string error_message = "Failed to bind model ";
+        error_message += _model_name;
+        error_message += "\'s " + buffer_name + " buffer memory";
+        logger.LogFatalError(error_message);
+        return false;
+    }
+
+    if (nullptr == upload_batch) {
+        if (nullptr == buffer.memory.mapped_data) {
+            std::string error_message = "Failed to map model ";
+            error_message += _model_name;
+            error_message += "\'s " + buffer_name + " buffer memory";
+            logger.LogFatalError(error_message);
+            return false;
+        }
+        memcpy(buffer.memory.mapped_data, data, static_cast<size_t>(size));
+    } else if (!_globe_resource_mgr->StageBufferUpload(upload_batch, buffer.vk_buffer, 0, data, size) ||
+               !upload_batch->FinishBuffer(buffer.vk_buffer, 0, size, vk_target_access,
+                                           VK_PIPELINE_STAGE_VERTEX_INPUT_BIT)) {
+        std::string error_message = "Failed to upload model ";
+        error_message += _model_name;
+        error_message += "\'s " + buffer_name + " buffer";
+        logger.LogFatalError(error_message);
+        return false;
+    }
+    return true;
+}
+
 GlobeModel::~GlobeModel() {
     if (VK_NULL_HANDLE != _index_buffer.vk_buffer) {
         vkDestroyBuffer(_vk_device, _index_buffer.vk_buffer, nullptr);
@@ -450,8 +986,26 @@ GlobeModel::~GlobeModel() {
         vkDestroyBuffer(_vk_device, _vertex_buffer.vk_buffer, nullptr);
         _vertex_buffer.vk_buffer = VK_NULL_HANDLE;
     }
-    _globe_resource_mgr->FreeDeviceMemory(_index_buffer.vk_memory);
-    _globe_resource_mgr->FreeDeviceMemory(_vertex_buffer.vk_memory);
+    _globe_resource_mgr->FreeDeviceMemory(_index_buffer.memory);
+    _globe_resource_mgr->FreeDeviceMemory(_vertex_buffer.memory);
+    if (_has_host_copy) {
+        _globe_resource_mgr->UntrackHostCopy(_vertices.size() * sizeof(float) + _indices.size() * sizeof(uint32_t));
+    }
+}
+
+bool GlobeModel::GetHostGeometry(std::vector<float>& vertices, std::vector<uint32_t>& indices) const {
+    if (_has_host_copy) {
+        vertices = _vertices;
+        indices = _indices;
+        return true;
+    }
+    ModelContent content = {};
+    if (!LoadModelFileContent(_sizes, _model_name, _directory, content, _cache_directory)) {
+        return false;
+    }
+    vertices.assign(content.vertex_data, content.vertex_data + content.vertex_float_count);
+    indices.assign(content.index_data, content.index_data + content.index_count);
+    return true;
 }
 
 void GlobeModel::GetSize(float& x, float& y, float& z) {
@@ -466,13 +1020,71 @@ void GlobeModel::GetCenter(float& x, float& y, float& z) {
     z = (_bounding_box.max[2] + _bounding_box.min[2]) * 0.5f;
 }
 
-void GlobeModel::FillInPipelineInfo(VkGraphicsPipelineCreateInfo& graphics_pipeline_c_i) {
-    graphics_pipeline_c_i.pVertexInputState = &_vk_pipeline_vert_create_info;
+glm::mat4 GlobeModel::GetPositionDequantization() const {
+    if (!IsNormalizedEncoding(_sizes.position_encoding)) {
+        return glm::mat4(1.f);
+    }
+    glm::mat4 dequantization = glm::translate(glm::mat4(1.f), glm::vec3(_bounding_box.min));
+    return glm::scale(dequantization, glm::vec3(_bounding_box.size));
+}
+
+void GlobeModel::FillInPipelineInfo(VkGraphicsPipelineCreateInfo& graphics_pipeline_c_i, bool instanced) {
+    if (instanced) {
+        graphics_pipeline_c_i.pVertexInputState = &_vk_pipeline_inst_create_info;
+    } else {
+        graphics_pipeline_c_i.pVertexInputState = &_vk_pipeline_vert_create_info;
+    }
+}
+
+uint32_t GlobeModel::SelectLod(GlobeCamera& camera, const glm::mat4& model_matrix, float viewport_height,
+                               float max_pixel_error) const {
+    float scale = std::max(std::max(glm::length(glm::vec3(model_matrix[0])), glm::length(glm::vec3(model_matrix[1]))),
+                           glm::length(glm::vec3(model_matrix[2])));
+    glm::vec4 center = model_matrix * glm::vec4(glm::vec3(_bounding_box.min + _bounding_box.size * 0.5f), 1.f);
+    float projected_size =
+        camera.ProjectedSize(glm::vec3(center), glm::length(glm::vec3(_bounding_box.size)) * scale, viewport_height);
+
+    // The coarsest LOD whose error still stays under the limit once projected.
+    uint32_t lod = static_cast<uint32_t>(_lods.size()) - 1;
+    while (lod > 0 && _lods[lod].error * projected_size > max_pixel_error) {
+        lod--;
+    }
+    return lod;
+}
+
+void GlobeModel::Draw(VkCommandBuffer& command_buffer, uint32_t lod) {
+    const LodInfo& lod_info = _lods[std::min(lod, static_cast<uint32_t>(_lods.size()) - 1)];
+    const VkDeviceSize vert_buffer_offset = 0;
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &_vertex_buffer.vk_buffer, &vert_buffer_offset);
+    vkCmdBindIndexBuffer(command_buffer, _index_buffer.vk_buffer, 0, _vk_index_type);
+    vkCmdDrawIndexed(command_buffer, lod_info.index_count, 1, lod_info.index_start, 0, 0);
+}
+
+bool GlobeModel::WriteInstanceTransforms(const glm::mat4* transforms, uint32_t count, VkBuffer& instance_buffer,
+                                         VkDeviceSize& instance_offset) {
+    if (0 == count) {
+        return false;
+    }
+    const uint8_t* instance_data = reinterpret_cast<const uint8_t*>(transforms);
+    std::vector<glm::mat4> dequantized_transforms;
+    if (IsNormalizedEncoding(_sizes.position_encoding)) {
+        glm::mat4 dequantization = GetPositionDequantization();
+        dequantized_transforms.resize(count);
+        for (uint32_t instance = 0; instance < count; ++instance) {
+            dequantized_transforms[instance] = transforms[instance] * dequantization;
+        }
+        instance_data = reinterpret_cast<const uint8_t*>(dequantized_transforms.data());
+    }
+    return _globe_resource_mgr->WriteInstanceData(instance_data, static_cast<VkDeviceSize>(count) * sizeof(glm::mat4),
+                                                  instance_buffer, instance_offset);
 }
 
-void GlobeModel::Draw(VkCommandBuffer& command_buffer) {
+void GlobeModel::DrawInstanced(VkCommandBuffer& command_buffer, VkBuffer instance_buffer, VkDeviceSize instance_offset,
+                               uint32_t instance_count, uint32_t lod) {
+    const LodInfo& lod_info = _lods[std::min(lod, static_cast<uint32_t>(_lods.size()) - 1)];
     const VkDeviceSize vert_buffer_offset = 0;
     vkCmdBindVertexBuffers(command_buffer, 0, 1, &_vertex_buffer.vk_buffer, &vert_buffer_offset);
-    vkCmdBindIndexBuffer(command_buffer, _index_buffer.vk_buffer, 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(command_buffer, static_cast<uint32_t>(_indices.size()), 1, 0, 0, 1);
+    vkCmdBindVertexBuffers(command_buffer, GLOBE_MODEL_INSTANCE_BINDING, 1, &instance_buffer, &instance_offset);
+    vkCmdBindIndexBuffer(command_buffer, _index_buffer.vk_buffer, 0, _vk_index_type);
+    vkCmdDrawIndexed(command_buffer, lod_info.index_count, instance_count, lod_info.index_start, 0, 0);
 }
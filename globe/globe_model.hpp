@@ -17,8 +17,18 @@
 
 #include "globe_glm_include.hpp"
 #include "globe_basic_types.hpp"
+#include "globe_file_view.hpp"
+
+// Most LODs a model keeps, LOD 0 being the full detail mesh.
+#define GLOBE_MODEL_MAX_LODS 8
+// Largest error, in pixels, SelectLod lets a LOD show on screen.
+#define GLOBE_MODEL_LOD_PIXEL_ERROR 1.f
+// Vertex binding the per-instance model matrices are read from when drawing instanced.
+#define GLOBE_MODEL_INSTANCE_BINDING 1
 
 class GlobeResourceManager;
+class GlobeUploadBatch;
+class GlobeCamera;
 
 class GlobeModel {
    public:
@@ -44,40 +54,132 @@ class GlobeModel {
         uint32_t index_count;
     };
 
-    static GlobeModel* LoadModelFile(const GlobeResourceManager* resource_manager, VkDevice vk_device,
-                                     const GlobeComponentSizes& sizes, const std::string& model_name,
-                                     const std::string& directory);
-    static GlobeModel* LoadDaeModelFile(const GlobeResourceManager* resource_manager, VkDevice vk_device,
-                                        const GlobeComponentSizes& sizes, const std::string& model_name,
-                                        const std::string& directory);
+    // A range of the index buffer drawing the whole model at one level of detail.  The error is how far the
+    // simplified surface strays from the full one, as a fraction of the bounding box diagonal.
+    struct LodInfo {
+        uint32_t index_start;
+        uint32_t index_count;
+        float error;
+    };
+
+    // CPU-side results of importing a model file, before any Vulkan objects are created.  The vertex and
+    // index data either lives in the vectors (fresh import) or directly in the mapped model cache file,
+    // vertex_data and index_data point at whichever one it is.
+    struct ModelContent {
+        std::vector<MeshInfo> meshes;
+        std::vector<LodInfo> lods;
+        BoundingBox bounding_box;
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        GlobeFileView cache_view;
+        const float* vertex_data;
+        uint32_t vertex_float_count;
+        const uint32_t* index_data;
+        uint32_t index_count;
+        // Where the content was loaded from, so a model that released its host copy can load it again.
+        std::string directory;
+        std::string cache_directory;
+    };
+
+    static GlobeModel* LoadModelFile(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
+                                     VkDevice vk_device, const GlobeComponentSizes& sizes,
+                                     const std::string& model_name, const std::string& directory,
+                                     const std::string& cache_directory = "",
+                                     GlobeHostCopyPolicy host_copy_policy = GLOBE_HOST_COPY_KEEP);
+    static GlobeModel* LoadDaeModelFile(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
+                                        VkDevice vk_device, const GlobeComponentSizes& sizes,
+                                        const std::string& model_name, const std::string& directory);
+    // Import only (safe to run on a worker thread).  CreateFromContent then builds the Vulkan buffers.
+    // With a cache directory, the post-processed import is written to a binary model cache there the first
+    // time, and later loads of the same (unchanged) source file with the same component sizes map the
+    // cache instead of running the importer.
+    static bool LoadModelFileContent(const GlobeComponentSizes& sizes, const std::string& model_name,
+                                     const std::string& directory, ModelContent& content,
+                                     const std::string& cache_directory = "");
+    static bool LoadDaeModelFileContent(const GlobeComponentSizes& sizes, const std::string& model_name,
+                                        const std::string& directory, ModelContent& content);
+    // With GLOBE_HOST_COPY_RELEASE the model keeps no host copy of its vertices and indices once they are
+    // in the buffers (GLOBE_HOST_COPY_DEFAULT must already have been resolved by the resource manager).
+    // Device local geometry (see GlobeResourceManager::SetGeometryMemoryPolicy) is copied in through the
+    // upload batch, and the model must not be drawn until the batch has completed.  Without a batch, the model
+    // uses one of its own and waits for it.
+    static GlobeModel* CreateFromContent(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
+                                         VkDevice vk_device, const std::string& model_name,
+                                         const GlobeComponentSizes& sizes, ModelContent& content,
+                                         GlobeHostCopyPolicy host_copy_policy = GLOBE_HOST_COPY_KEEP);
 
-    GlobeModel(const GlobeResourceManager* resource_manager, VkDevice vk_device, const std::string& model_name,
-               const GlobeComponentSizes& sizes, std::vector<MeshInfo>& meshes, const BoundingBox& bounding_box,
-               std::vector<float>& vertices, std::vector<uint32_t>& indices);
+    GlobeModel(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch, VkDevice vk_device,
+               const std::string& model_name, const GlobeComponentSizes& sizes, ModelContent& content,
+               GlobeHostCopyPolicy host_copy_policy);
     ~GlobeModel();
 
     bool IsValid() { return _is_valid; }
     void GetSize(float& x, float& y, float& z);
     void GetCenter(float& x, float& y, float& z);
+    // Maps positions stored with a normalized GlobeVertexEncoding (which are relative to the bounding box)
+    // back to model space; multiply it into the model matrix.  Identity for float and half positions.
+    glm::mat4 GetPositionDequantization() const;
+    // Host copy of the uploaded geometry.  If the model released its copy, it is loaded again from the model
+    // cache or the model file, which can be slow.
+    bool HasHostCopy() const { return _has_host_copy; }
+    bool GetHostGeometry(std::vector<float>& vertices, std::vector<uint32_t>& indices) const;
 
-    void FillInPipelineInfo(VkGraphicsPipelineCreateInfo& graphics_pipeline_c_i);
-    void Draw(VkCommandBuffer& command_buffer);
+    // The instanced vertex input state adds GLOBE_MODEL_INSTANCE_BINDING, stepped once per instance, with each
+    // instance's model matrix as four vec4 column attributes starting at InstanceAttributeLocation().
+    void FillInPipelineInfo(VkGraphicsPipelineCreateInfo& graphics_pipeline_c_i, bool instanced = false);
+    uint32_t InstanceAttributeLocation() const { return static_cast<uint32_t>(_vk_vert_attrib_desc.size()); }
+    // The mesh index ranges are those of LOD 0, the lower detail LODs follow all of them in the index buffer.
+    uint32_t NumLods() const { return static_cast<uint32_t>(_lods.size()); }
+    const LodInfo& GetLodInfo(uint32_t lod) const { return _lods[lod]; }
+    // Picks the lowest detail LOD whose error stays within max_pixel_error on screen, based on the bounding box
+    // size the camera projects.  The model matrix is the model's own, without GetPositionDequantization.
+    uint32_t SelectLod(GlobeCamera& camera, const glm::mat4& model_matrix, float viewport_height,
+                       float max_pixel_error = GLOBE_MODEL_LOD_PIXEL_ERROR) const;
+    void Draw(VkCommandBuffer& command_buffer, uint32_t lod = 0);
+    // Copies the model matrices into the resource manager's per-frame instance ring, with
+    // GetPositionDequantization already multiplied in, for a DrawInstanced in the frame being recorded.
+    bool WriteInstanceTransforms(const glm::mat4* transforms, uint32_t count, VkBuffer& instance_buffer,
+                                 VkDeviceSize& instance_offset);
+    // Needs a pipeline made with the instanced FillInPipelineInfo.
+    void DrawInstanced(VkCommandBuffer& command_buffer, VkBuffer instance_buffer, VkDeviceSize instance_offset,
+                       uint32_t instance_count, uint32_t lod = 0);
 
    private:
+    static std::string ModelCacheFileName(const GlobeComponentSizes& sizes, const std::string& model_name,
+                                          const std::string& directory, const std::string& cache_directory);
+    static bool LoadModelCache(const std::string& cache_file_name, uint64_t source_hash,
+                               const GlobeComponentSizes& sizes, ModelContent& content);
+    static bool SaveModelCache(const std::string& cache_file_name, uint64_t source_hash,
+                               const GlobeComponentSizes& sizes, const ModelContent& content);
+    static void OptimizeMeshes(const GlobeComponentSizes& sizes, const std::string& model_name, ModelContent& content);
+    // Host visible and written directly without an upload batch, device local and staged through it otherwise.
+    bool CreateGeometryBuffer(GlobeUploadBatch* upload_batch, VkBufferUsageFlags vk_usage,
+                              VkAccessFlags vk_target_access, const uint8_t* data, VkDeviceSize size,
+                              const std::string& buffer_name, GlobeVulkanBuffer& buffer);
     static void CopyVertexComponentData(std::vector<float>& buffer, float* data, bool data_valid, uint8_t copy_comps,
                                         uint8_t max_comps, bool flip_y = false);
 
     bool _is_valid;
     VkDevice _vk_device;
-    const GlobeResourceManager* _globe_resource_mgr;
+    GlobeResourceManager* _globe_resource_mgr;
     std::string _model_name;
+    std::string _directory;
+    std::string _cache_directory;
+    GlobeComponentSizes _sizes;
     std::vector<MeshInfo> _meshes;
+    std::vector<LodInfo> _lods;
     GlobeVulkanBuffer _vertex_buffer;
     GlobeVulkanBuffer _index_buffer;
     std::vector<float> _vertices;
     std::vector<uint32_t> _indices;
+    bool _has_host_copy;
+    uint32_t _index_count;
+    VkIndexType _vk_index_type;
     BoundingBox _bounding_box;
     VkVertexInputBindingDescription _vk_vert_binding_desc;
     std::vector<VkVertexInputAttributeDescription> _vk_vert_attrib_desc;
     VkPipelineVertexInputStateCreateInfo _vk_pipeline_vert_create_info;
+    std::vector<VkVertexInputBindingDescription> _vk_inst_binding_desc;
+    std::vector<VkVertexInputAttributeDescription> _vk_inst_attrib_desc;
+    VkPipelineVertexInputStateCreateInfo _vk_pipeline_inst_create_info;
 };
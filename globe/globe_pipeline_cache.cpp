@@ -0,0 +1,333 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_pipeline_cache.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include <cstring>
+#include <vector>
+
+#include "globe_logger.hpp"
+#include "globe_file_view.hpp"
+#include "globe_shader.hpp"
+#include "globe_layout_cache.hpp"
+#include "globe_resource_manager.hpp"
+#include "globe_pipeline_cache.hpp"
+
+// Only used on the plain Vulkan structures below, none of which have padding between members.
+template <typename T>
+static void AppendToKey(std::string& key, const T& value) {
+    key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static void AppendArrayToKey(std::string& key, const T* values, uint32_t count) {
+    AppendToKey(key, count);
+    if (nullptr != values && count > 0) {
+        key.append(reinterpret_cast<const char*>(values), sizeof(T) * count);
+    }
+}
+
+static void AppendStringToKey(std::string& key, const char* value) {
+    if (nullptr != value) {
+        key.append(value);
+    }
+    key.push_back('\0');
+}
+
+GlobePipelineCache::GlobePipelineCache(GlobeResourceManager* resource_manager, VkDevice vk_device,
+                                       VkPipelineCache vk_pipeline_cache)
+    : _globe_resource_mgr(resource_manager),
+      _vk_device(vk_device),
+      _vk_pipeline_cache(vk_pipeline_cache),
+      _num_hits(0),
+      _num_misses(0) {}
+
+GlobePipelineCache::~GlobePipelineCache() {
+    for (auto& pipeline : _pipelines) {
+        vkDestroyPipeline(_vk_device, pipeline.second.vk_pipeline, nullptr);
+    }
+    _pipelines.clear();
+    _pipeline_keys.clear();
+    for (auto& pipeline : _detached_pipelines) {
+        vkDestroyPipeline(_vk_device, pipeline.first, nullptr);
+    }
+    _detached_pipelines.clear();
+}
+
+VkPipeline GlobePipelineCache::GetGraphicsPipeline(const VkGraphicsPipelineCreateInfo& create_info) {
+    std::string key;
+    Entry entry = {};
+    BuildKey(create_info, key, entry);
+    auto pipeline_iter = _pipelines.find(key);
+    if (pipeline_iter != _pipelines.end()) {
+        _num_hits++;
+        pipeline_iter->second.ref_count++;
+        return pipeline_iter->second.vk_pipeline;
+    }
+
+    _num_misses++;
+    if (VK_SUCCESS !=
+        vkCreateGraphicsPipelines(_vk_device, _vk_pipeline_cache, 1, &create_info, nullptr, &entry.vk_pipeline)) {
+        GlobeLogger::getInstance().LogError("GlobePipelineCache failed to create graphics pipeline");
+        return VK_NULL_HANDLE;
+    }
+    entry.ref_count = 1;
+    _pipelines[key] = entry;
+    _pipeline_keys[entry.vk_pipeline] = key;
+    return entry.vk_pipeline;
+}
+
+void GlobePipelineCache::ReleaseGraphicsPipeline(VkPipeline vk_pipeline) {
+    auto key_iter = _pipeline_keys.find(vk_pipeline);
+    if (key_iter != _pipeline_keys.end()) {
+        Entry& entry = _pipelines[key_iter->second];
+        if (entry.ref_count > 0) {
+            entry.ref_count--;
+        }
+        return;
+    }
+    auto detached_iter = _detached_pipelines.find(vk_pipeline);
+    if (detached_iter != _detached_pipelines.end() && 0 == --detached_iter->second) {
+        FreePipeline(vk_pipeline);
+        _detached_pipelines.erase(detached_iter);
+    }
+}
+
+void GlobePipelineCache::AddShader(const GlobeShader* shader) {
+    std::vector<VkPipelineShaderStageCreateInfo> stages;
+    shader->GetPipelineShaderStages(stages);
+    for (const auto& stage : stages) {
+        _shader_module_hashes[stage.module] = shader->GetStageContentHash(stage.stage);
+    }
+}
+
+// Pipelines built from the shader stay valid, only the shader module handles are forgotten.
+void GlobePipelineCache::RemoveShader(const GlobeShader* shader) {
+    std::vector<VkPipelineShaderStageCreateInfo> stages;
+    shader->GetPipelineShaderStages(stages);
+    for (const auto& stage : stages) {
+        _shader_module_hashes.erase(stage.module);
+    }
+}
+
+// Pipelines keyed on the contents stay valid after the render pass is destroyed, since Vulkan allows using
+// them with any compatible render pass.
+void GlobePipelineCache::AddRenderPass(VkRenderPass vk_render_pass, const VkRenderPassCreateInfo& create_info) {
+    std::string key;
+    AppendToKey(key, create_info.flags);
+    AppendArrayToKey(key, create_info.pAttachments, create_info.attachmentCount);
+    AppendToKey(key, create_info.subpassCount);
+    for (uint32_t subpass = 0; subpass < create_info.subpassCount; ++subpass) {
+        const VkSubpassDescription& subpass_desc = create_info.pSubpasses[subpass];
+        AppendToKey(key, subpass_desc.flags);
+        AppendToKey(key, subpass_desc.pipelineBindPoint);
+        AppendArrayToKey(key, subpass_desc.pInputAttachments, subpass_desc.inputAttachmentCount);
+        AppendArrayToKey(key, subpass_desc.pColorAttachments, subpass_desc.colorAttachmentCount);
+        AppendArrayToKey(key, subpass_desc.pResolveAttachments,
+                         nullptr != subpass_desc.pResolveAttachments ? subpass_desc.colorAttachmentCount : 0);
+        AppendArrayToKey(key, subpass_desc.pDepthStencilAttachment,
+                         nullptr != subpass_desc.pDepthStencilAttachment ? 1 : 0);
+        AppendArrayToKey(key, subpass_desc.pPreserveAttachments, subpass_desc.preserveAttachmentCount);
+    }
+    AppendArrayToKey(key, create_info.pDependencies, create_info.dependencyCount);
+    _render_pass_hashes[vk_render_pass] = GlobeHashData(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+}
+
+void GlobePipelineCache::RemoveRenderPass(VkRenderPass vk_render_pass) {
+    _render_pass_hashes.erase(vk_render_pass);
+    DetachPipelines(vk_render_pass, VK_NULL_HANDLE);
+}
+
+void GlobePipelineCache::RemovePipelineLayout(VkPipelineLayout vk_pipeline_layout) {
+    DetachPipelines(VK_NULL_HANDLE, vk_pipeline_layout);
+}
+
+// Takes the pipelines keyed on the handle out of the cache, so nothing can hit on them anymore.  Other users
+// may still be recording with them, so those only get freed once released.
+void GlobePipelineCache::DetachPipelines(VkRenderPass vk_render_pass, VkPipelineLayout vk_pipeline_layout) {
+    for (auto pipeline_iter = _pipelines.begin(); pipeline_iter != _pipelines.end();) {
+        const Entry& entry = pipeline_iter->second;
+        if ((VK_NULL_HANDLE != vk_render_pass && entry.vk_render_pass == vk_render_pass) ||
+            (VK_NULL_HANDLE != vk_pipeline_layout && entry.vk_pipeline_layout == vk_pipeline_layout)) {
+            if (0 == entry.ref_count) {
+                FreePipeline(entry.vk_pipeline);
+            } else {
+                _detached_pipelines[entry.vk_pipeline] = entry.ref_count;
+            }
+            _pipeline_keys.erase(entry.vk_pipeline);
+            pipeline_iter = _pipelines.erase(pipeline_iter);
+        } else {
+            ++pipeline_iter;
+        }
+    }
+}
+
+// Frames that are still in flight may be using the pipeline.
+void GlobePipelineCache::FreePipeline(VkPipeline vk_pipeline) {
+    VkDevice vk_device = _vk_device;
+    _globe_resource_mgr->DeferredFree(
+        [vk_device, vk_pipeline]() { vkDestroyPipeline(vk_device, vk_pipeline, nullptr); });
+}
+
+void GlobePipelineCache::LogStats() const {
+    std::string perf_msg = "Pipeline cache: ";
+    perf_msg += std::to_string(_pipelines.size());
+    perf_msg += " pipelines, ";
+    perf_msg += std::to_string(_num_hits);
+    perf_msg += " hits, ";
+    perf_msg += std::to_string(_num_misses);
+    perf_msg += " misses";
+    GlobeLogger::getInstance().LogPerf(perf_msg);
+}
+
+void GlobePipelineCache::BuildKey(const VkGraphicsPipelineCreateInfo& create_info, std::string& key,
+                                  Entry& entry) const {
+    key.reserve(512);
+    AppendToKey(key, create_info.flags);
+    uint64_t layout_hash = 0;
+    GlobeLayoutCache* layout_cache = _globe_resource_mgr->GetLayoutCache();
+    if (nullptr != layout_cache && layout_cache->GetPipelineLayoutHash(create_info.layout, layout_hash)) {
+        key.push_back('L');
+        AppendToKey(key, layout_hash);
+    } else {
+        key.push_back('l');
+        AppendToKey(key, create_info.layout);
+        entry.vk_pipeline_layout = create_info.layout;
+    }
+    auto render_pass_iter = _render_pass_hashes.find(create_info.renderPass);
+    if (render_pass_iter != _render_pass_hashes.end()) {
+        key.push_back('R');
+        AppendToKey(key, render_pass_iter->second);
+    } else {
+        key.push_back('r');
+        AppendToKey(key, create_info.renderPass);
+        entry.vk_render_pass = create_info.renderPass;
+    }
+    AppendToKey(key, create_info.subpass);
+
+    // Shader stages
+    AppendToKey(key, create_info.stageCount);
+    for (uint32_t stage = 0; stage < create_info.stageCount; ++stage) {
+        const VkPipelineShaderStageCreateInfo& stage_info = create_info.pStages[stage];
+        AppendToKey(key, stage_info.flags);
+        AppendToKey(key, stage_info.stage);
+        auto hash_iter = _shader_module_hashes.find(stage_info.module);
+        if (hash_iter != _shader_module_hashes.end()) {
+            AppendToKey(key, hash_iter->second);
+        } else {
+            AppendToKey(key, stage_info.module);
+        }
+        AppendStringToKey(key, stage_info.pName);
+        const VkSpecializationInfo* specialization = stage_info.pSpecializationInfo;
+        if (nullptr == specialization) {
+            AppendToKey(key, static_cast<uint32_t>(0));
+        } else {
+            AppendArrayToKey(key, specialization->pMapEntries, specialization->mapEntryCount);
+            AppendToKey(key, specialization->dataSize);
+            if (nullptr != specialization->pData) {
+                key.append(reinterpret_cast<const char*>(specialization->pData), specialization->dataSize);
+            }
+        }
+    }
+
+    // Vertex input and assembly
+    const VkPipelineVertexInputStateCreateInfo* vertex_input = create_info.pVertexInputState;
+    if (nullptr != vertex_input) {
+        AppendToKey(key, vertex_input->flags);
+        AppendArrayToKey(key, vertex_input->pVertexBindingDescriptions, vertex_input->vertexBindingDescriptionCount);
+        AppendArrayToKey(key, vertex_input->pVertexAttributeDescriptions,
+                         vertex_input->vertexAttributeDescriptionCount);
+    }
+    key.push_back('|');
+    const VkPipelineInputAssemblyStateCreateInfo* input_assembly = create_info.pInputAssemblyState;
+    if (nullptr != input_assembly) {
+        AppendToKey(key, input_assembly->flags);
+        AppendToKey(key, input_assembly->topology);
+        AppendToKey(key, input_assembly->primitiveRestartEnable);
+    }
+    key.push_back('|');
+    const VkPipelineTessellationStateCreateInfo* tessellation = create_info.pTessellationState;
+    if (nullptr != tessellation) {
+        AppendToKey(key, tessellation->flags);
+        AppendToKey(key, tessellation->patchControlPoints);
+    }
+    key.push_back('|');
+
+    // Dynamic state decides whether the viewport and scissor contents matter.
+    bool dynamic_viewport = false;
+    bool dynamic_scissor = false;
+    const VkPipelineDynamicStateCreateInfo* dynamic_state = create_info.pDynamicState;
+    if (nullptr != dynamic_state) {
+        AppendToKey(key, dynamic_state->flags);
+        AppendArrayToKey(key, dynamic_state->pDynamicStates, dynamic_state->dynamicStateCount);
+        for (uint32_t state = 0; state < dynamic_state->dynamicStateCount; ++state) {
+            if (VK_DYNAMIC_STATE_VIEWPORT == dynamic_state->pDynamicStates[state]) {
+                dynamic_viewport = true;
+            } else if (VK_DYNAMIC_STATE_SCISSOR == dynamic_state->pDynamicStates[state]) {
+                dynamic_scissor = true;
+            }
+        }
+    }
+    key.push_back('|');
+    const VkPipelineViewportStateCreateInfo* viewport_state = create_info.pViewportState;
+    if (nullptr != viewport_state) {
+        AppendToKey(key, viewport_state->flags);
+        AppendArrayToKey(key, dynamic_viewport ? nullptr : viewport_state->pViewports, viewport_state->viewportCount);
+        AppendArrayToKey(key, dynamic_scissor ? nullptr : viewport_state->pScissors, viewport_state->scissorCount);
+    }
+    key.push_back('|');
+
+    // Fixed function state
+    const VkPipelineRasterizationStateCreateInfo* raster = create_info.pRasterizationState;
+    if (nullptr != raster) {
+        AppendToKey(key, raster->flags);
+        AppendToKey(key, raster->depthClampEnable);
+        AppendToKey(key, raster->rasterizerDiscardEnable);
+        AppendToKey(key, raster->polygonMode);
+        AppendToKey(key, raster->cullMode);
+        AppendToKey(key, raster->frontFace);
+        AppendToKey(key, raster->depthBiasEnable);
+        AppendToKey(key, raster->depthBiasConstantFactor);
+        AppendToKey(key, raster->depthBiasClamp);
+        AppendToKey(key, raster->depthBiasSlopeFactor);
+        AppendToKey(key, raster->lineWidth);
+    }
+    key.push_back('|');
+    const VkPipelineMultisampleStateCreateInfo* multisample = create_info.pMultisampleState;
+    if (nullptr != multisample) {
+        AppendToKey(key, multisample->flags);
+        AppendToKey(key, multisample->rasterizationSamples);
+        AppendToKey(key, multisample->sampleShadingEnable);
+        AppendToKey(key, multisample->minSampleShading);
+        AppendArrayToKey(key, multisample->pSampleMask, (multisample->rasterizationSamples + 31) / 32);
+        AppendToKey(key, multisample->alphaToCoverageEnable);
+        AppendToKey(key, multisample->alphaToOneEnable);
+    }
+    key.push_back('|');
+    const VkPipelineDepthStencilStateCreateInfo* depth_stencil = create_info.pDepthStencilState;
+    if (nullptr != depth_stencil) {
+        AppendToKey(key, depth_stencil->flags);
+        AppendToKey(key, depth_stencil->depthTestEnable);
+        AppendToKey(key, depth_stencil->depthWriteEnable);
+        AppendToKey(key, depth_stencil->depthCompareOp);
+        AppendToKey(key, depth_stencil->depthBoundsTestEnable);
+        AppendToKey(key, depth_stencil->stencilTestEnable);
+        AppendToKey(key, depth_stencil->front);
+        AppendToKey(key, depth_stencil->back);
+        AppendToKey(key, depth_stencil->minDepthBounds);
+        AppendToKey(key, depth_stencil->maxDepthBounds);
+    }
+    key.push_back('|');
+    const VkPipelineColorBlendStateCreateInfo* color_blend = create_info.pColorBlendState;
+    if (nullptr != color_blend) {
+        AppendToKey(key, color_blend->flags);
+        AppendToKey(key, color_blend->logicOpEnable);
+        AppendToKey(key, color_blend->logicOp);
+        AppendArrayToKey(key, color_blend->pAttachments, color_blend->attachmentCount);
+        AppendToKey(key, color_blend->blendConstants);
+    }
+}
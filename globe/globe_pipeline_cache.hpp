@@ -0,0 +1,79 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_pipeline_cache.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "vulkan/vulkan_core.h"
+
+class GlobeResourceManager;
+class GlobeShader;
+
+// Hands out graphics pipelines keyed on everything in a VkGraphicsPipelineCreateInfo that affects the
+// resulting pipeline, so asking for the same state twice returns the same VkPipeline instead of
+// building another one.  The cache owns every pipeline it returns.  Each GetGraphicsPipeline takes a
+// reference that is given back with ReleaseGraphicsPipeline.  Pipelines nobody references stay cached,
+// so tearing everything down and building it again (like on a window resize) hits.
+//
+// Objects are keyed on their contents wherever the cache can know them, so recreating one still hits:
+//  - shader modules of shaders added with AddShader, on their SPIR-V
+//  - render passes added with AddRenderPass, on the state that decides render pass compatibility
+//    (attachment formats, sample counts, load/store ops and the subpass layout)
+//  - pipeline layouts out of the GlobeLayoutCache, on the content hash it keeps
+// Anything else is keyed on its handle, so RemoveRenderPass or RemovePipelineLayout must be called
+// before destroying it (otherwise a new object that happens to reuse the handle would hit on the wrong
+// pipeline).  pNext chains are not looked at.
+class GlobePipelineCache {
+   public:
+    GlobePipelineCache(GlobeResourceManager* resource_manager, VkDevice vk_device, VkPipelineCache vk_pipeline_cache);
+    ~GlobePipelineCache();
+
+    VkPipeline GetGraphicsPipeline(const VkGraphicsPipelineCreateInfo& create_info);
+    void ReleaseGraphicsPipeline(VkPipeline vk_pipeline);
+
+    void AddShader(const GlobeShader* shader);
+    void RemoveShader(const GlobeShader* shader);
+    void AddRenderPass(VkRenderPass vk_render_pass, const VkRenderPassCreateInfo& create_info);
+    // Unreferenced pipelines keyed on the handle are freed, referenced ones once their last reference
+    // is released.
+    void RemoveRenderPass(VkRenderPass vk_render_pass);
+    void RemovePipelineLayout(VkPipelineLayout vk_pipeline_layout);
+
+    uint32_t NumPipelines() const { return static_cast<uint32_t>(_pipelines.size()); }
+    uint64_t NumHits() const { return _num_hits; }
+    uint64_t NumMisses() const { return _num_misses; }
+    void LogStats() const;
+
+   private:
+    // The render pass and layout handles are only set when the key had to use them.
+    struct Entry {
+        VkPipeline vk_pipeline;
+        uint32_t ref_count;
+        VkRenderPass vk_render_pass;
+        VkPipelineLayout vk_pipeline_layout;
+    };
+
+    void BuildKey(const VkGraphicsPipelineCreateInfo& create_info, std::string& key, Entry& entry) const;
+    void DetachPipelines(VkRenderPass vk_render_pass, VkPipelineLayout vk_pipeline_layout);
+    void FreePipeline(VkPipeline vk_pipeline);
+
+    GlobeResourceManager* _globe_resource_mgr;
+    VkDevice _vk_device;
+    VkPipelineCache _vk_pipeline_cache;
+    std::unordered_map<std::string, Entry> _pipelines;
+    std::unordered_map<VkPipeline, std::string> _pipeline_keys;
+    // Pipelines taken out of the cache while still referenced, with their remaining reference counts.
+    std::unordered_map<VkPipeline, uint32_t> _detached_pipelines;
+    std::unordered_map<VkShaderModule, uint64_t> _shader_module_hashes;
+    std::unordered_map<VkRenderPass, uint64_t> _render_pass_hashes;
+    uint64_t _num_hits;
+    uint64_t _num_misses;
+};
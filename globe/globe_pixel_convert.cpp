@@ -0,0 +1,311 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_pixel_convert.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLOBE_PIXEL_CONVERT_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define GLOBE_PIXEL_CONVERT_SSSE3 1
+#define GLOBE_PIXEL_CONVERT_SSSE3_TARGET __attribute__((target("ssse3")))
+#elif defined(_MSC_VER)
+#define GLOBE_PIXEL_CONVERT_SSSE3 1
+#define GLOBE_PIXEL_CONVERT_SSSE3_TARGET
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define GLOBE_PIXEL_CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+#include "globe_pixel_convert.hpp"
+
+typedef void (*GlobePixelConvertFunc)(const uint8_t* src, uint8_t* dst, size_t num_texels);
+
+struct GlobePixelConverters {
+    const char* name;
+    GlobePixelConvertFunc gray_to_rgba;
+    GlobePixelConvertFunc gray_alpha_to_rgba;
+    GlobePixelConvertFunc rgb_to_rgba;
+    GlobePixelConvertFunc swizzle_bgra_rgba;
+};
+
+// The scalar versions convert the texels [first_texel, num_texels), finishing off what the SIMD loops leave.
+static void GrayToRgbaScalar(const uint8_t* src, uint8_t* dst, size_t first_texel, size_t num_texels) {
+    for (size_t texel = first_texel; texel < num_texels; ++texel) {
+        uint8_t gray = src[texel];
+        dst[texel * 4] = gray;
+        dst[texel * 4 + 1] = gray;
+        dst[texel * 4 + 2] = gray;
+        dst[texel * 4 + 3] = 255;
+    }
+}
+
+static void GrayAlphaToRgbaScalar(const uint8_t* src, uint8_t* dst, size_t first_texel, size_t num_texels) {
+    for (size_t texel = first_texel; texel < num_texels; ++texel) {
+        uint8_t gray = src[texel * 2];
+        dst[texel * 4] = gray;
+        dst[texel * 4 + 1] = gray;
+        dst[texel * 4 + 2] = gray;
+        dst[texel * 4 + 3] = src[texel * 2 + 1];
+    }
+}
+
+static void RgbToRgbaScalar(const uint8_t* src, uint8_t* dst, size_t first_texel, size_t num_texels) {
+    for (size_t texel = first_texel; texel < num_texels; ++texel) {
+        dst[texel * 4] = src[texel * 3];
+        dst[texel * 4 + 1] = src[texel * 3 + 1];
+        dst[texel * 4 + 2] = src[texel * 3 + 2];
+        dst[texel * 4 + 3] = 255;
+    }
+}
+
+static void SwizzleBgraRgbaScalar(const uint8_t* src, uint8_t* dst, size_t first_texel, size_t num_texels) {
+    for (size_t texel = first_texel; texel < num_texels; ++texel) {
+        uint8_t first = src[texel * 4];
+        uint8_t third = src[texel * 4 + 2];
+        dst[texel * 4] = third;
+        dst[texel * 4 + 1] = src[texel * 4 + 1];
+        dst[texel * 4 + 2] = first;
+        dst[texel * 4 + 3] = src[texel * 4 + 3];
+    }
+}
+
+#if defined(GLOBE_PIXEL_CONVERT_SSE2)
+static void GrayToRgbaSse2(const uint8_t* src, uint8_t* dst, size_t num_texels) {
+    const __m128i opaque = _mm_set1_epi8(static_cast<char>(0xFF));
+    size_t texel = 0;
+    for (; texel + 16 <= num_texels; texel += 16) {
+        // (g, g) and (g, 255) pairs, interleaved again into (g, g, g, 255).
+        __m128i gray = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + texel));
+        __m128i gray_gray_low = _mm_unpacklo_epi8(gray, gray);
+        __m128i gray_gray_high = _mm_unpackhi_epi8(gray, gray);
+        __m128i gray_alpha_low = _mm_unpacklo_epi8(gray, opaque);
+        __m128i gray_alpha_high = _mm_unpackhi_epi8(gray, opaque);
+        __m128i* dst_texels = reinterpret_cast<__m128i*>(dst + texel * 4);
+        _mm_storeu_si128(dst_texels, _mm_unpacklo_epi16(gray_gray_low, gray_alpha_low));
+        _mm_storeu_si128(dst_texels + 1, _mm_unpackhi_epi16(gray_gray_low, gray_alpha_low));
+        _mm_storeu_si128(dst_texels + 2, _mm_unpacklo_epi16(gray_gray_high, gray_alpha_high));
+        _mm_storeu_si128(dst_texels + 3, _mm_unpackhi_epi16(gray_gray_high, gray_alpha_high));
+    }
+    GrayToRgbaScalar(src, dst, texel, num_texels);
+}
+
+static void GrayAlphaToRgbaSse2(const uint8_t* src, uint8_t* dst, size_t num_texels) {
+    const __m128i gray_mask = _mm_set1_epi16(0x00FF);
+    size_t texel = 0;
+    for (; texel + 8 <= num_texels; texel += 8) {
+        // Each 16-bit (g, a) becomes a (g, g) pair, then the two are interleaved into (g, g, g, a).
+        __m128i gray_alpha = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + texel * 2));
+        __m128i gray = _mm_and_si128(gray_alpha, gray_mask);
+        __m128i gray_gray = _mm_or_si128(gray, _mm_slli_epi16(gray, 8));
+        __m128i* dst_texels = reinterpret_cast<__m128i*>(dst + texel * 4);
+        _mm_storeu_si128(dst_texels, _mm_unpacklo_epi16(gray_gray, gray_alpha));
+        _mm_storeu_si128(dst_texels + 1, _mm_unpackhi_epi16(gray_gray, gray_alpha));
+    }
+    GrayAlphaToRgbaScalar(src, dst, texel, num_texels);
+}
+
+static void SwizzleBgraRgbaSse2(const uint8_t* src, uint8_t* dst, size_t num_texels) {
+    const __m128i odd_mask = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+    size_t texel = 0;
+    for (; texel + 4 <= num_texels; texel += 4) {
+        __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + texel * 4));
+        __m128i odd = _mm_and_si128(texels, odd_mask);
+        __m128i even = _mm_andnot_si128(odd_mask, texels);
+        __m128i swapped = _mm_or_si128(_mm_slli_epi32(even, 16), _mm_srli_epi32(even, 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + texel * 4), _mm_or_si128(odd, swapped));
+    }
+    SwizzleBgraRgbaScalar(src, dst, texel, num_texels);
+}
+#endif
+
+#if defined(GLOBE_PIXEL_CONVERT_SSSE3)
+GLOBE_PIXEL_CONVERT_SSSE3_TARGET static void RgbToRgbaSsse3(const uint8_t* src, uint8_t* dst, size_t num_texels) {
+    const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xFF000000));
+    size_t texel = 0;
+    for (; texel + 16 <= num_texels; texel += 16) {
+        // 48 bytes hold 16 texels, realign them so each register starts with 4 whole texels.
+        const __m128i* src_texels = reinterpret_cast<const __m128i*>(src + texel * 3);
+        __m128i first = _mm_loadu_si128(src_texels);
+        __m128i second = _mm_loadu_si128(src_texels + 1);
+        __m128i third = _mm_loadu_si128(src_texels + 2);
+        __m128i* dst_texels = reinterpret_cast<__m128i*>(dst + texel * 4);
+        _mm_storeu_si128(dst_texels, _mm_or_si128(_mm_shuffle_epi8(first, spread), opaque));
+        _mm_storeu_si128(dst_texels + 1,
+                         _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(second, first, 12), spread), opaque));
+        _mm_storeu_si128(dst_texels + 2,
+                         _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(third, second, 8), spread), opaque));
+        _mm_storeu_si128(dst_texels + 3, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(third, 4), spread), opaque));
+    }
+    RgbToRgbaScalar(src, dst, texel, num_texels);
+}
+
+static bool CpuSupportsSsse3() {
+#if defined(_MSC_VER)
+    int cpu_info[4] = {};
+    __cpuid(cpu_info, 1);
+    return 0 != (cpu_info[2] & (1 << 9));
+#else
+    // This runs during static initialization, possibly before the CPU model has been probed.
+    __builtin_cpu_init();
+    return 0 != __builtin_cpu_supports("ssse3");
+#endif
+}
+#endif
+
+#if defined(GLOBE_PIXEL_CONVERT_NEON)
+// The structured loads and stores do all of the (de-)interleaving.
+static void GrayToRgbaNeon(const uint8_t* src, uint8_t* dst, size_t num_texels) {
+    size_t texel = 0;
+    for (; texel + 16 <= num_texels; texel += 16) {
+        uint8x16x4_t rgba;
+        rgba.val[0] = vld1q_u8(src + texel);
+        rgba.val[1] = rgba.val[0];
+        rgba.val[2] = rgba.val[0];
+        rgba.val[3] = vdupq_n_u8(255);
+        vst4q_u8(dst + texel * 4, rgba);
+    }
+    GrayToRgbaScalar(src, dst, texel, num_texels);
+}
+
+static void GrayAlphaToRgbaNeon(const uint8_t* src, uint8_t* dst, size_t num_texels) {
+    size_t texel = 0;
+    for (; texel + 16 <= num_texels; texel += 16) {
+        uint8x16x2_t gray_alpha = vld2q_u8(src + texel * 2);
+        uint8x16x4_t rgba;
+        rgba.val[0] = gray_alpha.val[0];
+        rgba.val[1] = gray_alpha.val[0];
+        rgba.val[2] = gray_alpha.val[0];
+        rgba.val[3] = gray_alpha.val[1];
+        vst4q_u8(dst + texel * 4, rgba);
+    }
+    GrayAlphaToRgbaScalar(src, dst, texel, num_texels);
+}
+
+static void RgbToRgbaNeon(const uint8_t* src, uint8_t* dst, size_t num_texels) {
+    size_t texel = 0;
+    for (; texel + 16 <= num_texels; texel += 16) {
+        uint8x16x3_t rgb = vld3q_u8(src + texel * 3);
+        uint8x16x4_t rgba;
+        rgba.val[0] = rgb.val[0];
+        rgba.val[1] = rgb.val[1];
+        rgba.val[2] = rgb.val[2];
+        rgba.val[3] = vdupq_n_u8(255);
+        vst4q_u8(dst + texel * 4, rgba);
+    }
+    RgbToRgbaScalar(src, dst, texel, num_texels);
+}
+
+static void SwizzleBgraRgbaNeon(const uint8_t* src, uint8_t* dst, size_t num_texels) {
+    size_t texel = 0;
+    for (; texel + 16 <= num_texels; texel += 16) {
+        uint8x16x4_t texels = vld4q_u8(src + texel * 4);
+        uint8x16_t first = texels.val[0];
+        texels.val[0] = texels.val[2];
+        texels.val[2] = first;
+        vst4q_u8(dst + texel * 4, texels);
+    }
+    SwizzleBgraRgbaScalar(src, dst, texel, num_texels);
+}
+#endif
+
+static GlobePixelConverters SelectConverters() {
+    GlobePixelConverters converters = {};
+#if defined(GLOBE_PIXEL_CONVERT_SSE2)
+    converters.name = "SSE2";
+    converters.gray_to_rgba = GrayToRgbaSse2;
+    converters.gray_alpha_to_rgba = GrayAlphaToRgbaSse2;
+    converters.rgb_to_rgba = [](const uint8_t* src, uint8_t* dst, size_t num_texels) {
+        RgbToRgbaScalar(src, dst, 0, num_texels);
+    };
+    converters.swizzle_bgra_rgba = SwizzleBgraRgbaSse2;
+#if defined(GLOBE_PIXEL_CONVERT_SSSE3)
+    if (CpuSupportsSsse3()) {
+        converters.name = "SSSE3";
+        converters.rgb_to_rgba = RgbToRgbaSsse3;
+    }
+#endif
+#elif defined(GLOBE_PIXEL_CONVERT_NEON)
+    converters.name = "NEON";
+    converters.gray_to_rgba = GrayToRgbaNeon;
+    converters.gray_alpha_to_rgba = GrayAlphaToRgbaNeon;
+    converters.rgb_to_rgba = RgbToRgbaNeon;
+    converters.swizzle_bgra_rgba = SwizzleBgraRgbaNeon;
+#else
+    converters.name = "scalar";
+    converters.gray_to_rgba = [](const uint8_t* src, uint8_t* dst, size_t num_texels) {
+        GrayToRgbaScalar(src, dst, 0, num_texels);
+    };
+    converters.gray_alpha_to_rgba = [](const uint8_t* src, uint8_t* dst, size_t num_texels) {
+        GrayAlphaToRgbaScalar(src, dst, 0, num_texels);
+    };
+    converters.rgb_to_rgba = [](const uint8_t* src, uint8_t* dst, size_t num_texels) {
+        RgbToRgbaScalar(src, dst, 0, num_texels);
+    };
+    converters.swizzle_bgra_rgba = [](const uint8_t* src, uint8_t* dst, size_t num_texels) {
+        SwizzleBgraRgbaScalar(src, dst, 0, num_texels);
+    };
+#endif
+    return converters;
+}
+
+static const GlobePixelConverters pixel_converters = SelectConverters();
+
+GlobePixelConversion GlobePixelConversionFromChannels(uint32_t num_channels) {
+    switch (num_channels) {
+        case 1:
+            return GLOBE_PIXEL_CONVERSION_GRAY_TO_RGBA;
+        case 2:
+            return GLOBE_PIXEL_CONVERSION_GRAY_ALPHA_TO_RGBA;
+        case 3:
+            return GLOBE_PIXEL_CONVERSION_RGB_TO_RGBA;
+        default:
+            return GLOBE_PIXEL_CONVERSION_NONE;
+    }
+}
+
+uint32_t GlobePixelConversionSourceSize(GlobePixelConversion conversion) {
+    switch (conversion) {
+        case GLOBE_PIXEL_CONVERSION_GRAY_TO_RGBA:
+            return 1;
+        case GLOBE_PIXEL_CONVERSION_GRAY_ALPHA_TO_RGBA:
+            return 2;
+        case GLOBE_PIXEL_CONVERSION_RGB_TO_RGBA:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+void GlobeConvertPixels(GlobePixelConversion conversion, const uint8_t* src, uint8_t* dst, size_t num_texels) {
+    switch (conversion) {
+        case GLOBE_PIXEL_CONVERSION_NONE:
+            memcpy(dst, src, num_texels * 4);
+            break;
+        case GLOBE_PIXEL_CONVERSION_GRAY_TO_RGBA:
+            pixel_converters.gray_to_rgba(src, dst, num_texels);
+            break;
+        case GLOBE_PIXEL_CONVERSION_GRAY_ALPHA_TO_RGBA:
+            pixel_converters.gray_alpha_to_rgba(src, dst, num_texels);
+            break;
+        case GLOBE_PIXEL_CONVERSION_RGB_TO_RGBA:
+            pixel_converters.rgb_to_rgba(src, dst, num_texels);
+            break;
+        case GLOBE_PIXEL_CONVERSION_SWIZZLE_BGRA_RGBA:
+            pixel_converters.swizzle_bgra_rgba(src, dst, num_texels);
+            break;
+    }
+}
+
+const char* GlobePixelConvertSimdPathName() { return pixel_converters.name; }
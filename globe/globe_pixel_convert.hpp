@@ -0,0 +1,35 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_pixel_convert.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 8-bit per component conversions into 4 byte texels.  Gray expands to (g, g, g, 255), gray-alpha to
+// (g, g, g, a) and RGB to (r, g, b, 255).
+enum GlobePixelConversion {
+    // Already 4 bytes per texel, copied as is.
+    GLOBE_PIXEL_CONVERSION_NONE = 0,
+    GLOBE_PIXEL_CONVERSION_GRAY_TO_RGBA,
+    GLOBE_PIXEL_CONVERSION_GRAY_ALPHA_TO_RGBA,
+    GLOBE_PIXEL_CONVERSION_RGB_TO_RGBA,
+    // Swaps the first and third components, so it converts both BGRA to RGBA and RGBA to BGRA.
+    GLOBE_PIXEL_CONVERSION_SWIZZLE_BGRA_RGBA,
+};
+
+// The conversion from a decoded image with num_channels components per texel to RGBA.
+GlobePixelConversion GlobePixelConversionFromChannels(uint32_t num_channels);
+// Bytes per texel on the source side of the conversion, the destination is always 4.
+uint32_t GlobePixelConversionSourceSize(GlobePixelConversion conversion);
+// Converts num_texels texels from src into dst.  Only the swizzle may be done in place, otherwise src and
+// dst must not overlap.  dst may point straight into mapped (write-combined) memory, it is only written
+// sequentially and never read.
+void GlobeConvertPixels(GlobePixelConversion conversion, const uint8_t* src, uint8_t* dst, size_t num_texels);
+const char* GlobePixelConvertSimdPathName();
@@ -12,12 +12,24 @@
 #include "globe_submit_manager.hpp"
 #include "globe_shader.hpp"
 #include "globe_texture.hpp"
+#include "globe_texture_atlas.hpp"
 #include "globe_font.hpp"
 #include "globe_model.hpp"
 #include "globe_resource_manager.hpp"
 #include "globe_app.hpp"
+#include "globe_thread_pool.hpp"
+#include "globe_staging_ring.hpp"
+#include "globe_upload_batch.hpp"
+#include "globe_pipeline_cache.hpp"
+#include "globe_layout_cache.hpp"
+#include "globe_sampler_cache.hpp"
+#include "globe_descriptor_allocator.hpp"
+#include "globe_asset_archive.hpp"
 
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
 
 #if defined(VK_USE_PLATFORM_WIN32_KHR)
 const char directory_symbol = '\\';
@@ -25,59 +37,170 @@ const char directory_symbol = '\\';
 const char directory_symbol = '/';
 #endif
 
+enum GlobeAsyncLoadType {
+    GLOBE_ASYNC_LOAD_TYPE_TEXTURE = 0,
+    GLOBE_ASYNC_LOAD_TYPE_FONT,
+    GLOBE_ASYNC_LOAD_TYPE_SHADER,
+    GLOBE_ASYNC_LOAD_TYPE_MODEL,
+};
+
+struct GlobeAsyncLoadRequest {
+    GlobeAsyncLoadType type;
+    GlobeAsyncLoadStatus status;
+    bool content_valid;  // Written by the worker thread before the request is placed on the loaded list
+    std::string name;
+    std::string directory;
+
+    // Request specific inputs
+    bool generate_mipmaps;
+    GlobeTextureCompression texture_compression;
+    bool is_standard_file;
+    float font_size;
+    GlobeComponentSizes sizes;
+    GlobeHostCopyPolicy host_copy_policy;
+
+    // CPU-side content produced by the worker thread
+    GlobeTextureData texture_data;
+    GlobeFontData font_data;
+    GlobeShaderStageInitData shader_data[GLOBE_SHADER_STAGE_ID_NUM_STAGES];
+    GlobeModel::ModelContent model_content;
+
+    // Final resource, created on the polling thread
+    GlobeTexture* texture;
+    GlobeFont* font;
+    GlobeShader* shader;
+    GlobeModel* model;
+};
+
 GlobeResourceManager::GlobeResourceManager(const GlobeApp* app, const std::string& directory,
-                                           uint32_t queue_family_index) {
+                                           uint32_t graphics_queue_family_index, uint32_t transfer_queue_family_index) {
     _parent_app = app;
     _parent_app->GetVkInfo(_vk_instance, _vk_physical_device, _vk_device);
     _uses_staging_buffer = app->UsesStagingBuffer();
     _base_directory = directory;
+    _thread_pool = nullptr;
+    _async_pending_count = 0;
+    _host_copy_policy = GLOBE_HOST_COPY_KEEP;
+    _host_copy_resident_bytes = 0;
+    _host_copy_released_bytes = 0;
 
     // Get Memory information and properties
     vkGetPhysicalDeviceMemoryProperties(_vk_physical_device, &_vk_physical_device_memory_properties);
+    _memory_allocator = new GlobeMemoryAllocator(_vk_physical_device, _vk_device, GLOBE_MEMORY_BLOCK_SIZE);
+    _staging_ring = nullptr;
+    if (_uses_staging_buffer) {
+        _staging_ring = new GlobeStagingRing(this, _vk_device, app->StagingBufferSize());
+    }
+    _instance_ring = nullptr;
+    _pipeline_cache = new GlobePipelineCache(this, _vk_device, app->GetVkPipelineCache());
+    _sampler_cache = new GlobeSamplerCache(_vk_device);
+    _layout_cache = new GlobeLayoutCache(_vk_device, _sampler_cache);
+    _descriptor_allocator = new GlobeDescriptorAllocator(_vk_device);
+
+    // Integrated GPUs only report device local heaps, with host visible memory types in them.
+    bool host_visible_device_local = false;
+    for (uint32_t type = 0; type < _vk_physical_device_memory_properties.memoryTypeCount; ++type) {
+        VkMemoryPropertyFlags type_flags = _vk_physical_device_memory_properties.memoryTypes[type].propertyFlags;
+        if ((type_flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) && (type_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+            host_visible_device_local = true;
+        }
+    }
+    _is_unified_memory = host_visible_device_local && _vk_physical_device_memory_properties.memoryHeapCount > 0;
+    for (uint32_t heap = 0; heap < _vk_physical_device_memory_properties.memoryHeapCount; ++heap) {
+        if (0 == (_vk_physical_device_memory_properties.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) {
+            _is_unified_memory = false;
+        }
+    }
+    SetGeometryMemoryPolicy(GLOBE_GEOMETRY_MEMORY_DEFAULT);
+
+    // Prefer the packed resources over loose files if they were built.
+    std::string default_archive = _base_directory + GLOBE_ASSET_ARCHIVE_EXTENSION;
+    FILE* archive_file_ptr = fopen(default_archive.c_str(), "rb");
+    if (nullptr != archive_file_ptr) {
+        fclose(archive_file_ptr);
+        MountAssetArchive(default_archive);
+    }
 
     // Create a command pool for targeted command buffers;
     VkCommandPoolCreateInfo cmd_pool_create_info = {};
     cmd_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     cmd_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    cmd_pool_create_info.queueFamilyIndex = queue_family_index;
+    cmd_pool_create_info.queueFamilyIndex = graphics_queue_family_index;
     vkCreateCommandPool(_vk_device, &cmd_pool_create_info, nullptr, &_vk_cmd_pool);
+
+    // Uploads get their own pool when they run on a separate transfer queue family.
+    _graphics_queue_family_index = graphics_queue_family_index;
+    _transfer_queue_family_index = transfer_queue_family_index;
+    _vk_transfer_cmd_pool = VK_NULL_HANDLE;
+    if (UsesTransferQueue()) {
+        cmd_pool_create_info.queueFamilyIndex = transfer_queue_family_index;
+        vkCreateCommandPool(_vk_device, &cmd_pool_create_info, nullptr, &_vk_transfer_cmd_pool);
+    }
 }
 
 GlobeResourceManager::~GlobeResourceManager() {
+    // Let any outstanding worker jobs drain before tearing down what they reference.
+    delete _thread_pool;
+    _thread_pool = nullptr;
+    FreeAsyncRequests();
+    for (auto upload_batch : _upload_batches) {
+        delete upload_batch;
+    }
+    _upload_batches.clear();
     vkFreeCommandBuffers(_vk_device, _vk_cmd_pool, static_cast<uint32_t>(_targeted_vk_cmd_buffers.size()),
                          _targeted_vk_cmd_buffers.data());
     vkDestroyCommandPool(_vk_device, _vk_cmd_pool, nullptr);
+    if (VK_NULL_HANDLE != _vk_transfer_cmd_pool) {
+        vkDestroyCommandPool(_vk_device, _vk_transfer_cmd_pool, nullptr);
+    }
     FreeAllTextures();
     FreeAllShaders();
     FreeAllModels();
     FreeAllFonts();
+    ReleaseAllDeferredResources();
+    _pipeline_cache->LogStats();
+    delete _pipeline_cache;
+    _pipeline_cache = nullptr;
+    _descriptor_allocator->LogStats();
+    delete _descriptor_allocator;
+    _descriptor_allocator = nullptr;
+    _layout_cache->LogStats();
+    delete _layout_cache;
+    _layout_cache = nullptr;
+    // Last, since both textures and layouts hold references on samplers.
+    _sampler_cache->LogStats();
+    delete _sampler_cache;
+    _sampler_cache = nullptr;
+    delete _staging_ring;
+    _staging_ring = nullptr;
+    delete _instance_ring;
+    _instance_ring = nullptr;
+    _instance_allocations.clear();
+    for (auto asset_archive : _asset_archives) {
+        delete asset_archive;
+    }
+    _asset_archives.clear();
+    LogMemoryStats();
+    delete _memory_allocator;
 }
 
 // Texture management methods
 // --------------------------------------------------------------------------------------------------------------
 
-GlobeTexture* GlobeResourceManager::LoadTexture(const std::string& texture_name, bool generate_mipmaps) {
-    GlobeLogger& logger = GlobeLogger::getInstance();
-    std::string texture_dir = _base_directory;
-    texture_dir += directory_symbol;
-    texture_dir += "textures";
-    texture_dir += directory_symbol;
-    size_t period_location = texture_name.rfind('.', texture_name.length());
-    std::string file_extension;
-    if (period_location != std::string::npos) {
-        file_extension = texture_name.substr(period_location + 1, texture_name.length() - period_location);
-        std::transform(file_extension.begin(), file_extension.end(), file_extension.begin(), ::tolower);
-    } else {
-        logger.LogError("LoadTexture called with texture name missing file extension");
+GlobeTexture* GlobeResourceManager::LoadTexture(const std::string& texture_name, bool generate_mipmaps,
+                                                GlobeUploadBatch* upload_batch, GlobeTextureCompression compression) {
+    bool is_standard_file = false;
+    if (!IsStandardTextureFile(texture_name, is_standard_file)) {
         return nullptr;
     }
+    std::string texture_dir = AssetDirectory("textures");
     GlobeTexture* texture;
-    if (file_extension == "jpg" || file_extension == "jpeg" || file_extension == "png") {
-        texture = GlobeTexture::LoadFromStandardFile(this, _parent_app->SubmitManager(), _vk_device, generate_mipmaps,
+    if (is_standard_file) {
+        texture = GlobeTexture::LoadFromStandardFile(this, upload_batch, _vk_device, generate_mipmaps, compression,
                                                      texture_name, texture_dir);
     } else {
-        texture = GlobeTexture::LoadFromKtxFile(this, _parent_app->SubmitManager(), _vk_device, generate_mipmaps,
-                                                texture_name, texture_dir);
+        texture = GlobeTexture::LoadFromKtxFile(this, upload_batch, _vk_device, generate_mipmaps, texture_name,
+                                                texture_dir);
     }
     if (nullptr != texture) {
         _textures.push_back(texture);
@@ -85,6 +208,31 @@ GlobeTexture* GlobeResourceManager::LoadTexture(const std::string& texture_name,
     return texture;
 }
 
+GlobeTextureAtlas* GlobeResourceManager::LoadTextureAtlas(const std::vector<std::string>& texture_names,
+                                                         bool generate_mipmaps, GlobeUploadBatch* upload_batch) {
+    GlobeTextureAtlas* atlas = GlobeTextureAtlas::Load(this, upload_batch, _vk_device, generate_mipmaps, texture_names,
+                                                       AssetDirectory("textures"));
+    if (nullptr != atlas) {
+        _textures.push_back(atlas);
+    }
+    return atlas;
+}
+
+bool GlobeResourceManager::IsStandardTextureFile(const std::string& texture_name, bool& is_standard_file) const {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    size_t period_location = texture_name.rfind('.', texture_name.length());
+    std::string file_extension;
+    if (period_location != std::string::npos) {
+        file_extension = texture_name.substr(period_location + 1, texture_name.length() - period_location);
+        std::transform(file_extension.begin(), file_extension.end(), file_extension.begin(), ::tolower);
+    } else {
+        logger.LogError("LoadTexture called with texture name missing file extension");
+        return false;
+    }
+    is_standard_file = (file_extension == "jpg" || file_extension == "jpeg" || file_extension == "png");
+    return true;
+}
+
 GlobeTexture* GlobeResourceManager::CreateRenderTargetTexture(uint32_t width, uint32_t height, VkFormat vk_format) {
     GlobeTexture* texture = GlobeTexture::CreateRenderTarget(this, _vk_device, width, height, vk_format);
     if (nullptr != texture) {
@@ -95,7 +243,7 @@ GlobeTexture* GlobeResourceManager::CreateRenderTargetTexture(uint32_t width, ui
 
 void GlobeResourceManager::FreeAllTextures() {
     for (auto texture : _textures) {
-        delete texture;
+        DeferredFree([texture]() { delete texture; });
     }
     _textures.clear();
 }
@@ -103,7 +251,9 @@ void GlobeResourceManager::FreeAllTextures() {
 void GlobeResourceManager::FreeTexture(GlobeTexture* texture) {
     for (uint32_t tex_index = 0; tex_index < _textures.size(); ++tex_index) {
         if (_textures[tex_index] == texture) {
+            DeferredFree([texture]() { delete texture; });
             _textures.erase(_textures.begin() + tex_index);
+            break;
         }
     }
 }
@@ -245,13 +395,10 @@ bool GlobeResourceManager::InsertImageLayoutTransitionBarrier(VkCommandBuffer vk
 // Font management methods
 // --------------------------------------------------------------------------------------------------------------
 
-GlobeFont* GlobeResourceManager::LoadFontMap(const std::string& font_name, float font_size) {
-    std::string font_dir = _base_directory;
-    font_dir += directory_symbol;
-    font_dir += "fonts";
-    font_dir += directory_symbol;
-    GlobeFont* font =
-        GlobeFont::LoadFontMap(this, _parent_app->SubmitManager(), _vk_device, font_size, font_name, font_dir);
+GlobeFont* GlobeResourceManager::LoadFontMap(const std::string& font_name, float font_size,
+                                             GlobeUploadBatch* upload_batch) {
+    std::string font_dir = AssetDirectory("fonts");
+    GlobeFont* font = GlobeFont::LoadFontMap(this, upload_batch, _vk_device, font_size, font_name, font_dir);
     if (nullptr != font) {
         _fonts.push_back(font);
     }
@@ -260,7 +407,7 @@ GlobeFont* GlobeResourceManager::LoadFontMap(const std::string& font_name, float
 
 void GlobeResourceManager::FreeAllFonts() {
     for (auto font : _fonts) {
-        delete font;
+        DeferredFree([font]() { delete font; });
     }
     _fonts.clear();
 }
@@ -268,7 +415,9 @@ void GlobeResourceManager::FreeAllFonts() {
 void GlobeResourceManager::FreeFont(GlobeFont* font) {
     for (uint32_t font_index = 0; font_index < _fonts.size(); ++font_index) {
         if (_fonts[font_index] == font) {
+            DeferredFree([font]() { delete font; });
             _fonts.erase(_fonts.begin() + font_index);
+            break;
         }
     }
 }
@@ -277,20 +426,24 @@ void GlobeResourceManager::FreeFont(GlobeFont* font) {
 // --------------------------------------------------------------------------------------------------------------
 
 GlobeShader* GlobeResourceManager::LoadShader(const std::string& shader_prefix) {
-    std::string shader_dir = _base_directory;
-    shader_dir += directory_symbol;
-    shader_dir += "shaders";
-    shader_dir += directory_symbol;
+    std::string shader_dir = AssetDirectory("shaders");
     GlobeShader* shader = GlobeShader::LoadFromFile(_vk_device, shader_prefix, shader_dir);
     if (nullptr != shader) {
         _shaders.push_back(shader);
+        _pipeline_cache->AddShader(shader);
     }
     return shader;
 }
 
+bool GlobeResourceManager::HasShader(const std::string& shader_prefix) const {
+    GlobeShaderStageInitData shader_data[GLOBE_SHADER_STAGE_ID_NUM_STAGES] = {{}, {}, {}, {}, {}, {}};
+    return GlobeShader::LoadFileContent(shader_prefix, AssetDirectory("shaders"), shader_data);
+}
+
 void GlobeResourceManager::FreeAllShaders() {
     for (auto shader : _shaders) {
-        delete shader;
+        _pipeline_cache->RemoveShader(shader);
+        DeferredFree([shader]() { delete shader; });
     }
     _shaders.clear();
 }
@@ -298,8 +451,10 @@ void GlobeResourceManager::FreeAllShaders() {
 void GlobeResourceManager::FreeShader(GlobeShader* shader) {
     for (uint32_t shd_index = 0; shd_index < _shaders.size(); ++shd_index) {
         if (_shaders[shd_index] == shader) {
-            delete _shaders[shd_index];
+            _pipeline_cache->RemoveShader(shader);
+            DeferredFree([shader]() { delete shader; });
             _shaders.erase(_shaders.begin() + shd_index);
+            break;
         }
     }
 }
@@ -308,14 +463,11 @@ void GlobeResourceManager::FreeShader(GlobeShader* shader) {
 // --------------------------------------------------------------------------------------------------------------
 
 GlobeModel* GlobeResourceManager::LoadModel(const std::string& sub_dir, const std::string& model_name,
-                                            const GlobeComponentSizes& sizes) {
-    std::string model_dir = _base_directory;
-    model_dir += directory_symbol;
-    model_dir += "models";
-    model_dir += directory_symbol;
-    model_dir += sub_dir;
-    model_dir += directory_symbol;
-    GlobeModel* model = GlobeModel::LoadModelFile(this, _vk_device, sizes, model_name, model_dir);
+                                            const GlobeComponentSizes& sizes, GlobeHostCopyPolicy host_copy_policy,
+                                            GlobeUploadBatch* upload_batch) {
+    std::string model_dir = AssetDirectory("models", sub_dir);
+    GlobeModel* model = GlobeModel::LoadModelFile(this, upload_batch, _vk_device, sizes, model_name, model_dir,
+                                                  _parent_app->CacheDirectory(), HostCopyPolicy(host_copy_policy));
     if (nullptr != model) {
         _models.push_back(model);
     }
@@ -324,7 +476,7 @@ GlobeModel* GlobeResourceManager::LoadModel(const std::string& sub_dir, const st
 
 void GlobeResourceManager::FreeAllModels() {
     for (auto model : _models) {
-        delete model;
+        DeferredFree([model]() { delete model; });
     }
     _models.clear();
 }
@@ -332,18 +484,329 @@ void GlobeResourceManager::FreeAllModels() {
 void GlobeResourceManager::FreeModel(GlobeModel* model) {
     for (uint32_t model_index = 0; model_index < _models.size(); ++model_index) {
         if (_models[model_index] == model) {
-            delete _models[model_index];
+            DeferredFree([model]() { delete model; });
             _models.erase(_models.begin() + model_index);
+            break;
+        }
+    }
+}
+
+bool GlobeResourceManager::MountAssetArchive(const std::string& archive_file) {
+    GlobeAssetArchive* asset_archive = new GlobeAssetArchive();
+    if (!asset_archive->Open(archive_file, _base_directory)) {
+        GlobeLogger::getInstance().LogError("MountAssetArchive - Failed to open archive " + archive_file);
+        delete asset_archive;
+        return false;
+    }
+    GlobeAssetArchive::Mount(asset_archive);
+    _asset_archives.push_back(asset_archive);
+    GlobeLogger::getInstance().LogInfo("Mounted asset archive " + archive_file + " with " +
+                                       std::to_string(asset_archive->NumEntries()) + " entries");
+    return true;
+}
+
+// Asynchronous loading methods
+// --------------------------------------------------------------------------------------------------------------
+
+std::string GlobeResourceManager::AssetDirectory(const std::string& asset_type, const std::string& sub_dir) const {
+    std::string asset_dir = _base_directory;
+    asset_dir += directory_symbol;
+    asset_dir += asset_type;
+    asset_dir += directory_symbol;
+    if (!sub_dir.empty()) {
+        asset_dir += sub_dir;
+        asset_dir += directory_symbol;
+    }
+    return asset_dir;
+}
+
+GlobeAsyncLoadHandle GlobeResourceManager::LoadTextureAsync(const std::string& texture_name, bool generate_mipmaps,
+                                                            GlobeTextureCompression compression) {
+    bool is_standard_file = false;
+    if (!IsStandardTextureFile(texture_name, is_standard_file)) {
+        return GLOBE_ASYNC_LOAD_INVALID_HANDLE;
+    }
+    GlobeAsyncLoadRequest* request = new GlobeAsyncLoadRequest();
+    request->type = GLOBE_ASYNC_LOAD_TYPE_TEXTURE;
+    request->name = texture_name;
+    request->directory = AssetDirectory("textures");
+    request->generate_mipmaps = generate_mipmaps;
+    request->texture_compression = compression;
+    request->is_standard_file = is_standard_file;
+    return QueueAsyncLoad(request);
+}
+
+GlobeAsyncLoadHandle GlobeResourceManager::LoadFontMapAsync(const std::string& font_name, float font_size) {
+    GlobeAsyncLoadRequest* request = new GlobeAsyncLoadRequest();
+    request->type = GLOBE_ASYNC_LOAD_TYPE_FONT;
+    request->name = font_name;
+    request->directory = AssetDirectory("fonts");
+    request->font_size = font_size;
+    return QueueAsyncLoad(request);
+}
+
+GlobeAsyncLoadHandle GlobeResourceManager::LoadShaderAsync(const std::string& shader_prefix) {
+    GlobeAsyncLoadRequest* request = new GlobeAsyncLoadRequest();
+    request->type = GLOBE_ASYNC_LOAD_TYPE_SHADER;
+    request->name = shader_prefix;
+    request->directory = AssetDirectory("shaders");
+    return QueueAsyncLoad(request);
+}
+
+GlobeAsyncLoadHandle GlobeResourceManager::LoadModelAsync(const std::string& sub_dir, const std::string& model_name,
+                                                          const GlobeComponentSizes& sizes,
+                                                          GlobeHostCopyPolicy host_copy_policy) {
+    GlobeAsyncLoadRequest* request = new GlobeAsyncLoadRequest();
+    request->type = GLOBE_ASYNC_LOAD_TYPE_MODEL;
+    request->name = model_name;
+    request->directory = AssetDirectory("models", sub_dir);
+    request->sizes = sizes;
+    request->host_copy_policy = HostCopyPolicy(host_copy_policy);
+    return QueueAsyncLoad(request);
+}
+
+GlobeThreadPool* GlobeResourceManager::GetThreadPool() {
+    // Texture loads running on a worker may ask for the pool too, so only the first caller creates it.
+    std::call_once(_thread_pool_once, [this]() {
+        // Leave one core for the thread that is busy recording and submitting work.
+        uint32_t num_threads = std::thread::hardware_concurrency();
+        if (num_threads > 1) {
+            num_threads--;
+        }
+        _thread_pool = new GlobeThreadPool(num_threads);
+    });
+    return _thread_pool;
+}
+
+GlobeAsyncLoadHandle GlobeResourceManager::QueueAsyncLoad(GlobeAsyncLoadRequest* request) {
+    GlobeThreadPool* thread_pool = GetThreadPool();
+    request->status = GLOBE_ASYNC_LOAD_PENDING;
+    GlobeAsyncLoadHandle handle = static_cast<GlobeAsyncLoadHandle>(_async_requests.size());
+    _async_requests.push_back(request);
+    {
+        std::unique_lock<std::mutex> lock(_async_mutex);
+        _async_pending_count++;
+    }
+    thread_pool->Enqueue([this, request]() { LoadAsyncContent(request); });
+    return handle;
+}
+
+// Runs on a worker thread, so this must only perform file I/O and CPU work.
+void GlobeResourceManager::LoadAsyncContent(GlobeAsyncLoadRequest* request) {
+    bool content_valid = false;
+    switch (request->type) {
+        case GLOBE_ASYNC_LOAD_TYPE_TEXTURE:
+            if (request->is_standard_file) {
+                content_valid = GlobeTexture::LoadStandardFileContent(this, request->generate_mipmaps,
+                                                                      request->texture_compression, request->name,
+                                                                      request->directory, request->texture_data);
+            } else {
+                content_valid = GlobeTexture::LoadKtxFileContent(this, request->generate_mipmaps, request->name,
+                                                                 request->directory, request->texture_data);
+            }
+            break;
+        case GLOBE_ASYNC_LOAD_TYPE_FONT:
+            content_valid = GlobeFont::LoadFontMapContent(this, request->font_size, request->name, request->directory,
+                                                          request->font_data);
+            break;
+        case GLOBE_ASYNC_LOAD_TYPE_SHADER:
+            content_valid = GlobeShader::LoadFileContent(request->name, request->directory, request->shader_data);
+            break;
+        case GLOBE_ASYNC_LOAD_TYPE_MODEL:
+            content_valid = GlobeModel::LoadModelFileContent(request->sizes, request->name, request->directory,
+                                                             request->model_content, _parent_app->CacheDirectory());
+            break;
+    }
+    {
+        std::unique_lock<std::mutex> lock(_async_mutex);
+        request->content_valid = content_valid;
+        _async_loaded_requests.push_back(request);
+    }
+    _async_content_loaded.notify_all();
+}
+
+// Runs on the polling thread and creates the Vulkan objects for content the workers have finished with.
+void GlobeResourceManager::CreateAsyncResource(GlobeAsyncLoadRequest* request, GlobeUploadBatch* upload_batch) {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    bool created = false;
+    if (request->content_valid) {
+        switch (request->type) {
+            case GLOBE_ASYNC_LOAD_TYPE_TEXTURE:
+                request->texture = GlobeTexture::CreateFromContent(this, upload_batch, _vk_device, request->name,
+                                                                   request->texture_data);
+                if (nullptr != request->texture) {
+                    _textures.push_back(request->texture);
+                    created = true;
+                }
+                break;
+            case GLOBE_ASYNC_LOAD_TYPE_FONT:
+                request->font =
+                    GlobeFont::GenerateFont(this, upload_batch, _vk_device, request->name, request->font_data);
+                if (nullptr != request->font) {
+                    _fonts.push_back(request->font);
+                    created = true;
+                }
+                break;
+            case GLOBE_ASYNC_LOAD_TYPE_SHADER:
+                request->shader = new GlobeShader(_vk_device, request->name, request->shader_data);
+                if (!request->shader->IsValid()) {
+                    delete request->shader;
+                    request->shader = nullptr;
+                } else {
+                    _shaders.push_back(request->shader);
+                    _pipeline_cache->AddShader(request->shader);
+                    created = true;
+                }
+                for (uint32_t stage = 0; stage < GLOBE_SHADER_STAGE_ID_NUM_STAGES; ++stage) {
+                    request->shader_data[stage].spirv_file.Close();
+                }
+                break;
+            case GLOBE_ASYNC_LOAD_TYPE_MODEL:
+                request->model = GlobeModel::CreateFromContent(this, upload_batch, _vk_device, request->name,
+                                                               request->sizes, request->model_content,
+                                                               request->host_copy_policy);
+                if (nullptr != request->model) {
+                    _models.push_back(request->model);
+                    created = true;
+                }
+                request->model_content = {};
+                break;
         }
     }
+    if (created) {
+        request->status = GLOBE_ASYNC_LOAD_COMPLETE;
+    } else {
+        std::string error_msg = "CreateAsyncResource - Failed asynchronous load of \"";
+        error_msg += request->directory;
+        error_msg += request->name;
+        error_msg += "\"";
+        logger.LogError(error_msg);
+        request->status = GLOBE_ASYNC_LOAD_FAILED;
+    }
+}
+
+uint32_t GlobeResourceManager::PollAsyncLoads() {
+    std::vector<GlobeAsyncLoadRequest*> loaded_requests;
+    {
+        std::unique_lock<std::mutex> lock(_async_mutex);
+        loaded_requests.swap(_async_loaded_requests);
+    }
+    if (!loaded_requests.empty()) {
+        // Everything that finished loading since the last poll is uploaded with one submit.
+        GlobeUploadBatch* upload_batch = BeginUploadBatch();
+        for (auto request : loaded_requests) {
+            CreateAsyncResource(request, upload_batch);
+        }
+        if (nullptr != upload_batch) {
+            if (!upload_batch->Submit(true)) {
+                GlobeLogger::getInstance().LogError("PollAsyncLoads - Failed submitting upload batch");
+                // Whatever the batch created never got its contents, so free it rather than leave it registered
+                // for a later load of the same name to pick up.
+                for (auto request : loaded_requests) {
+                    switch (request->type) {
+                        case GLOBE_ASYNC_LOAD_TYPE_TEXTURE:
+                            if (nullptr != request->texture) {
+                                FreeTexture(request->texture);
+                                request->texture = nullptr;
+                            }
+                            break;
+                        case GLOBE_ASYNC_LOAD_TYPE_FONT:
+                            if (nullptr != request->font) {
+                                FreeFont(request->font);
+                                request->font = nullptr;
+                            }
+                            break;
+                        case GLOBE_ASYNC_LOAD_TYPE_MODEL:
+                            if (nullptr != request->model) {
+                                FreeModel(request->model);
+                                request->model = nullptr;
+                            }
+                            break;
+                        case GLOBE_ASYNC_LOAD_TYPE_SHADER:
+                            // Shaders don't upload anything.
+                            continue;
+                    }
+                    request->status = GLOBE_ASYNC_LOAD_FAILED;
+                }
+            }
+            FreeUploadBatch(upload_batch);
+        }
+    }
+    std::unique_lock<std::mutex> lock(_async_mutex);
+    _async_pending_count -= static_cast<uint32_t>(loaded_requests.size());
+    return _async_pending_count;
+}
+
+bool GlobeResourceManager::WaitAllAsyncLoads() {
+    while (0 < PollAsyncLoads()) {
+        std::unique_lock<std::mutex> lock(_async_mutex);
+        _async_content_loaded.wait(lock, [this] { return !_async_loaded_requests.empty(); });
+    }
+    for (auto request : _async_requests) {
+        if (GLOBE_ASYNC_LOAD_FAILED == request->status) {
+            return false;
+        }
+    }
+    return true;
+}
+
+GlobeAsyncLoadStatus GlobeResourceManager::GetAsyncLoadStatus(GlobeAsyncLoadHandle handle) const {
+    if (handle >= _async_requests.size()) {
+        return GLOBE_ASYNC_LOAD_FAILED;
+    }
+    return _async_requests[handle]->status;
+}
+
+GlobeTexture* GlobeResourceManager::GetAsyncTexture(GlobeAsyncLoadHandle handle) const {
+    if (handle >= _async_requests.size() || _async_requests[handle]->type != GLOBE_ASYNC_LOAD_TYPE_TEXTURE) {
+        return nullptr;
+    }
+    return _async_requests[handle]->texture;
+}
+
+GlobeFont* GlobeResourceManager::GetAsyncFont(GlobeAsyncLoadHandle handle) const {
+    if (handle >= _async_requests.size() || _async_requests[handle]->type != GLOBE_ASYNC_LOAD_TYPE_FONT) {
+        return nullptr;
+    }
+    return _async_requests[handle]->font;
+}
+
+GlobeShader* GlobeResourceManager::GetAsyncShader(GlobeAsyncLoadHandle handle) const {
+    if (handle >= _async_requests.size() || _async_requests[handle]->type != GLOBE_ASYNC_LOAD_TYPE_SHADER) {
+        return nullptr;
+    }
+    return _async_requests[handle]->shader;
+}
+
+GlobeModel* GlobeResourceManager::GetAsyncModel(GlobeAsyncLoadHandle handle) const {
+    if (handle >= _async_requests.size() || _async_requests[handle]->type != GLOBE_ASYNC_LOAD_TYPE_MODEL) {
+        return nullptr;
+    }
+    return _async_requests[handle]->model;
+}
+
+void GlobeResourceManager::FreeAsyncRequests() {
+    // Anything loaded by a worker but never picked up by a poll still owns its CPU-side content.
+    for (auto request : _async_loaded_requests) {
+        if (GLOBE_ASYNC_LOAD_TYPE_TEXTURE == request->type) {
+            GlobeTexture::FreeContent(request->texture_data);
+        } else if (GLOBE_ASYNC_LOAD_TYPE_FONT == request->type) {
+            GlobeTexture::FreeContent(request->font_data.texture_data);
+        }
+    }
+    _async_loaded_requests.clear();
+    for (auto request : _async_requests) {
+        delete request;
+    }
+    _async_requests.clear();
+    _async_pending_count = 0;
 }
 
 // Memory management methods
 // --------------------------------------------------------------------------------------------------------------
 
 bool GlobeResourceManager::AllocateDeviceBufferMemory(VkBuffer vk_buffer, VkMemoryPropertyFlags vk_memory_properties,
-                                                      VkDeviceMemory& vk_device_memory,
-                                                      VkDeviceSize& vk_allocated_size) const {
+                                                      GlobeDeviceMemory& device_memory) const {
     GlobeLogger& logger = GlobeLogger::getInstance();
 
     VkMemoryRequirements vk_memory_requirements = {};
@@ -353,23 +816,15 @@ bool GlobeResourceManager::AllocateDeviceBufferMemory(VkBuffer vk_buffer, VkMemo
         logger.LogError("Failed selecting memory type for buffer memory");
         return false;
     }
-
-    VkMemoryAllocateInfo vk_memory_alloc_info = {};
-    vk_memory_alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    vk_memory_alloc_info.pNext = nullptr;
-    vk_memory_alloc_info.allocationSize = vk_memory_requirements.size;
-    vk_memory_alloc_info.memoryTypeIndex = memory_type_index;
-    if (VK_SUCCESS != vkAllocateMemory(_vk_device, &vk_memory_alloc_info, nullptr, &vk_device_memory)) {
+    if (!_memory_allocator->Allocate(vk_memory_requirements, memory_type_index, false, device_memory)) {
         logger.LogError("Failed allocating device buffer memory");
         return false;
     }
-    vk_allocated_size = vk_memory_requirements.size;
     return true;
 }
 
 bool GlobeResourceManager::AllocateDeviceImageMemory(VkImage vk_image, VkMemoryPropertyFlags vk_memory_properties,
-                                                     VkDeviceMemory& vk_device_memory,
-                                                     VkDeviceSize& vk_allocated_size) const {
+                                                     GlobeDeviceMemory& device_memory) const {
     GlobeLogger& logger = GlobeLogger::getInstance();
 
     VkMemoryRequirements vk_memory_requirements = {};
@@ -379,22 +834,324 @@ bool GlobeResourceManager::AllocateDeviceImageMemory(VkImage vk_image, VkMemoryP
         logger.LogError("Failed selecting memory type for image memory");
         return false;
     }
-
-    VkMemoryAllocateInfo vk_memory_alloc_info = {};
-    vk_memory_alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    vk_memory_alloc_info.pNext = nullptr;
-    vk_memory_alloc_info.allocationSize = vk_memory_requirements.size;
-    vk_memory_alloc_info.memoryTypeIndex = memory_type_index;
-    if (VK_SUCCESS != vkAllocateMemory(_vk_device, &vk_memory_alloc_info, nullptr, &vk_device_memory)) {
+    if (!_memory_allocator->Allocate(vk_memory_requirements, memory_type_index, true, device_memory)) {
         logger.LogError("Failed allocating device image memory");
         return false;
     }
-    vk_allocated_size = vk_memory_requirements.size;
     return true;
 }
 
-void GlobeResourceManager::FreeDeviceMemory(VkDeviceMemory& vk_device_memory) const {
-    vkFreeMemory(_vk_device, vk_device_memory, nullptr);
+void GlobeResourceManager::FreeDeviceMemory(GlobeDeviceMemory& device_memory) const {
+    _memory_allocator->Free(device_memory);
+}
+
+bool GlobeResourceManager::FlushDeviceMemory(const GlobeDeviceMemory& device_memory, VkDeviceSize offset,
+                                             VkDeviceSize size) const {
+    return _memory_allocator->Flush(device_memory, offset, size);
+}
+
+GlobeMemoryStats GlobeResourceManager::GetMemoryStats() const { return _memory_allocator->GetStats(); }
+
+void GlobeResourceManager::LogMemoryStats() const {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    GlobeMemoryStats stats = _memory_allocator->GetStats();
+    std::string perf_msg = "Device memory: ";
+    perf_msg += std::to_string(stats.allocation_count);
+    perf_msg += " allocations (";
+    perf_msg += std::to_string(stats.used_bytes);
+    perf_msg += " bytes) in ";
+    perf_msg += std::to_string(stats.device_memory_count);
+    perf_msg += " VkDeviceMemory blocks (";
+    perf_msg += std::to_string(stats.reserved_bytes);
+    perf_msg += " bytes), ";
+    perf_msg += std::to_string(stats.total_allocations);
+    perf_msg += " requests serviced, average ";
+    perf_msg += std::to_string(stats.total_allocations > 0 ? stats.total_allocation_ns / stats.total_allocations : 0);
+    perf_msg += " ns, max ";
+    perf_msg += std::to_string(stats.max_allocation_ns);
+    perf_msg += " ns";
+    logger.LogPerf(perf_msg);
+
+    GlobeHostCopyStats host_copy_stats = GetHostCopyStats();
+    perf_msg = "Host copies: ";
+    perf_msg += std::to_string(host_copy_stats.resident_bytes);
+    perf_msg += " bytes resident, ";
+    perf_msg += std::to_string(host_copy_stats.released_bytes);
+    perf_msg += " bytes released after upload";
+    logger.LogPerf(perf_msg);
+}
+
+void GlobeResourceManager::SetHostCopyPolicy(GlobeHostCopyPolicy host_copy_policy) {
+    _host_copy_policy = GLOBE_HOST_COPY_DEFAULT == host_copy_policy ? GLOBE_HOST_COPY_KEEP : host_copy_policy;
+}
+
+GlobeHostCopyPolicy GlobeResourceManager::HostCopyPolicy(GlobeHostCopyPolicy host_copy_policy) const {
+    return GLOBE_HOST_COPY_DEFAULT == host_copy_policy ? _host_copy_policy : host_copy_policy;
+}
+
+void GlobeResourceManager::TrackHostCopy(uint64_t resident_bytes, uint64_t released_bytes) const {
+    _host_copy_resident_bytes += resident_bytes;
+    _host_copy_released_bytes += released_bytes;
+}
+
+void GlobeResourceManager::UntrackHostCopy(uint64_t resident_bytes) const {
+    _host_copy_resident_bytes -= resident_bytes;
+}
+
+GlobeHostCopyStats GlobeResourceManager::GetHostCopyStats() const {
+    GlobeHostCopyStats host_copy_stats = {};
+    host_copy_stats.resident_bytes = _host_copy_resident_bytes;
+    host_copy_stats.released_bytes = _host_copy_released_bytes;
+    return host_copy_stats;
+}
+
+void GlobeResourceManager::SetGeometryMemoryPolicy(GlobeGeometryMemoryPolicy geometry_memory_policy) {
+    if (!_uses_staging_buffer) {
+        _geometry_memory_policy = GLOBE_GEOMETRY_MEMORY_HOST_VISIBLE;
+    } else if (GLOBE_GEOMETRY_MEMORY_DEFAULT == geometry_memory_policy) {
+        _geometry_memory_policy =
+            _is_unified_memory ? GLOBE_GEOMETRY_MEMORY_HOST_VISIBLE : GLOBE_GEOMETRY_MEMORY_DEVICE_LOCAL;
+    } else {
+        _geometry_memory_policy = geometry_memory_policy;
+    }
+}
+
+// Staged upload methods
+// --------------------------------------------------------------------------------------------------------------
+
+// Number of texel rows covered by one row of blocks in the given format.
+static uint32_t FormatBlockHeight(VkFormat vk_format) {
+    if (vk_format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && vk_format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK) {
+        return 4;
+    }
+    switch (vk_format) {
+        case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_5x4_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_5x4_SRGB_BLOCK:
+            return 4;
+        case VK_FORMAT_ASTC_5x5_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_5x5_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_6x5_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_6x5_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_8x5_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_8x5_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_10x5_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_10x5_SRGB_BLOCK:
+            return 5;
+        case VK_FORMAT_ASTC_6x6_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_6x6_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_8x6_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_8x6_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_10x6_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_10x6_SRGB_BLOCK:
+            return 6;
+        case VK_FORMAT_ASTC_8x8_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_8x8_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_10x8_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_10x8_SRGB_BLOCK:
+            return 8;
+        case VK_FORMAT_ASTC_10x10_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_10x10_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_12x10_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_12x10_SRGB_BLOCK:
+            return 10;
+        case VK_FORMAT_ASTC_12x12_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_12x12_SRGB_BLOCK:
+            return 12;
+        default:
+            return 1;
+    }
+}
+
+GlobeUploadBatch* GlobeResourceManager::BeginUploadBatch() {
+    GlobeUploadBatch* upload_batch = new GlobeUploadBatch(this, _parent_app->SubmitManager(), _vk_device);
+    if (!upload_batch->Begin()) {
+        GlobeLogger::getInstance().LogError("BeginUploadBatch - Failed to begin upload batch");
+        delete upload_batch;
+        return nullptr;
+    }
+    _upload_batches.push_back(upload_batch);
+    return upload_batch;
+}
+
+void GlobeResourceManager::FreeUploadBatch(GlobeUploadBatch* upload_batch) {
+    auto batch_iter = std::find(_upload_batches.begin(), _upload_batches.end(), upload_batch);
+    if (batch_iter != _upload_batches.end()) {
+        _upload_batches.erase(batch_iter);
+        delete upload_batch;
+    }
+}
+
+void GlobeResourceManager::ReleaseStagingAllocation(uint64_t allocation_id) {
+    if (nullptr != _staging_ring) {
+        _staging_ring->Release(allocation_id);
+    }
+}
+
+bool GlobeResourceManager::WriteInstanceData(const uint8_t* data, VkDeviceSize size, VkBuffer& vk_buffer,
+                                             VkDeviceSize& vk_offset) {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    if (nullptr == _instance_ring) {
+        _instance_ring = new GlobeStagingRing(this, _vk_device, GLOBE_INSTANCE_RING_DEFAULT_SIZE,
+                                              VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    }
+    uint8_t* mapped_data = nullptr;
+    GlobeInstanceAllocation instance_allocation = {};
+    if (!_instance_ring->Allocate(size, 16, vk_offset, mapped_data, instance_allocation.allocation_id)) {
+        std::string error_message = "WriteInstanceData - Instance ring has no room for ";
+        error_message += std::to_string(size);
+        error_message += " bytes";
+        logger.LogError(error_message);
+        return false;
+    }
+    memcpy(mapped_data, data, static_cast<size_t>(size));
+    _instance_ring->Flush(vk_offset, size);
+    // Just like DeferredFree, the frame being recorded right now has to complete before the space is reused.
+    instance_allocation.retire_frame = _parent_app->SubmitManager()->SubmittedFrameCount() + 1;
+    _instance_allocations.push_back(instance_allocation);
+    vk_buffer = _instance_ring->GetVkBuffer();
+    return true;
+}
+
+bool GlobeResourceManager::ReserveStagingSpace(GlobeUploadBatch* upload_batch, VkDeviceSize size,
+                                               VkDeviceSize alignment, VkDeviceSize& offset, uint8_t*& mapped_data) {
+    uint64_t allocation_id = 0;
+    if (_staging_ring->Allocate(size, alignment, offset, mapped_data, allocation_id)) {
+        upload_batch->AddStagingAllocation(allocation_id);
+        return true;
+    }
+    // The space is held by batches that were submitted earlier, so wait on those, oldest first.
+    for (auto older_batch : _upload_batches) {
+        if (older_batch != upload_batch && older_batch->IsSubmitted()) {
+            older_batch->Wait();
+            if (_staging_ring->Allocate(size, alignment, offset, mapped_data, allocation_id)) {
+                upload_batch->AddStagingAllocation(allocation_id);
+                return true;
+            }
+        }
+    }
+    // Otherwise, this batch is holding the space itself, so send what it has so far.
+    if (!upload_batch->Flush()) {
+        return false;
+    }
+    if (_staging_ring->Allocate(size, alignment, offset, mapped_data, allocation_id)) {
+        upload_batch->AddStagingAllocation(allocation_id);
+        return true;
+    }
+    return false;
+}
+
+bool GlobeResourceManager::StageBufferUpload(GlobeUploadBatch* upload_batch, VkBuffer vk_buffer,
+                                             VkDeviceSize vk_offset, const uint8_t* data, VkDeviceSize size) {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    if (nullptr == _staging_ring || !_staging_ring->IsValid()) {
+        logger.LogError("StageBufferUpload - No staging buffer available");
+        return false;
+    }
+    VkDeviceSize uploaded = 0;
+    while (uploaded < size) {
+        VkDeviceSize chunk_size = size - uploaded;
+        if (chunk_size > _staging_ring->Size()) {
+            chunk_size = _staging_ring->Size();
+        }
+        VkDeviceSize staging_offset = 0;
+        uint8_t* mapped_data = nullptr;
+        if (!ReserveStagingSpace(upload_batch, chunk_size, 4, staging_offset, mapped_data)) {
+            logger.LogError("StageBufferUpload - Failed to reserve staging buffer space");
+            return false;
+        }
+        memcpy(mapped_data, data + uploaded, static_cast<size_t>(chunk_size));
+        _staging_ring->Flush(staging_offset, chunk_size);
+
+        VkBufferCopy vk_buffer_copy = {};
+        vk_buffer_copy.srcOffset = staging_offset;
+        vk_buffer_copy.dstOffset = vk_offset + uploaded;
+        vk_buffer_copy.size = chunk_size;
+        vkCmdCopyBuffer(upload_batch->GetVkCommandBuffer(), _staging_ring->GetVkBuffer(), vk_buffer, 1,
+                        &vk_buffer_copy);
+        uploaded += chunk_size;
+    }
+    return true;
+}
+
+// Each entry in vk_copies uses bufferOffset as the offset of that region's tightly packed data inside
+// of "data", and copy_sizes holds the size of that region's data.
+bool GlobeResourceManager::StageImageUpload(GlobeUploadBatch* upload_batch, VkImage vk_image, VkFormat vk_format,
+                                            VkDeviceSize texel_block_size, const uint8_t* data,
+                                            const std::vector<VkBufferImageCopy>& vk_copies,
+                                            const std::vector<VkDeviceSize>& copy_sizes,
+                                            GlobePixelConversion conversion) {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    if (nullptr == _staging_ring || !_staging_ring->IsValid()) {
+        logger.LogError("StageImageUpload - No staging buffer available");
+        return false;
+    }
+
+    // Buffer offsets for image copies must be a multiple of both 4 and the texel block size.
+    VkDeviceSize alignment = texel_block_size;
+    while (alignment % 4 != 0) {
+        alignment += texel_block_size;
+    }
+
+    uint32_t block_height = FormatBlockHeight(vk_format);
+    for (uint32_t region = 0; region < vk_copies.size(); ++region) {
+        const VkBufferImageCopy& vk_copy = vk_copies[region];
+        // Only 2D regions are split up, a 3D region has to fit in the ring as a whole.
+        uint32_t block_rows = 1;
+        if (vk_copy.imageExtent.depth <= 1) {
+            block_rows = (vk_copy.imageExtent.height + block_height - 1) / block_height;
+        }
+        VkDeviceSize row_size = copy_sizes[region] / block_rows;
+        VkDeviceSize max_rows = _staging_ring->Size() / row_size;
+        if (max_rows == 0) {
+            std::string error_msg = "StageImageUpload - Image region of ";
+            error_msg += std::to_string(copy_sizes[region]);
+            error_msg += " bytes can not be split to fit in the staging buffer";
+            logger.LogError(error_msg);
+            return false;
+        }
+
+        // Stream the region through the ring a band of rows at a time.
+        uint32_t cur_row = 0;
+        while (cur_row < block_rows) {
+            uint32_t num_rows = block_rows - cur_row;
+            if (num_rows > max_rows) {
+                num_rows = static_cast<uint32_t>(max_rows);
+            }
+            VkDeviceSize chunk_size = num_rows * row_size;
+            VkDeviceSize staging_offset = 0;
+            uint8_t* mapped_data = nullptr;
+            if (!ReserveStagingSpace(upload_batch, chunk_size, alignment, staging_offset, mapped_data)) {
+                logger.LogError("StageImageUpload - Failed to reserve staging buffer space");
+                return false;
+            }
+            VkDeviceSize data_offset = vk_copy.bufferOffset + cur_row * row_size;
+            if (GLOBE_PIXEL_CONVERSION_NONE == conversion) {
+                memcpy(mapped_data, data + data_offset, static_cast<size_t>(chunk_size));
+            } else {
+                const uint8_t* src_texels = data + data_offset / 4 * GlobePixelConversionSourceSize(conversion);
+                GlobeConvertPixels(conversion, src_texels, mapped_data, static_cast<size_t>(chunk_size / 4));
+            }
+            _staging_ring->Flush(staging_offset, chunk_size);
+
+            VkBufferImageCopy vk_chunk_copy = vk_copy;
+            vk_chunk_copy.bufferOffset = staging_offset;
+            vk_chunk_copy.bufferRowLength = 0;
+            vk_chunk_copy.bufferImageHeight = 0;
+            if (num_rows < block_rows) {
+                vk_chunk_copy.imageOffset.y += static_cast<int32_t>(cur_row * block_height);
+                vk_chunk_copy.imageExtent.height = num_rows * block_height;
+                if (vk_chunk_copy.imageExtent.height > vk_copy.imageExtent.height - cur_row * block_height) {
+                    vk_chunk_copy.imageExtent.height = vk_copy.imageExtent.height - cur_row * block_height;
+                }
+            }
+            vkCmdCopyBufferToImage(upload_batch->GetVkCommandBuffer(), _staging_ring->GetVkBuffer(), vk_image,
+                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &vk_chunk_copy);
+            cur_row += num_rows;
+        }
+    }
+    return true;
 }
 
 VkFormatProperties GlobeResourceManager::GetVkFormatProperties(VkFormat format) const {
@@ -403,6 +1160,11 @@ VkFormatProperties GlobeResourceManager::GetVkFormatProperties(VkFormat format)
     return format_properties;
 }
 
+// Pipelines created internally (like the font pipelines) share the application's persistent pipeline cache.
+VkPipelineCache GlobeResourceManager::GetVkPipelineCache() const { return _parent_app->GetVkPipelineCache(); }
+
+const std::string& GlobeResourceManager::CacheDirectory() const { return _parent_app->CacheDirectory(); }
+
 bool GlobeResourceManager::SelectMemoryTypeUsingRequirements(VkMemoryRequirements requirements, VkFlags required_flags,
                                                              uint32_t& type) const {
     uint32_t type_bits = requirements.memoryTypeBits;
@@ -448,3 +1210,75 @@ bool GlobeResourceManager::FreeCommandBuffer(VkCommandBuffer& command_buffer) {
     command_buffer = VK_NULL_HANDLE;
     return true;
 }
+
+// Transfer command buffers can only be submitted to the transfer queue (see GlobeSubmitManager::SubmitTransfer).
+// Without a separate transfer queue family these come from the same pool as AllocateCommandBuffer.
+bool GlobeResourceManager::AllocateTransferCommandBuffer(VkCommandBuffer& command_buffer) {
+    if (!UsesTransferQueue()) {
+        return AllocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, command_buffer);
+    }
+    VkCommandBufferAllocateInfo command_buffer_allocate_info = {};
+    command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_allocate_info.pNext = nullptr;
+    command_buffer_allocate_info.commandPool = _vk_transfer_cmd_pool;
+    command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_allocate_info.commandBufferCount = 1;
+    if (VK_SUCCESS != vkAllocateCommandBuffers(_vk_device, &command_buffer_allocate_info, &command_buffer)) {
+        GlobeLogger::getInstance().LogFatalError(
+            "GlobeResourceManager::AllocateTransferCommandBuffer - Failed to allocate command buffer");
+        return false;
+    }
+    return true;
+}
+
+bool GlobeResourceManager::FreeTransferCommandBuffer(VkCommandBuffer& command_buffer) {
+    if (!UsesTransferQueue()) {
+        return FreeCommandBuffer(command_buffer);
+    }
+    vkFreeCommandBuffers(_vk_device, _vk_transfer_cmd_pool, 1, &command_buffer);
+    command_buffer = VK_NULL_HANDLE;
+    return true;
+}
+
+// Deferred destruction methods
+// --------------------------------------------------------------------------------------------------------------
+
+void GlobeResourceManager::DeferredFree(const std::function<void()>& free_func) {
+    GlobeDeferredFree deferred_free = {};
+    // Nothing has been submitted yet for the frame being recorded right now, so it has to
+    // complete as well before the resource is out of use.
+    deferred_free.retire_frame = _parent_app->SubmitManager()->SubmittedFrameCount() + 1;
+    deferred_free.free_func = free_func;
+    _deferred_frees.push_back(deferred_free);
+}
+
+void GlobeResourceManager::ReleaseRetiredResources() {
+    uint64_t completed_frame = _parent_app->SubmitManager()->CompletedFrameCount();
+    // Frame descriptor sets allocated from here on belong to the next frame.
+    _descriptor_allocator->BeginFrame(_parent_app->SubmitManager()->SubmittedFrameCount() + 1, completed_frame);
+    while (!_instance_allocations.empty() && _instance_allocations.front().retire_frame <= completed_frame) {
+        _instance_ring->Release(_instance_allocations.front().allocation_id);
+        _instance_allocations.pop_front();
+    }
+    // Entries are queued in frame order, so stop at the first one still in flight.
+    while (!_deferred_frees.empty() && _deferred_frees.front().retire_frame <= completed_frame) {
+        std::function<void()> free_func = _deferred_frees.front().free_func;
+        _deferred_frees.pop_front();
+        free_func();
+    }
+}
+
+void GlobeResourceManager::ReleaseAllDeferredResources() {
+    while (!_instance_allocations.empty()) {
+        _instance_ring->Release(_instance_allocations.front().allocation_id);
+        _instance_allocations.pop_front();
+    }
+    // Destroying one resource may free others, so keep going until nothing new gets queued.
+    while (!_deferred_frees.empty()) {
+        std::deque<GlobeDeferredFree> deferred_frees;
+        deferred_frees.swap(_deferred_frees);
+        for (auto& deferred_free : deferred_frees) {
+            deferred_free.free_func();
+        }
+    }
+}
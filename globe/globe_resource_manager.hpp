@@ -9,24 +9,83 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "vulkan/vulkan_core.h"
 #include "globe_basic_types.hpp"
+#include "globe_memory_allocator.hpp"
+#include "globe_block_compressor.hpp"
+#include "globe_pixel_convert.hpp"
+
+#define GLOBE_MEMORY_BLOCK_SIZE (64 * 1024 * 1024)
+#define GLOBE_ASYNC_LOAD_INVALID_HANDLE 0xFFFFFFFF
+#define GLOBE_STAGING_BUFFER_DEFAULT_SIZE (16 * 1024 * 1024)
+#define GLOBE_INSTANCE_RING_DEFAULT_SIZE (32 * 1024 * 1024)
 
 class GlobeApp;
 class GlobeTexture;
+class GlobeTextureAtlas;
 class GlobeFont;
 class GlobeShader;
 class GlobeModel;
+class GlobeThreadPool;
+class GlobeStagingRing;
+class GlobeUploadBatch;
+class GlobePipelineCache;
+class GlobeLayoutCache;
+class GlobeSamplerCache;
+class GlobeDescriptorAllocator;
+class GlobeAssetArchive;
+struct GlobeAsyncLoadRequest;
+
+struct GlobeDeferredFree {
+    uint64_t retire_frame;
+    std::function<void()> free_func;
+};
+
+struct GlobeInstanceAllocation {
+    uint64_t retire_frame;
+    uint64_t allocation_id;
+};
+
+struct GlobeHostCopyStats {
+    uint64_t resident_bytes;  // Host copies of uploaded data that loaded resources are keeping alive
+    uint64_t released_bytes;  // Host copies dropped once their data was uploaded, since creation
+};
+
+typedef uint32_t GlobeAsyncLoadHandle;
+
+enum GlobeAsyncLoadStatus {
+    GLOBE_ASYNC_LOAD_PENDING = 0,
+    GLOBE_ASYNC_LOAD_COMPLETE,
+    GLOBE_ASYNC_LOAD_FAILED,
+};
 
 class GlobeResourceManager {
    public:
-    GlobeResourceManager(const GlobeApp* app, const std::string& directory, uint32_t queue_family_index);
+    GlobeResourceManager(const GlobeApp* app, const std::string& directory, uint32_t graphics_queue_family_index,
+                         uint32_t transfer_queue_family_index);
     ~GlobeResourceManager();
 
-    GlobeTexture* LoadTexture(const std::string& texture_name, bool generate_mipmaps);
+    // Packed asset archives (see GlobeAssetArchive) are mounted on the resource directory, and every asset
+    // found in one is loaded from it instead of from the loose file.  "<resource directory>.globepak" is
+    // mounted automatically when it exists.  Archives mounted later take precedence.
+    bool MountAssetArchive(const std::string& archive_file);
+
+    // Textures loaded from standard image files can be block compressed on load, see GlobeTextureCompression.
+    GlobeTexture* LoadTexture(const std::string& texture_name, bool generate_mipmaps,
+                              GlobeUploadBatch* upload_batch = nullptr,
+                              GlobeTextureCompression compression = GLOBE_TEXTURE_COMPRESSION_NONE);
+    // Packs the images into the layers of one array texture, see GlobeTextureAtlas.  The atlas is a texture
+    // like any other and is freed with FreeTexture.
+    GlobeTextureAtlas* LoadTextureAtlas(const std::vector<std::string>& texture_names, bool generate_mipmaps,
+                                        GlobeUploadBatch* upload_batch = nullptr);
     GlobeTexture* CreateRenderTargetTexture(uint32_t width, uint32_t height, VkFormat vk_format);
     void FreeTexture(GlobeTexture* texture);
     void FreeAllTextures();
@@ -35,33 +94,139 @@ class GlobeResourceManager {
                                             VkPipelineStageFlags vk_starting_stage, VkImageLayout vk_starting_layout,
                                             VkPipelineStageFlags vk_target_stage, VkImageLayout vk_target_layout);
 
-    GlobeFont* LoadFontMap(const std::string& font_name, float font_size);
+    GlobeFont* LoadFontMap(const std::string& font_name, float font_size, GlobeUploadBatch* upload_batch = nullptr);
     void FreeFont(GlobeFont* font);
     void FreeAllFonts();
 
     GlobeShader* LoadShader(const std::string& shader_prefix);
+    // Whether any stage of the shader has been compiled, so optional shaders can be skipped without
+    // logging a failed load.
+    bool HasShader(const std::string& shader_prefix) const;
     void FreeShader(GlobeShader* shader);
     void FreeAllShaders();
 
-    GlobeModel* LoadModel(const std::string& sub_dir, const std::string& model_name, const GlobeComponentSizes& sizes);
+    GlobeModel* LoadModel(const std::string& sub_dir, const std::string& model_name, const GlobeComponentSizes& sizes,
+                          GlobeHostCopyPolicy host_copy_policy = GLOBE_HOST_COPY_DEFAULT,
+                          GlobeUploadBatch* upload_batch = nullptr);
     void FreeModel(GlobeModel* model);
     void FreeAllModels();
 
+    // Asynchronous loading.  File I/O and decoding run on a pool of worker threads, while the Vulkan
+    // objects are created in batches on whichever thread calls PollAsyncLoads or WaitAllAsyncLoads
+    // (normally the thread that owns the submit manager).  Returned handles stay valid for the life of
+    // the resource manager, and the loaded resource is owned by the resource manager like any other.
+    GlobeAsyncLoadHandle LoadTextureAsync(const std::string& texture_name, bool generate_mipmaps,
+                                          GlobeTextureCompression compression = GLOBE_TEXTURE_COMPRESSION_NONE);
+    GlobeAsyncLoadHandle LoadFontMapAsync(const std::string& font_name, float font_size);
+    GlobeAsyncLoadHandle LoadShaderAsync(const std::string& shader_prefix);
+    GlobeAsyncLoadHandle LoadModelAsync(const std::string& sub_dir, const std::string& model_name,
+                                        const GlobeComponentSizes& sizes,
+                                        GlobeHostCopyPolicy host_copy_policy = GLOBE_HOST_COPY_DEFAULT);
+    uint32_t PollAsyncLoads();
+    bool WaitAllAsyncLoads();
+    GlobeAsyncLoadStatus GetAsyncLoadStatus(GlobeAsyncLoadHandle handle) const;
+    GlobeTexture* GetAsyncTexture(GlobeAsyncLoadHandle handle) const;
+    GlobeFont* GetAsyncFont(GlobeAsyncLoadHandle handle) const;
+    GlobeShader* GetAsyncShader(GlobeAsyncLoadHandle handle) const;
+    GlobeModel* GetAsyncModel(GlobeAsyncLoadHandle handle) const;
+
     bool AllocateDeviceBufferMemory(VkBuffer vk_buffer, VkMemoryPropertyFlags vk_memory_properties,
-                                    VkDeviceMemory& vk_device_memory, VkDeviceSize& vk_allocated_size) const;
+                                    GlobeDeviceMemory& device_memory) const;
     bool AllocateDeviceImageMemory(VkImage vk_image, VkMemoryPropertyFlags vk_memory_properties,
-                                   VkDeviceMemory& vk_device_memory, VkDeviceSize& vk_allocated_size) const;
-    void FreeDeviceMemory(VkDeviceMemory& vk_device_memory) const;
+                                   GlobeDeviceMemory& device_memory) const;
+    void FreeDeviceMemory(GlobeDeviceMemory& device_memory) const;
+    bool FlushDeviceMemory(const GlobeDeviceMemory& device_memory, VkDeviceSize offset, VkDeviceSize size) const;
+    GlobeMemoryStats GetMemoryStats() const;
+    void LogMemoryStats() const;
+
+    // Low-memory mode.  With GLOBE_HOST_COPY_RELEASE, models and font strings drop their host copies of
+    // vertex and index data as soon as it has been uploaded, instead of keeping them for the life of the
+    // resource.  Texture content is always dropped after upload.  The default is GLOBE_HOST_COPY_KEEP, and
+    // model loads can override it.  HostCopyPolicy resolves GLOBE_HOST_COPY_DEFAULT to the current policy.
+    void SetHostCopyPolicy(GlobeHostCopyPolicy host_copy_policy);
+    GlobeHostCopyPolicy HostCopyPolicy(GlobeHostCopyPolicy host_copy_policy = GLOBE_HOST_COPY_DEFAULT) const;
+    // Host copy accounting, reported by LogMemoryStats.  Resources track what they keep or release after
+    // their upload, and untrack what they kept when they are destroyed.
+    void TrackHostCopy(uint64_t resident_bytes, uint64_t released_bytes) const;
+    void UntrackHostCopy(uint64_t resident_bytes) const;
+    GlobeHostCopyStats GetHostCopyStats() const;
+
+    // Model geometry memory.  GLOBE_GEOMETRY_MEMORY_DEFAULT picks host visible buffers on unified memory
+    // devices (where every memory heap is device local) and device local ones uploaded through the staging
+    // ring everywhere else.  Without a staging buffer, geometry is always host visible.
+    void SetGeometryMemoryPolicy(GlobeGeometryMemoryPolicy geometry_memory_policy);
+    GlobeGeometryMemoryPolicy GeometryMemoryPolicy() const { return _geometry_memory_policy; }
+    bool IsUnifiedMemory() const { return _is_unified_memory; }
+
+    // Upload batches.  Any number of texture loads (and other staged uploads) can record into one
+    // batch, which is then sent to the GPU with a single submit and tracked by a single fence.  The
+    // resources loaded into a batch must not be used until the batch has completed.  Freeing a batch
+    // waits for it if it has been submitted.
+    GlobeUploadBatch* BeginUploadBatch();
+    void FreeUploadBatch(GlobeUploadBatch* upload_batch);
+
+    // Staged uploads.  The data is copied into the persistently mapped staging ring and the copy
+    // is recorded into the batch.  If the ring fills up, older submitted batches are waited on and,
+    // if that isn't enough, the batch is flushed, so uploads larger than the ring stream through in chunks.
+    bool StageBufferUpload(GlobeUploadBatch* upload_batch, VkBuffer vk_buffer, VkDeviceSize vk_offset,
+                           const uint8_t* data, VkDeviceSize size);
+    // With a conversion, data is in the conversion's source layout while the copies and copy sizes describe
+    // the converted RGBA texels, which get written straight into the staging ring.
+    bool StageImageUpload(GlobeUploadBatch* upload_batch, VkImage vk_image, VkFormat vk_format,
+                          VkDeviceSize texel_block_size, const uint8_t* data,
+                          const std::vector<VkBufferImageCopy>& vk_copies, const std::vector<VkDeviceSize>& copy_sizes,
+                          GlobePixelConversion conversion = GLOBE_PIXEL_CONVERSION_NONE);
+    void ReleaseStagingAllocation(uint64_t allocation_id);
+
+    // Per-instance vertex data.  The data is copied into a persistently mapped vertex buffer ring (created on
+    // first use) and stays there until the frame being recorded has completed, so it is written once per frame
+    // and bound with the returned buffer and offset.  Only for the thread recording the frame.
+    bool WriteInstanceData(const uint8_t* data, VkDeviceSize size, VkBuffer& vk_buffer, VkDeviceSize& vk_offset);
 
     bool AllocateCommandBuffer(VkCommandBufferLevel level, VkCommandBuffer& command_buffer);
     bool FreeCommandBuffer(VkCommandBuffer& command_buffer);
+    bool AllocateTransferCommandBuffer(VkCommandBuffer& command_buffer);
+    bool FreeTransferCommandBuffer(VkCommandBuffer& command_buffer);
+    uint32_t GraphicsQueueFamilyIndex() const { return _graphics_queue_family_index; }
+    uint32_t TransferQueueFamilyIndex() const { return _transfer_queue_family_index; }
+    bool UsesTransferQueue() const { return _graphics_queue_family_index != _transfer_queue_family_index; }
 
     bool UseStagingBuffer() const { return _uses_staging_buffer; }
+    // Shared worker pool, created on first use, for asynchronous loads and CPU heavy processing.
+    GlobeThreadPool* GetThreadPool();
     VkFormatProperties GetVkFormatProperties(VkFormat format) const;
+    VkPipelineCache GetVkPipelineCache() const;
+    // Where generated caches are written, see GlobeApp::CacheDirectory.
+    const std::string& CacheDirectory() const;
+    // Graphics pipelines shared by identical create state, see GlobePipelineCache.
+    GlobePipelineCache* GetPipelineCache() const { return _pipeline_cache; }
+    // Descriptor set and pipeline layouts shared by every shader with the same interface, see GlobeLayoutCache.
+    GlobeLayoutCache* GetLayoutCache() const { return _layout_cache; }
+    // Samplers shared by every texture with the same sampler state, see GlobeSamplerCache.
+    GlobeSamplerCache* GetSamplerCache() const { return _sampler_cache; }
+    // Persistent and per-frame descriptor sets out of shared, growing pools, see GlobeDescriptorAllocator.
+    GlobeDescriptorAllocator* GetDescriptorAllocator() const { return _descriptor_allocator; }
+
+    // Deferred destruction.  Freed resources may still be referenced by frames in flight, so the Free*
+    // methods hand the actual destruction to DeferredFree, which runs it once every frame submitted
+    // so far (including the one currently being recorded) has completed on the GPU.
+    // ReleaseRetiredResources is called once per frame by GlobeApp::Draw.  ReleaseAllDeferredResources
+    // must only be called while the device is idle.
+    void DeferredFree(const std::function<void()>& free_func);
+    void ReleaseRetiredResources();
+    void ReleaseAllDeferredResources();
 
    private:
     bool SelectMemoryTypeUsingRequirements(VkMemoryRequirements requirements, VkFlags required_flags,
                                            uint32_t& type) const;
+    std::string AssetDirectory(const std::string& asset_type, const std::string& sub_dir = "") const;
+    bool IsStandardTextureFile(const std::string& texture_name, bool& is_standard_file) const;
+    GlobeAsyncLoadHandle QueueAsyncLoad(GlobeAsyncLoadRequest* request);
+    void LoadAsyncContent(GlobeAsyncLoadRequest* request);
+    void CreateAsyncResource(GlobeAsyncLoadRequest* request, GlobeUploadBatch* upload_batch);
+    void FreeAsyncRequests();
+    bool ReserveStagingSpace(GlobeUploadBatch* upload_batch, VkDeviceSize size, VkDeviceSize alignment,
+                             VkDeviceSize& offset, uint8_t*& mapped_data);
 
     const GlobeApp* _parent_app;
     VkInstance _vk_instance;
@@ -74,6 +239,32 @@ class GlobeResourceManager {
     std::vector<GlobeFont*> _fonts;
     std::vector<GlobeShader*> _shaders;
     std::vector<GlobeModel*> _models;
+    GlobeMemoryAllocator* _memory_allocator;
+    GlobeStagingRing* _staging_ring;
+    GlobeStagingRing* _instance_ring;
+    std::deque<GlobeInstanceAllocation> _instance_allocations;
+    GlobePipelineCache* _pipeline_cache;
+    GlobeLayoutCache* _layout_cache;
+    GlobeSamplerCache* _sampler_cache;
+    GlobeDescriptorAllocator* _descriptor_allocator;
+    std::vector<GlobeAssetArchive*> _asset_archives;
+    std::vector<GlobeUploadBatch*> _upload_batches;
+    uint32_t _graphics_queue_family_index;
+    uint32_t _transfer_queue_family_index;
     VkCommandPool _vk_cmd_pool;
+    VkCommandPool _vk_transfer_cmd_pool;
     std::vector<VkCommandBuffer> _targeted_vk_cmd_buffers;
+    GlobeThreadPool* _thread_pool;
+    std::once_flag _thread_pool_once;
+    std::mutex _async_mutex;
+    std::condition_variable _async_content_loaded;
+    std::vector<GlobeAsyncLoadRequest*> _async_requests;
+    std::vector<GlobeAsyncLoadRequest*> _async_loaded_requests;
+    uint32_t _async_pending_count;
+    std::deque<GlobeDeferredFree> _deferred_frees;
+    GlobeHostCopyPolicy _host_copy_policy;
+    GlobeGeometryMemoryPolicy _geometry_memory_policy;
+    bool _is_unified_memory;
+    mutable std::atomic<uint64_t> _host_copy_resident_bytes;
+    mutable std::atomic<uint64_t> _host_copy_released_bytes;
 };
@@ -0,0 +1,108 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_sampler_cache.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include "globe_logger.hpp"
+#include "globe_sampler_cache.hpp"
+
+template <typename T>
+static void AppendToKey(std::string& key, const T& value) {
+    key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+GlobeSamplerCache::GlobeSamplerCache(VkDevice vk_device) : _vk_device(vk_device), _num_hits(0), _num_misses(0) {}
+
+GlobeSamplerCache::~GlobeSamplerCache() {
+    for (auto& sampler : _samplers) {
+        vkDestroySampler(_vk_device, sampler.second.vk_sampler, nullptr);
+    }
+    _samplers.clear();
+    _sampler_keys.clear();
+}
+
+VkSamplerCreateInfo GlobeSamplerCache::DefaultCreateInfo(float max_lod) {
+    VkSamplerCreateInfo sampler_create_info = {};
+    sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_create_info.pNext = nullptr;
+    sampler_create_info.magFilter = VK_FILTER_LINEAR;
+    sampler_create_info.minFilter = VK_FILTER_LINEAR;
+    sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.mipLodBias = 0.0f;
+    sampler_create_info.anisotropyEnable = VK_FALSE;
+    sampler_create_info.maxAnisotropy = 1;
+    sampler_create_info.compareOp = VK_COMPARE_OP_NEVER;
+    sampler_create_info.minLod = 0.0f;
+    sampler_create_info.maxLod = max_lod;
+    sampler_create_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+    sampler_create_info.unnormalizedCoordinates = VK_FALSE;
+    return sampler_create_info;
+}
+
+VkSampler GlobeSamplerCache::AcquireSampler(const VkSamplerCreateInfo& create_info) {
+    std::string key;
+    AppendToKey(key, create_info.flags);
+    AppendToKey(key, create_info.magFilter);
+    AppendToKey(key, create_info.minFilter);
+    AppendToKey(key, create_info.mipmapMode);
+    AppendToKey(key, create_info.addressModeU);
+    AppendToKey(key, create_info.addressModeV);
+    AppendToKey(key, create_info.addressModeW);
+    AppendToKey(key, create_info.mipLodBias);
+    AppendToKey(key, create_info.anisotropyEnable);
+    AppendToKey(key, create_info.maxAnisotropy);
+    AppendToKey(key, create_info.compareEnable);
+    AppendToKey(key, create_info.compareOp);
+    AppendToKey(key, create_info.minLod);
+    AppendToKey(key, create_info.maxLod);
+    AppendToKey(key, create_info.borderColor);
+    AppendToKey(key, create_info.unnormalizedCoordinates);
+    auto sampler_iter = _samplers.find(key);
+    if (sampler_iter != _samplers.end()) {
+        _num_hits++;
+        sampler_iter->second.ref_count++;
+        return sampler_iter->second.vk_sampler;
+    }
+
+    _num_misses++;
+    VkSampler vk_sampler = VK_NULL_HANDLE;
+    if (VK_SUCCESS != vkCreateSampler(_vk_device, &create_info, nullptr, &vk_sampler)) {
+        GlobeLogger::getInstance().LogError("GlobeSamplerCache failed to create sampler");
+        return VK_NULL_HANDLE;
+    }
+    Entry entry = {vk_sampler, 1};
+    _samplers[key] = entry;
+    _sampler_keys[vk_sampler] = key;
+    return vk_sampler;
+}
+
+void GlobeSamplerCache::ReleaseSampler(VkSampler vk_sampler) {
+    auto key_iter = _sampler_keys.find(vk_sampler);
+    if (key_iter == _sampler_keys.end()) {
+        return;
+    }
+    auto sampler_iter = _samplers.find(key_iter->second);
+    if (0 == --sampler_iter->second.ref_count) {
+        vkDestroySampler(_vk_device, vk_sampler, nullptr);
+        _samplers.erase(sampler_iter);
+        _sampler_keys.erase(key_iter);
+    }
+}
+
+void GlobeSamplerCache::LogStats() const {
+    std::string perf_msg = "Sampler cache: ";
+    perf_msg += std::to_string(_samplers.size());
+    perf_msg += " samplers, ";
+    perf_msg += std::to_string(_num_hits);
+    perf_msg += " hits, ";
+    perf_msg += std::to_string(_num_misses);
+    perf_msg += " misses";
+    GlobeLogger::getInstance().LogPerf(perf_msg);
+}
@@ -0,0 +1,49 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_sampler_cache.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "vulkan/vulkan_core.h"
+
+// Hands out samplers keyed on the contents of their VkSamplerCreateInfo, so all the textures and render
+// targets that filter and address the same way share a single VkSampler instead of each one using up
+// part of the device's maxSamplerAllocationCount.  The handles also make the samplers usable as immutable
+// samplers in layouts from GlobeLayoutCache.
+//
+// Samplers are reference counted: every AcquireSampler has to be matched by a ReleaseSampler, and the
+// sampler is destroyed along with its last reference.  pNext chains are not looked at.
+class GlobeSamplerCache {
+   public:
+    GlobeSamplerCache(VkDevice vk_device);
+    ~GlobeSamplerCache();
+
+    // Trilinear filtering with clamp to edge addressing, which is how textures are sampled by default.
+    static VkSamplerCreateInfo DefaultCreateInfo(float max_lod);
+
+    VkSampler AcquireSampler(const VkSamplerCreateInfo& create_info);
+    void ReleaseSampler(VkSampler vk_sampler);
+
+    uint32_t NumSamplers() const { return static_cast<uint32_t>(_samplers.size()); }
+    void LogStats() const;
+
+   private:
+    struct Entry {
+        VkSampler vk_sampler;
+        uint32_t ref_count;
+    };
+
+    VkDevice _vk_device;
+    std::unordered_map<std::string, Entry> _samplers;
+    std::unordered_map<VkSampler, std::string> _sampler_keys;
+    uint64_t _num_hits;
+    uint64_t _num_misses;
+};
@@ -7,10 +7,9 @@
 // Author(s):               Mark Young <marky@lunarg.com>
 //
 
+#include <algorithm>
 #include <cstring>
-#include <fstream>
 #include <string>
-#include <sstream>
 
 #include "globe_logger.hpp"
 #include "globe_event.hpp"
@@ -30,7 +29,13 @@ static const char main_shader_func_name[] = "main";
 GlobeShader* GlobeShader::LoadFromFile(VkDevice vk_device, const std::string& shader_name,
                                        const std::string& directory) {
     GlobeShaderStageInitData shader_data[GLOBE_SHADER_STAGE_ID_NUM_STAGES] = {{}, {}, {}, {}, {}, {}};
+    LoadFileContent(shader_name, directory, shader_data);
+    return new GlobeShader(vk_device, shader_name, shader_data);
+}
 
+bool GlobeShader::LoadFileContent(const std::string& shader_name, const std::string& directory,
+                                  GlobeShaderStageInitData shader_data[GLOBE_SHADER_STAGE_ID_NUM_STAGES]) {
+    bool found_stage = false;
     for (uint32_t stage = 0; stage < GLOBE_SHADER_STAGE_ID_NUM_STAGES; ++stage) {
         std::string full_shader_name = directory;
         full_shader_name += directory_symbol;
@@ -57,26 +62,14 @@ GlobeShader* GlobeShader::LoadFromFile(VkDevice vk_device, const std::string& sh
             default:
                 continue;
         }
-        std::ifstream* infile = nullptr;
-        std::string line;
-        std::stringstream strstream;
-        size_t shader_spv_size;
-        infile = new std::ifstream(full_shader_name.c_str(), std::ifstream::in | std::ios::binary);
-        if (nullptr == infile || infile->fail()) {
+        // SPIR-V goes to vkCreateShaderModule straight out of the mapping, which starts page aligned.
+        if (!shader_data[stage].spirv_file.Open(full_shader_name)) {
             continue;
         }
-        strstream << infile->rdbuf();
-        infile->close();
-        delete infile;
-
-        // Read the file contents
-        shader_spv_size = strstream.str().size();
-        shader_data[stage].spirv_content.resize((shader_spv_size / sizeof(uint32_t)));
-        memcpy(shader_data[stage].spirv_content.data(), strstream.str().c_str(), shader_spv_size);
         shader_data[stage].valid = true;
+        found_stage = true;
     }
-
-    return new GlobeShader(vk_device, shader_name, shader_data);
+    return found_stage;
 }
 
 GlobeShader::GlobeShader(VkDevice vk_device, const std::string& shader_name,
@@ -91,8 +84,10 @@ GlobeShader::GlobeShader(VkDevice vk_device, const std::string& shader_name,
             VkShaderModuleCreateInfo shader_module_create_info;
             shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
             shader_module_create_info.pNext = nullptr;
-            shader_module_create_info.codeSize = shader_data[stage].spirv_content.size() * sizeof(uint32_t);
-            shader_module_create_info.pCode = shader_data[stage].spirv_content.data();
+            const uint32_t* spirv_words = reinterpret_cast<const uint32_t*>(shader_data[stage].spirv_file.Data());
+            size_t spirv_word_count = shader_data[stage].spirv_file.Size() / sizeof(uint32_t);
+            shader_module_create_info.codeSize = spirv_word_count * sizeof(uint32_t);
+            shader_module_create_info.pCode = spirv_words;
             shader_module_create_info.flags = 0;
             VkResult vk_result = vkCreateShaderModule(vk_device, &shader_module_create_info, NULL,
                                                       &_shader_data[stage].vk_shader_module);
@@ -107,6 +102,17 @@ GlobeShader::GlobeShader(VkDevice vk_device, const std::string& shader_name,
             } else {
                 num_loaded_shaders++;
                 _shader_data[stage].valid = true;
+                _shader_data[stage].content_hash = 14695981039346656037ULL;
+                for (size_t word = 0; word < spirv_word_count; ++word) {
+                    _shader_data[stage].content_hash ^= spirv_words[word];
+                    _shader_data[stage].content_hash *= 1099511628211ULL;
+                }
+                if (!GlobeSpirvReflection::Reflect(spirv_words, spirv_word_count, _shader_data[stage].reflection)) {
+                    std::string warning_msg = "GlobeShader failed to reflect a stage of shader ";
+                    warning_msg += shader_name;
+                    warning_msg += ", its layouts will be incomplete";
+                    logger.LogWarning(warning_msg);
+                }
             }
         } else {
             _shader_data[stage].valid = false;
@@ -145,4 +151,90 @@ bool GlobeShader::GetPipelineShaderStages(std::vector<VkPipelineShaderStageCreat
         }
     }
     return true;
-}
\ No newline at end of file
+}
+
+uint64_t GlobeShader::GetStageContentHash(VkShaderStageFlagBits vk_shader_stage) const {
+    for (uint32_t stage = 0; stage < GLOBE_SHADER_STAGE_ID_NUM_STAGES; ++stage) {
+        if (_shader_data[stage].valid && _shader_data[stage].vk_shader_flag == vk_shader_stage) {
+            return _shader_data[stage].content_hash;
+        }
+    }
+    return 0;
+}
+
+bool GlobeShader::GetDescriptorSetLayoutBindings(
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>>& set_bindings) const {
+    if (!_initialized) {
+        return false;
+    }
+    set_bindings.clear();
+    for (uint32_t stage = 0; stage < GLOBE_SHADER_STAGE_ID_NUM_STAGES; ++stage) {
+        if (!_shader_data[stage].valid || !_shader_data[stage].reflection.valid) {
+            continue;
+        }
+        for (const auto& reflected : _shader_data[stage].reflection.descriptor_bindings) {
+            if (set_bindings.size() <= reflected.set) {
+                set_bindings.resize(reflected.set + 1);
+            }
+            std::vector<VkDescriptorSetLayoutBinding>& bindings = set_bindings[reflected.set];
+            bool found = false;
+            for (auto& binding : bindings) {
+                if (binding.binding == reflected.binding) {
+                    if (binding.descriptorType != reflected.vk_descriptor_type) {
+                        std::string error_msg = "GlobeShader ";
+                        error_msg += _shader_name;
+                        error_msg += " uses different descriptor types for binding ";
+                        error_msg += std::to_string(reflected.binding);
+                        error_msg += " of set ";
+                        error_msg += std::to_string(reflected.set);
+                        GlobeLogger::getInstance().LogError(error_msg);
+                        return false;
+                    }
+                    binding.descriptorCount = std::max(binding.descriptorCount, reflected.descriptor_count);
+                    binding.stageFlags |= _shader_data[stage].vk_shader_flag;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                VkDescriptorSetLayoutBinding binding = {};
+                binding.binding = reflected.binding;
+                binding.descriptorType = reflected.vk_descriptor_type;
+                binding.descriptorCount = reflected.descriptor_count;
+                binding.stageFlags = _shader_data[stage].vk_shader_flag;
+                binding.pImmutableSamplers = nullptr;
+                bindings.push_back(binding);
+            }
+        }
+    }
+    for (auto& bindings : set_bindings) {
+        std::sort(bindings.begin(), bindings.end(),
+                  [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+                      return a.binding < b.binding;
+                  });
+    }
+    return true;
+}
+
+bool GlobeShader::GetPushConstantRange(VkPushConstantRange& push_constant_range) const {
+    push_constant_range = {};
+    if (!_initialized) {
+        return false;
+    }
+    for (uint32_t stage = 0; stage < GLOBE_SHADER_STAGE_ID_NUM_STAGES; ++stage) {
+        if (_shader_data[stage].valid && _shader_data[stage].reflection.valid &&
+            _shader_data[stage].reflection.push_constant_size > 0) {
+            push_constant_range.stageFlags |= _shader_data[stage].vk_shader_flag;
+            push_constant_range.size =
+                std::max(push_constant_range.size, _shader_data[stage].reflection.push_constant_size);
+        }
+    }
+    return push_constant_range.size > 0;
+}
+
+const std::vector<GlobeSpirvVertexInput>& GlobeShader::GetVertexInputs() const {
+    if (_initialized && _shader_data[GLOBE_SHADER_STAGE_ID_VERTEX].valid) {
+        return _shader_data[GLOBE_SHADER_STAGE_ID_VERTEX].reflection.vertex_inputs;
+    }
+    return _no_vertex_inputs;
+}
@@ -13,6 +13,8 @@
 #include <vector>
 
 #include "vulkan/vulkan_core.h"
+#include "globe_spirv_reflection.hpp"
+#include "globe_file_view.hpp"
 
 enum GlobeShaderStageId {
     GLOBE_SHADER_STAGE_ID_VERTEX = 0,
@@ -26,18 +28,23 @@ enum GlobeShaderStageId {
 
 struct GlobeShaderStageInitData {
     bool valid;
-    std::vector<uint32_t> spirv_content;
+    GlobeFileView spirv_file;  // SPIR-V words, used in place
 };
 
 struct GlobeShaderStage {
     bool valid;
     VkShaderStageFlagBits vk_shader_flag;
     VkShaderModule vk_shader_module;
+    uint64_t content_hash;  // FNV-1a of the SPIR-V words
+    GlobeSpirvStageReflection reflection;
 };
 
 class GlobeShader {
    public:
     static GlobeShader* LoadFromFile(VkDevice vk_device, const std::string& shader_name, const std::string& directory);
+    // Reads the SPIR-V for every stage found on disk without touching Vulkan, so it may run on a worker thread.
+    static bool LoadFileContent(const std::string& shader_name, const std::string& directory,
+                                GlobeShaderStageInitData shader_data[GLOBE_SHADER_STAGE_ID_NUM_STAGES]);
 
     GlobeShader(VkDevice vk_device, const std::string& shader_name,
                 const GlobeShaderStageInitData shader_data[GLOBE_SHADER_STAGE_ID_NUM_STAGES]);
@@ -45,10 +52,19 @@ class GlobeShader {
 
     bool IsValid() { return _initialized; }
     bool GetPipelineShaderStages(std::vector<VkPipelineShaderStageCreateInfo>& pipeline_stages) const;
+    uint64_t GetStageContentHash(VkShaderStageFlagBits vk_shader_stage) const;
+
+    // Interface reflected out of the SPIR-V of every stage.  Bindings used by more than one stage are
+    // merged into one with the stage flags combined, and all push constants end up in a single range
+    // visible to every stage that declares a push constant block.  set_bindings is indexed by set.
+    bool GetDescriptorSetLayoutBindings(std::vector<std::vector<VkDescriptorSetLayoutBinding>>& set_bindings) const;
+    bool GetPushConstantRange(VkPushConstantRange& push_constant_range) const;
+    const std::vector<GlobeSpirvVertexInput>& GetVertexInputs() const;
 
    private:
     bool _initialized;
     VkDevice _vk_device;
     std::string _shader_name;
     GlobeShaderStage _shader_data[GLOBE_SHADER_STAGE_ID_NUM_STAGES];
+    std::vector<GlobeSpirvVertexInput> _no_vertex_inputs;
 };
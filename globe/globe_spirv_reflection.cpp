@@ -0,0 +1,464 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_spirv_reflection.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include <algorithm>
+#include <string>
+
+#include "globe_logger.hpp"
+#include "globe_spirv_reflection.hpp"
+
+// The handful of SPIR-V enumerant values the reflection cares about, straight out of the
+// SPIR-V specification so there's no need for spirv.hpp.
+static const uint32_t spirv_magic_number = 0x07230203;
+static const uint32_t spirv_header_word_count = 5;
+// Types nest far less than this in any real shader, a longer chain means the module references itself.
+static const uint32_t spirv_max_type_depth = 32;
+
+enum SpirvOpcode {
+    SPIRV_OP_ENTRY_POINT = 15,
+    SPIRV_OP_TYPE_INT = 21,
+    SPIRV_OP_TYPE_FLOAT = 22,
+    SPIRV_OP_TYPE_VECTOR = 23,
+    SPIRV_OP_TYPE_MATRIX = 24,
+    SPIRV_OP_TYPE_IMAGE = 25,
+    SPIRV_OP_TYPE_SAMPLER = 26,
+    SPIRV_OP_TYPE_SAMPLED_IMAGE = 27,
+    SPIRV_OP_TYPE_ARRAY = 28,
+    SPIRV_OP_TYPE_RUNTIME_ARRAY = 29,
+    SPIRV_OP_TYPE_STRUCT = 30,
+    SPIRV_OP_TYPE_POINTER = 32,
+    SPIRV_OP_CONSTANT = 43,
+    SPIRV_OP_SPEC_CONSTANT = 50,
+    SPIRV_OP_FUNCTION = 54,
+    SPIRV_OP_VARIABLE = 59,
+    SPIRV_OP_DECORATE = 71,
+    SPIRV_OP_MEMBER_DECORATE = 72,
+};
+
+enum SpirvDecoration {
+    SPIRV_DECORATION_BLOCK = 2,
+    SPIRV_DECORATION_BUFFER_BLOCK = 3,
+    SPIRV_DECORATION_ARRAY_STRIDE = 6,
+    SPIRV_DECORATION_MATRIX_STRIDE = 7,
+    SPIRV_DECORATION_BUILT_IN = 11,
+    SPIRV_DECORATION_LOCATION = 30,
+    SPIRV_DECORATION_BINDING = 33,
+    SPIRV_DECORATION_DESCRIPTOR_SET = 34,
+    SPIRV_DECORATION_OFFSET = 35,
+};
+
+enum SpirvStorageClass {
+    SPIRV_STORAGE_CLASS_UNIFORM_CONSTANT = 0,
+    SPIRV_STORAGE_CLASS_INPUT = 1,
+    SPIRV_STORAGE_CLASS_UNIFORM = 2,
+    SPIRV_STORAGE_CLASS_PUSH_CONSTANT = 9,
+    SPIRV_STORAGE_CLASS_STORAGE_BUFFER = 12,
+};
+
+enum SpirvImageDim {
+    SPIRV_DIM_BUFFER = 5,
+    SPIRV_DIM_SUBPASS_DATA = 6,
+};
+
+struct SpirvMember {
+    uint32_t offset;
+    uint32_t matrix_stride;
+};
+
+// Everything remembered about a single result id.  Operands are the instruction words following the
+// result id (for OpConstant and OpVariable the result type is kept separately).
+struct SpirvId {
+    uint32_t opcode;
+    uint32_t result_type;
+    std::vector<uint32_t> operands;
+    bool has_set;
+    bool has_binding;
+    bool has_location;
+    bool is_block;
+    bool is_buffer_block;
+    bool is_built_in;
+    uint32_t set;
+    uint32_t binding;
+    uint32_t location;
+    uint32_t array_stride;
+    std::vector<SpirvMember> members;
+};
+
+// Ids read out of operands haven't been checked against the bound yet.  Anything out of range comes back
+// as an empty id, which none of the type queries below match.
+static const SpirvId& SpirvLookupId(const std::vector<SpirvId>& ids, uint32_t id) {
+    static const SpirvId invalid_id = {};
+    return id < ids.size() ? ids[id] : invalid_id;
+}
+
+// Instructions can be cut short, missing operands read as 0.
+static uint32_t SpirvOperand(const SpirvId& id, uint32_t index) {
+    return index < id.operands.size() ? id.operands[index] : 0;
+}
+
+static uint32_t SpirvComputeTypeSize(const std::vector<SpirvId>& ids, uint32_t type_id,
+                                     std::vector<uint32_t>& type_sizes, uint32_t depth);
+
+// Sizes are remembered in type_sizes (UINT32_MAX until known), so types shared by many members of a
+// malformed module are only walked once.
+static uint32_t SpirvTypeSize(const std::vector<SpirvId>& ids, uint32_t type_id, std::vector<uint32_t>& type_sizes,
+                              uint32_t depth = 0) {
+    if (depth > spirv_max_type_depth || type_id >= type_sizes.size()) {
+        return 0;
+    }
+    if (UINT32_MAX == type_sizes[type_id]) {
+        type_sizes[type_id] = SpirvComputeTypeSize(ids, type_id, type_sizes, depth);
+    }
+    return type_sizes[type_id];
+}
+
+static uint32_t SpirvComputeTypeSize(const std::vector<SpirvId>& ids, uint32_t type_id,
+                                     std::vector<uint32_t>& type_sizes, uint32_t depth) {
+    const SpirvId& type = SpirvLookupId(ids, type_id);
+    switch (type.opcode) {
+        case SPIRV_OP_TYPE_INT:
+        case SPIRV_OP_TYPE_FLOAT:
+            return SpirvOperand(type, 0) / 8;
+        case SPIRV_OP_TYPE_VECTOR:
+        case SPIRV_OP_TYPE_MATRIX:
+            return SpirvTypeSize(ids, SpirvOperand(type, 0), type_sizes, depth + 1) * SpirvOperand(type, 1);
+        case SPIRV_OP_TYPE_ARRAY: {
+            const SpirvId& length = SpirvLookupId(ids, SpirvOperand(type, 1));
+            uint32_t element_count = length.operands.empty() ? 1 : length.operands[0];
+            uint32_t element_size = type.array_stride;
+            if (0 == element_size) {
+                element_size = SpirvTypeSize(ids, SpirvOperand(type, 0), type_sizes, depth + 1);
+            }
+            return element_size * element_count;
+        }
+        case SPIRV_OP_TYPE_STRUCT: {
+            uint32_t size = 0;
+            for (uint32_t member = 0; member < type.operands.size(); ++member) {
+                uint32_t member_type_id = type.operands[member];
+                uint32_t member_offset = 0;
+                uint32_t member_size = SpirvTypeSize(ids, member_type_id, type_sizes, depth + 1);
+                if (member < type.members.size()) {
+                    const SpirvId& member_type = SpirvLookupId(ids, member_type_id);
+                    member_offset = type.members[member].offset;
+                    // Explicit layouts may pad the columns of a matrix (std140 mat3 for example)
+                    if (SPIRV_OP_TYPE_MATRIX == member_type.opcode && 0 != type.members[member].matrix_stride) {
+                        member_size = type.members[member].matrix_stride * SpirvOperand(member_type, 1);
+                    }
+                }
+                size = std::max(size, member_offset + member_size);
+            }
+            return size;
+        }
+        default:
+            return 0;
+    }
+}
+
+static VkFormat SpirvVertexInputFormat(const std::vector<SpirvId>& ids, uint32_t type_id) {
+    const SpirvId* component = &SpirvLookupId(ids, type_id);
+    uint32_t component_count = 1;
+    if (SPIRV_OP_TYPE_VECTOR == component->opcode) {
+        component_count = SpirvOperand(*component, 1);
+        component = &SpirvLookupId(ids, SpirvOperand(*component, 0));
+    }
+    static const VkFormat float32_formats[4] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT,
+                                                VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+    static const VkFormat float64_formats[4] = {VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT,
+                                                VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT};
+    static const VkFormat sint32_formats[4] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT,
+                                               VK_FORMAT_R32G32B32A32_SINT};
+    static const VkFormat uint32_formats[4] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT,
+                                               VK_FORMAT_R32G32B32A32_UINT};
+    if (component_count < 1 || component_count > 4) {
+        return VK_FORMAT_UNDEFINED;
+    }
+    if (SPIRV_OP_TYPE_FLOAT == component->opcode) {
+        if (64 == SpirvOperand(*component, 0)) {
+            return float64_formats[component_count - 1];
+        }
+        return float32_formats[component_count - 1];
+    } else if (SPIRV_OP_TYPE_INT == component->opcode) {
+        if (0 != SpirvOperand(*component, 1)) {
+            return sint32_formats[component_count - 1];
+        }
+        return uint32_formats[component_count - 1];
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+static bool SpirvDescriptorType(const std::vector<SpirvId>& ids, uint32_t storage_class, uint32_t type_id,
+                                VkDescriptorType& vk_descriptor_type, uint32_t& descriptor_count) {
+    descriptor_count = 1;
+    const SpirvId* type = &SpirvLookupId(ids, type_id);
+    uint32_t depth = 0;
+    while (SPIRV_OP_TYPE_ARRAY == type->opcode || SPIRV_OP_TYPE_RUNTIME_ARRAY == type->opcode) {
+        if (++depth > spirv_max_type_depth) {
+            return false;
+        }
+        // Runtime sized arrays are given a single descriptor, the caller knows better how many it needs.
+        if (SPIRV_OP_TYPE_ARRAY == type->opcode) {
+            const SpirvId& length = SpirvLookupId(ids, SpirvOperand(*type, 1));
+            descriptor_count *= length.operands.empty() ? 1 : length.operands[0];
+        }
+        type = &SpirvLookupId(ids, SpirvOperand(*type, 0));
+    }
+    switch (storage_class) {
+        case SPIRV_STORAGE_CLASS_UNIFORM_CONSTANT:
+            if (SPIRV_OP_TYPE_SAMPLER == type->opcode) {
+                vk_descriptor_type = VK_DESCRIPTOR_TYPE_SAMPLER;
+            } else if (SPIRV_OP_TYPE_SAMPLED_IMAGE == type->opcode) {
+                vk_descriptor_type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            } else if (SPIRV_OP_TYPE_IMAGE == type->opcode) {
+                // Operands are: sampled type, dim, depth, arrayed, ms, sampled, format
+                bool storage = (2 == SpirvOperand(*type, 5));
+                if (SPIRV_DIM_BUFFER == SpirvOperand(*type, 1)) {
+                    vk_descriptor_type =
+                        storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                } else if (SPIRV_DIM_SUBPASS_DATA == SpirvOperand(*type, 1)) {
+                    vk_descriptor_type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                } else {
+                    vk_descriptor_type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                }
+            } else {
+                return false;
+            }
+            return true;
+        case SPIRV_STORAGE_CLASS_UNIFORM:
+            vk_descriptor_type =
+                type->is_buffer_block ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            return true;
+        case SPIRV_STORAGE_CLASS_STORAGE_BUFFER:
+            vk_descriptor_type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool GlobeSpirvReflection::Reflect(const uint32_t* spirv_words, size_t word_count,
+                                   GlobeSpirvStageReflection& reflection) {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    reflection.valid = false;
+    reflection.vk_shader_stage = VK_SHADER_STAGE_ALL;
+    reflection.descriptor_bindings.clear();
+    reflection.push_constant_size = 0;
+    reflection.vertex_inputs.clear();
+
+    if (nullptr == spirv_words || word_count < spirv_header_word_count || spirv_magic_number != spirv_words[0]) {
+        logger.LogError("GlobeSpirvReflection::Reflect given content that isn't a SPIR-V module");
+        return false;
+    }
+
+    // Every result id is below the bound in the header, so the ids can live in a flat array.  Each id needs an
+    // instruction of its own, so a bound past the module's size can only come from a corrupt header.
+    uint32_t id_bound = spirv_words[3];
+    if (id_bound > word_count) {
+        logger.LogError("GlobeSpirvReflection::Reflect found an id bound larger than the module");
+        return false;
+    }
+    std::vector<SpirvId> ids(id_bound, SpirvId{});
+    std::vector<uint32_t> variables;
+    uint32_t execution_model = UINT32_MAX;
+
+    size_t word = spirv_header_word_count;
+    while (word < word_count) {
+        uint32_t opcode = spirv_words[word] & 0xFFFF;
+        uint32_t insn_word_count = spirv_words[word] >> 16;
+        if (0 == insn_word_count || word + insn_word_count > word_count) {
+            logger.LogError("GlobeSpirvReflection::Reflect found a malformed instruction");
+            return false;
+        }
+        const uint32_t* insn = &spirv_words[word];
+        word += insn_word_count;
+
+        // Function bodies follow all the declarations the reflection needs.
+        if (SPIRV_OP_FUNCTION == opcode) {
+            break;
+        }
+        switch (opcode) {
+            case SPIRV_OP_ENTRY_POINT:
+                if (UINT32_MAX == execution_model && insn_word_count > 1) {
+                    execution_model = insn[1];
+                }
+                break;
+            case SPIRV_OP_TYPE_INT:
+            case SPIRV_OP_TYPE_FLOAT:
+            case SPIRV_OP_TYPE_VECTOR:
+            case SPIRV_OP_TYPE_MATRIX:
+            case SPIRV_OP_TYPE_IMAGE:
+            case SPIRV_OP_TYPE_SAMPLER:
+            case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+            case SPIRV_OP_TYPE_ARRAY:
+            case SPIRV_OP_TYPE_RUNTIME_ARRAY:
+            case SPIRV_OP_TYPE_STRUCT:
+            case SPIRV_OP_TYPE_POINTER:
+                if (insn_word_count > 1 && insn[1] < id_bound) {
+                    ids[insn[1]].opcode = opcode;
+                    ids[insn[1]].operands.assign(insn + 2, insn + insn_word_count);
+                }
+                break;
+            case SPIRV_OP_CONSTANT:
+            case SPIRV_OP_SPEC_CONSTANT:
+            case SPIRV_OP_VARIABLE:
+                if (insn_word_count > 3 && insn[2] < id_bound) {
+                    ids[insn[2]].opcode = opcode;
+                    ids[insn[2]].result_type = insn[1];
+                    ids[insn[2]].operands.assign(insn + 3, insn + insn_word_count);
+                    if (SPIRV_OP_VARIABLE == opcode) {
+                        variables.push_back(insn[2]);
+                    }
+                }
+                break;
+            case SPIRV_OP_DECORATE:
+                if (insn_word_count > 2 && insn[1] < id_bound) {
+                    SpirvId& target = ids[insn[1]];
+                    uint32_t literal = insn_word_count > 3 ? insn[3] : 0;
+                    switch (insn[2]) {
+                        case SPIRV_DECORATION_BLOCK:
+                            target.is_block = true;
+                            break;
+                        case SPIRV_DECORATION_BUFFER_BLOCK:
+                            target.is_buffer_block = true;
+                            break;
+                        case SPIRV_DECORATION_ARRAY_STRIDE:
+                            target.array_stride = literal;
+                            break;
+                        case SPIRV_DECORATION_BUILT_IN:
+                            target.is_built_in = true;
+                            break;
+                        case SPIRV_DECORATION_LOCATION:
+                            target.has_location = true;
+                            target.location = literal;
+                            break;
+                        case SPIRV_DECORATION_BINDING:
+                            target.has_binding = true;
+                            target.binding = literal;
+                            break;
+                        case SPIRV_DECORATION_DESCRIPTOR_SET:
+                            target.has_set = true;
+                            target.set = literal;
+                            break;
+                        default:
+                            break;
+                    }
+                }
+                break;
+            case SPIRV_OP_MEMBER_DECORATE:
+                if (insn_word_count > 4 && insn[1] < id_bound) {
+                    SpirvId& target = ids[insn[1]];
+                    uint32_t member = insn[2];
+                    // A struct can't have more members than the module has words.
+                    if (member >= word_count) {
+                        break;
+                    }
+                    if (SPIRV_DECORATION_OFFSET == insn[3] || SPIRV_DECORATION_MATRIX_STRIDE == insn[3]) {
+                        if (target.members.size() <= member) {
+                            target.members.resize(member + 1, SpirvMember{});
+                        }
+                        if (SPIRV_DECORATION_OFFSET == insn[3]) {
+                            target.members[member].offset = insn[4];
+                        } else {
+                            target.members[member].matrix_stride = insn[4];
+                        }
+                    } else if (SPIRV_DECORATION_BUILT_IN == insn[3]) {
+                        // gl_PerVertex and friends
+                        target.is_built_in = true;
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    switch (execution_model) {
+        case 0:
+            reflection.vk_shader_stage = VK_SHADER_STAGE_VERTEX_BIT;
+            break;
+        case 1:
+            reflection.vk_shader_stage = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+            break;
+        case 2:
+            reflection.vk_shader_stage = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+            break;
+        case 3:
+            reflection.vk_shader_stage = VK_SHADER_STAGE_GEOMETRY_BIT;
+            break;
+        case 4:
+            reflection.vk_shader_stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+            break;
+        case 5:
+            reflection.vk_shader_stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            break;
+        default:
+            logger.LogError("GlobeSpirvReflection::Reflect found no supported entry point");
+            return false;
+    }
+
+    std::vector<uint32_t> type_sizes(id_bound, UINT32_MAX);
+    for (uint32_t variable_id : variables) {
+        const SpirvId& variable = ids[variable_id];
+        const SpirvId& pointer = SpirvLookupId(ids, variable.result_type);
+        if (SPIRV_OP_TYPE_POINTER != pointer.opcode || pointer.operands.size() < 2 || variable.operands.empty()) {
+            continue;
+        }
+        uint32_t storage_class = variable.operands[0];
+        uint32_t type_id = pointer.operands[1];
+        switch (storage_class) {
+            case SPIRV_STORAGE_CLASS_UNIFORM_CONSTANT:
+            case SPIRV_STORAGE_CLASS_UNIFORM:
+            case SPIRV_STORAGE_CLASS_STORAGE_BUFFER: {
+                GlobeSpirvDescriptorBinding binding = {};
+                if (!variable.has_binding ||
+                    !SpirvDescriptorType(ids, storage_class, type_id, binding.vk_descriptor_type,
+                                         binding.descriptor_count)) {
+                    break;
+                }
+                binding.set = variable.has_set ? variable.set : 0;
+                binding.binding = variable.binding;
+                reflection.descriptor_bindings.push_back(binding);
+                break;
+            }
+            case SPIRV_STORAGE_CLASS_PUSH_CONSTANT:
+                reflection.push_constant_size =
+                    std::max(reflection.push_constant_size, SpirvTypeSize(ids, type_id, type_sizes));
+                break;
+            case SPIRV_STORAGE_CLASS_INPUT:
+                if (VK_SHADER_STAGE_VERTEX_BIT == reflection.vk_shader_stage && variable.has_location &&
+                    !variable.is_built_in && !SpirvLookupId(ids, type_id).is_built_in) {
+                    const SpirvId& input_type = SpirvLookupId(ids, type_id);
+                    // Matrices take up one location per column
+                    uint32_t location_count = 1;
+                    uint32_t column_type_id = type_id;
+                    if (SPIRV_OP_TYPE_MATRIX == input_type.opcode) {
+                        column_type_id = SpirvOperand(input_type, 0);
+                        location_count = SpirvOperand(input_type, 1);
+                    }
+                    for (uint32_t location = 0; location < location_count; ++location) {
+                        GlobeSpirvVertexInput vertex_input = {};
+                        vertex_input.location = variable.location + location;
+                        vertex_input.vk_format = SpirvVertexInputFormat(ids, column_type_id);
+                        reflection.vertex_inputs.push_back(vertex_input);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    std::sort(reflection.descriptor_bindings.begin(), reflection.descriptor_bindings.end(),
+              [](const GlobeSpirvDescriptorBinding& a, const GlobeSpirvDescriptorBinding& b) {
+                  return (a.set < b.set) || (a.set == b.set && a.binding < b.binding);
+              });
+    std::sort(reflection.vertex_inputs.begin(), reflection.vertex_inputs.end(),
+              [](const GlobeSpirvVertexInput& a, const GlobeSpirvVertexInput& b) { return a.location < b.location; });
+    reflection.valid = true;
+    return true;
+}
@@ -0,0 +1,46 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_spirv_reflection.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <vector>
+
+#include "vulkan/vulkan_core.h"
+
+struct GlobeSpirvDescriptorBinding {
+    uint32_t set;
+    uint32_t binding;
+    VkDescriptorType vk_descriptor_type;
+    uint32_t descriptor_count;
+};
+
+struct GlobeSpirvVertexInput {
+    uint32_t location;
+    VkFormat vk_format;
+};
+
+struct GlobeSpirvStageReflection {
+    bool valid;
+    VkShaderStageFlagBits vk_shader_stage;
+    std::vector<GlobeSpirvDescriptorBinding> descriptor_bindings;
+    uint32_t push_constant_size;  // 0 when the stage has no push constant block
+    std::vector<GlobeSpirvVertexInput> vertex_inputs;
+};
+
+// Walks the instructions of a SPIR-V module directly and pulls out the interface the stage
+// needs from the pipeline: descriptor bindings (with their types and array sizes), the size of
+// the push constant block and, for vertex shaders, the user input locations and formats.
+//
+// Only what glslang and friends emit for graphics and compute shaders is understood.  Uniform
+// buffers are always reported as VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, the module has no way of
+// saying it wants a dynamic one.
+class GlobeSpirvReflection {
+   public:
+    static bool Reflect(const uint32_t* spirv_words, size_t word_count, GlobeSpirvStageReflection& reflection);
+};
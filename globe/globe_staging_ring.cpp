@@ -0,0 +1,111 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_staging_ring.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include "globe_logger.hpp"
+#include "globe_resource_manager.hpp"
+#include "globe_staging_ring.hpp"
+
+GlobeStagingRing::GlobeStagingRing(GlobeResourceManager* resource_manager, VkDevice vk_device, VkDeviceSize size,
+                                   VkBufferUsageFlags vk_usage)
+    : _globe_resource_mgr(resource_manager),
+      _vk_device(vk_device),
+      _size(size),
+      _head(0),
+      _tail(0),
+      _first_allocation_id(0) {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    _staging_buffer = {};
+
+    VkBufferCreateInfo buffer_create_info = {};
+    buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_create_info.pNext = nullptr;
+    buffer_create_info.usage = vk_usage;
+    buffer_create_info.size = _size;
+    buffer_create_info.queueFamilyIndexCount = 0;
+    buffer_create_info.pQueueFamilyIndices = nullptr;
+    buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    buffer_create_info.flags = 0;
+    if (VK_SUCCESS != vkCreateBuffer(_vk_device, &buffer_create_info, nullptr, &_staging_buffer.vk_buffer)) {
+        logger.LogError("GlobeStagingRing - Failed to create staging buffer");
+        _staging_buffer.vk_buffer = VK_NULL_HANDLE;
+        return;
+    }
+    if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
+            _staging_buffer.vk_buffer, (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+            _staging_buffer.memory) ||
+        nullptr == _staging_buffer.memory.mapped_data ||
+        VK_SUCCESS != vkBindBufferMemory(_vk_device, _staging_buffer.vk_buffer, _staging_buffer.memory.vk_memory,
+                                         _staging_buffer.memory.vk_offset)) {
+        logger.LogError("GlobeStagingRing - Failed to allocate, map or bind staging buffer memory");
+        vkDestroyBuffer(_vk_device, _staging_buffer.vk_buffer, nullptr);
+        _globe_resource_mgr->FreeDeviceMemory(_staging_buffer.memory);
+        _staging_buffer.vk_buffer = VK_NULL_HANDLE;
+        return;
+    }
+}
+
+GlobeStagingRing::~GlobeStagingRing() {
+    if (VK_NULL_HANDLE != _staging_buffer.vk_buffer) {
+        vkDestroyBuffer(_vk_device, _staging_buffer.vk_buffer, nullptr);
+        _globe_resource_mgr->FreeDeviceMemory(_staging_buffer.memory);
+        _staging_buffer.vk_buffer = VK_NULL_HANDLE;
+    }
+}
+
+bool GlobeStagingRing::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset,
+                                uint8_t*& mapped_data, uint64_t& allocation_id) {
+    if (!IsValid() || size == 0 || size > _size) {
+        return false;
+    }
+    if (alignment == 0) {
+        alignment = 1;
+    }
+    VkDeviceSize position = _head % _size;
+    VkDeviceSize aligned_position = (position + alignment - 1) / alignment * alignment;
+    VkDeviceSize padding = aligned_position - position;
+    if (aligned_position + size > _size) {
+        // Doesn't fit before the end of the buffer, so burn the remainder and start again at the front.
+        aligned_position = 0;
+        padding = _size - position;
+    }
+    VkDeviceSize required = padding + size;
+    if (required > _size - (_head - _tail)) {
+        return false;
+    }
+    _head += required;
+    offset = aligned_position;
+    mapped_data = _staging_buffer.memory.mapped_data + aligned_position;
+    allocation_id = _first_allocation_id + _allocations.size();
+    Allocation allocation = {};
+    allocation.end = _head;
+    allocation.released = false;
+    _allocations.push_back(allocation);
+    return true;
+}
+
+void GlobeStagingRing::Release(uint64_t allocation_id) {
+    if (allocation_id < _first_allocation_id || allocation_id - _first_allocation_id >= _allocations.size()) {
+        return;
+    }
+    _allocations[static_cast<size_t>(allocation_id - _first_allocation_id)].released = true;
+    while (!_allocations.empty() && _allocations.front().released) {
+        _tail = _allocations.front().end;
+        _allocations.pop_front();
+        _first_allocation_id++;
+    }
+    if (_allocations.empty()) {
+        // Fully drained, so start back at the front of the buffer where we have the most contiguous space.
+        _head = 0;
+        _tail = 0;
+    }
+}
+
+bool GlobeStagingRing::Flush(VkDeviceSize offset, VkDeviceSize size) const {
+    return _globe_resource_mgr->FlushDeviceMemory(_staging_buffer.memory, offset, size);
+}
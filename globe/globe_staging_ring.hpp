@@ -0,0 +1,56 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_staging_ring.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <deque>
+
+#include "vulkan/vulkan_core.h"
+#include "globe_basic_types.hpp"
+
+class GlobeResourceManager;
+
+// A single persistently mapped, host-visible transfer source buffer that uploads are carved out of
+// in FIFO order.  Every allocation gets an id which the owner releases once the GPU work reading
+// from it has completed (normally when an upload batch's fence signals).  Space only becomes
+// reusable once every allocation in front of it has been released as well.  The buffer is a transfer source
+// unless other usage is asked for (the resource manager's per-frame instance ring is a vertex buffer).
+class GlobeStagingRing {
+   public:
+    GlobeStagingRing(GlobeResourceManager* resource_manager, VkDevice vk_device, VkDeviceSize size,
+                     VkBufferUsageFlags vk_usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+    ~GlobeStagingRing();
+
+    bool IsValid() const { return VK_NULL_HANDLE != _staging_buffer.vk_buffer; }
+    VkBuffer GetVkBuffer() const { return _staging_buffer.vk_buffer; }
+    VkDeviceSize Size() const { return _size; }
+
+    bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, uint8_t*& mapped_data,
+                  uint64_t& allocation_id);
+    void Release(uint64_t allocation_id);
+    bool Flush(VkDeviceSize offset, VkDeviceSize size) const;
+
+   private:
+    struct Allocation {
+        VkDeviceSize end;
+        bool released;
+    };
+
+    GlobeResourceManager* _globe_resource_mgr;
+    VkDevice _vk_device;
+    VkDeviceSize _size;
+    GlobeVulkanBuffer _staging_buffer;
+    // _head and _tail only ever increase (until the ring drains), the position in the buffer is the
+    // value modulo _size.  This keeps a completely full ring distinguishable from an empty one.
+    VkDeviceSize _head;
+    VkDeviceSize _tail;
+    // Allocations in order, the front one has the id _first_allocation_id.
+    std::deque<Allocation> _allocations;
+    uint64_t _first_allocation_id;
+};
@@ -27,8 +27,12 @@ GlobeSubmitManager::GlobeSubmitManager(GlobeApp *app, GlobeWindow *window, VkIns
     _num_images = 0;
     _cur_image = 0;
     _cur_wait_index = 0;
+    _submitted_frame_count = 0;
+    _completed_frame_count = 0;
     _current_width = window->Width();
     _current_height = window->Height();
+    _transfer_queue_family_index = UINT32_MAX;
+    _transfer_queue = VK_NULL_HANDLE;
 
     _found_google_display_timing_extension = false;
 }
@@ -149,6 +153,27 @@ bool GlobeSubmitManager::PrepareCreateDeviceItems(VkDeviceCreateInfo &device_cre
     _graphics_queue_family_index = graphics_queue_family_index;
     _present_queue_family_index = present_queue_family_index;
 
+    // Look for a transfer-only queue family (usually backed by dedicated DMA hardware) so that uploads
+    // can run alongside rendering instead of being serialized behind it on the graphics queue.
+    // Staged image uploads are split into arbitrary bands of rows, so only accept a family without
+    // any image transfer granularity restrictions.
+    _transfer_queue_family_index = _graphics_queue_family_index;
+    for (uint32_t i = 0; i < queue_family_count; ++i) {
+        VkQueueFlags queue_flags = queue_family_props[i].queueFlags;
+        VkExtent3D granularity = queue_family_props[i].minImageTransferGranularity;
+        if ((queue_flags & VK_QUEUE_TRANSFER_BIT) != 0 &&
+            (queue_flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0 &&
+            queue_family_props[i].queueCount > 0 && granularity.width == 1 && granularity.height == 1 &&
+            granularity.depth == 1) {
+            _transfer_queue_family_index = i;
+            std::string info_msg = "Using transfer-only queue family ";
+            info_msg += std::to_string(i);
+            info_msg += " for uploads";
+            logger.LogInfo(info_msg);
+            break;
+        }
+    }
+
     _GetPhysicalDeviceSurfaceCapabilities = reinterpret_cast<PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR>(
         vkGetInstanceProcAddr(_vk_instance, "vkGetPhysicalDeviceSurfaceCapabilitiesKHR"));
     _GetPhysicalDeviceSurfacePresentModes = reinterpret_cast<PFN_vkGetPhysicalDeviceSurfacePresentModesKHR>(
@@ -160,7 +185,7 @@ bool GlobeSubmitManager::PrepareCreateDeviceItems(VkDeviceCreateInfo &device_cre
 
     float *queue_priorities = new float();
     *queue_priorities = 0.f;
-    VkDeviceQueueCreateInfo *queues = new VkDeviceQueueCreateInfo[2];
+    VkDeviceQueueCreateInfo *queues = new VkDeviceQueueCreateInfo[3];
     queues[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
     queues[0].pNext = NULL;
     queues[0].queueFamilyIndex = _graphics_queue_family_index;
@@ -179,6 +204,16 @@ bool GlobeSubmitManager::PrepareCreateDeviceItems(VkDeviceCreateInfo &device_cre
         queues[1].flags = 0;
         device_create_info.queueCreateInfoCount = 2;
     }
+    if (UsesSeparateTransferQueue()) {
+        uint32_t transfer_queue = device_create_info.queueCreateInfoCount;
+        queues[transfer_queue].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queues[transfer_queue].pNext = NULL;
+        queues[transfer_queue].queueFamilyIndex = _transfer_queue_family_index;
+        queues[transfer_queue].queueCount = 1;
+        queues[transfer_queue].pQueuePriorities = queue_priorities;
+        queues[transfer_queue].flags = 0;
+        device_create_info.queueCreateInfoCount++;
+    }
 
     // We need the swapchain extension, but nothing else.
     return found_swapchain_extension;
@@ -338,10 +373,16 @@ bool GlobeSubmitManager::PrepareForSwapchain(VkDevice device, uint8_t num_images
     } else {
         vkGetDeviceQueue(_vk_device, _present_queue_family_index, 0, &_present_queue);
     }
+    if (!UsesSeparateTransferQueue()) {
+        _transfer_queue = _graphics_queue;
+    } else {
+        vkGetDeviceQueue(_vk_device, _transfer_queue_family_index, 0, &_transfer_queue);
+    }
 
     // Create fences that we can use to throttle if we get too far
     // ahead of the image presents
     _vk_fences.resize(_num_images);
+    _fence_frame_numbers.assign(_num_images, 0);
     VkFenceCreateInfo fence_create_info = {};
     fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fence_create_info.pNext = nullptr;
@@ -643,6 +684,7 @@ bool GlobeSubmitManager::DestroySwapchain() {
         vkWaitForFences(_vk_device, 1, &_vk_fences[i], VK_TRUE, UINT64_MAX);
         vkDestroyFence(_vk_device, _vk_fences[i], nullptr);
     }
+    _completed_frame_count = _submitted_frame_count;
 
     DetachSwapchain();
     _DestroySwapchain(_vk_device, _vk_swapchain, nullptr);
@@ -656,6 +698,9 @@ bool GlobeSubmitManager::AcquireNextImageIndex(uint32_t &index) {
     // Ensure no more than FRAME_LAG renderings are outstanding
     vkWaitForFences(_vk_device, 1, &_vk_fences[_cur_wait_index], VK_TRUE, UINT64_MAX);
     vkResetFences(_vk_device, 1, &_vk_fences[_cur_wait_index]);
+    if (_fence_frame_numbers[_cur_wait_index] > _completed_frame_count) {
+        _completed_frame_count = _fence_frame_numbers[_cur_wait_index];
+    }
 
     do {
         // Get the index of the next available swapchain image:
@@ -936,7 +981,8 @@ bool GlobeSubmitManager::InsertPresentCommandsToBuffer(VkCommandBuffer command_b
 }
 
 bool GlobeSubmitManager::Submit(VkCommandBuffer command_buffer, VkSemaphore wait_semaphore,
-                                VkSemaphore signal_semaphore, VkFence fence, bool immediately_wait) {
+                                VkSemaphore signal_semaphore, VkFence fence, bool immediately_wait,
+                                VkPipelineStageFlags wait_stage_flags) {
     GlobeLogger &logger = GlobeLogger::getInstance();
     VkFence signal_fence = fence;
     bool created_fence = false;
@@ -951,8 +997,7 @@ bool GlobeSubmitManager::Submit(VkCommandBuffer command_buffer, VkSemaphore wait
     } else {
         submit_info.waitSemaphoreCount = 1;
         submit_info.pWaitSemaphores = &wait_semaphore;
-        VkPipelineStageFlags pipe_stage_flags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        submit_info.pWaitDstStageMask = &pipe_stage_flags;
+        submit_info.pWaitDstStageMask = &wait_stage_flags;
     }
     submit_info.commandBufferCount = 1;
     submit_info.pCommandBuffers = &command_buffer;
@@ -995,6 +1040,37 @@ bool GlobeSubmitManager::Submit(VkCommandBuffer command_buffer, VkSemaphore wait
     return success;
 }
 
+bool GlobeSubmitManager::SubmitTransfer(VkCommandBuffer command_buffer, VkSemaphore signal_semaphore, VkFence fence) {
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pNext = nullptr;
+    submit_info.waitSemaphoreCount = 0;
+    submit_info.pWaitSemaphores = nullptr;
+    submit_info.pWaitDstStageMask = nullptr;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer;
+    if (signal_semaphore == VK_NULL_HANDLE) {
+        submit_info.signalSemaphoreCount = 0;
+        submit_info.pSignalSemaphores = nullptr;
+    } else {
+        submit_info.signalSemaphoreCount = 1;
+        submit_info.pSignalSemaphores = &signal_semaphore;
+    }
+    if (VK_SUCCESS != vkQueueSubmit(_transfer_queue, 1, &submit_info, fence)) {
+        GlobeLogger::getInstance().LogError("GlobeSubmitManager::SubmitTransfer failed to submit to transfer queue");
+        return false;
+    }
+    return true;
+}
+
+bool GlobeSubmitManager::WaitTransferQueueIdle() {
+    if (VK_SUCCESS != vkQueueWaitIdle(_transfer_queue)) {
+        GlobeLogger::getInstance().LogError("GlobeSubmitManager::WaitTransferQueueIdle failed waiting on queue");
+        return false;
+    }
+    return true;
+}
+
 bool GlobeSubmitManager::SubmitAndPresent(VkSemaphore wait_semaphore) {
     if (_found_google_display_timing_extension) {
         // Look at what happened to previous presents, and make appropriate
@@ -1038,6 +1114,7 @@ bool GlobeSubmitManager::SubmitAndPresent(VkSemaphore wait_semaphore) {
         GlobeLogger::getInstance().LogFatalError("SubmitAndPresent(): Render vkQueueSubmit failed.");
         return false;
     }
+    _fence_frame_numbers[_cur_wait_index] = ++_submitted_frame_count;
 
     if (UsesSeparatePresentQueue()) {
         // If we are using separate queues, change image ownership to the
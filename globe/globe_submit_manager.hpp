@@ -14,11 +14,11 @@
 
 #include "globe_vulkan_headers.hpp"
 #include "globe_window.hpp"
+#include "globe_basic_types.hpp"
 
 typedef struct {
     VkBuffer uniform_buffer;
-    VkDeviceMemory uniform_memory;
-    VkDeviceSize vk_allocated_size;
+    GlobeDeviceMemory uniform_memory;
     VkDescriptorSet descriptor_set;
 } SwapchainImageResources;
 
@@ -34,6 +34,9 @@ class GlobeSubmitManager {
     bool ReleaseCreateDeviceItems(VkDeviceCreateInfo device_create_info, void **next);
 
     uint32_t GetGraphicsQueueIndex() { return _graphics_queue_family_index; }
+    // Returns the graphics queue family index when the device has no transfer-only queue family.
+    uint32_t GetTransferQueueIndex() { return _transfer_queue_family_index; }
+    bool UsesSeparateTransferQueue() const { return _graphics_queue_family_index != _transfer_queue_family_index; }
 
     bool PrepareForSwapchain(VkDevice device, uint8_t num_images, VkPresentModeKHR present_mode,
                              VkFormat prefered_format, VkFormat secondary_format);
@@ -57,9 +60,18 @@ class GlobeSubmitManager {
     bool AdjustPresentTiming();
     bool InsertPresentCommandsToBuffer(VkCommandBuffer command_buffer);
     bool Submit(VkCommandBuffer command_buffer, VkSemaphore wait_semaphore, VkSemaphore signal_semaphore, VkFence fence,
-                bool immediately_wait);
+                bool immediately_wait,
+                VkPipelineStageFlags wait_stage_flags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    bool SubmitTransfer(VkCommandBuffer command_buffer, VkSemaphore signal_semaphore, VkFence fence);
+    bool WaitTransferQueueIdle();
     bool SubmitAndPresent(VkSemaphore wait_semaphore);
 
+    // Frames are numbered from 1 in the order they are submitted by SubmitAndPresent.  A frame counts
+    // as completed once its throttling fence has been waited on, so anything only used by frames up to
+    // CompletedFrameCount() is no longer in use by the GPU.
+    uint64_t SubmittedFrameCount() const { return _submitted_frame_count; }
+    uint64_t CompletedFrameCount() const { return _completed_frame_count; }
+
    private:
     GlobeApp *_app;
     GlobeWindow *_window;
@@ -74,6 +86,8 @@ class GlobeSubmitManager {
     VkQueue _graphics_queue;
     uint32_t _present_queue_family_index;
     VkQueue _present_queue;
+    uint32_t _transfer_queue_family_index;
+    VkQueue _transfer_queue;
     VkSurfaceTransformFlagBitsKHR _pre_transform_flags;
     VkSwapchainKHR _vk_swapchain;
     uint32_t _num_images;
@@ -82,6 +96,9 @@ class GlobeSubmitManager {
     std::vector<VkImageView> _vk_image_views;
     uint32_t _cur_wait_index;
     std::vector<VkFence> _vk_fences;
+    std::vector<uint64_t> _fence_frame_numbers;
+    uint64_t _submitted_frame_count;
+    uint64_t _completed_frame_count;
     std::vector<VkFramebuffer> _vk_framebuffers;
     VkCommandPool _vk_command_pool;
     std::vector<VkCommandBuffer> _vk_render_command_buffers;
@@ -7,6 +7,9 @@
 // Author(s):               Mark Young <marky@lunarg.com>
 //
 
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
 #include <cstring>
 
 #include "globe_logger.hpp"
@@ -15,12 +18,24 @@
 #include "globe_shader.hpp"
 #include "globe_texture.hpp"
 #include "globe_resource_manager.hpp"
+#include "globe_upload_batch.hpp"
 #include "globe_submit_manager.hpp"
 #include "globe_basic_types.hpp"
+#include "globe_file_view.hpp"
+#include "globe_mipmap_generator.hpp"
+#include "globe_sampler_cache.hpp"
+
+#include <gli/gli.hpp>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#if defined(VK_USE_PLATFORM_WIN32_KHR)
+const char directory_symbol = '\\';
+#else
+const char directory_symbol = '/';
+#endif
+
 uint32_t GlobeTexture::NextPowerOfTwo(uint32_t value) {
     value--;
     value |= (value >> 1);
@@ -179,96 +194,354 @@ static VkFormat GliFormatToVkFormat(gli::format gli_format) {
     return VK_FORMAT_UNDEFINED;
 }
 
-static uint32_t PreviousPowerOfTwo(uint32_t number) {
-    if (!number) {
-        return 0;
+// KTX 1.1 file layout, see https://www.khronos.org/opengles/sdk/tools/KTX/file_format_spec/
+static const uint8_t ktx_identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+static const uint32_t ktx_endian_reference = 0x04030201;
+
+struct GlobeKtxHeader {
+    uint8_t identifier[12];
+    uint32_t endianness;
+    uint32_t gl_type;
+    uint32_t gl_type_size;
+    uint32_t gl_format;
+    uint32_t gl_internal_format;
+    uint32_t gl_base_internal_format;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t number_of_array_elements;
+    uint32_t number_of_faces;
+    uint32_t number_of_mipmap_levels;
+    uint32_t bytes_of_key_value_data;
+};
+
+// Texture cache file layout: the header, followed by the GlobeTextureLevel array (with offsets from the
+// start of the file) and the blocks of every level.  Bump the version whenever the encoder output changes.
+#define GLOBE_TEXTURE_CACHE_MAGIC 0x4548435458455447ULL  // "GTEXTCHE"
+#define GLOBE_TEXTURE_CACHE_VERSION 1
+
+struct GlobeTextureCacheHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t level_size;
+    uint64_t source_hash;
+    uint32_t vk_format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t num_levels;
+};
+
+// Mipmaps can be blitted on the GPU when the format can be both source and destination of a linear
+// filtered blit.
+static bool SupportsBlitMipmaps(const VkFormatProperties& vk_format_props) {
+    const VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                                   VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return required_features == (vk_format_props.optimalTilingFeatures & required_features);
+}
+
+// Fills levels 1 and up of an image whose levels are all in the transfer destination layout, with only
+// level 0 holding valid contents.  Each level is blitted from the one before it, which first has to be
+// turned into a transfer source.  Everything ends up ready for sampling in the fragment shader.
+static void RecordMipmapBlits(VkCommandBuffer vk_command_buffer, VkImage vk_image, uint32_t width, uint32_t height,
+                              uint32_t num_mip_levels) {
+    VkImageMemoryBarrier image_memory_barrier = {};
+    image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    image_memory_barrier.pNext = nullptr;
+    image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    image_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    image_memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    image_memory_barrier.image = vk_image;
+    image_memory_barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    int32_t src_width = static_cast<int32_t>(width);
+    int32_t src_height = static_cast<int32_t>(height);
+    for (uint32_t mip = 1; mip < num_mip_levels; ++mip) {
+        int32_t dst_width = std::max(src_width >> 1, 1);
+        int32_t dst_height = std::max(src_height >> 1, 1);
+
+        image_memory_barrier.subresourceRange.baseMipLevel = mip - 1;
+        vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+                             nullptr, 0, nullptr, 1, &image_memory_barrier);
+
+        VkImageBlit image_blit = {};
+        image_blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip - 1, 0, 1};
+        image_blit.srcOffsets[1] = {src_width, src_height, 1};
+        image_blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip, 0, 1};
+        image_blit.dstOffsets[1] = {dst_width, dst_height, 1};
+        vkCmdBlitImage(vk_command_buffer, vk_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, vk_image,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &image_blit, VK_FILTER_LINEAR);
+        src_width = dst_width;
+        src_height = dst_height;
+    }
+
+    // All but the last level were blit sources, the last one was only ever written.
+    VkImageMemoryBarrier shader_read_barriers[2] = {image_memory_barrier, image_memory_barrier};
+    shader_read_barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    shader_read_barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    shader_read_barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    shader_read_barriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    shader_read_barriers[0].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, num_mip_levels - 1, 0, 1};
+    shader_read_barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    shader_read_barriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    shader_read_barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    shader_read_barriers[1].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    shader_read_barriers[1].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, num_mip_levels - 1, 1, 0, 1};
+    uint32_t first_barrier = num_mip_levels > 1 ? 0 : 1;
+    vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                         0, nullptr, 0, nullptr, 2 - first_barrier, &shader_read_barriers[first_barrier]);
+}
+
+// Builds the rest of the mip chain behind the base level already in raw_data.
+static void GenerateMipmaps(GlobeResourceManager* resource_manager, GlobeStandardTextureData& texture_data,
+                            uint32_t width, uint32_t height) {
+    texture_data.raw_data.resize(GlobeMipmapGenerator::MipChainSize(width, height));
+    GlobeMipmapGenerator mipmap_generator(resource_manager->GetThreadPool());
+    mipmap_generator.Generate(texture_data.raw_data.data(), width, height);
+
+    uint32_t num_levels = GlobeMipmapGenerator::NumMipLevels(width, height);
+    uint32_t offset = texture_data.levels[0].data_size;
+    for (uint32_t level = 1; level < num_levels; ++level) {
+        width = std::max(width >> 1, 1u);
+        height = std::max(height >> 1, 1u);
+        GlobeTextureLevel level_data = {};
+        level_data.width = width;
+        level_data.height = height;
+        level_data.data_size = width * height * 4;
+        level_data.offset = offset;
+        texture_data.levels.push_back(level_data);
+        offset += level_data.data_size;
+    }
+}
+
+// Bytes per texel block of the formats standard images are loaded into.
+static VkDeviceSize StandardTexelBlockSize(VkFormat vk_format) {
+    switch (vk_format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            return 8;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+            return 16;
+        default:
+            return 4;
+    }
+}
+
+static VkFormat BlockFormatToVkFormat(GlobeBlockFormat block_format) {
+    switch (block_format) {
+        case GLOBE_BLOCK_FORMAT_BC1:
+            return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        case GLOBE_BLOCK_FORMAT_BC3:
+            return VK_FORMAT_BC3_UNORM_BLOCK;
+        case GLOBE_BLOCK_FORMAT_BC7:
+            return VK_FORMAT_BC7_UNORM_BLOCK;
     }
-    uint32_t power = 1;
-    while (power < number) {
-        uint32_t new_power = power << 1;
-        if (new_power > number) {
-            return power;
+    return VK_FORMAT_UNDEFINED;
+}
+
+static bool VkFormatToBlockFormat(VkFormat vk_format, GlobeBlockFormat& block_format) {
+    switch (vk_format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            block_format = GLOBE_BLOCK_FORMAT_BC1;
+            return true;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+            block_format = GLOBE_BLOCK_FORMAT_BC3;
+            return true;
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+            block_format = GLOBE_BLOCK_FORMAT_BC7;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool HasTranslucentTexels(const uint8_t* image_data, int32_t num_channels, size_t num_texels) {
+    if (2 != num_channels && 4 != num_channels) {
+        return false;
+    }
+    for (size_t texel = 0; texel < num_texels; ++texel) {
+        if (255 != image_data[texel * num_channels + num_channels - 1]) {
+            return true;
         }
-        if (new_power == 0x80000000) {
-            return new_power;
+    }
+    return false;
+}
+
+// Picks the block format for the requested compression, dropping from BC7 to BC3 when the device can't
+// sample BC7.  Returns false when the device can't sample the chosen format either.
+static bool SelectBlockFormat(GlobeResourceManager* resource_manager, GlobeTextureCompression compression,
+                              bool has_alpha, GlobeBlockFormat& block_format) {
+    switch (compression) {
+        case GLOBE_TEXTURE_COMPRESSION_BC1:
+            block_format = GLOBE_BLOCK_FORMAT_BC1;
+            break;
+        case GLOBE_TEXTURE_COMPRESSION_BC3:
+            block_format = GLOBE_BLOCK_FORMAT_BC3;
+            break;
+        case GLOBE_TEXTURE_COMPRESSION_AUTO:
+            block_format = has_alpha ? GLOBE_BLOCK_FORMAT_BC7 : GLOBE_BLOCK_FORMAT_BC1;
+            break;
+        default:
+            block_format = GLOBE_BLOCK_FORMAT_BC7;
+            break;
+    }
+    VkFormatProperties vk_format_props = resource_manager->GetVkFormatProperties(BlockFormatToVkFormat(block_format));
+    if (GLOBE_BLOCK_FORMAT_BC7 == block_format &&
+        0 == (vk_format_props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+        block_format = GLOBE_BLOCK_FORMAT_BC3;
+        vk_format_props = resource_manager->GetVkFormatProperties(VK_FORMAT_BC3_UNORM_BLOCK);
+    }
+    return 0 != (vk_format_props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+}
+
+// Replaces every RGBA level in raw_data with its blocks.
+static void CompressLevels(GlobeResourceManager* resource_manager, GlobeBlockFormat block_format,
+                           GlobeStandardTextureData& texture_data) {
+    size_t compressed_size = 0;
+    for (const auto& level : texture_data.levels) {
+        compressed_size += GlobeBlockCompressor::CompressedSize(block_format, level.width, level.height);
+    }
+    std::vector<uint8_t> blocks(compressed_size);
+    GlobeBlockCompressor block_compressor(resource_manager->GetThreadPool(), block_format);
+    uint32_t offset = 0;
+    for (auto& level : texture_data.levels) {
+        block_compressor.Compress(texture_data.raw_data.data() + level.offset, level.width, level.height,
+                                  blocks.data() + offset);
+        level.data_size =
+            static_cast<uint32_t>(GlobeBlockCompressor::CompressedSize(block_format, level.width, level.height));
+        level.offset = offset;
+        offset += level.data_size;
+    }
+    texture_data.raw_data.swap(blocks);
+}
+
+static std::string TextureCacheFileName(const std::string& cache_directory, const std::string& texture_name,
+                                        const std::string& directory, GlobeTextureCompression compression,
+                                        bool generate_mipmaps) {
+    // The file name is unique per source path and load options, the source contents are checked against
+    // the hash stored in the header.
+    std::string key = directory + texture_name;
+    uint32_t options[2] = {static_cast<uint32_t>(compression), generate_mipmaps ? 1u : 0u};
+    uint64_t key_hash = GlobeHashData(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+    key_hash ^= GlobeHashData(reinterpret_cast<const uint8_t*>(options), sizeof(options));
+    char key_string[17];
+    snprintf(key_string, sizeof(key_string), "%016llx", static_cast<unsigned long long>(key_hash));
+
+    std::string file_name = cache_directory;
+    file_name += directory_symbol;
+    for (auto cur_char : texture_name) {
+        file_name += isalnum(static_cast<unsigned char>(cur_char)) ? static_cast<char>(tolower(cur_char)) : '_';
+    }
+    file_name += '_';
+    file_name += key_string;
+    file_name += ".texture_cache";
+    return file_name;
+}
+
+// Anything in the cache that doesn't match what LoadStandardFile would produce for the same options
+// marks it as out of date.
+static bool LoadTextureCache(GlobeResourceManager* resource_manager, const std::string& cache_file_name,
+                             bool generate_mipmaps, uint64_t source_hash, GlobeTextureData& texture_data) {
+    GlobeFileView cache_view;
+    if (!cache_view.Open(cache_file_name) || cache_view.Size() < sizeof(GlobeTextureCacheHeader)) {
+        return false;
+    }
+    GlobeTextureCacheHeader header = {};
+    memcpy(&header, cache_view.Data(), sizeof(GlobeTextureCacheHeader));
+    uint64_t levels_size = static_cast<uint64_t>(header.num_levels) * sizeof(GlobeTextureLevel);
+    VkFormat vk_format = static_cast<VkFormat>(header.vk_format);
+    GlobeBlockFormat block_format = GLOBE_BLOCK_FORMAT_BC7;
+    bool valid = GLOBE_TEXTURE_CACHE_MAGIC == header.magic && GLOBE_TEXTURE_CACHE_VERSION == header.version &&
+                 sizeof(GlobeTextureLevel) == header.level_size && source_hash == header.source_hash &&
+                 VkFormatToBlockFormat(vk_format, block_format) && 0 < header.width && 0 < header.height;
+    // With mipmaps the whole chain was generated on the CPU, otherwise only the base level is stored.
+    uint32_t expected_levels = 1;
+    if (valid && generate_mipmaps) {
+        expected_levels = GlobeMipmapGenerator::NumMipLevels(header.width, header.height);
+    }
+    valid = valid && expected_levels == header.num_levels &&
+            sizeof(GlobeTextureCacheHeader) + levels_size <= cache_view.Size();
+    std::vector<GlobeTextureLevel> levels;
+    if (valid) {
+        levels.resize(header.num_levels);
+        memcpy(levels.data(), cache_view.Data() + sizeof(GlobeTextureCacheHeader), static_cast<size_t>(levels_size));
+        for (uint32_t mip = 0; mip < header.num_levels; ++mip) {
+            const GlobeTextureLevel& level = levels[mip];
+            valid = valid && std::max(header.width >> mip, 1u) == level.width &&
+                    std::max(header.height >> mip, 1u) == level.height &&
+                    GlobeBlockCompressor::CompressedSize(block_format, level.width, level.height) == level.data_size &&
+                    static_cast<uint64_t>(level.offset) + level.data_size <= cache_view.Size();
         }
-        power = new_power;
-    }
-    return 0;
-}
-
-static void SampleSourceForMipmap(const uint8_t* src, uint32_t width, uint32_t height, uint32_t x, uint32_t y,
-                                  uint8_t* dst) {
-    uint32_t next_x = x + 1;
-    if (next_x >= width) {
-        next_x = x;
-    }
-    uint32_t next_y = y + 1;
-    if (next_y >= height) {
-        next_y = y;
-    }
-    uint32_t cum_dst[4];
-    cum_dst[0] = src[((y * height + x) * 4)];
-    cum_dst[1] = src[((y * height + x) * 4) + 1];
-    cum_dst[2] = src[((y * height + x) * 4) + 2];
-    cum_dst[3] = src[((y * height + x) * 4) + 3];
-    cum_dst[0] += src[((y * height + next_x) * 4)];
-    cum_dst[1] += src[((y * height + next_x) * 4) + 1];
-    cum_dst[2] += src[((y * height + next_x) * 4) + 2];
-    cum_dst[3] += src[((y * height + next_x) * 4) + 3];
-    cum_dst[0] += src[((next_y * height + x) * 4)];
-    cum_dst[1] += src[((next_y * height + x) * 4) + 1];
-    cum_dst[2] += src[((next_y * height + x) * 4) + 2];
-    cum_dst[3] += src[((next_y * height + x) * 4) + 3];
-    cum_dst[0] += src[((next_y * height + next_x) * 4)];
-    cum_dst[1] += src[((next_y * height + next_x) * 4) + 1];
-    cum_dst[2] += src[((next_y * height + next_x) * 4) + 2];
-    cum_dst[3] += src[((next_y * height + next_x) * 4) + 3];
-    dst[0] = static_cast<uint8_t>(cum_dst[0] >> 2);
-    dst[1] = static_cast<uint8_t>(cum_dst[1] >> 2);
-    dst[2] = static_cast<uint8_t>(cum_dst[2] >> 2);
-    dst[3] = static_cast<uint8_t>(cum_dst[3] >> 2);
-}
-
-static bool GenerateMipmaps(GlobeStandardTextureData& texture_data, uint32_t start_width, uint32_t start_height) {
-    if (texture_data.levels.size() != 1) {
+    }
+    // The cache may also have been written on a device with different format support.
+    VkFormatProperties vk_format_props = resource_manager->GetVkFormatProperties(vk_format);
+    if (!valid || 0 == (vk_format_props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+        GlobeLogger::getInstance().LogInfo("Texture cache " + cache_file_name + " is out of date");
         return false;
     }
 
-    uint32_t last_width = start_width;
-    uint32_t last_height = start_height;
-    uint32_t last_offset = 0;
-    uint32_t cur_width = PreviousPowerOfTwo(start_width);
-    uint32_t cur_height = PreviousPowerOfTwo(start_height);
-    uint32_t cur_offset = start_width * start_height * 4;
-    while (cur_width >= 1 && cur_height >= 1) {
-        GlobeTextureLevel level_data = {};
-        level_data.width = cur_width;
-        level_data.height = cur_height;
-        level_data.data_size = cur_width * cur_height * 4;
-        level_data.offset = cur_offset;
-        texture_data.levels.push_back(level_data);
-        texture_data.raw_data.resize(texture_data.raw_data.size() + level_data.data_size);
-
-        uint8_t* dst_ptr = texture_data.raw_data.data() + cur_offset;
-        uint8_t* src_ptr = texture_data.raw_data.data() + last_offset;
-        for (uint32_t row = 0; row < cur_height; ++row) {
-            for (uint32_t col = 0; col < cur_width; ++col) {
-                SampleSourceForMipmap(src_ptr, last_width, last_height, col * 2, row * 2,
-                                      &dst_ptr[(row * cur_height + col) * 4]);
-            }
-        }
+    // The blocks are staged straight out of the mapping, just like a KTX file.
+    texture_data.setup_for_render_target = false;
+    texture_data.vk_format = vk_format;
+    texture_data.vk_format_props = vk_format_props;
+    texture_data.width = header.width;
+    texture_data.height = header.height;
+    texture_data.num_mip_levels = header.num_levels;
+    texture_data.uses_standard_data = false;
+    texture_data.ktx_data = new GlobeKtxTextureData();
+    texture_data.ktx_data->file_view = cache_view;
+    texture_data.ktx_data->texel_block_size = StandardTexelBlockSize(vk_format);
+    texture_data.ktx_data->levels = levels;
+    return true;
+}
 
-        cur_offset += cur_width * cur_height * 4;
-        last_width = cur_width;
-        last_height = cur_height;
-        cur_width >>= 1;
-        cur_height >>= 1;
+static bool SaveTextureCache(const std::string& cache_file_name, uint64_t source_hash,
+                             const GlobeTextureData& texture_data) {
+    const GlobeStandardTextureData& standard_data = *texture_data.standard_data;
+    GlobeTextureCacheHeader header = {};
+    header.magic = GLOBE_TEXTURE_CACHE_MAGIC;
+    header.version = GLOBE_TEXTURE_CACHE_VERSION;
+    header.level_size = sizeof(GlobeTextureLevel);
+    header.source_hash = source_hash;
+    header.vk_format = static_cast<uint32_t>(texture_data.vk_format);
+    header.width = texture_data.width;
+    header.height = texture_data.height;
+    header.num_levels = static_cast<uint32_t>(standard_data.levels.size());
+    size_t levels_size = standard_data.levels.size() * sizeof(GlobeTextureLevel);
+    uint32_t data_offset = static_cast<uint32_t>(sizeof(GlobeTextureCacheHeader) + levels_size);
+    std::vector<GlobeTextureLevel> levels = standard_data.levels;
+    for (auto& level : levels) {
+        level.offset += data_offset;
     }
+
+    // Write to a temporary file first so a concurrent or interrupted load never sees a partial cache.
+    std::string temp_file_name = cache_file_name + ".tmp";
+    FILE* file_ptr = fopen(temp_file_name.c_str(), "wb");
+    if (nullptr == file_ptr) {
+        GlobeLogger::getInstance().LogWarning("Failed to create texture cache " + cache_file_name);
+        return false;
+    }
+    bool success = 1 == fwrite(&header, sizeof(GlobeTextureCacheHeader), 1, file_ptr);
+    success = success && 1 == fwrite(levels.data(), levels_size, 1, file_ptr);
+    success = success && 1 == fwrite(standard_data.raw_data.data(), standard_data.raw_data.size(), 1, file_ptr);
+    success = (0 == fclose(file_ptr)) && success;
+    if (success) {
+        remove(cache_file_name.c_str());
+        success = 0 == rename(temp_file_name.c_str(), cache_file_name.c_str());
+    }
+    if (!success) {
+        remove(temp_file_name.c_str());
+        GlobeLogger::getInstance().LogWarning("Failed to write texture cache " + cache_file_name);
+        return false;
+    }
+    GlobeLogger::getInstance().LogInfo("Wrote texture cache " + cache_file_name);
     return true;
 }
 
-static bool LoadStandardFile(GlobeResourceManager* resource_manager, const std::string& filename,
+static bool LoadStandardFile(GlobeResourceManager* resource_manager, bool generate_mipmaps,
+                             GlobeTextureCompression compression, const std::string& filename,
                              GlobeTextureData& texture_data) {
     GlobeLogger& logger = GlobeLogger::getInstance();
 
@@ -277,14 +550,16 @@ static bool LoadStandardFile(GlobeResourceManager* resource_manager, const std::
 #error("Unsupported platform")
 #elif defined(__ANDROID__)
 #else
-    FILE* file_ptr = fopen(filename.c_str(), "rb");
-    if (nullptr == file_ptr) {
+    // stb_image decodes straight out of the mapped file.
+    GlobeFileView file_view;
+    if (!file_view.Open(filename)) {
         return false;
     }
     int32_t int_width = 0;
     int32_t int_height = 0;
     int32_t num_channels = 0;
-    uint8_t* image_data = stbi_load_from_file(file_ptr, &int_width, &int_height, &num_channels, 0);
+    uint8_t* image_data = stbi_load_from_memory(file_view.Data(), static_cast<int>(file_view.Size()), &int_width,
+                                                &int_height, &num_channels, 0);
     if (nullptr == image_data || int_width <= 0 || int_height <= 0 || num_channels <= 0) {
         if (nullptr != image_data) {
             stbi_image_free(image_data);
@@ -299,6 +574,7 @@ static bool LoadStandardFile(GlobeResourceManager* resource_manager, const std::
     texture_data.vk_format = VK_FORMAT_R8G8B8A8_UNORM;
     texture_data.width = static_cast<uint32_t>(int_width);
     texture_data.height = static_cast<uint32_t>(int_height);
+    texture_data.vk_format_props = resource_manager->GetVkFormatProperties(texture_data.vk_format);
 
     texture_data.uses_standard_data = true;
     texture_data.standard_data = new GlobeStandardTextureData();
@@ -308,7 +584,6 @@ static bool LoadStandardFile(GlobeResourceManager* resource_manager, const std::
         logger.LogError(error_string);
         return false;
     }
-    // TODO: Brainpain - Generate mipmaps if needed
     texture_data.num_mip_levels = 1;
     GlobeTextureLevel level_data = {};
     level_data.width = int_width;
@@ -316,31 +591,56 @@ static bool LoadStandardFile(GlobeResourceManager* resource_manager, const std::
     level_data.data_size = int_width * int_height * 4;
     level_data.offset = 0;
     texture_data.standard_data->levels.push_back(level_data);
-    texture_data.standard_data->raw_data.resize(level_data.data_size);
-    if (num_channels != 4) {
-        uint8_t* dst_ptr = reinterpret_cast<uint8_t*>(texture_data.standard_data->raw_data.data());
-        uint8_t* src_ptr = image_data;
-        for (int32_t row = 0; row < int_height; ++row) {
-            for (int32_t col = 0; col < int_width; ++col) {
-                int32_t comp = 0;
-                for (; comp < num_channels; ++comp) {
-                    *dst_ptr++ = *src_ptr++;
-                }
-                while (comp++ < 4) {
-                    if (comp == 4) {
-                        *dst_ptr++ = 255;
-                    } else {
-                        *dst_ptr++ = 0;
-                    }
-                }
-            }
+    size_t num_texels = static_cast<size_t>(int_width) * static_cast<size_t>(int_height);
+
+    // Block compressed images are only ever staged, linear tiling support for them is rare.
+    GlobeBlockFormat block_format = GLOBE_BLOCK_FORMAT_BC1;
+    bool compress = false;
+    if (GLOBE_TEXTURE_COMPRESSION_NONE != compression && resource_manager->UseStagingBuffer()) {
+        bool has_alpha = HasTranslucentTexels(image_data, num_channels, num_texels);
+        compress = SelectBlockFormat(resource_manager, compression, has_alpha, block_format);
+        if (!compress) {
+            std::string warning_msg = "LoadStandardFile - Block compressed formats can't be sampled, leaving ";
+            warning_msg += filename;
+            warning_msg += " uncompressed";
+            logger.LogWarning(warning_msg);
+        }
+    }
+
+    // Linear images only ever get a single level, so the chain is only useful when staging.  Prefer
+    // blitting it on the GPU, which saves both the CPU work and uploading the extra levels.  Blits can't
+    // write block compressed images though, so those levels are built on the CPU before encoding.
+    bool generate_on_cpu = false;
+    if (generate_mipmaps && resource_manager->UseStagingBuffer()) {
+        if (!compress && SupportsBlitMipmaps(texture_data.vk_format_props)) {
+            texture_data.blit_mipmaps = true;
+            texture_data.num_mip_levels = GlobeMipmapGenerator::NumMipLevels(texture_data.width, texture_data.height);
+        } else {
+            generate_on_cpu = true;
         }
-    } else {
-        memcpy(texture_data.standard_data->raw_data.data(), image_data, int_width * int_height * 4 * sizeof(uint8_t));
     }
 
+    // Images with fewer than 4 channels are kept as decoded and only expanded to RGBA on their way to
+    // the GPU, unless the CPU needs the RGBA texels to build the mip chain or the blocks.
+    GlobePixelConversion conversion = GlobePixelConversionFromChannels(static_cast<uint32_t>(num_channels));
+    if (generate_on_cpu || compress) {
+        texture_data.standard_data->raw_data.resize(level_data.data_size);
+        GlobeConvertPixels(conversion, image_data, texture_data.standard_data->raw_data.data(), num_texels);
+    } else {
+        texture_data.standard_data->raw_data.assign(image_data, image_data + num_texels * num_channels);
+        texture_data.standard_data->conversion = conversion;
+    }
     stbi_image_free(image_data);
-    fclose(file_ptr);
+
+    if (generate_on_cpu) {
+        GenerateMipmaps(resource_manager, *texture_data.standard_data, texture_data.width, texture_data.height);
+        texture_data.num_mip_levels = static_cast<uint32_t>(texture_data.standard_data->levels.size());
+    }
+    if (compress) {
+        CompressLevels(resource_manager, block_format, *texture_data.standard_data);
+        texture_data.vk_format = BlockFormatToVkFormat(block_format);
+        texture_data.vk_format_props = resource_manager->GetVkFormatProperties(texture_data.vk_format);
+    }
 #endif
     return true;
 }
@@ -354,28 +654,41 @@ static bool LoadKtxFile(GlobeResourceManager* resource_manager, bool generate_mi
 #error("Unsupported platform")
 #elif defined(__ANDROID__)
 #else
-    gli::texture2d* gli_texture = new gli::texture2d(gli::load(filename.c_str()));
-    if (gli_texture->empty()) {
+    // The KTX file is parsed in place and the mip levels are staged directly out of the mapping.
+    GlobeFileView file_view;
+    const GlobeKtxHeader* header = nullptr;
+    if (file_view.Open(filename) && file_view.Size() >= sizeof(GlobeKtxHeader)) {
+        header = reinterpret_cast<const GlobeKtxHeader*>(file_view.Data());
+    }
+    if (nullptr == header || 0 != memcmp(header->identifier, ktx_identifier, sizeof(ktx_identifier)) ||
+        ktx_endian_reference != header->endianness) {
         std::string error_msg = "GlobeTexture::LoadKtxFile failed for file ";
         error_msg += filename;
         error_msg += " because it either does not exist or is invalid";
         logger.LogError(error_msg);
         return false;
     }
+    if (header->pixel_depth > 1 || header->number_of_array_elements > 0 || header->number_of_faces > 1) {
+        std::string error_msg = "GlobeTexture::LoadKtxFile failed for file ";
+        error_msg += filename;
+        error_msg += " because only 2D textures are supported";
+        logger.LogError(error_msg);
+        return false;
+    }
+
+    gli::gl gl_translator(gli::gl::PROFILE_KTX);
+    gli::format gli_format = gl_translator.find(static_cast<gli::gl::internal_format>(header->gl_internal_format),
+                                                static_cast<gli::gl::external_format>(header->gl_format),
+                                                static_cast<gli::gl::type_format>(header->gl_type));
 
     texture_data.is_color = true;
     texture_data.is_stencil = false;
     texture_data.is_depth = false;
     texture_data.vk_sample_count = VK_SAMPLE_COUNT_1_BIT;
     texture_data.setup_for_render_target = false;
-    texture_data.width = static_cast<uint32_t>(gli_texture[0].extent().x);
-    texture_data.height = static_cast<uint32_t>(gli_texture[0].extent().y);
-    if (generate_mipmaps) {
-        texture_data.num_mip_levels = static_cast<uint32_t>(gli_texture->levels());
-    } else {
-        texture_data.num_mip_levels = 1;
-    }
-    texture_data.vk_format = GliFormatToVkFormat(gli_texture->format());
+    texture_data.width = header->pixel_width;
+    texture_data.height = std::max(header->pixel_height, 1u);
+    texture_data.vk_format = GliFormatToVkFormat(gli_format);
     texture_data.vk_format_props = resource_manager->GetVkFormatProperties(texture_data.vk_format);
     if (0 == (texture_data.vk_format_props.linearTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) &&
         0 == (texture_data.vk_format_props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
@@ -384,103 +697,84 @@ static bool LoadKtxFile(GlobeResourceManager* resource_manager, bool generate_mi
         error_msg += " because it uses an unsupported format";
         logger.LogError(error_msg);
     }
-    texture_data.gli_texture_2d = gli_texture;
+
+    uint32_t file_mip_levels = std::max(header->number_of_mipmap_levels, 1u);
+    texture_data.num_mip_levels = generate_mipmaps ? file_mip_levels : 1;
+    std::vector<GlobeTextureLevel> levels;
+
+    // Each level is a 32-bit image size followed by the image, padded out to 4 bytes.
+    size_t offset = sizeof(GlobeKtxHeader) + header->bytes_of_key_value_data;
+    for (uint32_t mip = 0; mip < texture_data.num_mip_levels; ++mip) {
+        uint32_t image_size = 0;
+        if (offset + sizeof(uint32_t) <= file_view.Size()) {
+            memcpy(&image_size, file_view.Data() + offset, sizeof(uint32_t));
+        }
+        offset += sizeof(uint32_t);
+        if (0 == image_size || offset + image_size > file_view.Size()) {
+            std::string error_msg = "GlobeTexture::LoadKtxFile failed for file ";
+            error_msg += filename;
+            error_msg += " because it is truncated";
+            logger.LogError(error_msg);
+            return false;
+        }
+        GlobeTextureLevel level_data = {};
+        level_data.width = std::max(texture_data.width >> mip, 1u);
+        level_data.height = std::max(texture_data.height >> mip, 1u);
+        level_data.data_size = image_size;
+        level_data.offset = static_cast<uint32_t>(offset);
+        levels.push_back(level_data);
+        offset += (image_size + 3) & ~static_cast<size_t>(3);
+    }
+    texture_data.uses_standard_data = false;
+    texture_data.ktx_data = new GlobeKtxTextureData();
+    texture_data.ktx_data->file_view = file_view;
+    texture_data.ktx_data->texel_block_size = gli::block_size(gli_format);
+    texture_data.ktx_data->levels = levels;
+
+    // A file without its own mip chain can still get one from the GPU if the format allows it.
+    if (generate_mipmaps && 1 == file_mip_levels && resource_manager->UseStagingBuffer() &&
+        SupportsBlitMipmaps(texture_data.vk_format_props)) {
+        texture_data.blit_mipmaps = true;
+        texture_data.num_mip_levels = GlobeMipmapGenerator::NumMipLevels(texture_data.width, texture_data.height);
+    }
 #endif
 
     return true;
 }
 
-bool GlobeTexture::InitFromContent(GlobeResourceManager* resource_manager, GlobeSubmitManager* submit_manager,
-                                   VkDevice vk_device, const std::string& texture_name,
-                                   GlobeTextureData& texture_data) {
+bool GlobeTexture::RecordContentUpload(GlobeResourceManager* resource_manager, GlobeUploadBatch* batch,
+                                       VkDevice vk_device, const std::string& texture_name,
+                                       GlobeTextureData& texture_data) {
     GlobeLogger& logger = GlobeLogger::getInstance();
     bool uses_staging = resource_manager->UseStagingBuffer();
     uint32_t num_mip_levels = texture_data.num_mip_levels;
-    uint8_t* raw_data;
-    size_t raw_data_size;
-    GlobeVulkanBuffer staging_buffer;
+    uint32_t num_uploaded_levels = texture_data.blit_mipmaps ? 1 : num_mip_levels;
+    uint32_t num_layers = std::max(texture_data.array_layers, 1u);
+    const uint8_t* raw_data;
+    const std::vector<GlobeTextureLevel>* levels;
+    VkDeviceSize texel_block_size;
+    GlobePixelConversion conversion = GLOBE_PIXEL_CONVERSION_NONE;
 
     if (texture_data.uses_standard_data) {
         raw_data = texture_data.standard_data->raw_data.data();
-        raw_data_size = texture_data.standard_data->raw_data.size();
+        levels = &texture_data.standard_data->levels;
+        texel_block_size = StandardTexelBlockSize(texture_data.vk_format);
+        conversion = texture_data.standard_data->conversion;
     } else {
-        raw_data = static_cast<uint8_t*>(texture_data.gli_texture_2d->data());
-        raw_data_size = texture_data.gli_texture_2d->size();
-    }
-
-    VkCommandBuffer texture_copy_cmd_buf;
-    if (!resource_manager->AllocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, texture_copy_cmd_buf)) {
-        std::string error_msg = "InitFromContent - Failed allocating command buffer for copying texture  \"";
-        error_msg += texture_name;
-        error_msg += "\"";
-        logger.LogError(error_msg);
-        return false;
-    }
-    VkCommandBufferBeginInfo cmd_buf_begin_info = {};
-    cmd_buf_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    cmd_buf_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    if (VK_SUCCESS != vkBeginCommandBuffer(texture_copy_cmd_buf, &cmd_buf_begin_info)) {
-        std::string error_msg = "InitFromContent - Failed beginning command buffer for copying texture  \"";
-        error_msg += texture_name;
-        error_msg += "\"";
-        logger.LogError(error_msg);
-        return false;
+        raw_data = texture_data.ktx_data->file_view.Data();
+        levels = &texture_data.ktx_data->levels;
+        texel_block_size = texture_data.ktx_data->texel_block_size;
     }
 
-    VkBufferCreateInfo buffer_create_info = {};
-    buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    VkCommandBuffer texture_copy_cmd_buf = batch->GetVkCommandBuffer();
 
     VkImageSubresourceRange image_subresource_range = {};
     image_subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     image_subresource_range.levelCount = num_mip_levels;
-    image_subresource_range.layerCount = 1;
+    image_subresource_range.layerCount = num_layers;
 
     VkImageUsageFlags loading_image_usage_flags = VK_IMAGE_USAGE_SAMPLED_BIT;
     if (uses_staging) {
-        // Create a temporary staging buffer that is host-visible that we can copy
-        // the image data into and then transfer over to the GPU in its most
-        // efficient memory layout.
-        buffer_create_info.size = raw_data_size;
-        buffer_create_info.queueFamilyIndexCount = 0;
-        buffer_create_info.pQueueFamilyIndices = nullptr;
-        buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        buffer_create_info.flags = 0;
-        if (VK_SUCCESS != vkCreateBuffer(vk_device, &buffer_create_info, NULL, &staging_buffer.vk_buffer)) {
-            std::string error_msg = "InitFromContent - Failed to create staging buffer for texture \"";
-            error_msg += texture_name;
-            error_msg += "\"";
-            logger.LogError(error_msg);
-            return false;
-        }
-        if (!resource_manager->AllocateDeviceBufferMemory(
-                staging_buffer.vk_buffer, (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                staging_buffer.vk_memory, staging_buffer.vk_size)) {
-            std::string error_msg = "InitFromContent - Failed to allocate memory for staging buffer for texture \"";
-            error_msg += texture_name;
-            error_msg += "\"";
-            logger.LogError(error_msg);
-            return false;
-        }
-        if (VK_SUCCESS != vkBindBufferMemory(vk_device, staging_buffer.vk_buffer, staging_buffer.vk_memory, 0)) {
-            std::string error_msg = "InitFromContent - Failed to bind memory to staging buffer for texture \"";
-            error_msg += texture_name;
-            error_msg += "\"";
-            logger.LogError(error_msg);
-            return false;
-        }
-        uint8_t* mapped_staging_memory;
-        if (VK_SUCCESS != vkMapMemory(vk_device, staging_buffer.vk_memory, 0, staging_buffer.vk_size, 0,
-                                      reinterpret_cast<void**>(&mapped_staging_memory))) {
-            std::string error_msg = "InitFromContent - Failed to map memory for staging buffer for texture \"";
-            error_msg += texture_name;
-            error_msg += "\"";
-            logger.LogError(error_msg);
-            return false;
-        }
-        memcpy(mapped_staging_memory, raw_data, raw_data_size);
-        vkUnmapMemory(vk_device, staging_buffer.vk_memory);
-
         // Now define a texture image and memory for the resulting optimally tiled texture
         // on the device itself instead of unoptimal host-visible memory.
         VkImageCreateInfo image_create_info = {};
@@ -489,10 +783,13 @@ bool GlobeTexture::InitFromContent(GlobeResourceManager* resource_manager, Globe
         image_create_info.format = texture_data.vk_format;
         image_create_info.extent = {texture_data.width, texture_data.height, 1};
         image_create_info.mipLevels = num_mip_levels;
-        image_create_info.arrayLayers = 1;
+        image_create_info.arrayLayers = num_layers;
         image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
         image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
         image_create_info.usage = loading_image_usage_flags | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        if (texture_data.blit_mipmaps) {
+            image_create_info.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
         image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
         image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
         if (VK_SUCCESS != vkCreateImage(vk_device, &image_create_info, NULL, &texture_data.vk_image)) {
@@ -503,15 +800,15 @@ bool GlobeTexture::InitFromContent(GlobeResourceManager* resource_manager, Globe
             return false;
         }
         if (!resource_manager->AllocateDeviceImageMemory(texture_data.vk_image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                                         texture_data.vk_device_memory,
-                                                         texture_data.vk_allocated_size)) {
+                                                         texture_data.device_memory)) {
             std::string error_message = "InitFromContent - Failed allocating memory for resulting image for texture \"";
             error_message += texture_name;
             error_message += "\"";
             logger.LogError(error_message);
             return false;
         }
-        if (VK_SUCCESS != vkBindImageMemory(vk_device, texture_data.vk_image, texture_data.vk_device_memory, 0)) {
+        if (VK_SUCCESS != vkBindImageMemory(vk_device, texture_data.vk_image, texture_data.device_memory.vk_memory,
+                                            texture_data.device_memory.vk_offset)) {
             std::string error_message = "InitFromContent - Failed binding memory for resulting image for texture \"";
             error_message += texture_name;
             error_message += "\"";
@@ -531,46 +828,56 @@ bool GlobeTexture::InitFromContent(GlobeResourceManager* resource_manager, Globe
             return false;
         }
 
-        // We now need to setup a copy for each miplevel in the texture.
+        // We now need to setup a copy for each miplevel of each layer in the texture.  The buffer offsets
+        // are relative to the start of the raw data, the resource manager moves them into the staging ring.
         std::vector<VkBufferImageCopy> vk_buffer_image_copies;
-        vk_buffer_image_copies.resize(num_mip_levels);
-        uint32_t current_buffer_offset = 0;
-        for (uint32_t mip = 0; mip < num_mip_levels; ++mip) {
-            vk_buffer_image_copies[mip] = {};
-            vk_buffer_image_copies[mip].bufferOffset = current_buffer_offset;
-            vk_buffer_image_copies[mip].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            vk_buffer_image_copies[mip].imageSubresource.mipLevel = mip;
-            vk_buffer_image_copies[mip].imageSubresource.layerCount = 1;
-
-            if (texture_data.uses_standard_data) {
-                vk_buffer_image_copies[mip].imageExtent.width =
-                    static_cast<uint32_t>(texture_data.standard_data->levels[mip].width);
-                vk_buffer_image_copies[mip].imageExtent.height =
-                    static_cast<uint32_t>(texture_data.standard_data->levels[mip].height);
-                vk_buffer_image_copies[mip].imageExtent.depth = 1;
-                // Update the offset to be after the current texture
-                current_buffer_offset += static_cast<uint32_t>(texture_data.standard_data->levels[mip].data_size);
-            } else {
-                vk_buffer_image_copies[mip].imageExtent.width =
-                    static_cast<uint32_t>((*texture_data.gli_texture_2d)[mip].extent().x);
-                vk_buffer_image_copies[mip].imageExtent.height =
-                    static_cast<uint32_t>((*texture_data.gli_texture_2d)[mip].extent().y);
-                vk_buffer_image_copies[mip].imageExtent.depth = 1;
-                // Update the offset to be after the current texture
-                current_buffer_offset += static_cast<uint32_t>((*texture_data.gli_texture_2d)[mip].size());
+        std::vector<VkDeviceSize> copy_sizes;
+        for (uint32_t layer = 0; layer < num_layers; ++layer) {
+            for (uint32_t mip = 0; mip < num_uploaded_levels; ++mip) {
+                const GlobeTextureLevel& level = (*levels)[layer * num_mip_levels + mip];
+                VkBufferImageCopy vk_buffer_image_copy = {};
+                vk_buffer_image_copy.bufferOffset = level.offset;
+                vk_buffer_image_copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                vk_buffer_image_copy.imageSubresource.mipLevel = mip;
+                vk_buffer_image_copy.imageSubresource.baseArrayLayer = layer;
+                vk_buffer_image_copy.imageSubresource.layerCount = 1;
+                vk_buffer_image_copy.imageExtent.width = level.width;
+                vk_buffer_image_copy.imageExtent.height = level.height;
+                vk_buffer_image_copy.imageExtent.depth = 1;
+                vk_buffer_image_copies.push_back(vk_buffer_image_copy);
+                copy_sizes.push_back(level.data_size);
             }
         }
 
-        // Now, copy all the mip-map levels from the staging buffer into the final image.
-        vkCmdCopyBufferToImage(texture_copy_cmd_buf, staging_buffer.vk_buffer, texture_data.vk_image,
-                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                               static_cast<uint32_t>(vk_buffer_image_copies.size()), vk_buffer_image_copies.data());
+        // Now, copy all the mip-map levels through the staging buffer into the final image.
+        if (!resource_manager->StageImageUpload(batch, texture_data.vk_image, texture_data.vk_format, texel_block_size,
+                                                raw_data, vk_buffer_image_copies, copy_sizes, conversion)) {
+            std::string error_message = "InitFromContent - Failed staging image data for texture \"";
+            error_message += texture_name;
+            error_message += "\"";
+            logger.LogError(error_message);
+            return false;
+        }
 
-        // Make sure we delay until we can copy over the contents of the texture read.
-        if (!resource_manager->InsertImageLayoutTransitionBarrier(
-                texture_copy_cmd_buf, texture_data.vk_image, image_subresource_range, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)) {
+        // Make sure we delay until we can copy over the contents of the texture read.  This also hands
+        // the image over to the graphics queue if the batch runs on a separate transfer queue.  Blits need
+        // a graphics queue, so an image still missing its mipmaps is handed over as a transfer destination
+        // and the mip chain is recorded after the acquire.
+        if (texture_data.blit_mipmaps) {
+            if (!batch->FinishImage(texture_data.vk_image, image_subresource_range,
+                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT)) {
+                std::string error_message =
+                    "InitFromContent - Failed to add layout transition image barrier for texture \"";
+                error_message += texture_name;
+                error_message += "\" to mipmap generation state";
+                logger.LogError(error_message);
+                return false;
+            }
+            RecordMipmapBlits(batch->GetVkGraphicsCommandBuffer(), texture_data.vk_image, texture_data.width,
+                              texture_data.height, num_mip_levels);
+        } else if (!batch->FinishImage(texture_data.vk_image, image_subresource_range,
+                                       VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)) {
             std::string error_message =
                 "InitFromContent - Failed to add layout transition image barrier for texture \"";
             error_message += texture_name;
@@ -586,7 +893,7 @@ bool GlobeTexture::InitFromContent(GlobeResourceManager* resource_manager, Globe
         image_create_info.format = texture_data.vk_format;
         image_create_info.extent = {texture_data.width, texture_data.height, 1};
         image_create_info.mipLevels = num_mip_levels;
-        image_create_info.arrayLayers = 1;
+        image_create_info.arrayLayers = num_layers;
         image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
         image_create_info.tiling = VK_IMAGE_TILING_LINEAR;
         image_create_info.usage = loading_image_usage_flags | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
@@ -601,7 +908,7 @@ bool GlobeTexture::InitFromContent(GlobeResourceManager* resource_manager, Globe
         }
         if (!resource_manager->AllocateDeviceImageMemory(
                 texture_data.vk_image, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                texture_data.vk_device_memory, texture_data.vk_allocated_size)) {
+                texture_data.device_memory)) {
             std::string error_message =
                 "InitFromContent - Failed allocating memory for resulting image for linear texture \"";
             error_message += texture_name;
@@ -609,7 +916,8 @@ bool GlobeTexture::InitFromContent(GlobeResourceManager* resource_manager, Globe
             logger.LogError(error_message);
             return false;
         }
-        if (VK_SUCCESS != vkBindImageMemory(vk_device, texture_data.vk_image, texture_data.vk_device_memory, 0)) {
+        if (VK_SUCCESS != vkBindImageMemory(vk_device, texture_data.vk_image, texture_data.device_memory.vk_memory,
+                                            texture_data.device_memory.vk_offset)) {
             std::string error_message =
                 "InitFromContent - Failed binding memory for resulting image for linear texture \"";
             error_message += texture_name;
@@ -618,22 +926,27 @@ bool GlobeTexture::InitFromContent(GlobeResourceManager* resource_manager, Globe
             return false;
         }
 
-        uint8_t* mapped_staging_memory;
-        if (VK_SUCCESS != vkMapMemory(vk_device, texture_data.vk_device_memory, 0, texture_data.vk_allocated_size, 0,
-                                      reinterpret_cast<void**>(&mapped_staging_memory))) {
+        uint8_t* mapped_staging_memory = texture_data.device_memory.mapped_data;
+        if (nullptr == mapped_staging_memory) {
             std::string error_msg = "InitFromContent - Failed to map memory for staging buffer for linear texture \"";
             error_msg += texture_name;
             error_msg += "\"";
             logger.LogError(error_msg);
             return false;
         }
-        memcpy(mapped_staging_memory, raw_data, raw_data_size);
-        vkUnmapMemory(vk_device, texture_data.vk_device_memory);
+        for (uint32_t mip = 0; mip < num_mip_levels; ++mip) {
+            if (GLOBE_PIXEL_CONVERSION_NONE == conversion) {
+                memcpy(mapped_staging_memory, raw_data + (*levels)[mip].offset, (*levels)[mip].data_size);
+            } else {
+                GlobeConvertPixels(conversion, raw_data, mapped_staging_memory, (*levels)[mip].data_size / 4);
+            }
+            mapped_staging_memory += (*levels)[mip].data_size;
+        }
 
         // Make sure the image is loaded.
         if (!resource_manager->InsertImageLayoutTransitionBarrier(
-                texture_copy_cmd_buf, texture_data.vk_image, image_subresource_range, VK_PIPELINE_STAGE_HOST_BIT,
-                VK_IMAGE_LAYOUT_PREINITIALIZED, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                batch->GetVkGraphicsCommandBuffer(), texture_data.vk_image, image_subresource_range,
+                VK_PIPELINE_STAGE_HOST_BIT, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)) {
             std::string error_message =
                 "InitFromContent - Failed to add layout transition image barrier for texture \"";
@@ -644,60 +957,57 @@ bool GlobeTexture::InitFromContent(GlobeResourceManager* resource_manager, Globe
         }
     }
 
-    if (VK_SUCCESS != vkEndCommandBuffer(texture_copy_cmd_buf)) {
-        std::string error_message = "InitFromContent - Failed to end copy command buffer for texture \"";
-        error_message += texture_name;
-        error_message += "\"";
-        logger.LogError(error_message);
-        return false;
+    return true;
+}
+
+bool GlobeTexture::InitFromContent(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
+                                   VkDevice vk_device, const std::string& texture_name,
+                                   GlobeTextureData& texture_data) {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    uint32_t num_mip_levels = texture_data.num_mip_levels;
+    uint32_t num_layers = std::max(texture_data.array_layers, 1u);
+
+    // Without a batch from the caller, the texture gets a batch of its own which is submitted and
+    // waited on before we return.
+    GlobeUploadBatch* batch = upload_batch;
+    if (nullptr == batch) {
+        batch = resource_manager->BeginUploadBatch();
+        if (nullptr == batch) {
+            std::string error_msg = "InitFromContent - Failed starting upload batch for copying texture  \"";
+            error_msg += texture_name;
+            error_msg += "\"";
+            logger.LogError(error_msg);
+            return false;
+        }
     }
 
-    if (!submit_manager->Submit(texture_copy_cmd_buf, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, true)) {
-        std::string error_message = "InitFromContent - Failed submitting command buffer for copying into texture \"";
-        error_message += texture_name;
-        error_message += "\"";
-        logger.LogError(error_message);
-        return false;
+    bool uploaded = RecordContentUpload(resource_manager, batch, vk_device, texture_name, texture_data);
+    if (nullptr == upload_batch) {
+        // A batch freed without being submitted hands its staging space straight back to the ring.
+        bool submitted = uploaded && batch->Submit(true);
+        resource_manager->FreeUploadBatch(batch);
+        if (uploaded && !submitted) {
+            std::string error_message = "InitFromContent - Failed submitting upload batch for copying into texture \"";
+            error_message += texture_name;
+            error_message += "\"";
+            logger.LogError(error_message);
+        }
+        uploaded = submitted;
     }
-    if (!resource_manager->FreeCommandBuffer(texture_copy_cmd_buf)) {
-        std::string error_message = "InitFromContent - Failed freeing command buffer for copying into texture \"";
-        error_message += texture_name;
-        error_message += "\"";
-        logger.LogError(error_message);
+    if (!uploaded) {
+        FreeFailedContent(resource_manager, vk_device, nullptr != upload_batch, texture_data);
         return false;
     }
 
-    if (uses_staging) {
-        vkDestroyBuffer(vk_device, staging_buffer.vk_buffer, nullptr);
-        resource_manager->FreeDeviceMemory(staging_buffer.vk_memory);
-    }
-
-    // We're now ready to be read by a shader
+    // We're ready to be read by a shader once the upload batch has completed
     texture_data.vk_image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-    VkSamplerCreateInfo sampler_create_info = {};
-    sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    sampler_create_info.pNext = nullptr;
-    sampler_create_info.magFilter = VK_FILTER_LINEAR;
-    sampler_create_info.minFilter = VK_FILTER_LINEAR;
-    sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    sampler_create_info.mipLodBias = 0.0f;
-    sampler_create_info.anisotropyEnable = VK_FALSE;
-    sampler_create_info.maxAnisotropy = 1;
-    sampler_create_info.compareOp = VK_COMPARE_OP_NEVER;
-    sampler_create_info.minLod = 0.0f;
-    sampler_create_info.maxLod = 0.0f;
-    sampler_create_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-    sampler_create_info.unnormalizedCoordinates = VK_FALSE;
-
     VkImageViewCreateInfo image_view_create_info = {};
     image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     image_view_create_info.pNext = nullptr;
     image_view_create_info.image = VK_NULL_HANDLE;
-    image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    image_view_create_info.viewType =
+        texture_data.array_layers > 0 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
     image_view_create_info.format = texture_data.vk_format;
     image_view_create_info.components = {
         VK_COMPONENT_SWIZZLE_R,
@@ -705,77 +1015,159 @@ bool GlobeTexture::InitFromContent(GlobeResourceManager* resource_manager, Globe
         VK_COMPONENT_SWIZZLE_B,
         VK_COMPONENT_SWIZZLE_A,
     };
-    image_view_create_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    image_view_create_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, num_mip_levels, 0, num_layers};
     image_view_create_info.flags = 0;
 
-    if (VK_SUCCESS != vkCreateSampler(vk_device, &sampler_create_info, nullptr, &texture_data.vk_sampler)) {
+    VkSamplerCreateInfo sampler_create_info = GlobeSamplerCache::DefaultCreateInfo(static_cast<float>(num_mip_levels));
+    texture_data.vk_sampler = resource_manager->GetSamplerCache()->AcquireSampler(sampler_create_info);
+    if (VK_NULL_HANDLE == texture_data.vk_sampler) {
         logger.LogError("InitFromContent - Failed creating texture sampler for primary texture");
+        FreeFailedContent(resource_manager, vk_device, nullptr != upload_batch, texture_data);
         return false;
     }
 
     image_view_create_info.image = texture_data.vk_image;
     if (VK_SUCCESS != vkCreateImageView(vk_device, &image_view_create_info, nullptr, &texture_data.vk_image_view)) {
         logger.LogError("InitFromContent - Failed creating texture image view for primary texture");
+        FreeFailedContent(resource_manager, vk_device, nullptr != upload_batch, texture_data);
         return false;
     }
     return true;
 }
 
-GlobeTexture* GlobeTexture::LoadFromStandardFile(GlobeResourceManager* resource_manager,
-                                                 GlobeSubmitManager* submit_manager, VkDevice vk_device,
-                                                 bool generate_mipmaps, const std::string& texture_name,
-                                                 const std::string& directory) {
+void GlobeTexture::FreeFailedContent(GlobeResourceManager* resource_manager, VkDevice vk_device,
+                                     bool batch_pending, GlobeTextureData& texture_data) {
+    if (VK_NULL_HANDLE != texture_data.vk_sampler) {
+        resource_manager->GetSamplerCache()->ReleaseSampler(texture_data.vk_sampler);
+        texture_data.vk_sampler = VK_NULL_HANDLE;
+    }
+    VkImage vk_image = texture_data.vk_image;
+    GlobeDeviceMemory device_memory = texture_data.device_memory;
+    texture_data.vk_image = VK_NULL_HANDLE;
+    texture_data.device_memory = {};
+    if (VK_NULL_HANDLE == vk_image && VK_NULL_HANDLE == device_memory.vk_memory) {
+        return;
+    }
+    // Copies into the image may already sit in the caller's batch, which still gets submitted, so the
+    // image has to outlive it.  Our own batch is either finished or was never submitted.
+    if (batch_pending) {
+        resource_manager->DeferredFree([resource_manager, vk_device, vk_image, device_memory]() mutable {
+            vkDestroyImage(vk_device, vk_image, nullptr);
+            resource_manager->FreeDeviceMemory(device_memory);
+        });
+    } else {
+        vkDestroyImage(vk_device, vk_image, nullptr);
+        resource_manager->FreeDeviceMemory(device_memory);
+    }
+}
+
+bool GlobeTexture::LoadStandardFileContent(GlobeResourceManager* resource_manager, bool generate_mipmaps,
+                                           GlobeTextureCompression compression, const std::string& texture_name,
+                                           const std::string& directory, GlobeTextureData& texture_data) {
     GlobeLogger& logger = GlobeLogger::getInstance();
-    GlobeTextureData texture_data = {};
     std::string texture_file_name = directory;
     texture_file_name += texture_name;
 
-    if (!LoadStandardFile(resource_manager, texture_file_name, texture_data)) {
-        std::string error_message = "LoadFromStandardFile: Failed to load texture for file \"";
-        error_message += texture_file_name;
-        error_message += "\"";
-        logger.LogError(error_message);
-        return nullptr;
+    texture_data = {};
+    // Only compressed textures are cached, they save both the decode and the encode.
+    std::string cache_file_name;
+    uint64_t source_hash = 0;
+    if (GLOBE_TEXTURE_COMPRESSION_NONE != compression && resource_manager->UseStagingBuffer() &&
+        !resource_manager->CacheDirectory().empty()) {
+        GlobeFileView source_file;
+        if (source_file.Open(texture_file_name)) {
+            source_hash = GlobeHashData(source_file.Data(), source_file.Size());
+            cache_file_name = TextureCacheFileName(resource_manager->CacheDirectory(), texture_name, directory,
+                                                   compression, generate_mipmaps);
+            if (LoadTextureCache(resource_manager, cache_file_name, generate_mipmaps, source_hash, texture_data)) {
+                return true;
+            }
+        }
     }
-
-    GlobeTexture* texture_pointer = nullptr;
-    if (!InitFromContent(resource_manager, submit_manager, vk_device, texture_name, texture_data)) {
-        std::string error_message = "LoadFromStandardFile: Failed to setting up texture for Vulkan \"";
+    if (!LoadStandardFile(resource_manager, generate_mipmaps, compression, texture_file_name, texture_data)) {
+        std::string error_message = "LoadStandardFileContent: Failed to load texture for file \"";
         error_message += texture_file_name;
         error_message += "\"";
         logger.LogError(error_message);
-    } else {
-        texture_pointer = new GlobeTexture(resource_manager, vk_device, texture_name, &texture_data);
+        FreeContent(texture_data);
+        return false;
     }
-    delete texture_data.standard_data;
-    return texture_pointer;
+    if (!cache_file_name.empty() && VK_FORMAT_R8G8B8A8_UNORM != texture_data.vk_format) {
+        SaveTextureCache(cache_file_name, source_hash, texture_data);
+    }
+    return true;
 }
 
-GlobeTexture* GlobeTexture::LoadFromKtxFile(GlobeResourceManager* resource_manager, GlobeSubmitManager* submit_manager,
-                                            VkDevice vk_device, bool generate_mipmaps, const std::string& texture_name,
-                                            const std::string& directory) {
+bool GlobeTexture::LoadKtxFileContent(GlobeResourceManager* resource_manager, bool generate_mipmaps,
+                                      const std::string& texture_name, const std::string& directory,
+                                      GlobeTextureData& texture_data) {
     GlobeLogger& logger = GlobeLogger::getInstance();
-    GlobeTextureData texture_data = {};
     std::string texture_file_name = directory;
     texture_file_name += texture_name;
 
+    texture_data = {};
     if (!LoadKtxFile(resource_manager, generate_mipmaps, texture_file_name, texture_data)) {
-        std::string error_message = "LoadFromKtxFile - Failed to load texture for file \"";
+        std::string error_message = "LoadKtxFileContent - Failed to load texture for file \"";
         error_message += texture_file_name;
         error_message += "\"";
         logger.LogError(error_message);
-        return nullptr;
+        FreeContent(texture_data);
+        return false;
     }
+    return true;
+}
 
-    if (!InitFromContent(resource_manager, submit_manager, vk_device, texture_name, texture_data)) {
-        std::string error_message = "LoadFromKtxFile - Failed to setting up texture for Vulkan \"";
-        error_message += texture_file_name;
+void GlobeTexture::FreeContent(GlobeTextureData& texture_data) {
+    if (texture_data.uses_standard_data) {
+        delete texture_data.standard_data;
+        texture_data.standard_data = nullptr;
+    } else {
+        delete texture_data.ktx_data;
+        texture_data.ktx_data = nullptr;
+    }
+}
+
+GlobeTexture* GlobeTexture::CreateFromContent(GlobeResourceManager* resource_manager,
+                                              GlobeUploadBatch* upload_batch, VkDevice vk_device,
+                                              const std::string& texture_name, GlobeTextureData& texture_data) {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    GlobeTexture* texture_pointer = nullptr;
+    if (!InitFromContent(resource_manager, upload_batch, vk_device, texture_name, texture_data)) {
+        std::string error_message = "CreateFromContent: Failed to setting up texture for Vulkan \"";
+        error_message += texture_name;
         error_message += "\"";
         logger.LogError(error_message);
+    } else {
+        texture_pointer = new GlobeTexture(resource_manager, vk_device, texture_name, &texture_data);
+        // Texture content is never kept.  Only decoded texels count, KTX and cached content are file mappings.
+        if (texture_data.uses_standard_data) {
+            resource_manager->TrackHostCopy(0, texture_data.standard_data->raw_data.size());
+        }
+    }
+    FreeContent(texture_data);
+    return texture_pointer;
+}
+
+GlobeTexture* GlobeTexture::LoadFromStandardFile(GlobeResourceManager* resource_manager,
+                                                 GlobeUploadBatch* upload_batch, VkDevice vk_device,
+                                                 bool generate_mipmaps, GlobeTextureCompression compression,
+                                                 const std::string& texture_name, const std::string& directory) {
+    GlobeTextureData texture_data = {};
+    if (!LoadStandardFileContent(resource_manager, generate_mipmaps, compression, texture_name, directory,
+                                 texture_data)) {
         return nullptr;
     }
+    return CreateFromContent(resource_manager, upload_batch, vk_device, texture_name, texture_data);
+}
 
-    return new GlobeTexture(resource_manager, vk_device, texture_name, &texture_data);
+GlobeTexture* GlobeTexture::LoadFromKtxFile(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
+                                            VkDevice vk_device, bool generate_mipmaps, const std::string& texture_name,
+                                            const std::string& directory) {
+    GlobeTextureData texture_data = {};
+    if (!LoadKtxFileContent(resource_manager, generate_mipmaps, texture_name, directory, texture_data)) {
+        return nullptr;
+    }
+    return CreateFromContent(resource_manager, upload_batch, vk_device, texture_name, texture_data);
 }
 
 static bool IsStencilFormat(VkFormat vk_format) {
@@ -879,14 +1271,15 @@ GlobeTexture* GlobeTexture::CreateRenderTarget(GlobeResourceManager* resource_ma
     }
 
     if (!resource_manager->AllocateDeviceImageMemory(texture_data.vk_image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                                     texture_data.vk_device_memory, texture_data.vk_allocated_size)) {
+                                                     texture_data.device_memory)) {
         std::string error_msg = "Failed to allocate memory for render target ";
         error_msg += texture_name;
         logger.LogError(error_msg);
         return nullptr;
     }
 
-    if (VK_SUCCESS != vkBindImageMemory(vk_device, texture_data.vk_image, texture_data.vk_device_memory, 0)) {
+    if (VK_SUCCESS != vkBindImageMemory(vk_device, texture_data.vk_image, texture_data.device_memory.vk_memory,
+                                        texture_data.device_memory.vk_offset)) {
         std::string error_msg = "Failed to bind image to memory for render target ";
         error_msg += texture_name;
         logger.LogError(error_msg);
@@ -894,24 +1287,9 @@ GlobeTexture* GlobeTexture::CreateRenderTarget(GlobeResourceManager* resource_ma
     }
 
     if (is_color) {
-        VkSamplerCreateInfo sampler_create_info = {};
-        sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-        sampler_create_info.pNext = nullptr;
-        sampler_create_info.magFilter = VK_FILTER_LINEAR;
-        sampler_create_info.minFilter = VK_FILTER_LINEAR;
-        sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-        sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-        sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-        sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-        sampler_create_info.mipLodBias = 0.0f;
-        sampler_create_info.anisotropyEnable = VK_FALSE;
-        sampler_create_info.maxAnisotropy = 1;
-        sampler_create_info.compareOp = VK_COMPARE_OP_NEVER;
-        sampler_create_info.minLod = 0.0f;
-        sampler_create_info.maxLod = 0.0f;
-        sampler_create_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-        sampler_create_info.unnormalizedCoordinates = VK_FALSE;
-        if (VK_SUCCESS != vkCreateSampler(vk_device, &sampler_create_info, nullptr, &texture_data.vk_sampler)) {
+        VkSamplerCreateInfo sampler_create_info = GlobeSamplerCache::DefaultCreateInfo(0.0f);
+        texture_data.vk_sampler = resource_manager->GetSamplerCache()->AcquireSampler(sampler_create_info);
+        if (VK_NULL_HANDLE == texture_data.vk_sampler) {
             std::string error_msg = "Failed to create image sampler for render target ";
             error_msg += texture_name;
             logger.LogError(error_msg);
@@ -1001,14 +1379,13 @@ GlobeTexture::GlobeTexture(GlobeResourceManager* resource_manager, VkDevice vk_d
     _vk_sampler = texture_data->vk_sampler;
     _vk_image = texture_data->vk_image;
     _vk_image_layout = texture_data->vk_image_layout;
-    _vk_allocated_size = texture_data->vk_allocated_size;
-    _vk_device_memory = texture_data->vk_device_memory;
+    _device_memory = texture_data->device_memory;
     _vk_image_view = texture_data->vk_image_view;
 }
 
 GlobeTexture::~GlobeTexture() {
     if (VK_NULL_HANDLE != _vk_sampler) {
-        vkDestroySampler(_vk_device, _vk_sampler, nullptr);
+        _globe_resource_mgr->GetSamplerCache()->ReleaseSampler(_vk_sampler);
         _vk_sampler = VK_NULL_HANDLE;
     }
     if (VK_NULL_HANDLE != _vk_image_view) {
@@ -1016,5 +1393,5 @@ GlobeTexture::~GlobeTexture() {
         _vk_image_view = VK_NULL_HANDLE;
     }
     vkDestroyImage(_vk_device, _vk_image, nullptr);
-    _globe_resource_mgr->FreeDeviceMemory(_vk_device_memory);
+    _globe_resource_mgr->FreeDeviceMemory(_device_memory);
 }
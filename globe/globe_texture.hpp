@@ -13,8 +13,10 @@
 #include <vector>
 
 #include "vulkan/vulkan_core.h"
-
-#include <gli/gli.hpp>
+#include "globe_basic_types.hpp"
+#include "globe_file_view.hpp"
+#include "globe_pixel_convert.hpp"
+#include "globe_block_compressor.hpp"
 
 struct GlobeTextureLevel {
     uint32_t width;
@@ -23,9 +25,21 @@ struct GlobeTextureLevel {
     uint32_t offset;
 };
 
+// The levels describe the RGBA image, or the blocks when the image was compressed on load.  When conversion
+// is set, raw_data only holds the base level as decoded and it gets expanded to RGBA while it is written into
+// the staging buffer or the linear image.
 struct GlobeStandardTextureData {
     std::vector<uint8_t> raw_data;
     std::vector<GlobeTextureLevel> levels;
+    GlobePixelConversion conversion;
+};
+
+// KTX (and texture cache) levels are left in the mapped file, the level offsets are relative to the start
+// of the view.
+struct GlobeKtxTextureData {
+    GlobeFileView file_view;
+    VkDeviceSize texel_block_size;
+    std::vector<GlobeTextureLevel> levels;
 };
 
 struct GlobeTextureData {
@@ -36,42 +50,62 @@ struct GlobeTextureData {
     uint32_t width;
     uint32_t height;
     uint32_t num_mip_levels;
+    // Only the base level is uploaded, the remaining levels are blitted from it on the GPU.
+    bool blit_mipmaps;
+    // Number of layers of an array texture, or 0 for a plain 2D texture.  Each layer has num_mip_levels
+    // levels, and the levels of all layers are listed one layer after the other.
+    uint32_t array_layers;
     VkSampleCountFlagBits vk_sample_count;
     VkFormat vk_format;
     VkFormatProperties vk_format_props;
     VkSampler vk_sampler;
     VkImage vk_image;
     VkImageLayout vk_image_layout;
-    VkDeviceMemory vk_device_memory;
-    VkDeviceSize vk_allocated_size;
+    GlobeDeviceMemory device_memory;
     VkImageView vk_image_view;
     bool uses_standard_data;
     union {
         GlobeStandardTextureData* standard_data;
-        gli::texture2d* gli_texture_2d;
+        GlobeKtxTextureData* ktx_data;
     };
 };
 
 class GlobeResourceManager;
-class GlobeSubmitManager;
+class GlobeUploadBatch;
 
 class GlobeTexture {
    public:
-    static GlobeTexture* LoadFromStandardFile(GlobeResourceManager* resource_manager,
-                                              GlobeSubmitManager* submit_manager, VkDevice vk_device,
-                                              bool generate_mipmaps, const std::string& texture_name,
+    // When an upload batch is provided, the copies are only recorded into it and the texture can not be
+    // used until the batch has completed.  Otherwise the upload is submitted and waited on right away.
+    static GlobeTexture* LoadFromStandardFile(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
+                                              VkDevice vk_device, bool generate_mipmaps,
+                                              GlobeTextureCompression compression, const std::string& texture_name,
                                               const std::string& directory);
-    static GlobeTexture* LoadFromKtxFile(GlobeResourceManager* resource_manager, GlobeSubmitManager* submit_manager,
+    static GlobeTexture* LoadFromKtxFile(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
                                          VkDevice vk_device, bool generate_mipmaps, const std::string& texture_name,
                                          const std::string& directory);
-    static bool InitFromContent(GlobeResourceManager* resource_manager, GlobeSubmitManager* submit_manager,
+    // The *Content methods split loading into a CPU stage (file I/O and decode), which is safe to run on
+    // a worker thread, and a Vulkan stage (CreateFromContent) which must run on the submitting thread.
+    // Compressed images are written to a texture cache in the resource manager's cache directory, and later
+    // loads map the blocks from there as long as the source file hasn't changed.
+    static bool LoadStandardFileContent(GlobeResourceManager* resource_manager, bool generate_mipmaps,
+                                        GlobeTextureCompression compression, const std::string& texture_name,
+                                        const std::string& directory, GlobeTextureData& texture_data);
+    static bool LoadKtxFileContent(GlobeResourceManager* resource_manager, bool generate_mipmaps,
+                                   const std::string& texture_name, const std::string& directory,
+                                   GlobeTextureData& texture_data);
+    static GlobeTexture* CreateFromContent(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
+                                           VkDevice vk_device, const std::string& texture_name,
+                                           GlobeTextureData& texture_data);
+    static void FreeContent(GlobeTextureData& texture_data);
+    static bool InitFromContent(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
                                 VkDevice vk_device, const std::string& texture_name, GlobeTextureData& texture_data);
     static GlobeTexture* CreateRenderTarget(GlobeResourceManager* resource_manager, VkDevice vk_device, uint32_t width,
                                             uint32_t height, VkFormat vk_format);
 
     GlobeTexture(GlobeResourceManager* resource_manager, VkDevice vk_device, const std::string& texture_name,
                  GlobeTextureData* texture_data);
-    ~GlobeTexture();
+    virtual ~GlobeTexture();
 
     uint32_t NextPowerOfTwo(uint32_t value);
 
@@ -87,6 +121,15 @@ class GlobeTexture {
     VkAttachmentReference GenVkAttachmentReference(uint32_t attachment_index);
 
    protected:
+    // Records the image creation and copies for InitFromContent into the given batch.
+    static bool RecordContentUpload(GlobeResourceManager* resource_manager, GlobeUploadBatch* batch,
+                                    VkDevice vk_device, const std::string& texture_name,
+                                    GlobeTextureData& texture_data);
+    // Releases whatever a failed InitFromContent created.  With the caller's batch still pending, the
+    // image is only destroyed through the resource manager's deferred frees.
+    static void FreeFailedContent(GlobeResourceManager* resource_manager, VkDevice vk_device, bool batch_pending,
+                                  GlobeTextureData& texture_data);
+
     bool _setup_for_render_target;
     bool _is_color;
     bool _is_depth;
@@ -104,7 +147,6 @@ class GlobeTexture {
     VkSampler _vk_sampler;
     VkImage _vk_image;
     VkImageLayout _vk_image_layout;
-    VkDeviceMemory _vk_device_memory;
-    VkDeviceSize _vk_allocated_size;
+    GlobeDeviceMemory _device_memory;
     VkImageView _vk_image_view;
 };
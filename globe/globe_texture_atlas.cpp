@@ -0,0 +1,351 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_texture_atlas.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#include "globe_logger.hpp"
+#include "globe_resource_manager.hpp"
+#include "globe_thread_pool.hpp"
+#include "globe_mipmap_generator.hpp"
+#include "globe_texture_atlas.hpp"
+
+// Skyline bottom-left rectangle packer.  The skyline is the top edge of everything placed so far, kept as
+// horizontal segments from left to right that together span the whole width.
+class GlobeSkylinePacker {
+   public:
+    GlobeSkylinePacker(uint32_t width, uint32_t height) : _width(width), _height(height) {
+        Segment segment = {0, 0, width};
+        _skyline.push_back(segment);
+    }
+
+    // Places the rectangle where its top ends up lowest, preferring the narrower segment on ties.
+    bool Insert(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y) {
+        size_t best_index = _skyline.size();
+        uint32_t best_top = UINT_MAX;
+        uint32_t best_width = UINT_MAX;
+        for (size_t index = 0; index < _skyline.size(); ++index) {
+            uint32_t cur_y = 0;
+            if (Fits(index, width, height, cur_y) &&
+                (cur_y + height < best_top || (cur_y + height == best_top && _skyline[index].width < best_width))) {
+                best_index = index;
+                best_top = cur_y + height;
+                best_width = _skyline[index].width;
+                x = _skyline[index].x;
+                y = cur_y;
+            }
+        }
+        if (best_index == _skyline.size()) {
+            return false;
+        }
+
+        // The rectangle's top becomes a new segment, cutting back or removing the segments it now covers.
+        Segment new_segment = {x, y + height, width};
+        _skyline.insert(_skyline.begin() + best_index, new_segment);
+        uint32_t covered_end = x + width;
+        size_t index = best_index + 1;
+        while (index < _skyline.size() && _skyline[index].x < covered_end) {
+            uint32_t overlap = covered_end - _skyline[index].x;
+            if (_skyline[index].width <= overlap) {
+                _skyline.erase(_skyline.begin() + index);
+            } else {
+                _skyline[index].x += overlap;
+                _skyline[index].width -= overlap;
+                break;
+            }
+        }
+        for (index = 0; index + 1 < _skyline.size();) {
+            if (_skyline[index].y == _skyline[index + 1].y) {
+                _skyline[index].width += _skyline[index + 1].width;
+                _skyline.erase(_skyline.begin() + index + 1);
+            } else {
+                ++index;
+            }
+        }
+        return true;
+    }
+
+   private:
+    struct Segment {
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;
+    };
+
+    // A rectangle starting at a segment rests on the highest segment underneath it.
+    bool Fits(size_t index, uint32_t width, uint32_t height, uint32_t& y) const {
+        if (_skyline[index].x + width > _width) {
+            return false;
+        }
+        y = 0;
+        uint32_t covered = 0;
+        for (size_t cur = index; covered < width; ++cur) {
+            y = std::max(y, _skyline[cur].y);
+            if (y + height > _height) {
+                return false;
+            }
+            covered += _skyline[cur].width;
+        }
+        return true;
+    }
+
+    uint32_t _width;
+    uint32_t _height;
+    std::vector<Segment> _skyline;
+};
+
+struct GlobeAtlasSlot {
+    uint32_t layer;
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+};
+
+static uint32_t AlignUp(uint32_t value, uint32_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+static uint32_t NextPowerOfTwo(uint32_t value) {
+    uint32_t power = 1;
+    while (power < value) {
+        power <<= 1;
+    }
+    return power;
+}
+
+// Packs every slot into layers of layer_size, returning the number of layers used or 0 if that takes more than
+// GLOBE_TEXTURE_ATLAS_MAX_LAYERS.
+static uint32_t PackSlots(uint32_t layer_size, const std::vector<uint32_t>& order, std::vector<GlobeAtlasSlot>& slots) {
+    std::vector<GlobeSkylinePacker> packers;
+    for (auto index : order) {
+        GlobeAtlasSlot& slot = slots[index];
+        slot.layer = 0;
+        while (slot.layer < packers.size() && !packers[slot.layer].Insert(slot.width, slot.height, slot.x, slot.y)) {
+            slot.layer++;
+        }
+        if (slot.layer == packers.size()) {
+            if (packers.size() == GLOBE_TEXTURE_ATLAS_MAX_LAYERS) {
+                return 0;
+            }
+            // Every slot fits an empty layer, the caller checked that.
+            packers.push_back(GlobeSkylinePacker(layer_size, layer_size));
+            packers.back().Insert(slot.width, slot.height, slot.x, slot.y);
+        }
+    }
+    return static_cast<uint32_t>(packers.size());
+}
+
+// Copies an image into its slot, expanding it to RGBA and repeating its edge texels out to the slot's border.
+static void CopyIntoSlot(const GlobeStandardTextureData& image, const GlobeAtlasSlot& slot, uint32_t layer_size,
+                         uint8_t* layer_data) {
+    const GlobeTextureLevel& level = image.levels[0];
+    const uint32_t padding = GLOBE_TEXTURE_ATLAS_PADDING;
+    uint32_t src_texel_size = GlobePixelConversionSourceSize(image.conversion);
+    uint32_t left = padding;
+    uint32_t right = slot.width - padding - level.width;
+    for (uint32_t row = 0; row < slot.height; ++row) {
+        uint32_t src_row = std::min(std::max(row, padding) - padding, level.height - 1);
+        const uint8_t* src = image.raw_data.data() + static_cast<size_t>(src_row) * level.width * src_texel_size;
+        uint8_t* dst = layer_data + (static_cast<size_t>(slot.y + row) * layer_size + slot.x) * 4;
+        GlobeConvertPixels(image.conversion, src, dst + left * 4, level.width);
+        for (uint32_t col = 0; col < left; ++col) {
+            memcpy(dst + col * 4, dst + left * 4, 4);
+        }
+        uint8_t* last_texel = dst + (left + level.width - 1) * 4;
+        for (uint32_t col = 1; col <= right; ++col) {
+            memcpy(last_texel + col * 4, last_texel, 4);
+        }
+    }
+}
+
+GlobeTextureAtlas* GlobeTextureAtlas::Load(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
+                                           VkDevice vk_device, bool generate_mipmaps,
+                                           const std::vector<std::string>& texture_names,
+                                           const std::string& directory) {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    if (texture_names.empty()) {
+        logger.LogError("GlobeTextureAtlas::Load - No textures to pack");
+        return nullptr;
+    }
+    if (!resource_manager->UseStagingBuffer()) {
+        logger.LogError("GlobeTextureAtlas::Load - Texture atlases can only be uploaded with a staging buffer");
+        return nullptr;
+    }
+
+    // Decode all the images at once, they stay in their decoded layout until they are copied into a layer.
+    uint32_t num_images = static_cast<uint32_t>(texture_names.size());
+    std::vector<GlobeTextureData> images(num_images);
+    std::vector<uint8_t> images_loaded(num_images, 0);
+    GlobeThreadPool* thread_pool = resource_manager->GetThreadPool();
+    thread_pool->ParallelFor(num_images, [&](uint32_t index) {
+        images_loaded[index] = LoadStandardFileContent(resource_manager, false, GLOBE_TEXTURE_COMPRESSION_NONE,
+                                                       texture_names[index], directory, images[index]);
+    });
+    bool valid = true;
+    for (uint32_t index = 0; index < num_images; ++index) {
+        if (!images_loaded[index]) {
+            std::string error_msg = "GlobeTextureAtlas::Load - Failed loading texture ";
+            error_msg += texture_names[index];
+            logger.LogError(error_msg);
+            valid = false;
+        }
+    }
+
+    // Slots are the image plus padding, rounded up so every slot starts on a multiple of the padding.
+    const uint32_t padding = GLOBE_TEXTURE_ATLAS_PADDING;
+    const uint32_t max_layer_size = GLOBE_TEXTURE_ATLAS_LAYER_SIZE;
+    std::vector<GlobeAtlasSlot> slots(num_images);
+    uint64_t total_area = 0;
+    uint32_t largest_side = 0;
+    for (uint32_t index = 0; valid && index < num_images; ++index) {
+        const GlobeTextureLevel& level = images[index].standard_data->levels[0];
+        slots[index].width = AlignUp(level.width + 2 * padding, padding);
+        slots[index].height = AlignUp(level.height + 2 * padding, padding);
+        if (slots[index].width > max_layer_size || slots[index].height > max_layer_size) {
+            std::string error_msg = "GlobeTextureAtlas::Load - Texture ";
+            error_msg += texture_names[index];
+            error_msg += " is too large for an atlas layer";
+            logger.LogError(error_msg);
+            valid = false;
+        }
+        total_area += static_cast<uint64_t>(slots[index].width) * slots[index].height;
+        largest_side = std::max(largest_side, std::max(slots[index].width, slots[index].height));
+    }
+
+    // Tallest first, which keeps the skyline flat.  Start with the smallest power of two layer that could
+    // hold everything and only grow it while the images spill into more layers.
+    std::vector<uint32_t> order(num_images);
+    for (uint32_t index = 0; index < num_images; ++index) {
+        order[index] = index;
+    }
+    std::stable_sort(order.begin(), order.end(), [&slots](uint32_t first, uint32_t second) {
+        return slots[first].height > slots[second].height ||
+               (slots[first].height == slots[second].height && slots[first].width > slots[second].width);
+    });
+    uint32_t layer_size = NextPowerOfTwo(
+        std::max(largest_side, static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(total_area))))));
+    layer_size = std::min(layer_size, max_layer_size);
+    uint32_t num_layers = 0;
+    while (valid) {
+        num_layers = PackSlots(layer_size, order, slots);
+        if (1 == num_layers || max_layer_size == layer_size) {
+            break;
+        }
+        layer_size *= 2;
+    }
+    // Level offsets are 32-bit, which also keeps the atlas to a sensible amount of memory.
+    uint64_t atlas_size = static_cast<uint64_t>(layer_size) * layer_size * 4 * num_layers;
+    if (valid && (0 == num_layers || atlas_size > UINT_MAX / 2)) {
+        logger.LogError("GlobeTextureAtlas::Load - Textures don't fit in the maximum number of atlas layers");
+        valid = false;
+    }
+    if (!valid) {
+        for (auto& image : images) {
+            FreeContent(image);
+        }
+        return nullptr;
+    }
+
+    // Each mip level halves the padding, so the chain stops at the level with a single texel of it left.
+    uint32_t num_mip_levels = 1;
+    size_t layer_data_size = static_cast<size_t>(layer_size) * layer_size * 4;
+    if (generate_mipmaps) {
+        uint32_t padding_levels = 1;
+        while ((1u << padding_levels) <= padding) {
+            padding_levels++;
+        }
+        num_mip_levels = std::min(GlobeMipmapGenerator::NumMipLevels(layer_size, layer_size), padding_levels);
+        layer_data_size = GlobeMipmapGenerator::MipChainSize(layer_size, layer_size);
+    }
+
+    GlobeTextureData texture_data = {};
+    texture_data.setup_for_render_target = false;
+    texture_data.vk_format = VK_FORMAT_R8G8B8A8_UNORM;
+    texture_data.vk_format_props = resource_manager->GetVkFormatProperties(texture_data.vk_format);
+    texture_data.width = layer_size;
+    texture_data.height = layer_size;
+    texture_data.num_mip_levels = num_mip_levels;
+    texture_data.blit_mipmaps = false;
+    texture_data.array_layers = num_layers;
+    texture_data.uses_standard_data = true;
+    texture_data.standard_data = new GlobeStandardTextureData();
+    texture_data.standard_data->conversion = GLOBE_PIXEL_CONVERSION_NONE;
+    std::vector<uint8_t>& raw_data = texture_data.standard_data->raw_data;
+    raw_data.resize(layer_data_size * num_layers);
+
+    // Slots never overlap, so the images can all be copied at once.
+    thread_pool->ParallelFor(num_images, [&](uint32_t index) {
+        CopyIntoSlot(*images[index].standard_data, slots[index], layer_size,
+                     raw_data.data() + slots[index].layer * layer_data_size);
+    });
+    std::vector<GlobeTextureAtlasEntry> entries(num_images);
+    for (uint32_t index = 0; index < num_images; ++index) {
+        const GlobeTextureLevel& level = images[index].standard_data->levels[0];
+        float texel_size = 1.0f / static_cast<float>(layer_size);
+        entries[index].uv_min[0] = static_cast<float>(slots[index].x + padding) * texel_size;
+        entries[index].uv_min[1] = static_cast<float>(slots[index].y + padding) * texel_size;
+        entries[index].uv_max[0] = entries[index].uv_min[0] + static_cast<float>(level.width) * texel_size;
+        entries[index].uv_max[1] = entries[index].uv_min[1] + static_cast<float>(level.height) * texel_size;
+        entries[index].layer = slots[index].layer;
+        entries[index].width = level.width;
+        entries[index].height = level.height;
+        FreeContent(images[index]);
+    }
+
+    GlobeMipmapGenerator mipmap_generator(thread_pool);
+    for (uint32_t layer = 0; layer < num_layers; ++layer) {
+        if (generate_mipmaps) {
+            mipmap_generator.Generate(raw_data.data() + layer * layer_data_size, layer_size, layer_size);
+        }
+        uint32_t offset = static_cast<uint32_t>(layer * layer_data_size);
+        for (uint32_t mip = 0; mip < num_mip_levels; ++mip) {
+            GlobeTextureLevel level_data = {};
+            level_data.width = std::max(layer_size >> mip, 1u);
+            level_data.height = level_data.width;
+            level_data.data_size = level_data.width * level_data.height * 4;
+            level_data.offset = offset;
+            texture_data.standard_data->levels.push_back(level_data);
+            offset += level_data.data_size;
+        }
+    }
+
+    std::string atlas_name = "texture_atlas_";
+    atlas_name += std::to_string(num_images);
+    atlas_name += "_";
+    atlas_name += texture_names[0];
+    std::string info_msg = "GlobeTextureAtlas::Load - Packed ";
+    info_msg += std::to_string(num_images);
+    info_msg += " textures into ";
+    info_msg += std::to_string(num_layers);
+    info_msg += " layers of ";
+    info_msg += std::to_string(layer_size);
+    info_msg += "x";
+    info_msg += std::to_string(layer_size);
+    logger.LogInfo(info_msg);
+
+    GlobeTextureAtlas* atlas = nullptr;
+    if (!InitFromContent(resource_manager, upload_batch, vk_device, atlas_name, texture_data)) {
+        std::string error_msg = "GlobeTextureAtlas::Load - Failed setting up atlas texture for Vulkan \"";
+        error_msg += atlas_name;
+        error_msg += "\"";
+        logger.LogError(error_msg);
+    } else {
+        atlas = new GlobeTextureAtlas(resource_manager, vk_device, atlas_name, &texture_data, entries);
+    }
+    FreeContent(texture_data);
+    return atlas;
+}
+
+GlobeTextureAtlas::GlobeTextureAtlas(GlobeResourceManager* resource_manager, VkDevice vk_device,
+                                     const std::string& texture_name, GlobeTextureData* texture_data,
+                                     const std::vector<GlobeTextureAtlasEntry>& entries)
+    : GlobeTexture(resource_manager, vk_device, texture_name, texture_data),
+      _num_layers(std::max(texture_data->array_layers, 1u)),
+      _entries(entries) {}
@@ -0,0 +1,56 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_texture_atlas.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "globe_texture.hpp"
+
+// Width and height of every layer of an atlas.
+#define GLOBE_TEXTURE_ATLAS_LAYER_SIZE 2048
+// Texels of repeated edge around every image, and the alignment of the images inside a layer.  Together they
+// keep the images apart down to mip level log2(padding), which is where an atlas' mip chain stops.
+#define GLOBE_TEXTURE_ATLAS_PADDING 4
+// The smallest maxImageArrayLayers a device may report.
+#define GLOBE_TEXTURE_ATLAS_MAX_LAYERS 256
+
+// Where an image ended up in the atlas.  The coordinates are normalized and cover exactly the image's texels
+// in its layer, so they can be used as is with a sampler2DArray.
+struct GlobeTextureAtlasEntry {
+    float uv_min[2];
+    float uv_max[2];
+    uint32_t layer;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Packs many small images into the layers of a single 2D array texture, so a scene can draw all of them with
+// one descriptor.  Images are placed with a skyline bottom-left packer, largest first, and a new layer is
+// started whenever one doesn't fit in the current layers.  Only standard image files (PNG/JPEG) can be
+// packed, and atlases are always uploaded through the staging buffer.
+class GlobeTextureAtlas : public GlobeTexture {
+   public:
+    static GlobeTextureAtlas* Load(GlobeResourceManager* resource_manager, GlobeUploadBatch* upload_batch,
+                                   VkDevice vk_device, bool generate_mipmaps,
+                                   const std::vector<std::string>& texture_names, const std::string& directory);
+
+    GlobeTextureAtlas(GlobeResourceManager* resource_manager, VkDevice vk_device, const std::string& texture_name,
+                      GlobeTextureData* texture_data, const std::vector<GlobeTextureAtlasEntry>& entries);
+
+    uint32_t NumLayers() const { return _num_layers; }
+    // Entries are in the order of the names the atlas was loaded from.
+    uint32_t NumEntries() const { return static_cast<uint32_t>(_entries.size()); }
+    const GlobeTextureAtlasEntry& Entry(uint32_t index) const { return _entries[index]; }
+
+   private:
+    uint32_t _num_layers;
+    std::vector<GlobeTextureAtlasEntry> _entries;
+};
@@ -0,0 +1,97 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_thread_pool.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "globe_thread_pool.hpp"
+
+GlobeThreadPool::GlobeThreadPool(uint32_t num_threads) : _shutting_down(false) {
+    if (num_threads == 0) {
+        num_threads = 1;
+    }
+    for (uint32_t thread = 0; thread < num_threads; ++thread) {
+        _threads.push_back(std::thread(&GlobeThreadPool::WorkerLoop, this));
+    }
+}
+
+GlobeThreadPool::~GlobeThreadPool() {
+    // Anything already queued still runs, since the owner may be waiting on the results.
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _shutting_down = true;
+    }
+    _job_available.notify_all();
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+    _threads.clear();
+}
+
+void GlobeThreadPool::Enqueue(const std::function<void()>& job) {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _jobs.push_back(job);
+    }
+    _job_available.notify_one();
+}
+
+void GlobeThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func) {
+    struct ParallelForState {
+        std::function<void(uint32_t)> func;
+        uint32_t count;
+        std::atomic<uint32_t> next_item;
+        std::atomic<uint32_t> remaining_items;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    if (0 == count) {
+        return;
+    }
+    // Helpers may only get to run after everything is done, so they share the state instead of
+    // referencing this stack frame.
+    std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+    state->func = func;
+    state->count = count;
+    state->next_item = 0;
+    state->remaining_items = count;
+    auto run_items = [state]() {
+        for (uint32_t item = state->next_item++; item < state->count; item = state->next_item++) {
+            state->func(item);
+            if (1 == state->remaining_items--) {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+    uint32_t num_helpers = std::min(count - 1, NumThreads());
+    for (uint32_t helper = 0; helper < num_helpers; ++helper) {
+        Enqueue(run_items);
+    }
+    run_items();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state] { return 0 == state->remaining_items.load(); });
+}
+
+void GlobeThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _job_available.wait(lock, [this] { return _shutting_down || !_jobs.empty(); });
+            if (_jobs.empty()) {
+                return;
+            }
+            job = _jobs.front();
+            _jobs.pop_front();
+        }
+        job();
+    }
+}
@@ -0,0 +1,40 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_thread_pool.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Simple fixed-size pool of worker threads which pull jobs off of a shared FIFO queue.
+// Jobs must not touch Vulkan objects that require external synchronization.
+class GlobeThreadPool {
+   public:
+    GlobeThreadPool(uint32_t num_threads);
+    ~GlobeThreadPool();
+
+    void Enqueue(const std::function<void()>& job);
+    // Runs func(0) through func(count - 1) spread over the workers and the calling thread, and returns once
+    // all of them are done.  Since the caller works through the items itself, this may be called from a job.
+    void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func);
+    uint32_t NumThreads() const { return static_cast<uint32_t>(_threads.size()); }
+
+   private:
+    void WorkerLoop();
+
+    std::mutex _mutex;
+    std::condition_variable _job_available;
+    std::deque<std::function<void()>> _jobs;
+    std::vector<std::thread> _threads;
+    bool _shutting_down;
+};
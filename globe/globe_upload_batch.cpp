@@ -0,0 +1,285 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_upload_batch.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#include "globe_logger.hpp"
+#include "globe_resource_manager.hpp"
+#include "globe_submit_manager.hpp"
+#include "globe_upload_batch.hpp"
+
+GlobeUploadBatch::GlobeUploadBatch(GlobeResourceManager* resource_manager, GlobeSubmitManager* submit_manager,
+                                   VkDevice vk_device)
+    : _globe_resource_mgr(resource_manager),
+      _globe_submit_mgr(submit_manager),
+      _vk_device(vk_device),
+      _uses_transfer_queue(resource_manager->UsesTransferQueue()),
+      _graphics_queue_family_index(resource_manager->GraphicsQueueFamilyIndex()),
+      _transfer_queue_family_index(resource_manager->TransferQueueFamilyIndex()),
+      _vk_command_buffer(VK_NULL_HANDLE),
+      _vk_acquire_command_buffer(VK_NULL_HANDLE),
+      _vk_semaphore(VK_NULL_HANDLE),
+      _vk_fence(VK_NULL_HANDLE),
+      _recording(false),
+      _submitted(false),
+      _complete(false),
+      _num_submits(0) {}
+
+GlobeUploadBatch::~GlobeUploadBatch() {
+    if (_submitted && !_complete) {
+        Wait();
+    }
+    if (!_submitted) {
+        // Never sent, so nothing on the GPU will ever read this staging space.
+        ReleaseStagingAllocations();
+    }
+    if (_recording) {
+        vkEndCommandBuffer(_vk_command_buffer);
+        if (VK_NULL_HANDLE != _vk_acquire_command_buffer) {
+            vkEndCommandBuffer(_vk_acquire_command_buffer);
+        }
+    }
+    if (VK_NULL_HANDLE != _vk_command_buffer) {
+        _globe_resource_mgr->FreeTransferCommandBuffer(_vk_command_buffer);
+    }
+    if (VK_NULL_HANDLE != _vk_acquire_command_buffer) {
+        _globe_resource_mgr->FreeCommandBuffer(_vk_acquire_command_buffer);
+    }
+    if (VK_NULL_HANDLE != _vk_semaphore) {
+        vkDestroySemaphore(_vk_device, _vk_semaphore, nullptr);
+        _vk_semaphore = VK_NULL_HANDLE;
+    }
+    if (VK_NULL_HANDLE != _vk_fence) {
+        vkDestroyFence(_vk_device, _vk_fence, nullptr);
+        _vk_fence = VK_NULL_HANDLE;
+    }
+}
+
+bool GlobeUploadBatch::Begin() {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    VkFenceCreateInfo fence_create_info = {};
+    fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_create_info.pNext = nullptr;
+    fence_create_info.flags = 0;
+    if (VK_SUCCESS != vkCreateFence(_vk_device, &fence_create_info, nullptr, &_vk_fence)) {
+        logger.LogError("GlobeUploadBatch::Begin - Failed to create upload fence");
+        _vk_fence = VK_NULL_HANDLE;
+        return false;
+    }
+    if (!_globe_resource_mgr->AllocateTransferCommandBuffer(_vk_command_buffer)) {
+        logger.LogError("GlobeUploadBatch::Begin - Failed to allocate upload command buffer");
+        _vk_command_buffer = VK_NULL_HANDLE;
+        return false;
+    }
+    if (_uses_transfer_queue) {
+        VkSemaphoreCreateInfo semaphore_create_info = {};
+        semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphore_create_info.pNext = nullptr;
+        semaphore_create_info.flags = 0;
+        if (VK_SUCCESS != vkCreateSemaphore(_vk_device, &semaphore_create_info, nullptr, &_vk_semaphore)) {
+            logger.LogError("GlobeUploadBatch::Begin - Failed to create transfer semaphore");
+            _vk_semaphore = VK_NULL_HANDLE;
+            return false;
+        }
+        if (!_globe_resource_mgr->AllocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, _vk_acquire_command_buffer)) {
+            logger.LogError("GlobeUploadBatch::Begin - Failed to allocate ownership acquire command buffer");
+            _vk_acquire_command_buffer = VK_NULL_HANDLE;
+            return false;
+        }
+    }
+    return BeginCommandBuffers();
+}
+
+bool GlobeUploadBatch::BeginCommandBuffers() {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    VkCommandBufferBeginInfo cmd_buf_begin_info = {};
+    cmd_buf_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmd_buf_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (VK_SUCCESS != vkBeginCommandBuffer(_vk_command_buffer, &cmd_buf_begin_info)) {
+        logger.LogError("GlobeUploadBatch - Failed to begin upload command buffer");
+        return false;
+    }
+    if (VK_NULL_HANDLE != _vk_acquire_command_buffer &&
+        VK_SUCCESS != vkBeginCommandBuffer(_vk_acquire_command_buffer, &cmd_buf_begin_info)) {
+        logger.LogError("GlobeUploadBatch - Failed to begin ownership acquire command buffer");
+        vkEndCommandBuffer(_vk_command_buffer);
+        return false;
+    }
+    _recording = true;
+    return true;
+}
+
+bool GlobeUploadBatch::FinishImage(VkImage vk_image, const VkImageSubresourceRange& vk_subresource_range,
+                                   VkImageLayout vk_target_layout, VkPipelineStageFlags vk_target_stage) {
+    if (!_uses_transfer_queue) {
+        return _globe_resource_mgr->InsertImageLayoutTransitionBarrier(
+            _vk_command_buffer, vk_image, vk_subresource_range, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, vk_target_stage, vk_target_layout);
+    }
+
+    VkAccessFlags vk_target_access = VK_ACCESS_MEMORY_READ_BIT;
+    if (VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL == vk_target_layout) {
+        vk_target_access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+    } else if (VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL == vk_target_layout) {
+        vk_target_access = VK_ACCESS_TRANSFER_READ_BIT;
+    } else if (VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL == vk_target_layout) {
+        vk_target_access = VK_ACCESS_TRANSFER_WRITE_BIT;
+    }
+
+    // The release and acquire halves must describe the same layout transition and queue families.
+    VkImageMemoryBarrier image_memory_barrier = {};
+    image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    image_memory_barrier.pNext = nullptr;
+    image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    image_memory_barrier.dstAccessMask = 0;
+    image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    image_memory_barrier.newLayout = vk_target_layout;
+    image_memory_barrier.srcQueueFamilyIndex = _transfer_queue_family_index;
+    image_memory_barrier.dstQueueFamilyIndex = _graphics_queue_family_index;
+    image_memory_barrier.image = vk_image;
+    image_memory_barrier.subresourceRange = vk_subresource_range;
+    vkCmdPipelineBarrier(_vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+
+    // The acquire submit waits on the transfer semaphore at all commands, so chain off of that.
+    image_memory_barrier.srcAccessMask = 0;
+    image_memory_barrier.dstAccessMask = vk_target_access;
+    vkCmdPipelineBarrier(_vk_acquire_command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, vk_target_stage, 0, 0,
+                         nullptr, 0, nullptr, 1, &image_memory_barrier);
+    return true;
+}
+
+bool GlobeUploadBatch::FinishBuffer(VkBuffer vk_buffer, VkDeviceSize vk_offset, VkDeviceSize vk_size,
+                                    VkAccessFlags vk_target_access, VkPipelineStageFlags vk_target_stage) {
+    VkBufferMemoryBarrier buffer_memory_barrier = {};
+    buffer_memory_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    buffer_memory_barrier.pNext = nullptr;
+    buffer_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    buffer_memory_barrier.dstAccessMask = vk_target_access;
+    buffer_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    buffer_memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    buffer_memory_barrier.buffer = vk_buffer;
+    buffer_memory_barrier.offset = vk_offset;
+    buffer_memory_barrier.size = vk_size;
+    if (!_uses_transfer_queue) {
+        vkCmdPipelineBarrier(_vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, vk_target_stage, 0, 0, nullptr, 1,
+                             &buffer_memory_barrier, 0, nullptr);
+        return true;
+    }
+
+    buffer_memory_barrier.dstAccessMask = 0;
+    buffer_memory_barrier.srcQueueFamilyIndex = _transfer_queue_family_index;
+    buffer_memory_barrier.dstQueueFamilyIndex = _graphics_queue_family_index;
+    vkCmdPipelineBarrier(_vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                         0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+
+    buffer_memory_barrier.srcAccessMask = 0;
+    buffer_memory_barrier.dstAccessMask = vk_target_access;
+    vkCmdPipelineBarrier(_vk_acquire_command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, vk_target_stage, 0, 0,
+                         nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+    return true;
+}
+
+bool GlobeUploadBatch::EndAndSubmit() {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    if (!_recording) {
+        logger.LogError("GlobeUploadBatch - Attempting to submit a batch that is not recording");
+        return false;
+    }
+    _recording = false;
+    if (VK_SUCCESS != vkEndCommandBuffer(_vk_command_buffer)) {
+        logger.LogError("GlobeUploadBatch - Failed to end upload command buffer");
+        return false;
+    }
+    if (_uses_transfer_queue) {
+        if (VK_SUCCESS != vkEndCommandBuffer(_vk_acquire_command_buffer)) {
+            logger.LogError("GlobeUploadBatch - Failed to end ownership acquire command buffer");
+            return false;
+        }
+        if (!_globe_submit_mgr->SubmitTransfer(_vk_command_buffer, _vk_semaphore, VK_NULL_HANDLE)) {
+            logger.LogError("GlobeUploadBatch - Failed to submit upload command buffer");
+            return false;
+        }
+        if (!_globe_submit_mgr->Submit(_vk_acquire_command_buffer, _vk_semaphore, VK_NULL_HANDLE, _vk_fence, false,
+                                       VK_PIPELINE_STAGE_ALL_COMMANDS_BIT)) {
+            logger.LogError("GlobeUploadBatch - Failed to submit ownership acquire command buffer");
+            // The transfer half is already running and the fence will never cover it, so let it finish before
+            // anyone frees its staging space, command buffer or semaphore.
+            _globe_submit_mgr->WaitTransferQueueIdle();
+            return false;
+        }
+    } else if (!_globe_submit_mgr->Submit(_vk_command_buffer, VK_NULL_HANDLE, VK_NULL_HANDLE, _vk_fence, false)) {
+        logger.LogError("GlobeUploadBatch - Failed to submit upload command buffer");
+        return false;
+    }
+    _submitted = true;
+    _complete = false;
+    _num_submits++;
+    return true;
+}
+
+bool GlobeUploadBatch::Flush() {
+    GlobeLogger& logger = GlobeLogger::getInstance();
+    if (!EndAndSubmit() || !Wait()) {
+        return false;
+    }
+    if (VK_SUCCESS != vkResetFences(_vk_device, 1, &_vk_fence)) {
+        logger.LogError("GlobeUploadBatch::Flush - Failed to reset upload fence");
+        return false;
+    }
+    if (!BeginCommandBuffers()) {
+        logger.LogError("GlobeUploadBatch::Flush - Failed to restart upload command buffers");
+        return false;
+    }
+    _submitted = false;
+    _complete = false;
+    return true;
+}
+
+bool GlobeUploadBatch::Submit(bool wait_for_completion) {
+    if (!EndAndSubmit()) {
+        return false;
+    }
+    if (wait_for_completion) {
+        return Wait();
+    }
+    return true;
+}
+
+bool GlobeUploadBatch::IsComplete() {
+    if (!_submitted) {
+        return false;
+    }
+    if (!_complete && VK_SUCCESS == vkGetFenceStatus(_vk_device, _vk_fence)) {
+        _complete = true;
+        ReleaseStagingAllocations();
+    }
+    return _complete;
+}
+
+bool GlobeUploadBatch::Wait() {
+    if (!_submitted) {
+        GlobeLogger::getInstance().LogError("GlobeUploadBatch::Wait - Batch has not been submitted");
+        return false;
+    }
+    if (!_complete) {
+        if (VK_SUCCESS != vkWaitForFences(_vk_device, 1, &_vk_fence, VK_TRUE, UINT64_MAX)) {
+            GlobeLogger::getInstance().LogError("GlobeUploadBatch::Wait - Failed waiting on upload fence");
+            return false;
+        }
+        _complete = true;
+        ReleaseStagingAllocations();
+    }
+    return true;
+}
+
+void GlobeUploadBatch::ReleaseStagingAllocations() {
+    for (auto allocation_id : _staging_allocations) {
+        _globe_resource_mgr->ReleaseStagingAllocation(allocation_id);
+    }
+    _staging_allocations.clear();
+}
@@ -0,0 +1,84 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    globe/globe_upload_batch.hpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+
+#pragma once
+
+#include <vector>
+
+#include "vulkan/vulkan_core.h"
+
+class GlobeResourceManager;
+class GlobeSubmitManager;
+
+// Collects any number of staged copies and their layout transitions into a single command buffer
+// so they can be sent to the GPU with one submit, and tracks the whole lot with one fence.
+// Batches are created and freed through the resource manager (BeginUploadBatch/FreeUploadBatch).
+//
+// When the device has a transfer-only queue family, the copies are recorded for and submitted to
+// that queue.  Each finished resource is released from the transfer queue family and acquired by
+// the graphics queue family in a second, small command buffer that waits on a semaphore signaled
+// by the transfer submit.  Rendering already queued on the graphics queue keeps running while the
+// copies happen.
+class GlobeUploadBatch {
+   public:
+    GlobeUploadBatch(GlobeResourceManager* resource_manager, GlobeSubmitManager* submit_manager, VkDevice vk_device);
+    ~GlobeUploadBatch();
+
+    bool Begin();
+    // Copies go into this command buffer, it may belong to the transfer queue family.
+    VkCommandBuffer GetVkCommandBuffer() const { return _vk_command_buffer; }
+    // Graphics-only work on already finished resources (like linear image transitions) goes in here.
+    VkCommandBuffer GetVkGraphicsCommandBuffer() const {
+        return _uses_transfer_queue ? _vk_acquire_command_buffer : _vk_command_buffer;
+    }
+    bool UsesTransferQueue() const { return _uses_transfer_queue; }
+    bool IsRecording() const { return _recording; }
+    bool IsSubmitted() const { return _submitted; }
+    uint32_t NumSubmits() const { return _num_submits; }
+
+    // Remember a staging ring allocation that the recorded commands read from.  It gets released
+    // back to the ring once the batch's fence has signaled.
+    void AddStagingAllocation(uint64_t allocation_id) { _staging_allocations.push_back(allocation_id); }
+
+    // Called once all copies into a resource have been recorded.  Transitions it from the transfer
+    // destination state into the state it will be used in on the graphics queue, transferring queue
+    // family ownership when needed.
+    bool FinishImage(VkImage vk_image, const VkImageSubresourceRange& vk_subresource_range,
+                     VkImageLayout vk_target_layout, VkPipelineStageFlags vk_target_stage);
+    bool FinishBuffer(VkBuffer vk_buffer, VkDeviceSize vk_offset, VkDeviceSize vk_size, VkAccessFlags vk_target_access,
+                      VkPipelineStageFlags vk_target_stage);
+
+    // Send everything recorded so far, wait for it and start recording again.  Used when the
+    // staging ring runs out of space in the middle of a batch.
+    bool Flush();
+    bool Submit(bool wait_for_completion);
+    bool IsComplete();
+    bool Wait();
+
+   private:
+    bool BeginCommandBuffers();
+    bool EndAndSubmit();
+    void ReleaseStagingAllocations();
+
+    GlobeResourceManager* _globe_resource_mgr;
+    GlobeSubmitManager* _globe_submit_mgr;
+    VkDevice _vk_device;
+    bool _uses_transfer_queue;
+    uint32_t _graphics_queue_family_index;
+    uint32_t _transfer_queue_family_index;
+    VkCommandBuffer _vk_command_buffer;
+    VkCommandBuffer _vk_acquire_command_buffer;
+    VkSemaphore _vk_semaphore;
+    VkFence _vk_fence;
+    bool _recording;
+    bool _submitted;
+    bool _complete;
+    uint32_t _num_submits;
+    std::vector<uint64_t> _staging_allocations;
+};
@@ -26,6 +26,9 @@
 #include "globe/globe_shader.hpp"
 #include "globe/globe_texture.hpp"
 #include "globe/globe_resource_manager.hpp"
+#include "globe/globe_descriptor_allocator.hpp"
+#include "globe/globe_layout_cache.hpp"
+#include "globe/globe_pipeline_cache.hpp"
 #include "globe/globe_app.hpp"
 #include "globe/globe_main.hpp"
 
@@ -53,8 +56,6 @@ class DynamicUniformApp : public GlobeApp {
     GlobeVulkanBuffer _vertex_buffer;
     GlobeVulkanBuffer _index_buffer;
     GlobeVulkanBuffer _uniform_buffer;
-    VkDescriptorPool _vk_descriptor_pool;
-    VkDescriptorSet _vk_descriptor_set;
     VkPipeline _vk_pipeline;
     VkDeviceSize _vk_uniform_matrix_alignment;
     uint8_t *_uniform_mapped_data;
@@ -64,17 +65,12 @@ DynamicUniformApp::DynamicUniformApp() {
     _vk_descriptor_set_layout = VK_NULL_HANDLE;
     _vk_pipeline_layout = VK_NULL_HANDLE;
     _vk_render_pass = VK_NULL_HANDLE;
-    _vertex_buffer.vk_size = 0;
     _vertex_buffer.vk_buffer = VK_NULL_HANDLE;
-    _vertex_buffer.vk_memory = VK_NULL_HANDLE;
-    _index_buffer.vk_size = 0;
+    _vertex_buffer.memory = {};
     _index_buffer.vk_buffer = VK_NULL_HANDLE;
-    _index_buffer.vk_memory = VK_NULL_HANDLE;
-    _uniform_buffer.vk_size = 0;
+    _index_buffer.memory = {};
     _uniform_buffer.vk_buffer = VK_NULL_HANDLE;
-    _uniform_buffer.vk_memory = VK_NULL_HANDLE;
-    _vk_descriptor_pool = VK_NULL_HANDLE;
-    _vk_descriptor_set = VK_NULL_HANDLE;
+    _uniform_buffer.memory = {};
     _vk_pipeline = VK_NULL_HANDLE;
 }
 
@@ -83,19 +79,10 @@ DynamicUniformApp::~DynamicUniformApp() { Cleanup(); }
 void DynamicUniformApp::CleanupCommandObjects(bool is_resize) {
     if (!_is_minimized) {
         if (VK_NULL_HANDLE != _vk_pipeline) {
-            vkDestroyPipeline(_vk_device, _vk_pipeline, nullptr);
+            _globe_resource_mgr->GetPipelineCache()->ReleaseGraphicsPipeline(_vk_pipeline);
             _vk_pipeline = VK_NULL_HANDLE;
         }
-        if (VK_NULL_HANDLE != _vk_descriptor_set) {
-            vkFreeDescriptorSets(_vk_device, _vk_descriptor_pool, 1, &_vk_descriptor_set);
-            _vk_descriptor_set = VK_NULL_HANDLE;
-        }
-        if (VK_NULL_HANDLE != _vk_descriptor_pool) {
-            vkDestroyDescriptorPool(_vk_device, _vk_descriptor_pool, nullptr);
-            _vk_descriptor_pool = VK_NULL_HANDLE;
-        }
         if (VK_NULL_HANDLE != _uniform_buffer.vk_buffer) {
-            vkUnmapMemory(_vk_device, _uniform_buffer.vk_memory);
             vkDestroyBuffer(_vk_device, _uniform_buffer.vk_buffer, nullptr);
             _uniform_buffer.vk_buffer = VK_NULL_HANDLE;
         }
@@ -107,21 +94,17 @@ void DynamicUniformApp::CleanupCommandObjects(bool is_resize) {
             vkDestroyBuffer(_vk_device, _vertex_buffer.vk_buffer, nullptr);
             _vertex_buffer.vk_buffer = VK_NULL_HANDLE;
         }
-        _globe_resource_mgr->FreeDeviceMemory(_uniform_buffer.vk_memory);
-        _globe_resource_mgr->FreeDeviceMemory(_index_buffer.vk_memory);
-        _globe_resource_mgr->FreeDeviceMemory(_vertex_buffer.vk_memory);
+        _globe_resource_mgr->FreeDeviceMemory(_uniform_buffer.memory);
+        _globe_resource_mgr->FreeDeviceMemory(_index_buffer.memory);
+        _globe_resource_mgr->FreeDeviceMemory(_vertex_buffer.memory);
         if (VK_NULL_HANDLE != _vk_render_pass) {
+            _globe_resource_mgr->GetPipelineCache()->RemoveRenderPass(_vk_render_pass);
             vkDestroyRenderPass(_vk_device, _vk_render_pass, nullptr);
             _vk_render_pass = VK_NULL_HANDLE;
         }
-        if (VK_NULL_HANDLE != _vk_pipeline_layout) {
-            vkDestroyPipelineLayout(_vk_device, _vk_pipeline_layout, nullptr);
-            _vk_pipeline_layout = VK_NULL_HANDLE;
-        }
-        if (VK_NULL_HANDLE != _vk_descriptor_set_layout) {
-            vkDestroyDescriptorSetLayout(_vk_device, _vk_descriptor_set_layout, nullptr);
-            _vk_descriptor_set_layout = VK_NULL_HANDLE;
-        }
+        // The layouts belong to the resource manager's layout cache.
+        _vk_pipeline_layout = VK_NULL_HANDLE;
+        _vk_descriptor_set_layout = VK_NULL_HANDLE;
     }
     GlobeApp::CleanupCommandObjects(is_resize);
 }
@@ -154,24 +137,16 @@ bool DynamicUniformApp::Setup() {
         descriptor_set_layout_bindings.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
         descriptor_set_layout_bindings.pImmutableSamplers = nullptr;
 
-        VkDescriptorSetLayoutCreateInfo descriptor_set_layout = {};
-        descriptor_set_layout.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        descriptor_set_layout.pNext = nullptr;
-        descriptor_set_layout.bindingCount = 1;
-        descriptor_set_layout.pBindings = &descriptor_set_layout_bindings;
-        if (VK_SUCCESS !=
-            vkCreateDescriptorSetLayout(_vk_device, &descriptor_set_layout, nullptr, &_vk_descriptor_set_layout)) {
+        _vk_descriptor_set_layout =
+            _globe_resource_mgr->GetLayoutCache()->GetDescriptorSetLayout({descriptor_set_layout_bindings});
+        if (VK_NULL_HANDLE == _vk_descriptor_set_layout) {
             logger.LogFatalError("Failed to create descriptor set layout");
             return false;
         }
 
-        VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
-        pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipeline_layout_create_info.pNext = nullptr;
-        pipeline_layout_create_info.setLayoutCount = 1;
-        pipeline_layout_create_info.pSetLayouts = &_vk_descriptor_set_layout;
-        if (VK_SUCCESS !=
-            vkCreatePipelineLayout(_vk_device, &pipeline_layout_create_info, nullptr, &_vk_pipeline_layout)) {
+        _vk_pipeline_layout =
+            _globe_resource_mgr->GetLayoutCache()->GetPipelineLayout({_vk_descriptor_set_layout}, {});
+        if (VK_NULL_HANDLE == _vk_pipeline_layout) {
             logger.LogFatalError("Failed to create pipeline layout layout");
             return false;
         }
@@ -236,6 +211,7 @@ bool DynamicUniformApp::Setup() {
             logger.LogFatalError("Failed to create renderpass");
             return false;
         }
+        _globe_resource_mgr->GetPipelineCache()->AddRenderPass(_vk_render_pass, render_pass_create_info);
 
         // Create the vertex buffer
         VkBufferCreateInfo buffer_create_info = {};
@@ -253,18 +229,18 @@ bool DynamicUniformApp::Setup() {
         }
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 _vertex_buffer.vk_buffer, (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                _vertex_buffer.vk_memory, _vertex_buffer.vk_size)) {
+                _vertex_buffer.memory)) {
             logger.LogFatalError("Failed to allocate vertex buffer memory");
             return false;
         }
-        if (VK_SUCCESS !=
-            vkMapMemory(_vk_device, _vertex_buffer.vk_memory, 0, _vertex_buffer.vk_size, 0, (void **)&mapped_data)) {
+        mapped_data = _vertex_buffer.memory.mapped_data;
+        if (nullptr == mapped_data) {
             logger.LogFatalError("Failed to map vertex buffer memory");
             return false;
         }
         memcpy(mapped_data, g_triangle_vertex_buffer_data, sizeof(g_triangle_vertex_buffer_data));
-        vkUnmapMemory(_vk_device, _vertex_buffer.vk_memory);
-        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _vertex_buffer.vk_buffer, _vertex_buffer.vk_memory, 0)) {
+        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _vertex_buffer.vk_buffer, _vertex_buffer.memory.vk_memory,
+                                             _vertex_buffer.memory.vk_offset)) {
             logger.LogFatalError("Failed to bind vertex buffer memory");
             return false;
         }
@@ -278,18 +254,18 @@ bool DynamicUniformApp::Setup() {
         }
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 _index_buffer.vk_buffer, (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                _index_buffer.vk_memory, _index_buffer.vk_size)) {
+                _index_buffer.memory)) {
             logger.LogFatalError("Failed to allocate index buffer memory");
             return false;
         }
-        if (VK_SUCCESS !=
-            vkMapMemory(_vk_device, _index_buffer.vk_memory, 0, _index_buffer.vk_size, 0, (void **)&mapped_data)) {
+        mapped_data = _index_buffer.memory.mapped_data;
+        if (nullptr == mapped_data) {
             logger.LogFatalError("Failed to map index buffer memory");
             return false;
         }
         memcpy(mapped_data, g_triangle_index_buffer_data, sizeof(g_triangle_index_buffer_data));
-        vkUnmapMemory(_vk_device, _index_buffer.vk_memory);
-        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _index_buffer.vk_buffer, _index_buffer.vk_memory, 0)) {
+        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _index_buffer.vk_buffer, _index_buffer.memory.vk_memory,
+                                             _index_buffer.memory.vk_offset)) {
             logger.LogFatalError("Failed to bind index buffer memory");
             return false;
         }
@@ -306,64 +282,23 @@ bool DynamicUniformApp::Setup() {
         }
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 _uniform_buffer.vk_buffer, (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                _uniform_buffer.vk_memory, _uniform_buffer.vk_size)) {
+                _uniform_buffer.memory)) {
             logger.LogFatalError("Failed to allocate uniform buffer memory");
             return false;
         }
-        if (VK_SUCCESS != vkMapMemory(_vk_device, _uniform_buffer.vk_memory, 0, _uniform_buffer.vk_size, 0,
-                                      (void **)&_uniform_mapped_data)) {
+        _uniform_mapped_data = _uniform_buffer.memory.mapped_data;
+        if (nullptr == _uniform_mapped_data) {
             logger.LogFatalError("Failed to map uniform buffer memory");
             return false;
         }
         memcpy(_uniform_mapped_data, &view_matrix, sizeof(view_matrix));
 
-        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _uniform_buffer.vk_buffer, _uniform_buffer.vk_memory, 0)) {
+        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _uniform_buffer.vk_buffer, _uniform_buffer.memory.vk_memory,
+                                             _uniform_buffer.memory.vk_offset)) {
             logger.LogFatalError("Failed to bind uniform buffer memory");
             return false;
         }
 
-        VkDescriptorPoolSize descriptor_pool_size = {};
-        descriptor_pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-        descriptor_pool_size.descriptorCount = 1;
-        VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
-        descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        descriptor_pool_create_info.pNext = nullptr;
-        descriptor_pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-        descriptor_pool_create_info.maxSets = 2;
-        descriptor_pool_create_info.poolSizeCount = 2;
-        descriptor_pool_create_info.pPoolSizes = &descriptor_pool_size;
-        if (VK_SUCCESS !=
-            vkCreateDescriptorPool(_vk_device, &descriptor_pool_create_info, nullptr, &_vk_descriptor_pool)) {
-            logger.LogFatalError("Failed to create descriptor pool");
-            return false;
-        }
-
-        VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
-        descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        descriptor_set_allocate_info.pNext = NULL;
-        descriptor_set_allocate_info.descriptorPool = _vk_descriptor_pool;
-        descriptor_set_allocate_info.descriptorSetCount = 1;
-        descriptor_set_allocate_info.pSetLayouts = &_vk_descriptor_set_layout;
-        if (VK_SUCCESS != vkAllocateDescriptorSets(_vk_device, &descriptor_set_allocate_info, &_vk_descriptor_set)) {
-            logger.LogFatalError("Failed to allocate descriptor set");
-            return false;
-        }
-
-        VkDescriptorBufferInfo descriptor_buffer_info = {};
-        descriptor_buffer_info.buffer = _uniform_buffer.vk_buffer;
-        descriptor_buffer_info.offset = 0;
-        descriptor_buffer_info.range = sizeof(glm::mat4);
-        VkWriteDescriptorSet write_descriptor_set = {};
-        write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write_descriptor_set.pNext = NULL;
-        write_descriptor_set.dstSet = _vk_descriptor_set;
-        write_descriptor_set.descriptorCount = 1;
-        write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-        write_descriptor_set.pBufferInfo = &descriptor_buffer_info;
-        write_descriptor_set.dstArrayElement = 0;
-        write_descriptor_set.dstBinding = 0;
-        vkUpdateDescriptorSets(_vk_device, 1, &write_descriptor_set, 0, nullptr);
-
         // Viewport and scissor dynamic state
         VkDynamicState dynamic_state_enables[2];
         dynamic_state_enables[0] = VK_DYNAMIC_STATE_VIEWPORT;
@@ -484,8 +419,8 @@ bool DynamicUniformApp::Setup() {
         gfx_pipeline_create_info.pStages = pipeline_shader_stage_create_info.data();
         gfx_pipeline_create_info.renderPass = _vk_render_pass;
         gfx_pipeline_create_info.pDynamicState = &pipeline_dynamic_state_create_info;
-        if (VK_SUCCESS != vkCreateGraphicsPipelines(_vk_device, VK_NULL_HANDLE, 1, &gfx_pipeline_create_info, nullptr,
-                                                    &_vk_pipeline)) {
+        _vk_pipeline = _globe_resource_mgr->GetPipelineCache()->GetGraphicsPipeline(gfx_pipeline_create_info);
+        if (VK_NULL_HANDLE == _vk_pipeline) {
             logger.LogFatalError("Failed to create graphics pipeline");
             return false;
         }
@@ -513,12 +448,7 @@ bool DynamicUniformApp::Update(float diff_ms) {
         inc = inc - 360.f;
     }
     memcpy(_uniform_mapped_data + offset, &view_matrix, sizeof(view_matrix));
-    VkMappedMemoryRange memoryRange = {};
-    memoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    memoryRange.memory = _uniform_buffer.vk_memory;
-    memoryRange.size = sizeof(glm::mat4);
-    memoryRange.offset = offset;
-    vkFlushMappedMemoryRanges(_vk_device, 1, &memoryRange);
+    _globe_resource_mgr->FlushDeviceMemory(_uniform_buffer.memory, offset, sizeof(glm::mat4));
 
     if (!UpdateOverlay(_current_buffer)) {
         logger.LogFatalError("Failed to update overlay");
@@ -581,9 +511,31 @@ bool DynamicUniformApp::Draw() {
     scissor.offset.y = 0;
     vkCmdSetScissor(vk_render_command_buffer, 0, 1, &scissor);
 
+    // The command buffer is recorded from scratch every frame, so the set only has to live for this frame.
+    VkDescriptorSet vk_descriptor_set = VK_NULL_HANDLE;
+    if (!_globe_resource_mgr->GetDescriptorAllocator()->AllocateFrameSet(_vk_descriptor_set_layout,
+                                                                         vk_descriptor_set)) {
+        logger.LogFatalError("Failed to allocate descriptor set");
+        return false;
+    }
+    VkDescriptorBufferInfo descriptor_buffer_info = {};
+    descriptor_buffer_info.buffer = _uniform_buffer.vk_buffer;
+    descriptor_buffer_info.offset = 0;
+    descriptor_buffer_info.range = sizeof(glm::mat4);
+    VkWriteDescriptorSet write_descriptor_set = {};
+    write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write_descriptor_set.pNext = NULL;
+    write_descriptor_set.dstSet = vk_descriptor_set;
+    write_descriptor_set.descriptorCount = 1;
+    write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write_descriptor_set.pBufferInfo = &descriptor_buffer_info;
+    write_descriptor_set.dstArrayElement = 0;
+    write_descriptor_set.dstBinding = 0;
+    vkUpdateDescriptorSets(_vk_device, 1, &write_descriptor_set, 0, nullptr);
+
     uint32_t dynamic_offset = _current_buffer * static_cast<uint32_t>(_vk_uniform_matrix_alignment);
     vkCmdBindDescriptorSets(vk_render_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _vk_pipeline_layout, 0, 1,
-                            &_vk_descriptor_set, 1, &dynamic_offset);
+                            &vk_descriptor_set, 1, &dynamic_offset);
     vkCmdBindPipeline(vk_render_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _vk_pipeline);
 
     const VkDeviceSize vert_buffer_offset = 0;
@@ -26,6 +26,9 @@
 #include "globe/globe_shader.hpp"
 #include "globe/globe_texture.hpp"
 #include "globe/globe_resource_manager.hpp"
+#include "globe/globe_descriptor_allocator.hpp"
+#include "globe/globe_layout_cache.hpp"
+#include "globe/globe_pipeline_cache.hpp"
 #include "globe/globe_app.hpp"
 #include "globe/globe_main.hpp"
 
@@ -52,7 +55,7 @@ class PushConstantApp : public GlobeApp {
     GlobeVulkanBuffer _vertex_buffer;
     GlobeVulkanBuffer _index_buffer;
     GlobeVulkanBuffer _uniform_buffer;
-    VkDescriptorPool _vk_descriptor_pool;
+    GlobeDescriptorAllocation _descriptor_allocation;
     VkDescriptorSet _vk_descriptor_set;
     VkPipeline _vk_pipeline;
     VkDeviceSize _vk_uniform_vec4_alignment;
@@ -69,16 +72,13 @@ PushConstantApp::PushConstantApp() {
     _vk_descriptor_set_layout = VK_NULL_HANDLE;
     _vk_pipeline_layout = VK_NULL_HANDLE;
     _vk_render_pass = VK_NULL_HANDLE;
-    _vertex_buffer.vk_size = 0;
     _vertex_buffer.vk_buffer = VK_NULL_HANDLE;
-    _vertex_buffer.vk_memory = VK_NULL_HANDLE;
-    _index_buffer.vk_size = 0;
+    _vertex_buffer.memory = {};
     _index_buffer.vk_buffer = VK_NULL_HANDLE;
-    _index_buffer.vk_memory = VK_NULL_HANDLE;
-    _uniform_buffer.vk_size = 0;
+    _index_buffer.memory = {};
     _uniform_buffer.vk_buffer = VK_NULL_HANDLE;
-    _uniform_buffer.vk_memory = VK_NULL_HANDLE;
-    _vk_descriptor_pool = VK_NULL_HANDLE;
+    _uniform_buffer.memory = {};
+    _descriptor_allocation = {};
     _vk_descriptor_set = VK_NULL_HANDLE;
     _vk_pipeline = VK_NULL_HANDLE;
     _texture_1 = nullptr;
@@ -94,19 +94,14 @@ void PushConstantApp::CleanupCommandObjects(bool is_resize) {
             _push_constants = nullptr;
         }
         if (VK_NULL_HANDLE != _vk_pipeline) {
-            vkDestroyPipeline(_vk_device, _vk_pipeline, nullptr);
+            _globe_resource_mgr->GetPipelineCache()->ReleaseGraphicsPipeline(_vk_pipeline);
             _vk_pipeline = VK_NULL_HANDLE;
         }
         if (VK_NULL_HANDLE != _vk_descriptor_set) {
-            vkFreeDescriptorSets(_vk_device, _vk_descriptor_pool, 1, &_vk_descriptor_set);
+            _globe_resource_mgr->GetDescriptorAllocator()->FreePersistentSet(_descriptor_allocation);
             _vk_descriptor_set = VK_NULL_HANDLE;
         }
-        if (VK_NULL_HANDLE != _vk_descriptor_pool) {
-            vkDestroyDescriptorPool(_vk_device, _vk_descriptor_pool, nullptr);
-            _vk_descriptor_pool = VK_NULL_HANDLE;
-        }
         if (VK_NULL_HANDLE != _uniform_buffer.vk_buffer) {
-            vkUnmapMemory(_vk_device, _uniform_buffer.vk_memory);
             vkDestroyBuffer(_vk_device, _uniform_buffer.vk_buffer, nullptr);
             _uniform_buffer.vk_buffer = VK_NULL_HANDLE;
         }
@@ -118,21 +113,17 @@ void PushConstantApp::CleanupCommandObjects(bool is_resize) {
             vkDestroyBuffer(_vk_device, _vertex_buffer.vk_buffer, nullptr);
             _vertex_buffer.vk_buffer = VK_NULL_HANDLE;
         }
-        _globe_resource_mgr->FreeDeviceMemory(_uniform_buffer.vk_memory);
-        _globe_resource_mgr->FreeDeviceMemory(_index_buffer.vk_memory);
-        _globe_resource_mgr->FreeDeviceMemory(_vertex_buffer.vk_memory);
+        _globe_resource_mgr->FreeDeviceMemory(_uniform_buffer.memory);
+        _globe_resource_mgr->FreeDeviceMemory(_index_buffer.memory);
+        _globe_resource_mgr->FreeDeviceMemory(_vertex_buffer.memory);
         if (VK_NULL_HANDLE != _vk_render_pass) {
+            _globe_resource_mgr->GetPipelineCache()->RemoveRenderPass(_vk_render_pass);
             vkDestroyRenderPass(_vk_device, _vk_render_pass, nullptr);
             _vk_render_pass = VK_NULL_HANDLE;
         }
-        if (VK_NULL_HANDLE != _vk_pipeline_layout) {
-            vkDestroyPipelineLayout(_vk_device, _vk_pipeline_layout, nullptr);
-            _vk_pipeline_layout = VK_NULL_HANDLE;
-        }
-        if (VK_NULL_HANDLE != _vk_descriptor_set_layout) {
-            vkDestroyDescriptorSetLayout(_vk_device, _vk_descriptor_set_layout, nullptr);
-            _vk_descriptor_set_layout = VK_NULL_HANDLE;
-        }
+        // The layouts belong to the resource manager's layout cache.
+        _vk_pipeline_layout = VK_NULL_HANDLE;
+        _vk_descriptor_set_layout = VK_NULL_HANDLE;
     }
     GlobeApp::CleanupCommandObjects(is_resize);
 }
@@ -199,13 +190,9 @@ bool PushConstantApp::Setup() {
         cur_binding.pImmutableSamplers = nullptr;
         descriptor_set_layout_bindings.push_back(cur_binding);
 
-        VkDescriptorSetLayoutCreateInfo descriptor_set_layout = {};
-        descriptor_set_layout.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        descriptor_set_layout.pNext = nullptr;
-        descriptor_set_layout.bindingCount = static_cast<uint32_t>(descriptor_set_layout_bindings.size());
-        descriptor_set_layout.pBindings = descriptor_set_layout_bindings.data();
-        if (VK_SUCCESS !=
-            vkCreateDescriptorSetLayout(_vk_device, &descriptor_set_layout, nullptr, &_vk_descriptor_set_layout)) {
+        _vk_descriptor_set_layout =
+            _globe_resource_mgr->GetLayoutCache()->GetDescriptorSetLayout(descriptor_set_layout_bindings);
+        if (VK_NULL_HANDLE == _vk_descriptor_set_layout) {
             logger.LogFatalError("Failed to create descriptor set layout");
             return false;
         }
@@ -218,15 +205,9 @@ bool PushConstantApp::Setup() {
         push_constant_range.size = 12;
         push_constant_ranges.push_back(push_constant_range);
 
-        VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
-        pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipeline_layout_create_info.pNext = nullptr;
-        pipeline_layout_create_info.pushConstantRangeCount = static_cast<uint32_t>(push_constant_ranges.size());
-        pipeline_layout_create_info.pPushConstantRanges = push_constant_ranges.data();
-        pipeline_layout_create_info.setLayoutCount = 1;
-        pipeline_layout_create_info.pSetLayouts = &_vk_descriptor_set_layout;
-        if (VK_SUCCESS !=
-            vkCreatePipelineLayout(_vk_device, &pipeline_layout_create_info, nullptr, &_vk_pipeline_layout)) {
+        _vk_pipeline_layout =
+            _globe_resource_mgr->GetLayoutCache()->GetPipelineLayout({_vk_descriptor_set_layout}, push_constant_ranges);
+        if (VK_NULL_HANDLE == _vk_pipeline_layout) {
             logger.LogFatalError("Failed to create pipeline layout layout");
             return false;
         }
@@ -291,6 +272,7 @@ bool PushConstantApp::Setup() {
             logger.LogFatalError("Failed to create renderpass");
             return false;
         }
+        _globe_resource_mgr->GetPipelineCache()->AddRenderPass(_vk_render_pass, render_pass_create_info);
 
         // Create the vertex buffer
         VkBufferCreateInfo buffer_create_info = {};
@@ -308,18 +290,18 @@ bool PushConstantApp::Setup() {
         }
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 _vertex_buffer.vk_buffer, (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                _vertex_buffer.vk_memory, _vertex_buffer.vk_size)) {
+                _vertex_buffer.memory)) {
             logger.LogFatalError("Failed to allocate vertex buffer memory");
             return false;
         }
-        if (VK_SUCCESS !=
-            vkMapMemory(_vk_device, _vertex_buffer.vk_memory, 0, _vertex_buffer.vk_size, 0, (void **)&mapped_data)) {
+        mapped_data = _vertex_buffer.memory.mapped_data;
+        if (nullptr == mapped_data) {
             logger.LogFatalError("Failed to map vertex buffer memory");
             return false;
         }
         memcpy(mapped_data, g_quad_vertex_buffer_data, sizeof(g_quad_vertex_buffer_data));
-        vkUnmapMemory(_vk_device, _vertex_buffer.vk_memory);
-        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _vertex_buffer.vk_buffer, _vertex_buffer.vk_memory, 0)) {
+        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _vertex_buffer.vk_buffer, _vertex_buffer.memory.vk_memory,
+                                             _vertex_buffer.memory.vk_offset)) {
             logger.LogFatalError("Failed to bind vertex buffer memory");
             return false;
         }
@@ -333,18 +315,18 @@ bool PushConstantApp::Setup() {
         }
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 _index_buffer.vk_buffer, (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                _index_buffer.vk_memory, _index_buffer.vk_size)) {
+                _index_buffer.memory)) {
             logger.LogFatalError("Failed to allocate index buffer memory");
             return false;
         }
-        if (VK_SUCCESS !=
-            vkMapMemory(_vk_device, _index_buffer.vk_memory, 0, _index_buffer.vk_size, 0, (void **)&mapped_data)) {
+        mapped_data = _index_buffer.memory.mapped_data;
+        if (nullptr == mapped_data) {
             logger.LogFatalError("Failed to map index buffer memory");
             return false;
         }
         memcpy(mapped_data, g_quad_index_buffer_data, sizeof(g_quad_index_buffer_data));
-        vkUnmapMemory(_vk_device, _index_buffer.vk_memory);
-        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _index_buffer.vk_buffer, _index_buffer.vk_memory, 0)) {
+        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _index_buffer.vk_buffer, _index_buffer.memory.vk_memory,
+                                             _index_buffer.memory.vk_offset)) {
             logger.LogFatalError("Failed to bind index buffer memory");
             return false;
         }
@@ -368,53 +350,29 @@ bool PushConstantApp::Setup() {
         }
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 _uniform_buffer.vk_buffer, (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                _uniform_buffer.vk_memory, _uniform_buffer.vk_size)) {
+                _uniform_buffer.memory)) {
             logger.LogFatalError("Failed to allocate uniform buffer memory");
             return false;
         }
-        if (VK_SUCCESS != vkMapMemory(_vk_device, _uniform_buffer.vk_memory, 0, _uniform_buffer.vk_size, 0,
-                                      (void **)&_uniform_mapped_data)) {
+        _uniform_mapped_data = _uniform_buffer.memory.mapped_data;
+        if (nullptr == _uniform_mapped_data) {
             logger.LogFatalError("Failed to map uniform buffer memory");
             return false;
         }
         memcpy(_uniform_mapped_data, &_ellipse_center, sizeof(_ellipse_center));
 
-        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _uniform_buffer.vk_buffer, _uniform_buffer.vk_memory, 0)) {
+        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _uniform_buffer.vk_buffer, _uniform_buffer.memory.vk_memory,
+                                             _uniform_buffer.memory.vk_offset)) {
             logger.LogFatalError("Failed to bind uniform buffer memory");
             return false;
         }
 
-        std::vector<VkDescriptorPoolSize> descriptor_pool_sizes;
-        VkDescriptorPoolSize pool_size = {};
-        pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-        pool_size.descriptorCount = 1;
-        descriptor_pool_sizes.push_back(pool_size);
-        pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        pool_size.descriptorCount = 2;
-        descriptor_pool_sizes.push_back(pool_size);
-        VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
-        descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        descriptor_pool_create_info.pNext = nullptr;
-        descriptor_pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-        descriptor_pool_create_info.maxSets = 2;
-        descriptor_pool_create_info.poolSizeCount = static_cast<uint32_t>(descriptor_pool_sizes.size());
-        descriptor_pool_create_info.pPoolSizes = descriptor_pool_sizes.data();
-        if (VK_SUCCESS !=
-            vkCreateDescriptorPool(_vk_device, &descriptor_pool_create_info, nullptr, &_vk_descriptor_pool)) {
-            logger.LogFatalError("Failed to create descriptor pool");
-            return false;
-        }
-
-        VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
-        descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        descriptor_set_allocate_info.pNext = NULL;
-        descriptor_set_allocate_info.descriptorPool = _vk_descriptor_pool;
-        descriptor_set_allocate_info.descriptorSetCount = 1;
-        descriptor_set_allocate_info.pSetLayouts = &_vk_descriptor_set_layout;
-        if (VK_SUCCESS != vkAllocateDescriptorSets(_vk_device, &descriptor_set_allocate_info, &_vk_descriptor_set)) {
+        if (!_globe_resource_mgr->GetDescriptorAllocator()->AllocatePersistentSet(_vk_descriptor_set_layout,
+                                                                                   _descriptor_allocation)) {
             logger.LogFatalError("Failed to allocate descriptor set");
             return false;
         }
+        _vk_descriptor_set = _descriptor_allocation.vk_descriptor_set;
 
         std::vector<VkDescriptorImageInfo> descriptor_image_infos;
         VkDescriptorImageInfo image_info = {};
@@ -599,8 +557,8 @@ bool PushConstantApp::Setup() {
         gfx_pipeline_create_info.pStages = pipeline_shader_stage_create_info.data();
         gfx_pipeline_create_info.renderPass = _vk_render_pass;
         gfx_pipeline_create_info.pDynamicState = &pipeline_dynamic_state_create_info;
-        if (VK_SUCCESS != vkCreateGraphicsPipelines(_vk_device, VK_NULL_HANDLE, 1, &gfx_pipeline_create_info, nullptr,
-                                                    &_vk_pipeline)) {
+        _vk_pipeline = _globe_resource_mgr->GetPipelineCache()->GetGraphicsPipeline(gfx_pipeline_create_info);
+        if (VK_NULL_HANDLE == _vk_pipeline) {
             logger.LogFatalError("Failed to create graphics pipeline");
             return false;
         }
@@ -733,12 +691,7 @@ bool PushConstantApp::Draw() {
 
     VkDeviceSize offset = (_vk_uniform_vec4_alignment * _current_buffer);
     memcpy(_uniform_mapped_data + offset, &_ellipse_center, sizeof(_ellipse_center));
-    VkMappedMemoryRange memoryRange = {};
-    memoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    memoryRange.memory = _uniform_buffer.vk_memory;
-    memoryRange.size = _vk_uniform_vec4_alignment;
-    memoryRange.offset = offset;
-    vkFlushMappedMemoryRanges(_vk_device, 1, &memoryRange);
+    _globe_resource_mgr->FlushDeviceMemory(_uniform_buffer.memory, offset, _vk_uniform_vec4_alignment);
 
     const VkDeviceSize vert_buffer_offset = 0;
     vkCmdBindVertexBuffers(vk_render_command_buffer, 0, 1, &_vertex_buffer.vk_buffer, &vert_buffer_offset);
@@ -27,6 +27,9 @@
 #include "globe/globe_shader.hpp"
 #include "globe/globe_texture.hpp"
 #include "globe/globe_resource_manager.hpp"
+#include "globe/globe_descriptor_allocator.hpp"
+#include "globe/globe_layout_cache.hpp"
+#include "globe/globe_pipeline_cache.hpp"
 #include "globe/globe_app.hpp"
 #include "globe/globe_main.hpp"
 
@@ -38,7 +41,7 @@ struct VulkanTarget {
     VkSemaphore vk_semaphore;
     VkDescriptorSetLayout vk_descriptor_set_layout;
     VkPipelineLayout vk_pipeline_layout;
-    VkDescriptorPool vk_descriptor_pool;
+    GlobeDescriptorAllocation descriptor_allocation;
     VkDescriptorSet vk_descriptor_set;
     VkPipeline vk_pipeline;
     GlobeVulkanBuffer vertex_buffer;
@@ -171,7 +174,7 @@ OffscreenRenderingApp::~OffscreenRenderingApp() { Cleanup(); }
 
 void OffscreenRenderingApp::CleanupVulkanTarget(VulkanTarget &target) {
     if (VK_NULL_HANDLE != target.vk_pipeline) {
-        vkDestroyPipeline(_vk_device, target.vk_pipeline, nullptr);
+        _globe_resource_mgr->GetPipelineCache()->ReleaseGraphicsPipeline(target.vk_pipeline);
         target.vk_pipeline = VK_NULL_HANDLE;
     }
     if (VK_NULL_HANDLE != target.vk_semaphore) {
@@ -183,24 +186,23 @@ void OffscreenRenderingApp::CleanupVulkanTarget(VulkanTarget &target) {
         target.vk_framebuffer = VK_NULL_HANDLE;
     }
     if (VK_NULL_HANDLE != target.vk_render_pass) {
+        _globe_resource_mgr->GetPipelineCache()->RemoveRenderPass(target.vk_render_pass);
         vkDestroyRenderPass(_vk_device, target.vk_render_pass, nullptr);
         target.vk_render_pass = VK_NULL_HANDLE;
     }
-    if (VK_NULL_HANDLE != target.vk_pipeline_layout) {
-        vkDestroyPipelineLayout(_vk_device, target.vk_pipeline_layout, nullptr);
-        target.vk_pipeline_layout = VK_NULL_HANDLE;
+    // The layouts belong to the resource manager's layout cache.
+    target.vk_pipeline_layout = VK_NULL_HANDLE;
+    target.vk_descriptor_set_layout = VK_NULL_HANDLE;
+    if (VK_NULL_HANDLE != target.uniform_buffer.memory.vk_memory) {
+        _globe_resource_mgr->FreeDeviceMemory(target.uniform_buffer.memory);
     }
-    if (VK_NULL_HANDLE != target.uniform_buffer.vk_memory) {
-        vkUnmapMemory(_vk_device, target.uniform_buffer.vk_memory);
-        _globe_resource_mgr->FreeDeviceMemory(target.uniform_buffer.vk_memory);
+    if (VK_NULL_HANDLE != target.index_buffer.memory.vk_memory) {
+        _globe_resource_mgr->FreeDeviceMemory(target.index_buffer.memory);
+        target.index_buffer.memory = {};
     }
-    if (VK_NULL_HANDLE != target.index_buffer.vk_memory) {
-        _globe_resource_mgr->FreeDeviceMemory(target.index_buffer.vk_memory);
-        target.index_buffer.vk_memory = VK_NULL_HANDLE;
-    }
-    if (VK_NULL_HANDLE != target.vertex_buffer.vk_memory) {
-        _globe_resource_mgr->FreeDeviceMemory(target.vertex_buffer.vk_memory);
-        target.vertex_buffer.vk_memory = VK_NULL_HANDLE;
+    if (VK_NULL_HANDLE != target.vertex_buffer.memory.vk_memory) {
+        _globe_resource_mgr->FreeDeviceMemory(target.vertex_buffer.memory);
+        target.vertex_buffer.memory = {};
     }
     if (VK_NULL_HANDLE != target.uniform_buffer.vk_buffer) {
         vkDestroyBuffer(_vk_device, target.uniform_buffer.vk_buffer, nullptr);
@@ -214,13 +216,9 @@ void OffscreenRenderingApp::CleanupVulkanTarget(VulkanTarget &target) {
         vkDestroyBuffer(_vk_device, target.vertex_buffer.vk_buffer, nullptr);
         target.vertex_buffer.vk_buffer = VK_NULL_HANDLE;
     }
-    if (VK_NULL_HANDLE != target.vk_descriptor_set_layout) {
-        vkDestroyDescriptorSetLayout(_vk_device, target.vk_descriptor_set_layout, nullptr);
-        target.vk_descriptor_set_layout = VK_NULL_HANDLE;
-    }
-    if (VK_NULL_HANDLE != target.vk_descriptor_pool) {
-        vkDestroyDescriptorPool(_vk_device, target.vk_descriptor_pool, nullptr);
-        target.vk_descriptor_pool = VK_NULL_HANDLE;
+    if (VK_NULL_HANDLE != target.vk_descriptor_set) {
+        _globe_resource_mgr->GetDescriptorAllocator()->FreePersistentSet(target.descriptor_allocation);
+        target.vk_descriptor_set = VK_NULL_HANDLE;
     }
     if (target.vk_command_buffers.size() > 0) {
         vkFreeCommandBuffers(_vk_device, target.vk_command_pool,
@@ -342,6 +340,8 @@ bool OffscreenRenderingApp::CreateOffscreenTarget(VkCommandBuffer vk_command_buf
         logger.LogFatalError("Failed to create offscreen render pass");
         return false;
     }
+    _globe_resource_mgr->GetPipelineCache()->AddRenderPass(_offscreen_target.vk_render_pass,
+                                                           offscreen_render_pass_create_info);
 
     // Now attach the offscreen images to a framebuffer
     std::vector<VkImageView> image_views;
@@ -383,13 +383,9 @@ bool OffscreenRenderingApp::CreateOffscreenTarget(VkCommandBuffer vk_command_buf
     cur_binding.pImmutableSamplers = nullptr;
     descriptor_set_layout_bindings.push_back(cur_binding);
 
-    VkDescriptorSetLayoutCreateInfo descriptor_set_layout = {};
-    descriptor_set_layout.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    descriptor_set_layout.pNext = nullptr;
-    descriptor_set_layout.bindingCount = static_cast<uint32_t>(descriptor_set_layout_bindings.size());
-    descriptor_set_layout.pBindings = descriptor_set_layout_bindings.data();
-    if (VK_SUCCESS != vkCreateDescriptorSetLayout(_vk_device, &descriptor_set_layout, nullptr,
-                                                  &_offscreen_target.vk_descriptor_set_layout)) {
+    _offscreen_target.vk_descriptor_set_layout =
+        _globe_resource_mgr->GetLayoutCache()->GetDescriptorSetLayout(descriptor_set_layout_bindings);
+    if (VK_NULL_HANDLE == _offscreen_target.vk_descriptor_set_layout) {
         logger.LogFatalError("Failed to create offscreen render target descriptor set layout");
         return false;
     }
@@ -399,15 +395,9 @@ bool OffscreenRenderingApp::CreateOffscreenTarget(VkCommandBuffer vk_command_buf
     push_constant_range.offset = 0;
     push_constant_range.size = sizeof(glm::mat4);
 
-    VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
-    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipeline_layout_create_info.pNext = nullptr;
-    pipeline_layout_create_info.pushConstantRangeCount = 1;
-    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
-    pipeline_layout_create_info.setLayoutCount = 1;
-    pipeline_layout_create_info.pSetLayouts = &_offscreen_target.vk_descriptor_set_layout;
-    if (VK_SUCCESS != vkCreatePipelineLayout(_vk_device, &pipeline_layout_create_info, nullptr,
-                                             &_offscreen_target.vk_pipeline_layout)) {
+    _offscreen_target.vk_pipeline_layout = _globe_resource_mgr->GetLayoutCache()->GetPipelineLayout(
+        {_offscreen_target.vk_descriptor_set_layout}, {push_constant_range});
+    if (VK_NULL_HANDLE == _offscreen_target.vk_pipeline_layout) {
         logger.LogFatalError("Failed to create offscreen render target pipeline layout layout");
         return false;
     }
@@ -429,19 +419,19 @@ bool OffscreenRenderingApp::CreateOffscreenTarget(VkCommandBuffer vk_command_buf
     }
     if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
             _offscreen_target.vertex_buffer.vk_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-            _offscreen_target.vertex_buffer.vk_memory, _offscreen_target.vertex_buffer.vk_size)) {
+            _offscreen_target.vertex_buffer.memory)) {
         logger.LogFatalError("Failed to allocate offscreen vertex buffer memory");
         return false;
     }
-    if (VK_SUCCESS != vkMapMemory(_vk_device, _offscreen_target.vertex_buffer.vk_memory, 0,
-                                  _offscreen_target.vertex_buffer.vk_size, 0, (void **)&mapped_data)) {
+    mapped_data = _offscreen_target.vertex_buffer.memory.mapped_data;
+    if (nullptr == mapped_data) {
         logger.LogFatalError("Failed to map offscreen vertex buffer memory");
         return false;
     }
     memcpy(mapped_data, g_offscreen_vertex_data, sizeof(g_offscreen_vertex_data));
-    vkUnmapMemory(_vk_device, _offscreen_target.vertex_buffer.vk_memory);
     if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _offscreen_target.vertex_buffer.vk_buffer,
-                                         _offscreen_target.vertex_buffer.vk_memory, 0)) {
+                                         _offscreen_target.vertex_buffer.memory.vk_memory,
+                                         _offscreen_target.vertex_buffer.memory.vk_offset)) {
         logger.LogFatalError("Failed to bind offscreen vertex buffer memory");
         return false;
     }
@@ -457,19 +447,19 @@ bool OffscreenRenderingApp::CreateOffscreenTarget(VkCommandBuffer vk_command_buf
     if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
             _offscreen_target.index_buffer.vk_buffer,
             (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-            _offscreen_target.index_buffer.vk_memory, _offscreen_target.index_buffer.vk_size)) {
+            _offscreen_target.index_buffer.memory)) {
         logger.LogFatalError("Failed to allocate offscreen index buffer memory");
         return false;
     }
-    if (VK_SUCCESS != vkMapMemory(_vk_device, _offscreen_target.index_buffer.vk_memory, 0,
-                                  _offscreen_target.index_buffer.vk_size, 0, (void **)&mapped_data)) {
+    mapped_data = _offscreen_target.index_buffer.memory.mapped_data;
+    if (nullptr == mapped_data) {
         logger.LogFatalError("Failed to map offscreen index buffer memory");
         return false;
     }
     memcpy(mapped_data, g_offscreen_index_data, sizeof(g_offscreen_index_data));
-    vkUnmapMemory(_vk_device, _offscreen_target.index_buffer.vk_memory);
     if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _offscreen_target.index_buffer.vk_buffer,
-                                         _offscreen_target.index_buffer.vk_memory, 0)) {
+                                         _offscreen_target.index_buffer.memory.vk_memory,
+                                         _offscreen_target.index_buffer.memory.vk_offset)) {
         logger.LogFatalError("Failed to bind offscreen index buffer memory");
         return false;
     }
@@ -487,51 +477,29 @@ bool OffscreenRenderingApp::CreateOffscreenTarget(VkCommandBuffer vk_command_buf
     if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
             _offscreen_target.uniform_buffer.vk_buffer,
             (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-            _offscreen_target.uniform_buffer.vk_memory, _offscreen_target.uniform_buffer.vk_size)) {
+            _offscreen_target.uniform_buffer.memory)) {
         logger.LogFatalError("Failed to allocate offscreen uniform buffer memory");
         return false;
     }
-    if (VK_SUCCESS != vkMapMemory(_vk_device, _offscreen_target.uniform_buffer.vk_memory, 0,
-                                  _offscreen_target.uniform_buffer.vk_size, 0,
-                                  (void **)&_offscreen_target.uniform_map)) {
+    _offscreen_target.uniform_map = _offscreen_target.uniform_buffer.memory.mapped_data;
+    if (nullptr == _offscreen_target.uniform_map) {
         logger.LogFatalError("Failed to map offscreen uniform buffer memory");
         return false;
     }
     if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _offscreen_target.uniform_buffer.vk_buffer,
-                                         _offscreen_target.uniform_buffer.vk_memory, 0)) {
+                                         _offscreen_target.uniform_buffer.memory.vk_memory,
+                                         _offscreen_target.uniform_buffer.memory.vk_offset)) {
         logger.LogFatalError("Failed to bind offscreen uniform buffer memory");
         return false;
     }
 
-    std::vector<VkDescriptorPoolSize> descriptor_pool_sizes;
-    VkDescriptorPoolSize pool_size = {};
-    pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-    pool_size.descriptorCount = 1;
-    descriptor_pool_sizes.push_back(pool_size);
-    VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
-    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    descriptor_pool_create_info.pNext = nullptr;
-    descriptor_pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-    descriptor_pool_create_info.maxSets = 2;
-    descriptor_pool_create_info.poolSizeCount = static_cast<uint32_t>(descriptor_pool_sizes.size());
-    descriptor_pool_create_info.pPoolSizes = descriptor_pool_sizes.data();
-    if (VK_SUCCESS != vkCreateDescriptorPool(_vk_device, &descriptor_pool_create_info, nullptr,
-                                             &_offscreen_target.vk_descriptor_pool)) {
-        logger.LogFatalError("Failed to create offscreen descriptor pool");
-        return false;
-    }
-
-    VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
-    descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    descriptor_set_allocate_info.pNext = NULL;
-    descriptor_set_allocate_info.descriptorPool = _offscreen_target.vk_descriptor_pool;
-    descriptor_set_allocate_info.descriptorSetCount = 1;
-    descriptor_set_allocate_info.pSetLayouts = &_offscreen_target.vk_descriptor_set_layout;
-    if (VK_SUCCESS !=
-        vkAllocateDescriptorSets(_vk_device, &descriptor_set_allocate_info, &_offscreen_target.vk_descriptor_set)) {
+    GlobeDescriptorAllocator *descriptor_allocator = _globe_resource_mgr->GetDescriptorAllocator();
+    if (!descriptor_allocator->AllocatePersistentSet(_offscreen_target.vk_descriptor_set_layout,
+                                                     _offscreen_target.descriptor_allocation)) {
         logger.LogFatalError("Failed to allocate offscreen descriptor set");
         return false;
     }
+    _offscreen_target.vk_descriptor_set = _offscreen_target.descriptor_allocation.vk_descriptor_set;
 
     VkDescriptorBufferInfo descriptor_buffer_info = {};
     descriptor_buffer_info.buffer = _offscreen_target.uniform_buffer.vk_buffer;
@@ -672,8 +640,9 @@ bool OffscreenRenderingApp::CreateOffscreenTarget(VkCommandBuffer vk_command_buf
     gfx_pipeline_create_info.pStages = pipeline_shader_stage_create_info.data();
     gfx_pipeline_create_info.renderPass = _offscreen_target.vk_render_pass;
     gfx_pipeline_create_info.pDynamicState = &pipeline_dynamic_state_create_info;
-    if (VK_SUCCESS != vkCreateGraphicsPipelines(_vk_device, VK_NULL_HANDLE, 1, &gfx_pipeline_create_info, nullptr,
-                                                &_offscreen_target.vk_pipeline)) {
+    _offscreen_target.vk_pipeline =
+        _globe_resource_mgr->GetPipelineCache()->GetGraphicsPipeline(gfx_pipeline_create_info);
+    if (VK_NULL_HANDLE == _offscreen_target.vk_pipeline) {
         logger.LogFatalError("Failed to create graphics pipeline");
         return false;
     }
@@ -764,13 +733,9 @@ bool OffscreenRenderingApp::Setup() {
         cur_binding.pImmutableSamplers = nullptr;
         descriptor_set_layout_bindings.push_back(cur_binding);
 
-        VkDescriptorSetLayoutCreateInfo descriptor_set_layout = {};
-        descriptor_set_layout.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        descriptor_set_layout.pNext = nullptr;
-        descriptor_set_layout.bindingCount = static_cast<uint32_t>(descriptor_set_layout_bindings.size());
-        descriptor_set_layout.pBindings = descriptor_set_layout_bindings.data();
-        if (VK_SUCCESS != vkCreateDescriptorSetLayout(_vk_device, &descriptor_set_layout, nullptr,
-                                                      &_onscreen_target.vk_descriptor_set_layout)) {
+        _onscreen_target.vk_descriptor_set_layout =
+            _globe_resource_mgr->GetLayoutCache()->GetDescriptorSetLayout(descriptor_set_layout_bindings);
+        if (VK_NULL_HANDLE == _onscreen_target.vk_descriptor_set_layout) {
             logger.LogFatalError("Failed to create descriptor set layout");
             return false;
         }
@@ -782,15 +747,9 @@ bool OffscreenRenderingApp::Setup() {
         push_constant_range.size = sizeof(glm::mat4);
         push_constant_ranges.push_back(push_constant_range);
 
-        VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
-        pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipeline_layout_create_info.pNext = nullptr;
-        pipeline_layout_create_info.pushConstantRangeCount = static_cast<uint32_t>(push_constant_ranges.size());
-        pipeline_layout_create_info.pPushConstantRanges = push_constant_ranges.data();
-        pipeline_layout_create_info.setLayoutCount = 1;
-        pipeline_layout_create_info.pSetLayouts = &_onscreen_target.vk_descriptor_set_layout;
-        if (VK_SUCCESS != vkCreatePipelineLayout(_vk_device, &pipeline_layout_create_info, nullptr,
-                                                 &_onscreen_target.vk_pipeline_layout)) {
+        _onscreen_target.vk_pipeline_layout = _globe_resource_mgr->GetLayoutCache()->GetPipelineLayout(
+            {_onscreen_target.vk_descriptor_set_layout}, push_constant_ranges);
+        if (VK_NULL_HANDLE == _onscreen_target.vk_pipeline_layout) {
             logger.LogFatalError("Failed to create pipeline layout layout");
             return false;
         }
@@ -856,6 +815,7 @@ bool OffscreenRenderingApp::Setup() {
             return false;
         }
         _onscreen_target.vk_render_pass = _vk_render_pass;
+        _globe_resource_mgr->GetPipelineCache()->AddRenderPass(_vk_render_pass, render_pass_create_info);
 
         // Viewport and scissor dynamic state
         VkDynamicState dynamic_state_enables[2];
@@ -977,8 +937,9 @@ bool OffscreenRenderingApp::Setup() {
         gfx_pipeline_create_info.pStages = pipeline_shader_stage_create_info.data();
         gfx_pipeline_create_info.renderPass = _onscreen_target.vk_render_pass;
         gfx_pipeline_create_info.pDynamicState = &pipeline_dynamic_state_create_info;
-        if (VK_SUCCESS != vkCreateGraphicsPipelines(_vk_device, VK_NULL_HANDLE, 1, &gfx_pipeline_create_info, nullptr,
-                                                    &_onscreen_target.vk_pipeline)) {
+        _onscreen_target.vk_pipeline =
+            _globe_resource_mgr->GetPipelineCache()->GetGraphicsPipeline(gfx_pipeline_create_info);
+        if (VK_NULL_HANDLE == _onscreen_target.vk_pipeline) {
             logger.LogFatalError("Failed to create graphics pipeline");
             return false;
         }
@@ -1003,19 +964,19 @@ bool OffscreenRenderingApp::Setup() {
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 _onscreen_target.vertex_buffer.vk_buffer,
                 (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                _onscreen_target.vertex_buffer.vk_memory, _onscreen_target.vertex_buffer.vk_size)) {
+                _onscreen_target.vertex_buffer.memory)) {
             logger.LogFatalError("Failed to allocate vertex buffer memory");
             return false;
         }
-        if (VK_SUCCESS != vkMapMemory(_vk_device, _onscreen_target.vertex_buffer.vk_memory, 0,
-                                      _onscreen_target.vertex_buffer.vk_size, 0, (void **)&mapped_data)) {
+        mapped_data = _onscreen_target.vertex_buffer.memory.mapped_data;
+        if (nullptr == mapped_data) {
             logger.LogFatalError("Failed to map vertex buffer memory");
             return false;
         }
         memcpy(mapped_data, g_onscreen_cube_data, sizeof(g_onscreen_cube_data));
-        vkUnmapMemory(_vk_device, _onscreen_target.vertex_buffer.vk_memory);
         if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _onscreen_target.vertex_buffer.vk_buffer,
-                                             _onscreen_target.vertex_buffer.vk_memory, 0)) {
+                                             _onscreen_target.vertex_buffer.memory.vk_memory,
+                                             _onscreen_target.vertex_buffer.memory.vk_offset)) {
             logger.LogFatalError("Failed to bind vertex buffer memory");
             return false;
         }
@@ -1031,19 +992,19 @@ bool OffscreenRenderingApp::Setup() {
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 _onscreen_target.index_buffer.vk_buffer,
                 (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                _onscreen_target.index_buffer.vk_memory, _onscreen_target.index_buffer.vk_size)) {
+                _onscreen_target.index_buffer.memory)) {
             logger.LogFatalError("Failed to allocate index buffer memory");
             return false;
         }
-        if (VK_SUCCESS != vkMapMemory(_vk_device, _onscreen_target.index_buffer.vk_memory, 0,
-                                      _onscreen_target.index_buffer.vk_size, 0, (void **)&mapped_data)) {
+        mapped_data = _onscreen_target.index_buffer.memory.mapped_data;
+        if (nullptr == mapped_data) {
             logger.LogFatalError("Failed to map index buffer memory");
             return false;
         }
         memcpy(mapped_data, g_onscreen_cube_index_data, sizeof(g_onscreen_cube_index_data));
-        vkUnmapMemory(_vk_device, _onscreen_target.index_buffer.vk_memory);
         if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _onscreen_target.index_buffer.vk_buffer,
-                                             _onscreen_target.index_buffer.vk_memory, 0)) {
+                                             _onscreen_target.index_buffer.memory.vk_memory,
+                                             _onscreen_target.index_buffer.memory.vk_offset)) {
             logger.LogFatalError("Failed to bind index buffer memory");
             return false;
         }
@@ -1061,54 +1022,29 @@ bool OffscreenRenderingApp::Setup() {
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 _onscreen_target.uniform_buffer.vk_buffer,
                 (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                _onscreen_target.uniform_buffer.vk_memory, _onscreen_target.uniform_buffer.vk_size)) {
+                _onscreen_target.uniform_buffer.memory)) {
             logger.LogFatalError("Failed to allocate onscreen uniform buffer memory");
             return false;
         }
-        if (VK_SUCCESS != vkMapMemory(_vk_device, _onscreen_target.uniform_buffer.vk_memory, 0,
-                                      _onscreen_target.uniform_buffer.vk_size, 0,
-                                      (void **)&_onscreen_target.uniform_map)) {
+        _onscreen_target.uniform_map = _onscreen_target.uniform_buffer.memory.mapped_data;
+        if (nullptr == _onscreen_target.uniform_map) {
             logger.LogFatalError("Failed to map onscreen uniform buffer memory");
             return false;
         }
         if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _onscreen_target.uniform_buffer.vk_buffer,
-                                             _onscreen_target.uniform_buffer.vk_memory, 0)) {
+                                             _onscreen_target.uniform_buffer.memory.vk_memory,
+                                             _onscreen_target.uniform_buffer.memory.vk_offset)) {
             logger.LogFatalError("Failed to bind onscreen uniform buffer memory");
             return false;
         }
 
-        std::vector<VkDescriptorPoolSize> descriptor_pool_sizes;
-        VkDescriptorPoolSize pool_size = {};
-        pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-        pool_size.descriptorCount = 1;
-        descriptor_pool_sizes.push_back(pool_size);
-        pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        pool_size.descriptorCount = 2;
-        descriptor_pool_sizes.push_back(pool_size);
-        VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
-        descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        descriptor_pool_create_info.pNext = nullptr;
-        descriptor_pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-        descriptor_pool_create_info.maxSets = 2;
-        descriptor_pool_create_info.poolSizeCount = static_cast<uint32_t>(descriptor_pool_sizes.size());
-        descriptor_pool_create_info.pPoolSizes = descriptor_pool_sizes.data();
-        if (VK_SUCCESS != vkCreateDescriptorPool(_vk_device, &descriptor_pool_create_info, nullptr,
-                                                 &_onscreen_target.vk_descriptor_pool)) {
-            logger.LogFatalError("Failed to create descriptor pool");
-            return false;
-        }
-
-        VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
-        descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        descriptor_set_allocate_info.pNext = NULL;
-        descriptor_set_allocate_info.descriptorPool = _onscreen_target.vk_descriptor_pool;
-        descriptor_set_allocate_info.descriptorSetCount = 1;
-        descriptor_set_allocate_info.pSetLayouts = &_onscreen_target.vk_descriptor_set_layout;
-        if (VK_SUCCESS !=
-            vkAllocateDescriptorSets(_vk_device, &descriptor_set_allocate_info, &_onscreen_target.vk_descriptor_set)) {
+        GlobeDescriptorAllocator *descriptor_allocator = _globe_resource_mgr->GetDescriptorAllocator();
+        if (!descriptor_allocator->AllocatePersistentSet(_onscreen_target.vk_descriptor_set_layout,
+                                                         _onscreen_target.descriptor_allocation)) {
             logger.LogFatalError("Failed to allocate descriptor set");
             return false;
         }
+        _onscreen_target.vk_descriptor_set = _onscreen_target.descriptor_allocation.vk_descriptor_set;
 
         VkDescriptorBufferInfo descriptor_buffer_info = {};
         descriptor_buffer_info.buffer = _onscreen_target.uniform_buffer.vk_buffer;
@@ -1194,12 +1130,7 @@ bool OffscreenRenderingApp::Update(float diff_ms) {
     uniform_map += sizeof(glm::mat4);
     glm::mat4 view_mat = _offscreen_camera.ViewMatrix();
     memcpy(uniform_map, &view_mat, sizeof(glm::mat4));
-    VkMappedMemoryRange memory_range = {};
-    memory_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    memory_range.memory = _offscreen_target.uniform_buffer.vk_memory;
-    memory_range.size = _vk_uniform_frame_size;
-    memory_range.offset = offset;
-    vkFlushMappedMemoryRanges(_vk_device, 1, &memory_range);
+    _globe_resource_mgr->FlushDeviceMemory(_offscreen_target.uniform_buffer.memory, offset, _vk_uniform_frame_size);
 
     // Now onscreen
     uniform_map = _onscreen_target.uniform_map + offset;
@@ -1207,12 +1138,7 @@ bool OffscreenRenderingApp::Update(float diff_ms) {
     uniform_map += sizeof(glm::mat4);
     view_mat = _onscreen_camera.ViewMatrix();
     memcpy(uniform_map, &view_mat, sizeof(glm::mat4));
-    memory_range = {};
-    memory_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    memory_range.memory = _onscreen_target.uniform_buffer.vk_memory;
-    memory_range.size = _vk_uniform_frame_size;
-    memory_range.offset = offset;
-    vkFlushMappedMemoryRanges(_vk_device, 1, &memory_range);
+    _globe_resource_mgr->FlushDeviceMemory(_onscreen_target.uniform_buffer.memory, offset, _vk_uniform_frame_size);
 
     if (!UpdateOverlay(_current_buffer)) {
         logger.LogFatalError("Failed to update overlay");
@@ -29,9 +29,16 @@
 #include "globe/globe_shader.hpp"
 #include "globe/globe_texture.hpp"
 #include "globe/globe_resource_manager.hpp"
+#include "globe/globe_descriptor_allocator.hpp"
+#include "globe/globe_layout_cache.hpp"
+#include "globe/globe_pipeline_cache.hpp"
 #include "globe/globe_app.hpp"
 #include "globe/globe_main.hpp"
 
+// Dragons drawn side by side with one instanced draw when the instanced vertex shader has been built,
+// otherwise just the one in the middle.
+#define NUM_MODEL_INSTANCES 3
+
 class SimpleModelApp : public GlobeApp {
    public:
     SimpleModelApp();
@@ -52,9 +59,10 @@ class SimpleModelApp : public GlobeApp {
     GlobeVulkanBuffer _uniform_buffer;
     GlobeModel *_model;
     uint8_t *_uniform_map;
-    VkDescriptorPool _vk_descriptor_pool;
+    GlobeDescriptorAllocation _descriptor_allocation;
     VkDescriptorSet _vk_descriptor_set;
     VkPipeline _vk_pipeline;
+    VkPipeline _vk_instanced_pipeline;
     GlobeCamera _camera;
     float _camera_distance;
     float _camera_step;
@@ -71,13 +79,13 @@ SimpleModelApp::SimpleModelApp() {
     _vk_descriptor_set_layout = VK_NULL_HANDLE;
     _vk_pipeline_layout = VK_NULL_HANDLE;
     _vk_render_pass = VK_NULL_HANDLE;
-    _uniform_buffer.vk_size = 0;
     _uniform_buffer.vk_buffer = VK_NULL_HANDLE;
-    _uniform_buffer.vk_memory = VK_NULL_HANDLE;
+    _uniform_buffer.memory = {};
     _uniform_map = nullptr;
-    _vk_descriptor_pool = VK_NULL_HANDLE;
+    _descriptor_allocation = {};
     _vk_descriptor_set = VK_NULL_HANDLE;
     _vk_pipeline = VK_NULL_HANDLE;
+    _vk_instanced_pipeline = VK_NULL_HANDLE;
     _camera_distance = 15.f;
     _camera_step = 0.05f;
     _camera.SetPerspectiveProjection(1.0f, 45.f, 1.0f, 100.f);
@@ -109,21 +117,18 @@ void SimpleModelApp::CalculateModelMatrices(void) {
 void SimpleModelApp::CleanupCommandObjects(bool is_resize) {
     if (!_is_minimized) {
         if (VK_NULL_HANDLE != _vk_pipeline) {
-            vkDestroyPipeline(_vk_device, _vk_pipeline, nullptr);
+            _globe_resource_mgr->GetPipelineCache()->ReleaseGraphicsPipeline(_vk_pipeline);
             _vk_pipeline = VK_NULL_HANDLE;
         }
+        if (VK_NULL_HANDLE != _vk_instanced_pipeline) {
+            _globe_resource_mgr->GetPipelineCache()->ReleaseGraphicsPipeline(_vk_instanced_pipeline);
+            _vk_instanced_pipeline = VK_NULL_HANDLE;
+        }
         if (VK_NULL_HANDLE != _vk_descriptor_set) {
-            vkFreeDescriptorSets(_vk_device, _vk_descriptor_pool, 1, &_vk_descriptor_set);
+            _globe_resource_mgr->GetDescriptorAllocator()->FreePersistentSet(_descriptor_allocation);
             _vk_descriptor_set = VK_NULL_HANDLE;
         }
-        if (VK_NULL_HANDLE != _vk_descriptor_pool) {
-            vkDestroyDescriptorPool(_vk_device, _vk_descriptor_pool, nullptr);
-            _vk_descriptor_pool = VK_NULL_HANDLE;
-        }
-        if (nullptr != _uniform_map) {
-            vkUnmapMemory(_vk_device, _uniform_buffer.vk_memory);
-            _uniform_map = nullptr;
-        }
+        _uniform_map = nullptr;
         if (VK_NULL_HANDLE != _uniform_buffer.vk_buffer) {
             vkDestroyBuffer(_vk_device, _uniform_buffer.vk_buffer, nullptr);
             _uniform_buffer.vk_buffer = VK_NULL_HANDLE;
@@ -132,19 +137,15 @@ void SimpleModelApp::CleanupCommandObjects(bool is_resize) {
             _globe_resource_mgr->FreeModel(_model);
             _model = nullptr;
         }
-        _globe_resource_mgr->FreeDeviceMemory(_uniform_buffer.vk_memory);
+        _globe_resource_mgr->FreeDeviceMemory(_uniform_buffer.memory);
         if (VK_NULL_HANDLE != _vk_render_pass) {
+            _globe_resource_mgr->GetPipelineCache()->RemoveRenderPass(_vk_render_pass);
             vkDestroyRenderPass(_vk_device, _vk_render_pass, nullptr);
             _vk_render_pass = VK_NULL_HANDLE;
         }
-        if (VK_NULL_HANDLE != _vk_pipeline_layout) {
-            vkDestroyPipelineLayout(_vk_device, _vk_pipeline_layout, nullptr);
-            _vk_pipeline_layout = VK_NULL_HANDLE;
-        }
-        if (VK_NULL_HANDLE != _vk_descriptor_set_layout) {
-            vkDestroyDescriptorSetLayout(_vk_device, _vk_descriptor_set_layout, nullptr);
-            _vk_descriptor_set_layout = VK_NULL_HANDLE;
-        }
+        // The layouts belong to the resource manager's layout cache.
+        _vk_pipeline_layout = VK_NULL_HANDLE;
+        _vk_descriptor_set_layout = VK_NULL_HANDLE;
     }
     GlobeApp::CleanupCommandObjects(is_resize);
 }
@@ -177,12 +178,14 @@ bool SimpleModelApp::Setup() {
         sizes.specular_color = 4;
         sizes.emissive_color = 4;
         sizes.shininess = 4;
+        // Material colors and unit normals don't need full floats, which takes the vertex from 112 to 52 bytes.
+        sizes.normal_encoding = GLOBE_VERTEX_ENCODING_SNORM8;
+        sizes.color_encoding = GLOBE_VERTEX_ENCODING_UNORM8;
 
-        _model = _globe_resource_mgr->LoadModel("sascha_willems", "chinesedragon.dae", sizes);
-        if (nullptr == _model) {
-            logger.LogFatalError("Failed to load model file");
-            return false;
-        }
+        // Kick off the model and shader loads so they overlap with the rest of the setup below.
+        GlobeAsyncLoadHandle model_handle =
+            _globe_resource_mgr->LoadModelAsync("sascha_willems", "chinesedragon.dae", sizes);
+        GlobeAsyncLoadHandle shader_handle = _globe_resource_mgr->LoadShaderAsync("phong");
 
         uint8_t *mapped_data;
 
@@ -193,13 +196,9 @@ bool SimpleModelApp::Setup() {
         descriptor_set_layout_bindings.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
         descriptor_set_layout_bindings.pImmutableSamplers = nullptr;
 
-        VkDescriptorSetLayoutCreateInfo descriptor_set_layout = {};
-        descriptor_set_layout.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        descriptor_set_layout.pNext = nullptr;
-        descriptor_set_layout.bindingCount = 1;
-        descriptor_set_layout.pBindings = &descriptor_set_layout_bindings;
-        if (VK_SUCCESS !=
-            vkCreateDescriptorSetLayout(_vk_device, &descriptor_set_layout, nullptr, &_vk_descriptor_set_layout)) {
+        _vk_descriptor_set_layout =
+            _globe_resource_mgr->GetLayoutCache()->GetDescriptorSetLayout({descriptor_set_layout_bindings});
+        if (VK_NULL_HANDLE == _vk_descriptor_set_layout) {
             logger.LogFatalError("Failed to create descriptor set layout");
             return false;
         }
@@ -209,15 +208,9 @@ bool SimpleModelApp::Setup() {
         push_constant_range.offset = 0;
         push_constant_range.size = sizeof(glm::mat4);
 
-        VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
-        pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipeline_layout_create_info.pNext = nullptr;
-        pipeline_layout_create_info.setLayoutCount = 1;
-        pipeline_layout_create_info.pSetLayouts = &_vk_descriptor_set_layout;
-        pipeline_layout_create_info.pushConstantRangeCount = 1;
-        pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
-        if (VK_SUCCESS !=
-            vkCreatePipelineLayout(_vk_device, &pipeline_layout_create_info, nullptr, &_vk_pipeline_layout)) {
+        _vk_pipeline_layout = _globe_resource_mgr->GetLayoutCache()->GetPipelineLayout({_vk_descriptor_set_layout},
+                                                                                       {push_constant_range});
+        if (VK_NULL_HANDLE == _vk_pipeline_layout) {
             logger.LogFatalError("Failed to create pipeline layout layout");
             return false;
         }
@@ -282,6 +275,7 @@ bool SimpleModelApp::Setup() {
             logger.LogFatalError("Failed to create renderpass");
             return false;
         }
+        _globe_resource_mgr->GetPipelineCache()->AddRenderPass(_vk_render_pass, render_pass_create_info);
 
         // Create the vertex buffer
         VkBufferCreateInfo buffer_create_info = {};
@@ -301,46 +295,27 @@ bool SimpleModelApp::Setup() {
         }
         if (!_globe_resource_mgr->AllocateDeviceBufferMemory(
                 _uniform_buffer.vk_buffer, (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-                _uniform_buffer.vk_memory, _uniform_buffer.vk_size)) {
+                _uniform_buffer.memory)) {
             logger.LogFatalError("Failed to allocate uniform buffer memory");
             return false;
         }
-        if (VK_SUCCESS !=
-            vkMapMemory(_vk_device, _uniform_buffer.vk_memory, 0, VK_WHOLE_SIZE, 0, (void **)&_uniform_map)) {
+        _uniform_map = _uniform_buffer.memory.mapped_data;
+        if (nullptr == _uniform_map) {
             logger.LogFatalError("Failed to map uniform buffer memory");
             return false;
         }
-        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _uniform_buffer.vk_buffer, _uniform_buffer.vk_memory, 0)) {
+        if (VK_SUCCESS != vkBindBufferMemory(_vk_device, _uniform_buffer.vk_buffer, _uniform_buffer.memory.vk_memory,
+                                             _uniform_buffer.memory.vk_offset)) {
             logger.LogFatalError("Failed to bind uniform buffer memory");
             return false;
         }
 
-        VkDescriptorPoolSize descriptor_pool_size = {};
-        descriptor_pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-        descriptor_pool_size.descriptorCount = 1;
-        VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
-        descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        descriptor_pool_create_info.pNext = nullptr;
-        descriptor_pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-        descriptor_pool_create_info.maxSets = 2;
-        descriptor_pool_create_info.poolSizeCount = 1;
-        descriptor_pool_create_info.pPoolSizes = &descriptor_pool_size;
-        if (VK_SUCCESS !=
-            vkCreateDescriptorPool(_vk_device, &descriptor_pool_create_info, nullptr, &_vk_descriptor_pool)) {
-            logger.LogFatalError("Failed to create descriptor pool");
-            return false;
-        }
-
-        VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
-        descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        descriptor_set_allocate_info.pNext = NULL;
-        descriptor_set_allocate_info.descriptorPool = _vk_descriptor_pool;
-        descriptor_set_allocate_info.descriptorSetCount = 1;
-        descriptor_set_allocate_info.pSetLayouts = &_vk_descriptor_set_layout;
-        if (VK_SUCCESS != vkAllocateDescriptorSets(_vk_device, &descriptor_set_allocate_info, &_vk_descriptor_set)) {
+        if (!_globe_resource_mgr->GetDescriptorAllocator()->AllocatePersistentSet(_vk_descriptor_set_layout,
+                                                                                   _descriptor_allocation)) {
             logger.LogFatalError("Failed to allocate descriptor set");
             return false;
         }
+        _vk_descriptor_set = _descriptor_allocation.vk_descriptor_set;
 
         VkDescriptorBufferInfo descriptor_buffer_info = {};
         descriptor_buffer_info.buffer = _uniform_buffer.vk_buffer;
@@ -430,7 +405,13 @@ bool SimpleModelApp::Setup() {
         pipeline_multisample_state_create_info.pSampleMask = nullptr;
         pipeline_multisample_state_create_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
-        GlobeShader *cube_shader = _globe_resource_mgr->LoadShader("phong");
+        _globe_resource_mgr->WaitAllAsyncLoads();
+        _model = _globe_resource_mgr->GetAsyncModel(model_handle);
+        if (nullptr == _model) {
+            logger.LogFatalError("Failed to load model file");
+            return false;
+        }
+        GlobeShader *cube_shader = _globe_resource_mgr->GetAsyncShader(shader_handle);
         if (nullptr == cube_shader) {
             logger.LogFatalError("Failed to load phong shaders");
             return false;
@@ -452,12 +433,40 @@ bool SimpleModelApp::Setup() {
         gfx_pipeline_create_info.pStages = pipeline_shader_stage_create_info.data();
         gfx_pipeline_create_info.renderPass = _vk_render_pass;
         gfx_pipeline_create_info.pDynamicState = &pipeline_dynamic_state_create_info;
-        if (VK_SUCCESS != vkCreateGraphicsPipelines(_vk_device, VK_NULL_HANDLE, 1, &gfx_pipeline_create_info, nullptr,
-                                                    &_vk_pipeline)) {
+        _vk_pipeline = _globe_resource_mgr->GetPipelineCache()->GetGraphicsPipeline(gfx_pipeline_create_info);
+        if (VK_NULL_HANDLE == _vk_pipeline) {
             logger.LogFatalError("Failed to create graphics pipeline");
             return false;
         }
 
+        // The instanced pipeline swaps in the instanced vertex stage, which takes the model matrices from the
+        // instance attributes.  It's optional, without the compiled shader only one dragon is drawn.
+        GlobeShader *instanced_shader = nullptr;
+        if (_globe_resource_mgr->HasShader("phong_instanced")) {
+            instanced_shader = _globe_resource_mgr->LoadShader("phong_instanced");
+        }
+        std::vector<VkPipelineShaderStageCreateInfo> instanced_stage_create_info;
+        if (nullptr != instanced_shader && instanced_shader->IsValid() &&
+            instanced_shader->GetPipelineShaderStages(instanced_stage_create_info)) {
+            for (const auto &stage_create_info : pipeline_shader_stage_create_info) {
+                if (VK_SHADER_STAGE_VERTEX_BIT != stage_create_info.stage) {
+                    instanced_stage_create_info.push_back(stage_create_info);
+                }
+            }
+            VkGraphicsPipelineCreateInfo instanced_pipeline_create_info = gfx_pipeline_create_info;
+            _model->FillInPipelineInfo(instanced_pipeline_create_info, true);
+            instanced_pipeline_create_info.stageCount = static_cast<uint32_t>(instanced_stage_create_info.size());
+            instanced_pipeline_create_info.pStages = instanced_stage_create_info.data();
+            _vk_instanced_pipeline =
+                _globe_resource_mgr->GetPipelineCache()->GetGraphicsPipeline(instanced_pipeline_create_info);
+            if (VK_NULL_HANDLE == _vk_instanced_pipeline) {
+                logger.LogWarning("Failed to create instanced graphics pipeline, drawing dragons one by one");
+            }
+        }
+        if (nullptr != instanced_shader) {
+            _globe_resource_mgr->FreeShader(instanced_shader);
+        }
+
         _globe_resource_mgr->FreeShader(cube_shader);
     }
 
@@ -505,12 +514,8 @@ bool SimpleModelApp::Update(float diff_ms) {
     cur_uniform_pointer += sizeof(glm::vec4);
     memcpy(cur_uniform_pointer, &_light_color, sizeof(glm::vec4));
 
-    VkMappedMemoryRange mapped_range = {};
-    mapped_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    mapped_range.memory = _uniform_buffer.vk_memory;
-    mapped_range.offset = (_vk_uniform_frame_size * _current_buffer);
-    mapped_range.size = _vk_uniform_frame_size;
-    vkFlushMappedMemoryRanges(_vk_device, 1, &mapped_range);
+    _globe_resource_mgr->FlushDeviceMemory(_uniform_buffer.memory, _vk_uniform_frame_size * _current_buffer,
+                                           _vk_uniform_frame_size);
 
     if (!UpdateOverlay(_current_buffer)) {
         logger.LogFatalError("Failed to update overlay");
@@ -576,11 +581,36 @@ bool SimpleModelApp::Draw() {
     uint32_t dynamic_offset = _current_buffer * static_cast<uint32_t>(_vk_uniform_frame_size);
     vkCmdBindDescriptorSets(vk_render_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _vk_pipeline_layout, 0, 1,
                             &_vk_descriptor_set, 1, &dynamic_offset);
-    vkCmdBindPipeline(vk_render_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _vk_pipeline);
 
-    const VkDeviceSize vert_buffer_offset = 0;
-    vkCmdPushConstants(vk_render_command_buffer, _vk_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, 64, &_model_mat);
-    _model->Draw(vk_render_command_buffer);
+    uint32_t lod = _model->SelectLod(_camera, _model_mat, static_cast<float>(_height));
+    bool drawn_instanced = false;
+    if (VK_NULL_HANDLE != _vk_instanced_pipeline) {
+        // The dragons stand side by side, the center one being the one the camera orbits.  Their matrices go
+        // into the resource manager's per-frame instance ring, which recycles them once this frame completes.
+        float size_x = 0.f;
+        float size_y = 0.f;
+        float size_z = 0.f;
+        _model->GetSize(size_x, size_y, size_z);
+        glm::mat4 instance_mats[NUM_MODEL_INSTANCES];
+        for (uint32_t instance = 0; instance < NUM_MODEL_INSTANCES; ++instance) {
+            float offset = (static_cast<float>(instance) - (NUM_MODEL_INSTANCES - 1) * 0.5f) * size_x * 1.25f;
+            instance_mats[instance] = glm::translate(glm::mat4(1), glm::vec3(offset, 0.f, 0.f)) * _model_mat;
+        }
+        VkBuffer instance_buffer = VK_NULL_HANDLE;
+        VkDeviceSize instance_offset = 0;
+        if (_model->WriteInstanceTransforms(instance_mats, NUM_MODEL_INSTANCES, instance_buffer, instance_offset)) {
+            vkCmdBindPipeline(vk_render_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _vk_instanced_pipeline);
+            _model->DrawInstanced(vk_render_command_buffer, instance_buffer, instance_offset, NUM_MODEL_INSTANCES,
+                                  lod);
+            drawn_instanced = true;
+        }
+    }
+    if (!drawn_instanced) {
+        vkCmdBindPipeline(vk_render_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _vk_pipeline);
+        vkCmdPushConstants(vk_render_command_buffer, _vk_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, 64,
+                           &_model_mat);
+        _model->Draw(vk_render_command_buffer, lod);
+    }
 
     DrawOverlay(vk_render_command_buffer, _current_buffer);
 
@@ -0,0 +1,201 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    tools/globe_block_compress_bench.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+// Measures GlobeBlockCompressor in megatexels per second for each block format, and decodes the result
+// again to report the PSNR against the source image.
+//
+//     globe_block_compress_bench [iterations]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "globe/globe_block_compressor.hpp"
+#include "globe/globe_thread_pool.hpp"
+
+#define BENCH_WIDTH 2048
+#define BENCH_HEIGHT 2048
+
+static void DecodeRgb565(uint16_t packed, int32_t* color) {
+    int32_t red = (packed >> 11) & 0x1F;
+    int32_t green = (packed >> 5) & 0x3F;
+    int32_t blue = packed & 0x1F;
+    color[0] = (red << 3) | (red >> 2);
+    color[1] = (green << 2) | (green >> 4);
+    color[2] = (blue << 3) | (blue >> 2);
+}
+
+static void DecodeBc1Color(const uint8_t* block, uint8_t* texels) {
+    uint16_t color0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+    uint16_t color1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+    int32_t palette[4][3];
+    DecodeRgb565(color0, palette[0]);
+    DecodeRgb565(color1, palette[1]);
+    for (uint32_t comp = 0; comp < 3; ++comp) {
+        if (color0 > color1) {
+            palette[2][comp] = (2 * palette[0][comp] + palette[1][comp]) / 3;
+            palette[3][comp] = (palette[0][comp] + 2 * palette[1][comp]) / 3;
+        } else {
+            palette[2][comp] = (palette[0][comp] + palette[1][comp]) / 2;
+            palette[3][comp] = 0;
+        }
+    }
+    uint32_t indices;
+    memcpy(&indices, block + 4, 4);
+    for (uint32_t texel = 0; texel < 16; ++texel) {
+        for (uint32_t comp = 0; comp < 3; ++comp) {
+            texels[texel * 4 + comp] = static_cast<uint8_t>(palette[(indices >> (texel * 2)) & 3][comp]);
+        }
+        texels[texel * 4 + 3] = 255;
+    }
+}
+
+static void DecodeBc3Alpha(const uint8_t* block, uint8_t* texels) {
+    int32_t palette[8] = {block[0], block[1]};
+    if (block[0] > block[1]) {
+        for (int32_t step = 1; step < 7; ++step) {
+            palette[step + 1] = ((7 - step) * block[0] + step * block[1]) / 7;
+        }
+    } else {
+        for (int32_t step = 1; step < 5; ++step) {
+            palette[step + 1] = ((5 - step) * block[0] + step * block[1]) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    uint64_t indices = 0;
+    for (uint32_t byte = 0; byte < 6; ++byte) {
+        indices |= static_cast<uint64_t>(block[2 + byte]) << (byte * 8);
+    }
+    for (uint32_t texel = 0; texel < 16; ++texel) {
+        texels[texel * 4 + 3] = static_cast<uint8_t>(palette[(indices >> (texel * 3)) & 7]);
+    }
+}
+
+static uint32_t ReadBits(const uint8_t* block, uint32_t& position, uint32_t num_bits) {
+    uint32_t value = 0;
+    for (uint32_t bit = 0; bit < num_bits; ++bit, ++position) {
+        value |= ((block[position / 8] >> (position % 8)) & 1) << bit;
+    }
+    return value;
+}
+
+// Only decodes mode 6, the one mode the compressor writes.
+static bool DecodeBc7Mode6(const uint8_t* block, uint8_t* texels) {
+    uint32_t position = 0;
+    if (1 << 6 != ReadBits(block, position, 7)) {
+        return false;
+    }
+    int32_t endpoints[2][4];
+    for (uint32_t comp = 0; comp < 4; ++comp) {
+        endpoints[0][comp] = ReadBits(block, position, 7) << 1;
+        endpoints[1][comp] = ReadBits(block, position, 7) << 1;
+    }
+    for (uint32_t endpoint = 0; endpoint < 2; ++endpoint) {
+        uint32_t p_bit = ReadBits(block, position, 1);
+        for (uint32_t comp = 0; comp < 4; ++comp) {
+            endpoints[endpoint][comp] |= p_bit;
+        }
+    }
+    static const int32_t weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+    for (uint32_t texel = 0; texel < 16; ++texel) {
+        int32_t weight = weights[ReadBits(block, position, 0 == texel ? 3 : 4)];
+        for (uint32_t comp = 0; comp < 4; ++comp) {
+            texels[texel * 4 + comp] =
+                static_cast<uint8_t>(((64 - weight) * endpoints[0][comp] + weight * endpoints[1][comp] + 32) >> 6);
+        }
+    }
+    return true;
+}
+
+static double Psnr(GlobeBlockFormat format, const std::vector<uint8_t>& image, const std::vector<uint8_t>& blocks) {
+    uint32_t blocks_wide = BENCH_WIDTH / 4;
+    uint32_t num_comps = GLOBE_BLOCK_FORMAT_BC1 == format ? 3 : 4;
+    double squared_error = 0.0;
+    for (uint32_t block_index = 0; block_index < blocks.size() / GlobeBlockCompressor::BlockSize(format);
+         ++block_index) {
+        const uint8_t* block = blocks.data() + block_index * GlobeBlockCompressor::BlockSize(format);
+        uint8_t texels[64];
+        switch (format) {
+            case GLOBE_BLOCK_FORMAT_BC1:
+                DecodeBc1Color(block, texels);
+                break;
+            case GLOBE_BLOCK_FORMAT_BC3:
+                DecodeBc1Color(block + 8, texels);
+                DecodeBc3Alpha(block, texels);
+                break;
+            case GLOBE_BLOCK_FORMAT_BC7:
+                if (!DecodeBc7Mode6(block, texels)) {
+                    return 0.0;
+                }
+                break;
+        }
+        uint32_t x = (block_index % blocks_wide) * 4;
+        uint32_t y = (block_index / blocks_wide) * 4;
+        for (uint32_t texel = 0; texel < 16; ++texel) {
+            const uint8_t* source = image.data() + ((y + texel / 4) * BENCH_WIDTH + x + texel % 4) * 4;
+            for (uint32_t comp = 0; comp < num_comps; ++comp) {
+                double difference = static_cast<double>(texels[texel * 4 + comp]) - source[comp];
+                squared_error += difference * difference;
+            }
+        }
+    }
+    double mean_squared_error = squared_error / (static_cast<double>(BENCH_WIDTH) * BENCH_HEIGHT * num_comps);
+    return 10.0 * log10(255.0 * 255.0 / std::max(mean_squared_error, 1e-10));
+}
+
+int main(int argc, char** argv) {
+    uint32_t iterations = 5;
+    if (argc > 1) {
+        iterations = std::max(atoi(argv[1]), 1);
+    }
+    uint32_t num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    printf("globe_block_compress_bench: %s, %u threads, %ux%u texels, %u iterations\n",
+           GlobeBlockCompressor::SimdPathName(), num_threads, BENCH_WIDTH, BENCH_HEIGHT, iterations);
+
+    // Smooth gradients with a little noise, closer to a real texture than pure noise.
+    std::vector<uint8_t> image(static_cast<size_t>(BENCH_WIDTH) * BENCH_HEIGHT * 4);
+    srand(1);
+    for (uint32_t y = 0; y < BENCH_HEIGHT; ++y) {
+        for (uint32_t x = 0; x < BENCH_WIDTH; ++x) {
+            uint8_t* texel = image.data() + (static_cast<size_t>(y) * BENCH_WIDTH + x) * 4;
+            texel[0] = static_cast<uint8_t>(128 + 120 * sin(x * 0.021) + (rand() & 7));
+            texel[1] = static_cast<uint8_t>(128 + 120 * cos(y * 0.017) + (rand() & 7));
+            texel[2] = static_cast<uint8_t>((x + y) / 16);
+            texel[3] = static_cast<uint8_t>(128 + 120 * sin((x + y) * 0.013));
+        }
+    }
+
+    GlobeThreadPool thread_pool(num_threads);
+    const char* format_names[] = {"BC1", "BC3", "BC7"};
+    for (uint32_t format_index = 0; format_index < 3; ++format_index) {
+        GlobeBlockFormat format = static_cast<GlobeBlockFormat>(format_index);
+        std::vector<uint8_t> blocks(GlobeBlockCompressor::CompressedSize(format, BENCH_WIDTH, BENCH_HEIGHT));
+        double megatexels_per_second[2];
+        for (uint32_t threaded = 0; threaded < 2; ++threaded) {
+            GlobeBlockCompressor block_compressor(threaded ? &thread_pool : nullptr, format);
+            block_compressor.Compress(image.data(), BENCH_WIDTH, BENCH_HEIGHT, blocks.data());  // Warm up caches
+            auto start = std::chrono::high_resolution_clock::now();
+            for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+                block_compressor.Compress(image.data(), BENCH_WIDTH, BENCH_HEIGHT, blocks.data());
+            }
+            std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+            megatexels_per_second[threaded] =
+                (static_cast<double>(BENCH_WIDTH) * BENCH_HEIGHT * iterations) / (seconds.count() * 1000000.0);
+        }
+        printf("%s   single thread %8.1f MT/s   thread pool %8.1f MT/s   PSNR %5.2f dB\n", format_names[format_index],
+               megatexels_per_second[0], megatexels_per_second[1], Psnr(format, image, blocks));
+    }
+    return 0;
+}
@@ -0,0 +1,204 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    tools/globe_mipmap_bench.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+// Measures CPU mip chain generation in source megapixels per second, comparing the original scalar
+// generator against GlobeMipmapGenerator.  Before timing anything, it checks that the SIMD and threaded
+// chains are byte for byte identical to the scalar ones, and fails if any of them differ.
+//
+//     globe_mipmap_bench [iterations]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "globe/globe_mipmap_generator.hpp"
+#include "globe/globe_thread_pool.hpp"
+
+// The generator GlobeTexture used before GlobeMipmapGenerator, kept as the baseline.  It indexes rows
+// by the height, so it is only safe to run on square images.
+static uint32_t LegacyPreviousPowerOfTwo(uint32_t number) {
+    if (!number) {
+        return 0;
+    }
+    uint32_t power = 1;
+    while (power < number) {
+        uint32_t new_power = power << 1;
+        if (new_power > number) {
+            return power;
+        }
+        if (new_power == 0x80000000) {
+            return new_power;
+        }
+        power = new_power;
+    }
+    return 0;
+}
+
+static void LegacySampleSource(const uint8_t* src, uint32_t width, uint32_t height, uint32_t x, uint32_t y,
+                               uint8_t* dst) {
+    uint32_t next_x = x + 1;
+    if (next_x >= width) {
+        next_x = x;
+    }
+    uint32_t next_y = y + 1;
+    if (next_y >= height) {
+        next_y = y;
+    }
+    for (uint32_t comp = 0; comp < 4; ++comp) {
+        uint32_t sum = src[((y * height + x) * 4) + comp];
+        sum += src[((y * height + next_x) * 4) + comp];
+        sum += src[((next_y * height + x) * 4) + comp];
+        sum += src[((next_y * height + next_x) * 4) + comp];
+        dst[comp] = static_cast<uint8_t>(sum >> 2);
+    }
+}
+
+static void LegacyGenerateMipmaps(std::vector<uint8_t>& raw_data, uint32_t start_width, uint32_t start_height) {
+    uint32_t last_width = start_width;
+    uint32_t last_height = start_height;
+    uint32_t last_offset = 0;
+    uint32_t cur_width = LegacyPreviousPowerOfTwo(start_width);
+    uint32_t cur_height = LegacyPreviousPowerOfTwo(start_height);
+    uint32_t cur_offset = start_width * start_height * 4;
+    while (cur_width >= 1 && cur_height >= 1) {
+        raw_data.resize(raw_data.size() + cur_width * cur_height * 4);
+        uint8_t* dst_ptr = raw_data.data() + cur_offset;
+        uint8_t* src_ptr = raw_data.data() + last_offset;
+        for (uint32_t row = 0; row < cur_height; ++row) {
+            for (uint32_t col = 0; col < cur_width; ++col) {
+                LegacySampleSource(src_ptr, last_width, last_height, col * 2, row * 2,
+                                   &dst_ptr[(row * cur_height + col) * 4]);
+            }
+        }
+        cur_offset += cur_width * cur_height * 4;
+        last_width = cur_width;
+        last_height = cur_height;
+        cur_width >>= 1;
+        cur_height >>= 1;
+    }
+}
+
+static double MegapixelsPerSecond(uint32_t width, uint32_t height, uint32_t iterations,
+                                  const std::function<void()>& run) {
+    run();  // Warm up caches and the thread pool
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+        run();
+    }
+    std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+    return (static_cast<double>(width) * height * iterations) / (seconds.count() * 1000000.0);
+}
+
+static void FillRandom(std::vector<uint8_t>& data) {
+    srand(1);
+    for (auto& value : data) {
+        value = static_cast<uint8_t>(rand());
+    }
+}
+
+static bool MatchesScalar(const char* label, const std::vector<uint8_t>& chain, const std::vector<uint8_t>& scalar,
+                          uint32_t width, uint32_t height, GlobeMipmapFilter filter) {
+    if (0 == memcmp(chain.data(), scalar.data(), scalar.size())) {
+        return true;
+    }
+    size_t offset = 0;
+    while (chain[offset] == scalar[offset]) {
+        ++offset;
+    }
+    fprintf(stderr, "globe_mipmap_bench: %s %s chain of %ux%u differs from the scalar one at byte %zu (%u vs %u)\n",
+            label, GLOBE_MIPMAP_FILTER_KAISER == filter ? "kaiser" : "box", width, height, offset, chain[offset],
+            scalar[offset]);
+    return false;
+}
+
+// Runs both filters over power of two, odd and degenerate sizes so every kernel and its scalar tail is
+// compared against the scalar generator.
+static bool CheckExactness(GlobeThreadPool* thread_pool) {
+    const uint32_t sizes[][2] = {{256, 256}, {1999, 1031}, {257, 129}, {31, 17}, {1, 7}, {13, 1}, {3, 3}};
+    const GlobeMipmapFilter filters[] = {GLOBE_MIPMAP_FILTER_BOX, GLOBE_MIPMAP_FILTER_KAISER};
+    bool matches = true;
+    for (const auto& size : sizes) {
+        uint32_t width = size[0];
+        uint32_t height = size[1];
+        std::vector<uint8_t> scalar(GlobeMipmapGenerator::MipChainSize(width, height));
+        FillRandom(scalar);
+        std::fill(scalar.begin() + static_cast<size_t>(width) * height * 4, scalar.end(), 0);
+        std::vector<uint8_t> simd(scalar);
+        std::vector<uint8_t> threaded(scalar);
+        for (GlobeMipmapFilter filter : filters) {
+            GlobeMipmapGenerator(nullptr, filter, false).Generate(scalar.data(), width, height);
+            GlobeMipmapGenerator(nullptr, filter).Generate(simd.data(), width, height);
+            GlobeMipmapGenerator(thread_pool, filter).Generate(threaded.data(), width, height);
+            matches &= MatchesScalar("SIMD", simd, scalar, width, height, filter);
+            matches &= MatchesScalar("threaded", threaded, scalar, width, height, filter);
+        }
+    }
+    return matches;
+}
+
+int main(int argc, char** argv) {
+    uint32_t iterations = 10;
+    if (argc > 1) {
+        iterations = std::max(atoi(argv[1]), 1);
+    }
+    uint32_t num_threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    GlobeThreadPool thread_pool(num_threads);
+    printf("globe_mipmap_bench: %s box path, %u worker threads, %u iterations\n",
+           GlobeMipmapGenerator::SimdPathName(), num_threads, iterations);
+    if (!CheckExactness(&thread_pool)) {
+        return 1;
+    }
+    printf("SIMD and threaded chains match the scalar generator\n");
+
+    const uint32_t sizes[][2] = {{2048, 2048}, {4096, 4096}, {1999, 1031}};
+    for (const auto& size : sizes) {
+        uint32_t width = size[0];
+        uint32_t height = size[1];
+        std::vector<uint8_t> base_level(static_cast<size_t>(width) * height * 4);
+        FillRandom(base_level);
+        std::vector<uint8_t> chain(GlobeMipmapGenerator::MipChainSize(width, height));
+        std::copy(base_level.begin(), base_level.end(), chain.begin());
+
+        std::vector<uint8_t> legacy_chain;
+        double legacy = 0.0;
+        if (width == height) {
+            legacy = MegapixelsPerSecond(width, height, iterations, [&]() {
+                legacy_chain = base_level;
+                LegacyGenerateMipmaps(legacy_chain, width, height);
+            });
+        }
+        GlobeMipmapGenerator single_box(nullptr);
+        double box = MegapixelsPerSecond(width, height, iterations,
+                                         [&]() { single_box.Generate(chain.data(), width, height); });
+        GlobeMipmapGenerator pool_box(&thread_pool);
+        double box_threaded = MegapixelsPerSecond(width, height, iterations,
+                                                  [&]() { pool_box.Generate(chain.data(), width, height); });
+        GlobeMipmapGenerator single_kaiser(nullptr, GLOBE_MIPMAP_FILTER_KAISER);
+        double kaiser = MegapixelsPerSecond(width, height, iterations,
+                                            [&]() { single_kaiser.Generate(chain.data(), width, height); });
+        GlobeMipmapGenerator pool_kaiser(&thread_pool, GLOBE_MIPMAP_FILTER_KAISER);
+        double kaiser_threaded = MegapixelsPerSecond(width, height, iterations,
+                                                     [&]() { pool_kaiser.Generate(chain.data(), width, height); });
+
+        printf("%5ux%-5u", width, height);
+        if (width == height) {
+            printf("  legacy %7.1f MP/s  box %7.1f MP/s (%.1fx)  box threaded %7.1f MP/s (%.1fx)", legacy, box,
+                   box / legacy, box_threaded, box_threaded / legacy);
+        } else {
+            printf("  legacy     n/a       box %7.1f MP/s         box threaded %7.1f MP/s       ", box, box_threaded);
+        }
+        printf("  kaiser %7.1f MP/s  kaiser threaded %7.1f MP/s\n", kaiser, kaiser_threaded);
+    }
+    return 0;
+}
@@ -0,0 +1,222 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    tools/globe_pack.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+// Packs a resource directory into a single GlobeAssetArchive file.
+//
+//     globe_pack [-x <excluded relative path>]... <resource directory> <archive file>
+//
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "globe/globe_asset_archive.hpp"
+
+struct PackFile {
+    std::string relative_path;
+    std::string full_path;
+    uint64_t size;
+};
+
+static bool IsExcluded(const std::string& relative_path, const std::vector<std::string>& excludes) {
+    for (const auto& exclude : excludes) {
+        if (relative_path == exclude ||
+            (relative_path.size() > exclude.size() && 0 == relative_path.compare(0, exclude.size(), exclude) &&
+             '/' == relative_path[exclude.size()])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool CollectFiles(const std::string& root, const std::string& relative_dir,
+                         const std::vector<std::string>& excludes, std::vector<PackFile>& files) {
+    std::string directory = root;
+    if (!relative_dir.empty()) {
+        directory += "/";
+        directory += relative_dir;
+    }
+    std::vector<std::string> names;
+    std::vector<bool> is_directory;
+#if defined(_WIN32)
+    WIN32_FIND_DATAA find_data = {};
+    HANDLE find_handle = FindFirstFileA((directory + "/*").c_str(), &find_data);
+    if (INVALID_HANDLE_VALUE == find_handle) {
+        return false;
+    }
+    do {
+        names.push_back(find_data.cFileName);
+        is_directory.push_back(0 != (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY));
+    } while (FindNextFileA(find_handle, &find_data));
+    FindClose(find_handle);
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (nullptr == dir) {
+        return false;
+    }
+    while (struct dirent* dir_entry = readdir(dir)) {
+        struct stat entry_stat = {};
+        if (0 == stat((directory + "/" + dir_entry->d_name).c_str(), &entry_stat)) {
+            names.push_back(dir_entry->d_name);
+            is_directory.push_back(S_ISDIR(entry_stat.st_mode));
+        }
+    }
+    closedir(dir);
+#endif
+
+    for (size_t cur_name = 0; cur_name < names.size(); ++cur_name) {
+        const std::string& name = names[cur_name];
+        // Skip ".", ".." and hidden files
+        if (name.empty() || '.' == name[0]) {
+            continue;
+        }
+        std::string relative_path = relative_dir.empty() ? name : relative_dir + "/" + name;
+        if (IsExcluded(relative_path, excludes)) {
+            continue;
+        }
+        if (is_directory[cur_name]) {
+            if (!CollectFiles(root, relative_path, excludes, files)) {
+                return false;
+            }
+        } else {
+            PackFile file = {};
+            file.relative_path = relative_path;
+            file.full_path = root + "/" + relative_path;
+            files.push_back(file);
+        }
+    }
+    return true;
+}
+
+static bool WritePadding(FILE* file_ptr, uint64_t& offset, uint64_t alignment) {
+    static const uint8_t zeroes[GLOBE_ASSET_ARCHIVE_ALIGNMENT] = {};
+    uint64_t padding = (alignment - (offset % alignment)) % alignment;
+    offset += padding;
+    return 0 == padding || 1 == fwrite(zeroes, static_cast<size_t>(padding), 1, file_ptr);
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> excludes;
+    std::vector<std::string> positional;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (0 == strcmp(argv[arg], "-x") && arg + 1 < argc) {
+            excludes.push_back(GlobeAssetArchiveNormalizePath(argv[++arg]));
+        } else {
+            positional.push_back(argv[arg]);
+        }
+    }
+    if (positional.size() != 2) {
+        fprintf(stderr, "Usage: globe_pack [-x <excluded relative path>]... <resource directory> <archive file>\n");
+        return 1;
+    }
+    const std::string& root = positional[0];
+    const std::string& archive_name = positional[1];
+
+    std::vector<PackFile> files;
+    if (!CollectFiles(root, "", excludes, files)) {
+        fprintf(stderr, "globe_pack: failed to read directory %s\n", root.c_str());
+        return 1;
+    }
+    for (auto& file : files) {
+        FILE* file_ptr = fopen(file.full_path.c_str(), "rb");
+        if (nullptr == file_ptr) {
+            fprintf(stderr, "globe_pack: failed to open %s\n", file.full_path.c_str());
+            return 1;
+        }
+        fseek(file_ptr, 0, SEEK_END);
+        file.size = static_cast<uint64_t>(ftell(file_ptr));
+        fclose(file_ptr);
+    }
+
+    // Order the index by hash (and by name for the rare collision) so the runtime can binary search it.
+    // The payloads go out in path order, which keeps files from the same directory together.
+    std::sort(files.begin(), files.end(),
+              [](const PackFile& a, const PackFile& b) { return a.relative_path < b.relative_path; });
+    std::vector<GlobeAssetArchiveEntry> entries(files.size());
+    std::string names;
+    uint64_t names_offset = sizeof(GlobeAssetArchiveHeader) + entries.size() * sizeof(GlobeAssetArchiveEntry);
+    for (size_t cur_file = 0; cur_file < files.size(); ++cur_file) {
+        entries[cur_file].path_hash = GlobeAssetArchivePathHash(files[cur_file].relative_path);
+        entries[cur_file].name_offset = static_cast<uint32_t>(names.size());
+        entries[cur_file].name_size = static_cast<uint32_t>(files[cur_file].relative_path.size());
+        names += files[cur_file].relative_path;
+    }
+    const uint64_t alignment_mask = GLOBE_ASSET_ARCHIVE_ALIGNMENT - 1;
+    uint64_t offset = names_offset + names.size();
+    for (size_t cur_file = 0; cur_file < files.size(); ++cur_file) {
+        offset = (offset + alignment_mask) & ~alignment_mask;
+        entries[cur_file].offset = offset;
+        entries[cur_file].size = files[cur_file].size;
+        offset += files[cur_file].size;
+    }
+    std::vector<GlobeAssetArchiveEntry> sorted_entries = entries;
+    std::sort(sorted_entries.begin(), sorted_entries.end(),
+              [&names](const GlobeAssetArchiveEntry& a, const GlobeAssetArchiveEntry& b) {
+                  if (a.path_hash != b.path_hash) {
+                      return a.path_hash < b.path_hash;
+                  }
+                  return names.compare(a.name_offset, a.name_size, names, b.name_offset, b.name_size) < 0;
+              });
+
+    GlobeAssetArchiveHeader header = {};
+    header.magic = GLOBE_ASSET_ARCHIVE_MAGIC;
+    header.version = GLOBE_ASSET_ARCHIVE_VERSION;
+    header.entry_count = static_cast<uint32_t>(sorted_entries.size());
+    header.toc_offset = sizeof(GlobeAssetArchiveHeader);
+    header.names_offset = names_offset;
+    header.names_size = names.size();
+
+    FILE* archive_ptr = fopen(archive_name.c_str(), "wb");
+    if (nullptr == archive_ptr) {
+        fprintf(stderr, "globe_pack: failed to create %s\n", archive_name.c_str());
+        return 1;
+    }
+    bool success = 1 == fwrite(&header, sizeof(header), 1, archive_ptr);
+    if (success && !sorted_entries.empty()) {
+        success = sorted_entries.size() == fwrite(sorted_entries.data(), sizeof(GlobeAssetArchiveEntry),
+                                                  sorted_entries.size(), archive_ptr);
+    }
+    if (success && !names.empty()) {
+        success = 1 == fwrite(names.data(), names.size(), 1, archive_ptr);
+    }
+    uint64_t write_offset = names_offset + names.size();
+    std::vector<uint8_t> contents;
+    for (size_t cur_file = 0; success && cur_file < files.size(); ++cur_file) {
+        success = WritePadding(archive_ptr, write_offset, GLOBE_ASSET_ARCHIVE_ALIGNMENT);
+        contents.resize(static_cast<size_t>(files[cur_file].size));
+        FILE* file_ptr = fopen(files[cur_file].full_path.c_str(), "rb");
+        if (nullptr == file_ptr || (!contents.empty() && 1 != fread(contents.data(), contents.size(), 1, file_ptr))) {
+            fprintf(stderr, "globe_pack: failed to read %s\n", files[cur_file].full_path.c_str());
+            success = false;
+        } else if (!contents.empty()) {
+            success = success && 1 == fwrite(contents.data(), contents.size(), 1, archive_ptr);
+        }
+        if (nullptr != file_ptr) {
+            fclose(file_ptr);
+        }
+        write_offset += files[cur_file].size;
+    }
+    fclose(archive_ptr);
+    if (!success) {
+        fprintf(stderr, "globe_pack: failed writing %s\n", archive_name.c_str());
+        remove(archive_name.c_str());
+        return 1;
+    }
+    printf("globe_pack: packed %u files (%llu bytes) into %s\n", header.entry_count,
+           static_cast<unsigned long long>(write_offset), archive_name.c_str());
+    return 0;
+}
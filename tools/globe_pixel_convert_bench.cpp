@@ -0,0 +1,196 @@
+//
+// Project:                 LunarGlobe
+// SPDX-License-Identifier: Apache-2.0
+//
+// File:                    tools/globe_pixel_convert_bench.cpp
+// Copyright(C):            2019; LunarG, Inc.
+// Author(s):               Mark Young <marky@lunarg.com>
+//
+// Measures the RGBA expansion of decoded images in megatexels per second, comparing the per-byte loops
+// GlobeTexture and GlobeFont used before against the GlobeConvertPixels converters.  Before timing anything,
+// it checks that the converters produce the same bytes as the per-byte loops, and fails if any differ.
+//
+//     globe_pixel_convert_bench [iterations]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "globe/globe_pixel_convert.hpp"
+
+#define BENCH_WIDTH 2048
+#define BENCH_HEIGHT 2048
+
+// The expansion LoadStandardFile used for images with fewer than 4 channels.
+static void LegacyExpandToRgba(const uint8_t* image_data, int32_t num_channels, uint8_t* raw_data, int32_t width,
+                               int32_t height) {
+    uint8_t* dst_ptr = raw_data;
+    const uint8_t* src_ptr = image_data;
+    for (int32_t row = 0; row < height; ++row) {
+        for (int32_t col = 0; col < width; ++col) {
+            int32_t comp = 0;
+            for (; comp < num_channels; ++comp) {
+                *dst_ptr++ = *src_ptr++;
+            }
+            while (comp++ < 4) {
+                if (comp == 4) {
+                    *dst_ptr++ = 255;
+                } else {
+                    *dst_ptr++ = 0;
+                }
+            }
+        }
+    }
+}
+
+// The copy GlobeFont used to build its RGBA atlas from the glyph bitmap.
+static void LegacyFontToRgba(const uint8_t* font_bitmap, uint8_t* raw_data, int32_t width, int32_t height) {
+    uint8_t* dst_ptr = raw_data;
+    const uint8_t* src_ptr = font_bitmap;
+    for (int32_t row = 0; row < height; ++row) {
+        for (int32_t col = 0; col < width; ++col) {
+            *dst_ptr++ = *src_ptr;
+            *dst_ptr++ = *src_ptr;
+            *dst_ptr++ = *src_ptr++;
+            *dst_ptr++ = 255;
+        }
+    }
+}
+
+// A plain per-texel swap, there was no BGRA path before.
+static void LegacySwizzle(const uint8_t* src, uint8_t* dst, size_t num_texels) {
+    for (size_t texel = 0; texel < num_texels; ++texel) {
+        dst[texel * 4] = src[texel * 4 + 2];
+        dst[texel * 4 + 1] = src[texel * 4 + 1];
+        dst[texel * 4 + 2] = src[texel * 4];
+        dst[texel * 4 + 3] = src[texel * 4 + 3];
+    }
+}
+
+// The image loop above leaves gray-alpha as (g, a, 0, 255), so the converter is checked against this one.
+static void ReferenceGrayAlphaToRgba(const uint8_t* src, uint8_t* dst, size_t num_texels) {
+    for (size_t texel = 0; texel < num_texels; ++texel) {
+        dst[texel * 4] = src[texel * 2];
+        dst[texel * 4 + 1] = src[texel * 2];
+        dst[texel * 4 + 2] = src[texel * 2];
+        dst[texel * 4 + 3] = src[texel * 2 + 1];
+    }
+}
+
+// Runs every converter over each length up to a few SIMD blocks and some larger odd lengths, so each
+// scalar tail is covered, from an aligned and an unaligned source.  The destinations are padded with a
+// guard pattern which must also come out untouched.
+static bool CheckExactness(const std::vector<uint8_t>& src) {
+    struct ExactCase {
+        const char* name;
+        GlobePixelConversion conversion;
+        std::function<void(const uint8_t*, uint8_t*, size_t)> reference;
+    };
+    const ExactCase exact_cases[] = {
+        {"rgb -> rgba", GLOBE_PIXEL_CONVERSION_RGB_TO_RGBA,
+         [](const uint8_t* in, uint8_t* out, size_t num_texels) {
+             LegacyExpandToRgba(in, 3, out, static_cast<int32_t>(num_texels), 1);
+         }},
+        {"gray -> rgba", GLOBE_PIXEL_CONVERSION_GRAY_TO_RGBA,
+         [](const uint8_t* in, uint8_t* out, size_t num_texels) {
+             LegacyFontToRgba(in, out, static_cast<int32_t>(num_texels), 1);
+         }},
+        {"gray alpha -> rgba", GLOBE_PIXEL_CONVERSION_GRAY_ALPHA_TO_RGBA, ReferenceGrayAlphaToRgba},
+        {"bgra <-> rgba", GLOBE_PIXEL_CONVERSION_SWIZZLE_BGRA_RGBA, LegacySwizzle},
+    };
+    std::vector<size_t> lengths;
+    for (size_t num_texels = 0; num_texels <= 70; ++num_texels) {
+        lengths.push_back(num_texels);
+    }
+    lengths.push_back(1023);
+    lengths.push_back(4097);
+    lengths.push_back(65537);
+
+    const size_t guard_size = 64;
+    bool matches = true;
+    for (const auto& exact_case : exact_cases) {
+        for (size_t src_offset = 0; src_offset < 2; ++src_offset) {
+            for (size_t num_texels : lengths) {
+                std::vector<uint8_t> expected(num_texels * 4 + guard_size, 0xCD);
+                std::vector<uint8_t> converted(expected);
+                exact_case.reference(src.data() + src_offset, expected.data(), num_texels);
+                GlobeConvertPixels(exact_case.conversion, src.data() + src_offset, converted.data(), num_texels);
+                if (0 != memcmp(expected.data(), converted.data(), expected.size())) {
+                    size_t offset = 0;
+                    while (expected[offset] == converted[offset]) {
+                        ++offset;
+                    }
+                    fprintf(stderr,
+                            "globe_pixel_convert_bench: %s of %zu texels (source offset %zu) differs from the "
+                            "per-byte loop at byte %zu (%u vs %u)\n",
+                            exact_case.name, num_texels, src_offset, offset, converted[offset], expected[offset]);
+                    matches = false;
+                    break;
+                }
+            }
+        }
+    }
+    return matches;
+}
+
+static double MegatexelsPerSecond(uint32_t iterations, const std::function<void()>& run) {
+    run();  // Warm up caches
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+        run();
+    }
+    std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+    return (static_cast<double>(BENCH_WIDTH) * BENCH_HEIGHT * iterations) / (seconds.count() * 1000000.0);
+}
+
+int main(int argc, char** argv) {
+    uint32_t iterations = 20;
+    if (argc > 1) {
+        iterations = std::max(atoi(argv[1]), 1);
+    }
+    printf("globe_pixel_convert_bench: %s converters, %ux%u texels, %u iterations\n", GlobePixelConvertSimdPathName(),
+           BENCH_WIDTH, BENCH_HEIGHT, iterations);
+
+    const size_t num_texels = static_cast<size_t>(BENCH_WIDTH) * BENCH_HEIGHT;
+    std::vector<uint8_t> src(num_texels * 4);
+    std::vector<uint8_t> dst(num_texels * 4);
+    srand(1);
+    for (auto& value : src) {
+        value = static_cast<uint8_t>(rand());
+    }
+    if (!CheckExactness(src)) {
+        return 1;
+    }
+    printf("converters match the per-byte loops\n");
+
+    struct BenchCase {
+        const char* name;
+        GlobePixelConversion conversion;
+        std::function<void()> legacy;
+    };
+    const BenchCase bench_cases[] = {
+        {"rgb -> rgba", GLOBE_PIXEL_CONVERSION_RGB_TO_RGBA,
+         [&]() { LegacyExpandToRgba(src.data(), 3, dst.data(), BENCH_WIDTH, BENCH_HEIGHT); }},
+        {"gray -> rgba", GLOBE_PIXEL_CONVERSION_GRAY_TO_RGBA,
+         [&]() { LegacyExpandToRgba(src.data(), 1, dst.data(), BENCH_WIDTH, BENCH_HEIGHT); }},
+        {"gray alpha -> rgba", GLOBE_PIXEL_CONVERSION_GRAY_ALPHA_TO_RGBA,
+         [&]() { LegacyExpandToRgba(src.data(), 2, dst.data(), BENCH_WIDTH, BENCH_HEIGHT); }},
+        {"font gray -> rgba", GLOBE_PIXEL_CONVERSION_GRAY_TO_RGBA,
+         [&]() { LegacyFontToRgba(src.data(), dst.data(), BENCH_WIDTH, BENCH_HEIGHT); }},
+        {"bgra <-> rgba", GLOBE_PIXEL_CONVERSION_SWIZZLE_BGRA_RGBA,
+         [&]() { LegacySwizzle(src.data(), dst.data(), num_texels); }},
+    };
+    for (const auto& bench_case : bench_cases) {
+        double legacy = MegatexelsPerSecond(iterations, bench_case.legacy);
+        double converted = MegatexelsPerSecond(
+            iterations, [&]() { GlobeConvertPixels(bench_case.conversion, src.data(), dst.data(), num_texels); });
+        printf("%-20s legacy %8.1f MT/s   converter %8.1f MT/s   (%.1fx)\n", bench_case.name, legacy, converted,
+               converted / legacy);
+    }
+    return 0;
+}